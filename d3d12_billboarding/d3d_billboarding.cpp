@@ -19,6 +19,11 @@ https://www.gamedev.net/blogs/entry/2262563-adding-msaa-and-stream-output-suppor
 #include "headers/dds_loader.h"
 
 #include "waves.h"
+#include "terrain.h"
+#include "texture_batch.h"
+#include "texture_registry.h"
+#include "texture_assembler.h"
+#include "upload_ring.h"
 
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_win32.h>
@@ -42,12 +47,21 @@ https://www.gamedev.net/blogs/entry/2262563-adding-msaa-and-stream-output-suppor
 
 #define NUM_BACKBUFFERS         2
 #define NUM_QUEUING_FRAMES      3
+#define UPLOAD_RING_SIZE        (16 * 1024 * 1024)  // startup uploads, then a few frames of waves vertices (~2MB each)
+
+// NOTE(omid): TERRAIN_GRID_DIM must match the define in default.hlsl
+#define TERRAIN_WORLD_SIZE      4096.0f     // 16 km^2, leaves are 16m chunks (1m quads)
+#define TERRAIN_LOD_COUNT       9
+#define TERRAIN_GRID_DIM        16
+#define TERRAIN_LOD0_RANGE      40.0f
+#define TERRAIN_MAX_CHUNKS      1024
 
 enum RENDER_LAYER : int {
     LAYER_OPAQUE = 0,
     LAYER_TRANSPARENT = 1,
     LAYER_ALPHATESTED = 2,
     LAYER_ALPHATESTED_TREESPRITES = 3,
+    LAYER_TERRAIN = 4,
 
     _COUNT_RENDER_LAYER
 };
@@ -85,6 +99,15 @@ enum TEX_INDEX {
 
     _COUNT_TEX
 };
+// -- textures assembled out of the TEX_INDEX ones, what the shaders sample
+enum SHARED_TEX_INDEX {
+    SHARED_TEX_MATERIALS = 0,   // array: crate, grass, wirefence (same size and format)
+    SHARED_TEX_WATER = 1,       // array of one: water is the only image of its size and format
+    SHARED_TEX_TREES = 2,       // atlas: slices of the tree array
+
+    _COUNT_SHARED_TEX
+};
+#define MAX_TREE_IMAGES     8
 enum SAMPLER_INDEX {
     SAMPLER_POINT_WRAP = 0,
     SAMPLER_POINT_CLAMP = 1,
@@ -174,6 +197,12 @@ struct D3DRenderContext {
 
     MeshGeometry                    geom[_COUNT_GEOM];
 
+    Terrain *                       terrain;
+
+    // Every CPU to GPU upload: textures and static geometry at startup, then each frame's pass constants,
+    // waves vertices and terrain instances
+    UploadRing                      upload_ring;
+
     // Synchronization stuff
     UINT                            frame_index;
     HANDLE                          fence_event;
@@ -188,79 +217,24 @@ struct D3DRenderContext {
     ID3D12Resource *                depth_stencil_buffer;
 
     Material                        materials[_COUNT_MATERIAL];
-    Texture                         textures[_COUNT_TEX];
-};
-static void
-load_texture (
-    ID3D12Device * device,
-    ID3D12GraphicsCommandList * cmd_list,
-    wchar_t const * tex_path,
-    Texture * out_texture
-) {
-
-    uint8_t * ddsData;
-    D3D12_SUBRESOURCE_DATA * subresources;
-    UINT n_subresources = 0;
-
-    LoadDDSTextureFromFile(device, tex_path, &out_texture->resource, &ddsData, &subresources, &n_subresources);
-
-    UINT64 upload_buffer_size = get_required_intermediate_size(out_texture->resource, 0,
-                                                               n_subresources);
-
-   // Create the GPU upload buffer.
-    D3D12_HEAP_PROPERTIES heap_props = {};
-    heap_props.Type = D3D12_HEAP_TYPE_UPLOAD;
-    heap_props.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-    heap_props.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-    heap_props.CreationNodeMask = 1;
-    heap_props.VisibleNodeMask = 1;
-
-    D3D12_RESOURCE_DESC desc = {};
-    desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-    desc.Alignment = 0;
-    desc.Width = upload_buffer_size;
-    desc.Height = 1;
-    desc.DepthOrArraySize = 1;
-    desc.MipLevels = 1;
-    desc.Format = DXGI_FORMAT_UNKNOWN;
-    // TODO(omid): do we need to set 4x MSAA here? 
-    desc.SampleDesc.Count = 1;
-    desc.SampleDesc.Quality = 0;
-    desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-    desc.Flags = D3D12_RESOURCE_FLAG_NONE;
-
-    device->CreateCommittedResource(
-        &heap_props,
-        D3D12_HEAP_FLAG_NONE,
-        &desc,
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        nullptr,
-        IID_PPV_ARGS(&out_texture->upload_heap)
-    );
-
-    D3D12_RESOURCE_BARRIER barrier = {};
-    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-    barrier.Transition.pResource = out_texture->resource;
-    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
-    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    Texture                         textures[_COUNT_TEX];   // resources are owned by the registry (until they are assembled)
 
-    // Use Heap-allocating UpdateSubresources implementation for variable number of subresources (which is the case for textures).
-    update_subresources_heap(
-        cmd_list, out_texture->resource, out_texture->upload_heap,
-        0, 0, n_subresources, subresources
-    );
-    cmd_list->ResourceBarrier(1, &barrier);
+    // Textures shared by content, owns the texture SRVs (the first _COUNT_TEX descriptors of srv_heap)
+    TextureRegistry                 texture_registry;
+    int                             texture_entries[_COUNT_TEX];    // released once the shared textures are assembled
 
-    ::free(subresources);
-    ::free(ddsData);
-}
+    // Assembled textures, their SRVs follow the registry's
+    ID3D12Resource *                shared_textures[_COUNT_SHARED_TEX];
+    XMFLOAT4                        tree_uv_transforms[MAX_TREE_IMAGES];
+    UINT                            n_tree_images;
+};
+// texture_srvs/texture_slices: SRV index and array slice of each TEX_INDEX (materials share texture arrays)
 static void
-create_materials (Material out_materials []) {
+create_materials (UINT const texture_srvs [], UINT const texture_slices [], Material out_materials []) {
     strcpy_s(out_materials[MAT_GRASS].name, "grass");
     out_materials[MAT_GRASS].mat_cbuffer_index = 0;
-    out_materials[MAT_GRASS].diffuse_srvheap_index = 0;
+    out_materials[MAT_GRASS].diffuse_srvheap_index = texture_srvs[TEX_GRASS];
+    out_materials[MAT_GRASS].diffuse_slice = texture_slices[TEX_GRASS];
     out_materials[MAT_GRASS].diffuse_albedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
     out_materials[MAT_GRASS].fresnel_r0 = XMFLOAT3(0.01f, 0.01f, 0.01f);
     out_materials[MAT_GRASS].roughness = 0.125f;
@@ -269,7 +243,8 @@ create_materials (Material out_materials []) {
 
     strcpy_s(out_materials[MAT_WATER].name, "water");
     out_materials[MAT_WATER].mat_cbuffer_index = 1;
-    out_materials[MAT_WATER].diffuse_srvheap_index = 1;
+    out_materials[MAT_WATER].diffuse_srvheap_index = texture_srvs[TEX_WATER];
+    out_materials[MAT_WATER].diffuse_slice = texture_slices[TEX_WATER];
     out_materials[MAT_WATER].diffuse_albedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 0.5f);
     out_materials[MAT_WATER].fresnel_r0 = XMFLOAT3(0.1f, 0.1f, 0.1f);
     out_materials[MAT_WATER].roughness = 0.0f;
@@ -278,7 +253,8 @@ create_materials (Material out_materials []) {
 
     strcpy_s(out_materials[MAT_WOOD_CRATE].name, "wood_crate");
     out_materials[MAT_WOOD_CRATE].mat_cbuffer_index = 2;
-    out_materials[MAT_WOOD_CRATE].diffuse_srvheap_index = 2;
+    out_materials[MAT_WOOD_CRATE].diffuse_srvheap_index = texture_srvs[TEX_CRATE01];
+    out_materials[MAT_WOOD_CRATE].diffuse_slice = texture_slices[TEX_CRATE01];
     out_materials[MAT_WOOD_CRATE].diffuse_albedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
     out_materials[MAT_WOOD_CRATE].fresnel_r0 = XMFLOAT3(0.05f, 0.05f, 0.05f);
     out_materials[MAT_WOOD_CRATE].roughness = 0.2f;
@@ -287,7 +263,8 @@ create_materials (Material out_materials []) {
 
     strcpy_s(out_materials[MAT_WIRED_CRATE].name, "wired_crate");
     out_materials[MAT_WIRED_CRATE].mat_cbuffer_index = 3;
-    out_materials[MAT_WIRED_CRATE].diffuse_srvheap_index = 3;
+    out_materials[MAT_WIRED_CRATE].diffuse_srvheap_index = texture_srvs[TEX_WIREFENCE];
+    out_materials[MAT_WIRED_CRATE].diffuse_slice = texture_slices[TEX_WIREFENCE];
     out_materials[MAT_WIRED_CRATE].diffuse_albedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
     out_materials[MAT_WIRED_CRATE].fresnel_r0 = XMFLOAT3(0.05f, 0.05f, 0.05f);
     out_materials[MAT_WIRED_CRATE].roughness = 0.2f;
@@ -296,7 +273,8 @@ create_materials (Material out_materials []) {
 
     strcpy_s(out_materials[MAT_TREE_SPRITE].name, "tree_sprites");
     out_materials[MAT_TREE_SPRITE].mat_cbuffer_index = 4;
-    out_materials[MAT_TREE_SPRITE].diffuse_srvheap_index = 4;
+    out_materials[MAT_TREE_SPRITE].diffuse_srvheap_index = texture_srvs[TEX_TREEARRAY];
+    out_materials[MAT_TREE_SPRITE].diffuse_slice = texture_slices[TEX_TREEARRAY];
     out_materials[MAT_TREE_SPRITE].diffuse_albedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
     out_materials[MAT_TREE_SPRITE].fresnel_r0 = XMFLOAT3(0.01f, 0.01f, 0.01f);
     out_materials[MAT_TREE_SPRITE].roughness = 0.125f;
@@ -307,56 +285,21 @@ static float
 calc_hill_height (float x, float z) {
     return 0.3f * (z * sinf(0.1f * x) + x * cosf(0.1f * z));
 }
-static XMFLOAT3
-calc_hill_normal (float x, float z) {
-    // n = (-df/dx, 1, -df/dz)
-    XMFLOAT3 n(
-        -0.03f * z * cosf(0.1f * x) - 0.3f * cosf(0.1f * z),
-        1.0f,
-        -0.3f * sinf(0.1f * x) + 0.03f * x * sinf(0.1f * z)
-    );
-
-    XMVECTOR unit_normal = XMVector3Normalize(XMLoadFloat3(&n));
-    XMStoreFloat3(&n, unit_normal);
-
-    return n;
-}
 static void
 create_shape_geometry (D3DRenderContext * render_ctx) {
 
-    // required sizes
-    int nvtx = 24;
-    int nidx = 36;
-
-    Vertex *    vertices = (Vertex *)::malloc(sizeof(Vertex) * nvtx);
-    uint16_t *  indices = (uint16_t *)::malloc(sizeof(uint16_t) * nidx);
-    BYTE *      scratch = (BYTE *)::malloc(sizeof(GeomVertex) * nvtx + sizeof(uint16_t) * nidx);
-
-    // box
-    UINT bsz = sizeof(GeomVertex) * nvtx;
-    GeomVertex *    box_vertices = reinterpret_cast<GeomVertex *>(scratch);
-    uint16_t *      box_indices = reinterpret_cast<uint16_t *>(scratch + bsz);
-
-    create_box(8.0f, 8.0f, 8.0f, box_vertices, box_indices);
+    // box (read-only table built at compile time, uploaded as is)
+    StaticGeometry<Vertex, 24, 36> const & box = box_geometry<Vertex, 8.0f, 8.0f, 8.0f>;
+    UINT nvtx = ARRAY_COUNT(box.vertices);
+    UINT nidx = ARRAY_COUNT(box.indices);
+    Vertex const *      vertices = box.vertices;
+    uint16_t const *    indices = box.indices;
 
     SubmeshGeometry box_submesh = {};
     box_submesh.index_count = nidx;
     box_submesh.start_index_location = 0;
     box_submesh.base_vertex_location = 0;
 
-    UINT k = 0;
-    for (size_t i = 0; i < nvtx; ++i, ++k) {
-        vertices[k].position = box_vertices[i].Position;
-        vertices[k].normal = box_vertices[i].Normal;
-        vertices[k].texc = box_vertices[i].TexC;
-    }
-
-    // -- pack indices
-    k = 0;
-    for (size_t i = 0; i < nidx; ++i, ++k) {
-        indices[k] = box_indices[i];
-    }
-
     UINT vb_byte_size = nvtx * sizeof(Vertex);
     UINT ib_byte_size = nidx * sizeof(uint16_t);
 
@@ -369,8 +312,8 @@ create_shape_geometry (D3DRenderContext * render_ctx) {
     if (indices)
         CopyMemory(render_ctx->geom[GEOM_BOX].ib_cpu->GetBufferPointer(), indices, ib_byte_size);
 
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size, &render_ctx->geom[GEOM_BOX].vb_uploader, &render_ctx->geom[GEOM_BOX].vb_gpu);
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size, &render_ctx->geom[GEOM_BOX].ib_uploader, &render_ctx->geom[GEOM_BOX].ib_gpu);
+    render_ctx->geom[GEOM_BOX].vb_gpu = UploadRing_CreateBuffer(&render_ctx->upload_ring, render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size);
+    render_ctx->geom[GEOM_BOX].ib_gpu = UploadRing_CreateBuffer(&render_ctx->upload_ring, render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size);
 
     render_ctx->geom[GEOM_BOX].vb_byte_stide = sizeof(Vertex);
     render_ctx->geom[GEOM_BOX].vb_byte_size = vb_byte_size;
@@ -379,40 +322,21 @@ create_shape_geometry (D3DRenderContext * render_ctx) {
 
     render_ctx->geom[GEOM_BOX].submesh_names[0] = "box";
     render_ctx->geom[GEOM_BOX].submesh_geoms[0] = box_submesh;
-
-    // -- cleanup
-    free(scratch);
-    free(indices);
-    free(vertices);
 }
+// -- the whole landscape is drawn by instancing one chunk mesh (see terrain.h)
 static void
-create_land_geometry (D3DRenderContext * render_ctx) {
+create_terrain_geometry (D3DRenderContext * render_ctx) {
 
     // required sizes calculations
-    int nrow = 50;
-    int ncol = 50;
-    int nvtx = nrow * ncol;
-    int nidx = (nrow - 1) * (ncol - 1) * 6;     // every 6 vertices form a quad
+    int nvtx = (TERRAIN_GRID_DIM + 1) * (TERRAIN_GRID_DIM + 1);
+    int nidx = TERRAIN_GRID_DIM * TERRAIN_GRID_DIM * 6;     // every 6 vertices form a quad
 
-    Vertex * vertices = (Vertex *)::malloc(sizeof(Vertex) * nvtx);
+    XMFLOAT2 * vertices = (XMFLOAT2 *)::malloc(sizeof(XMFLOAT2) * nvtx);
     uint16_t * indices = (uint16_t *)::malloc(sizeof(uint16_t) * nidx);
-    GeomVertex * grid = (GeomVertex *)::malloc(sizeof(GeomVertex) * nvtx);
-
-    create_grid(320.0f, 320.0f, 50, 50, grid, indices);
 
-    // Extract the vertex elements we are interested and apply the height function to
-    // each vertex.  In addition, color the vertices based on their height so we have
-    // sandy looking beaches, grassy low hills, and snow mountain peaks.
+    Terrain_CreateChunkMesh(TERRAIN_GRID_DIM, vertices, indices);
 
-    for (int i = 0; i < nvtx; ++i) {
-        auto & p = grid[i].Position;
-        vertices[i].position = p;
-        vertices[i].position.y = calc_hill_height(p.x, p.z);
-        vertices[i].normal = calc_hill_normal(p.x, p.z);
-        vertices[i].texc = grid[i].TexC;
-    }
-
-    UINT vb_byte_size = nvtx * sizeof(Vertex);
+    UINT vb_byte_size = nvtx * sizeof(XMFLOAT2);
     UINT ib_byte_size = nidx * sizeof(uint16_t);
 
     // -- Fill out render_ctx geom (output)
@@ -425,10 +349,10 @@ create_land_geometry (D3DRenderContext * render_ctx) {
     if (indices)
         CopyMemory(render_ctx->geom[GEOM_GRID].ib_cpu->GetBufferPointer(), indices, ib_byte_size);
 
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size, &render_ctx->geom[GEOM_GRID].vb_uploader, &render_ctx->geom[GEOM_GRID].vb_gpu);
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size, &render_ctx->geom[GEOM_GRID].ib_uploader, &render_ctx->geom[GEOM_GRID].ib_gpu);
+    render_ctx->geom[GEOM_GRID].vb_gpu = UploadRing_CreateBuffer(&render_ctx->upload_ring, render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size);
+    render_ctx->geom[GEOM_GRID].ib_gpu = UploadRing_CreateBuffer(&render_ctx->upload_ring, render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size);
 
-    render_ctx->geom[GEOM_GRID].vb_byte_stide = sizeof(Vertex);
+    render_ctx->geom[GEOM_GRID].vb_byte_stide = sizeof(XMFLOAT2);
     render_ctx->geom[GEOM_GRID].vb_byte_size = vb_byte_size;
     render_ctx->geom[GEOM_GRID].ib_byte_size = ib_byte_size;
     render_ctx->geom[GEOM_GRID].index_format = DXGI_FORMAT_R16_UINT;
@@ -438,10 +362,9 @@ create_land_geometry (D3DRenderContext * render_ctx) {
     submesh.start_index_location = 0;
     submesh.base_vertex_location = 0;
 
-    render_ctx->geom[GEOM_GRID].submesh_names[0] = "grid";
+    render_ctx->geom[GEOM_GRID].submesh_names[0] = "terrain_chunk";
     render_ctx->geom[GEOM_GRID].submesh_geoms[0] = submesh;
 
-    ::free(grid);
     ::free(indices);
     ::free(vertices);
 }
@@ -483,8 +406,8 @@ create_water_geometry (UINT nrow, UINT ncol, UINT ntri, D3DRenderContext * rende
     if (indices)
         CopyMemory(render_ctx->geom[GEOM_WATER].ib_cpu->GetBufferPointer(), indices, ib_byte_size);
 
-    //create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size, &render_ctx->geom[GEOM_WATER].vb_uploader, &render_ctx->geom[GEOM_WATER].vb_gpu);
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size, &render_ctx->geom[GEOM_WATER].ib_uploader, &render_ctx->geom[GEOM_WATER].ib_gpu);
+    // -- the water vb is rewritten every frame in the upload ring (see update_waves_vb)
+    render_ctx->geom[GEOM_WATER].ib_gpu = UploadRing_CreateBuffer(&render_ctx->upload_ring, render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size);
 
     render_ctx->geom[GEOM_WATER].vb_byte_stide = sizeof(Vertex);
     render_ctx->geom[GEOM_WATER].vb_byte_size = vb_byte_size;
@@ -507,6 +430,7 @@ create_treesprites_geometry (D3DRenderContext * render_ctx) {
     struct TreeSpriteVertex {
         XMFLOAT3 pos;
         XMFLOAT2 size;
+        XMFLOAT4 uv_transform;  // where the tree image is in the atlas
     };
 
     constexpr int tree_count = 16;
@@ -522,6 +446,7 @@ create_treesprites_geometry (D3DRenderContext * render_ctx) {
 
         vertices[i].pos = XMFLOAT3(x, y, z);
         vertices[i].size = XMFLOAT2(20.0f, 20.0f);
+        vertices[i].uv_transform = render_ctx->n_tree_images > 0 ? render_ctx->tree_uv_transforms[i % render_ctx->n_tree_images] : XMFLOAT4(1.0f, 1.0f, 0.0f, 0.0f);
     }
 
     uint16_t indices[tree_count] = {
@@ -540,8 +465,8 @@ create_treesprites_geometry (D3DRenderContext * render_ctx) {
     if (indices)
         CopyMemory(render_ctx->geom[GEOM_TREESPRITE].ib_cpu->GetBufferPointer(), indices, ib_byte_size);
 
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size, &render_ctx->geom[GEOM_TREESPRITE].vb_uploader, &render_ctx->geom[GEOM_TREESPRITE].vb_gpu);
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size, &render_ctx->geom[GEOM_TREESPRITE].ib_uploader, &render_ctx->geom[GEOM_TREESPRITE].ib_gpu);
+    render_ctx->geom[GEOM_TREESPRITE].vb_gpu = UploadRing_CreateBuffer(&render_ctx->upload_ring, render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size);
+    render_ctx->geom[GEOM_TREESPRITE].ib_gpu = UploadRing_CreateBuffer(&render_ctx->upload_ring, render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size);
 
     render_ctx->geom[GEOM_TREESPRITE].vb_byte_stide = sizeof(TreeSpriteVertex);
     render_ctx->geom[GEOM_TREESPRITE].vb_byte_size = vb_byte_size;
@@ -597,8 +522,7 @@ create_render_items (
     all_ritems->ritems[RITEM_GRID].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
     all_ritems->ritems[RITEM_GRID].initialized = true;
     all_ritems->size++;
-    opaque_ritems->ritems[0] = all_ritems->ritems[RITEM_GRID];
-    opaque_ritems->size++;
+    // NOTE(omid): The grid item is not in any layer; it holds the terrain cbuffer and material (see draw_terrain)
 
     all_ritems->ritems[RITEM_BOX].world = Identity4x4();
     XMStoreFloat4x4(&all_ritems->ritems[RITEM_BOX].world, XMMatrixTranslation(3.0f, 2.0f, -9.0f));
@@ -634,6 +558,7 @@ create_render_items (
     alphatested_treesprites_ritems->size++;
 }
 // -- indexed drawing
+// bound_table: descriptor table bound to root parameter 0 (0 for none), the table is only set when it changes
 static void
 draw_render_items (
     ID3D12GraphicsCommandList * cmd_list,
@@ -642,7 +567,8 @@ draw_render_items (
     UINT64 descriptor_increment_size,
     ID3D12DescriptorHeap * srv_heap,
     RenderItemArray * ritem_array,
-    UINT current_frame_index
+    UINT current_frame_index,
+    UINT64 * bound_table
 ) {
     UINT objcb_byte_size = (UINT64)sizeof(ObjectConstants);
     UINT matcb_byte_size = (UINT64)sizeof(MaterialConstants);
@@ -663,7 +589,10 @@ draw_render_items (
             D3D12_GPU_VIRTUAL_ADDRESS matcb_address = mat_cbuffer->GetGPUVirtualAddress();
             matcb_address += (UINT64)ritem_array->ritems[i].mat->mat_cbuffer_index * matcb_byte_size;
 
-            cmd_list->SetGraphicsRootDescriptorTable(0, tex);
+            if (tex.ptr != *bound_table) {
+                cmd_list->SetGraphicsRootDescriptorTable(0, tex);
+                *bound_table = tex.ptr;
+            }
             cmd_list->SetGraphicsRootConstantBufferView(1, objcb_address);
             cmd_list->SetGraphicsRootConstantBufferView(3, matcb_address);
             cmd_list->DrawIndexedInstanced(ritem_array->ritems[i].index_count, 1, ritem_array->ritems[i].start_index_loc, ritem_array->ritems[i].base_vertex_loc, 0);
@@ -673,76 +602,13 @@ draw_render_items (
 static void
 create_descriptor_heaps (D3DRenderContext * render_ctx) {
 
-    // Create Shader Resource View descriptor heap
+    // Create Shader Resource View descriptor heap (the texture registry's SRVs, then the shared textures' SRVs)
     D3D12_DESCRIPTOR_HEAP_DESC srv_heap_desc = {};
-    srv_heap_desc.NumDescriptors = _COUNT_TEX + 1 /* imgui descriptor */;
+    srv_heap_desc.NumDescriptors = _COUNT_TEX + _COUNT_SHARED_TEX + 1 /* imgui descriptor */;
     srv_heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
     srv_heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
     render_ctx->device->CreateDescriptorHeap(&srv_heap_desc, IID_PPV_ARGS(&render_ctx->srv_heap));
 
-    // Fill out the heap with actual descriptors
-    D3D12_CPU_DESCRIPTOR_HANDLE descriptor_cpu_handle = render_ctx->srv_heap->GetCPUDescriptorHandleForHeapStart();
-
-    // grass texture
-    ID3D12Resource * grass_tex = render_ctx->textures[TEX_GRASS].resource;
-    D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
-    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srv_desc.Format = grass_tex->GetDesc().Format;
-    srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srv_desc.Texture2D.MostDetailedMip = 0;
-    srv_desc.Texture2D.MipLevels = grass_tex->GetDesc().MipLevels;
-    srv_desc.Texture2D.ResourceMinLODClamp = 0.0f;
-    render_ctx->device->CreateShaderResourceView(grass_tex, &srv_desc, descriptor_cpu_handle);
-
-    // water texture
-    ID3D12Resource * water_tex = render_ctx->textures[TEX_WATER].resource;
-    memset(&srv_desc, 0, sizeof(srv_desc));         // reset desc
-    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srv_desc.Format = water_tex->GetDesc().Format;
-    srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srv_desc.Texture2D.MostDetailedMip = 0;
-    srv_desc.Texture2D.MipLevels = water_tex->GetDesc().MipLevels;
-    srv_desc.Texture2D.ResourceMinLODClamp = 0.0f;
-    descriptor_cpu_handle.ptr += render_ctx->cbv_srv_uav_descriptor_size;   // next descriptr
-    render_ctx->device->CreateShaderResourceView(water_tex, &srv_desc, descriptor_cpu_handle);
-
-    // crate texture
-    ID3D12Resource * box_tex = render_ctx->textures[TEX_CRATE01].resource;
-    memset(&srv_desc, 0, sizeof(srv_desc)); // reset desc
-    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srv_desc.Format = box_tex->GetDesc().Format;
-    srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srv_desc.Texture2D.MostDetailedMip = 0;
-    srv_desc.Texture2D.MipLevels = box_tex->GetDesc().MipLevels;
-    srv_desc.Texture2D.ResourceMinLODClamp = 0.0f;
-    descriptor_cpu_handle.ptr += render_ctx->cbv_srv_uav_descriptor_size;   // next descriptor
-    render_ctx->device->CreateShaderResourceView(box_tex, &srv_desc, descriptor_cpu_handle);
-
-    // wire_fence texture
-    ID3D12Resource * wire_tex = render_ctx->textures[TEX_WIREFENCE].resource;
-    memset(&srv_desc, 0, sizeof(srv_desc)); // reset desc
-    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srv_desc.Format = wire_tex->GetDesc().Format;
-    srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srv_desc.Texture2D.MostDetailedMip = 0;
-    srv_desc.Texture2D.MipLevels = wire_tex->GetDesc().MipLevels;
-    srv_desc.Texture2D.ResourceMinLODClamp = 0.0f;
-    descriptor_cpu_handle.ptr += render_ctx->cbv_srv_uav_descriptor_size;   // next descriptor
-    render_ctx->device->CreateShaderResourceView(wire_tex, &srv_desc, descriptor_cpu_handle);
-
-    // tree_array texture
-    ID3D12Resource * tree_tex = render_ctx->textures[TEX_TREEARRAY].resource;
-    memset(&srv_desc, 0, sizeof(srv_desc)); // reset desc
-    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srv_desc.Format = tree_tex->GetDesc().Format;
-    srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
-    srv_desc.Texture2DArray.MostDetailedMip = 0;
-    srv_desc.Texture2DArray.MipLevels = tree_tex->GetDesc().MipLevels;
-    srv_desc.Texture2DArray.FirstArraySlice = 0;
-    srv_desc.Texture2DArray.ArraySize = tree_tex->GetDesc().DepthOrArraySize;
-    descriptor_cpu_handle.ptr += render_ctx->cbv_srv_uav_descriptor_size;   // next descriptor
-    render_ctx->device->CreateShaderResourceView(tree_tex, &srv_desc, descriptor_cpu_handle);
-
     // Create Render Target View Descriptor Heap
     D3D12_DESCRIPTOR_HEAP_DESC rtv_heap_desc = {};
     rtv_heap_desc.NumDescriptors = NUM_BACKBUFFERS;
@@ -917,7 +783,8 @@ create_pso (
     IDxcBlob * pixel_shader_code_alphatested,
     IDxcBlob * vertex_shader_code_tree,
     IDxcBlob * geo_shader_code_tree,
-    IDxcBlob * pixel_shader_code_tree
+    IDxcBlob * pixel_shader_code_tree,
+    IDxcBlob * vertex_shader_code_terrain
 ) {
     // -- Create vertex-input-layout Elements
 
@@ -946,7 +813,7 @@ create_pso (
     std_input_desc[2].AlignedByteOffset = 24;
     std_input_desc[2].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
 
-    D3D12_INPUT_ELEMENT_DESC treesprite_input_desc[2];
+    D3D12_INPUT_ELEMENT_DESC treesprite_input_desc[3];
     treesprite_input_desc[0] = {};
     treesprite_input_desc[0].SemanticName = "POSITION";
     treesprite_input_desc[0].SemanticIndex = 0;
@@ -962,6 +829,14 @@ create_pso (
     treesprite_input_desc[1].InputSlot = 0;
     treesprite_input_desc[1].AlignedByteOffset = 12;
     treesprite_input_desc[1].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+
+    treesprite_input_desc[2] = {};
+    treesprite_input_desc[2].SemanticName = "UVTRANSFORM";
+    treesprite_input_desc[2].SemanticIndex = 0;
+    treesprite_input_desc[2].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+    treesprite_input_desc[2].InputSlot = 0;
+    treesprite_input_desc[2].AlignedByteOffset = 20;
+    treesprite_input_desc[2].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
     //
     // -- Create PSO for Opaque objs
     //
@@ -1066,6 +941,43 @@ create_pso (
     tree_pso_desc.InputLayout.pInputElementDescs = treesprite_input_desc;
     tree_pso_desc.InputLayout.NumElements = ARRAY_COUNT(treesprite_input_desc);
     render_ctx->device->CreateGraphicsPipelineState(&tree_pso_desc, IID_PPV_ARGS(&render_ctx->psos[LAYER_ALPHATESTED_TREESPRITES]));
+
+    //
+    // -- Create PSO for terrain chunks (slot 0: chunk grid, slot 1: per-instance chunk data)
+    //
+    D3D12_INPUT_ELEMENT_DESC terrain_input_desc[3];
+    terrain_input_desc[0] = {};
+    terrain_input_desc[0].SemanticName = "GRIDPOS";
+    terrain_input_desc[0].SemanticIndex = 0;
+    terrain_input_desc[0].Format = DXGI_FORMAT_R32G32_FLOAT;
+    terrain_input_desc[0].InputSlot = 0;
+    terrain_input_desc[0].AlignedByteOffset = 0;
+    terrain_input_desc[0].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+
+    terrain_input_desc[1] = {};
+    terrain_input_desc[1].SemanticName = "CHUNK";
+    terrain_input_desc[1].SemanticIndex = 0;
+    terrain_input_desc[1].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+    terrain_input_desc[1].InputSlot = 1;
+    terrain_input_desc[1].AlignedByteOffset = offsetof(TerrainChunkDraw, origin_x);
+    terrain_input_desc[1].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA;
+    terrain_input_desc[1].InstanceDataStepRate = 1;
+
+    terrain_input_desc[2] = {};
+    terrain_input_desc[2].SemanticName = "CHUNK";
+    terrain_input_desc[2].SemanticIndex = 1;
+    terrain_input_desc[2].Format = DXGI_FORMAT_R32G32_FLOAT;
+    terrain_input_desc[2].InputSlot = 1;
+    terrain_input_desc[2].AlignedByteOffset = offsetof(TerrainChunkDraw, morph_start);
+    terrain_input_desc[2].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA;
+    terrain_input_desc[2].InstanceDataStepRate = 1;
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC terrain_pso_desc = opaque_pso_desc;
+    terrain_pso_desc.VS.pShaderBytecode = vertex_shader_code_terrain->GetBufferPointer();
+    terrain_pso_desc.VS.BytecodeLength = vertex_shader_code_terrain->GetBufferSize();
+    terrain_pso_desc.InputLayout.pInputElementDescs = terrain_input_desc;
+    terrain_pso_desc.InputLayout.NumElements = ARRAY_COUNT(terrain_input_desc);
+    render_ctx->device->CreateGraphicsPipelineState(&terrain_pso_desc, IID_PPV_ARGS(&render_ctx->psos[LAYER_TERRAIN]));
 }
 static void
 handle_keyboard_input (SceneContext * scene_ctx, GameTimer * gt) {
@@ -1172,6 +1084,7 @@ update_mat_cbuffers (D3DRenderContext * render_ctx) {
             mat_constants.fresnel_r0 = render_ctx->materials[i].fresnel_r0;
             mat_constants.roughness = render_ctx->materials[i].roughness;
             XMStoreFloat4x4(&mat_constants.mat_transform, XMMatrixTranspose(mat_transform));
+            mat_constants.diffuse_slice = (UINT)mat->diffuse_slice;
 
             uint8_t * mat_ptr = render_ctx->frame_resources[frame_index].mat_cb_data_ptr + ((UINT64)mat->mat_cbuffer_index * cbuffer_size);
             memcpy(mat_ptr, &mat_constants, cbuffer_size);
@@ -1218,8 +1131,14 @@ update_pass_cbuffers (D3DRenderContext * render_ctx, GameTimer * timer) {
     render_ctx->main_pass_constants.lights[2].direction = {0.0f, -0.707f, -0.707f};
     render_ctx->main_pass_constants.lights[2].strength = {0.15f, 0.15f, 0.15f};
 
-    uint8_t * pass_ptr = render_ctx->frame_resources[render_ctx->frame_index].pass_cb_data_ptr;
-    memcpy(pass_ptr, &render_ctx->main_pass_constants, sizeof(PassConstants));
+    UploadRingAllocation pass_cb = {};
+    // -- this frame can't be drawn without its pass constants
+    if (!UploadRing_Alloc(&render_ctx->upload_ring, sizeof(PassConstants), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, &pass_cb)) {
+        ::printf("[ERROR] UploadRing_Alloc() failed at line %d, UPLOAD_RING_SIZE too small. \n", __LINE__);
+        ::abort();
+    }
+    memcpy(pass_cb.cpu, &render_ctx->main_pass_constants, sizeof(PassConstants));
+    render_ctx->frame_resources[render_ctx->frame_index].pass_cb_address = pass_cb.gpu;
 }
 static void
 animate_material (Material * mat, GameTimer * timer) {
@@ -1266,17 +1185,15 @@ update_waves_vb (Waves * waves, D3DRenderContext * render_ctx, GameTimer * timer
     ::free(temp);
 
     // Update the wave vertex buffer with the new solution.
-    UINT frame_index = render_ctx->frame_index;
-    uint8_t * wave_ptr = render_ctx->frame_resources[frame_index].waves_vb_data_ptr;
-
-    //D3D12_RANGE mem_range = {};
-    //mem_range.Begin = 0;
-    //mem_range.End = 0;
-    //CHECK_AND_FAIL(
-    //    render_ctx->frame_resources[frame_index].waves_vb->Map(0, &mem_range, reinterpret_cast<void**>(&wave_ptr))
-    //);
-
     UINT v_size = (UINT64)sizeof(Vertex);
+    UploadRingAllocation waves_vb = {};
+    // -- the previous frame's vertices may already be overwritten, so there's nothing to fall back on
+    if (!UploadRing_Alloc(&render_ctx->upload_ring, (UINT64)v_size * waves->nvtx, sizeof(float), &waves_vb)) {
+        ::printf("[ERROR] UploadRing_Alloc() failed at line %d, UPLOAD_RING_SIZE too small. \n", __LINE__);
+        ::abort();
+    }
+    uint8_t * wave_ptr = waves_vb.cpu;
+
     for (int i = 0; i < waves->nvtx; ++i) {
         Vertex v;
 
@@ -1290,10 +1207,35 @@ update_waves_vb (Waves * waves, D3DRenderContext * render_ctx, GameTimer * timer
 
         ::memcpy(wave_ptr + (UINT64)i * v_size, &v, v_size);
     }
-    // NOTE(omid): We did the upload_buffer mapping to data pointer (when creating the upload_buffer)
 
     // Set the dynamic VB of the wave renderitem to the current frame VB.
-    render_ctx->all_ritems.ritems[RITEM_WATER].geometry->vb_gpu = render_ctx->frame_resources[frame_index].waves_vb;
+    render_ctx->all_ritems.ritems[RITEM_WATER].geometry->vb_gpu = waves_vb.buffer;
+    render_ctx->all_ritems.ritems[RITEM_WATER].geometry->vb_offset = waves_vb.offset;
+}
+static void
+update_terrain_chunks (Terrain * terrain, SceneContext * scene_ctx, D3DRenderContext * render_ctx) {
+    // -- world space view frustum
+    XMMATRIX view = XMLoadFloat4x4(&scene_ctx->view);
+    XMMATRIX proj = XMLoadFloat4x4(&scene_ctx->proj);
+    XMVECTOR view_det = XMMatrixDeterminant(view);
+    XMMATRIX inv_view = XMMatrixInverse(&view_det, view);
+
+    BoundingFrustum frustum;
+    BoundingFrustum::CreateFromMatrix(frustum, proj);
+    frustum.Transform(frustum, inv_view);
+
+    Terrain_Select(terrain, scene_ctx->eye_pos, &frustum);
+
+    // Copy the selected chunks to the current frame instance buffer
+    if (0 == terrain->selection_count)
+        return;
+    UploadRingAllocation chunks_vb = {};
+    if (!UploadRing_Alloc(&render_ctx->upload_ring, sizeof(TerrainChunkDraw) * terrain->selection_count, sizeof(float), &chunks_vb)) {
+        ::printf("[ERROR] UploadRing_Alloc() failed at line %d, UPLOAD_RING_SIZE too small. \n", __LINE__);
+        ::abort();
+    }
+    ::memcpy(chunks_vb.cpu, terrain->selection, sizeof(TerrainChunkDraw) * terrain->selection_count);
+    render_ctx->frame_resources[render_ctx->frame_index].terrain_chunks_vb_address = chunks_vb.gpu;
 }
 static HRESULT
 move_to_next_frame (D3DRenderContext * render_ctx, UINT * out_frame_index, UINT * out_backbuffer_index) {
@@ -1358,6 +1300,49 @@ create_barrier (ID3D12Resource * resource, D3D12_RESOURCE_STATES before, D3D12_R
     barrier.Transition.StateAfter = after;
     return barrier;
 }
+// -- one instanced draw for all the selected terrain chunks
+static void
+draw_terrain (
+    ID3D12GraphicsCommandList * cmd_list,
+    ID3D12Resource * object_cbuffer,
+    ID3D12Resource * mat_cbuffer,
+    D3D12_GPU_VIRTUAL_ADDRESS chunks_vb_address,
+    UINT64 descriptor_increment_size,
+    ID3D12DescriptorHeap * srv_heap,
+    RenderItem * terrain_ritem,
+    UINT n_chunks,
+    UINT64 * bound_table
+) {
+    if (0 == n_chunks)
+        return;
+
+    D3D12_VERTEX_BUFFER_VIEW vbvs[2];
+    vbvs[0] = Mesh_GetVertexBufferView(terrain_ritem->geometry);
+    vbvs[1].BufferLocation = chunks_vb_address;
+    vbvs[1].StrideInBytes = (UINT)sizeof(TerrainChunkDraw);
+    vbvs[1].SizeInBytes = (UINT)sizeof(TerrainChunkDraw) * n_chunks;
+    D3D12_INDEX_BUFFER_VIEW ibv = Mesh_GetIndexBufferView(terrain_ritem->geometry);
+    cmd_list->IASetVertexBuffers(0, 2, vbvs);
+    cmd_list->IASetIndexBuffer(&ibv);
+    cmd_list->IASetPrimitiveTopology(terrain_ritem->primitive_type);
+
+    D3D12_GPU_DESCRIPTOR_HANDLE tex = srv_heap->GetGPUDescriptorHandleForHeapStart();
+    tex.ptr += descriptor_increment_size * terrain_ritem->mat->diffuse_srvheap_index;
+
+    D3D12_GPU_VIRTUAL_ADDRESS objcb_address = object_cbuffer->GetGPUVirtualAddress();
+    objcb_address += (UINT64)terrain_ritem->obj_cbuffer_index * sizeof(ObjectConstants);
+
+    D3D12_GPU_VIRTUAL_ADDRESS matcb_address = mat_cbuffer->GetGPUVirtualAddress();
+    matcb_address += (UINT64)terrain_ritem->mat->mat_cbuffer_index * sizeof(MaterialConstants);
+
+    if (tex.ptr != *bound_table) {
+        cmd_list->SetGraphicsRootDescriptorTable(0, tex);
+        *bound_table = tex.ptr;
+    }
+    cmd_list->SetGraphicsRootConstantBufferView(1, objcb_address);
+    cmd_list->SetGraphicsRootConstantBufferView(3, matcb_address);
+    cmd_list->DrawIndexedInstanced(terrain_ritem->index_count, n_chunks, terrain_ritem->start_index_loc, terrain_ritem->base_vertex_loc, 0);
+}
 static HRESULT
 draw_main (D3DRenderContext * render_ctx) {
     HRESULT ret = E_FAIL;
@@ -1402,17 +1387,35 @@ draw_main (D3DRenderContext * render_ctx) {
     render_ctx->direct_cmd_list->SetGraphicsRootSignature(render_ctx->root_signature);
 
     // Bind per-pass constant buffer.  We only need to do this once per-pass.
-    ID3D12Resource * pass_cb = render_ctx->frame_resources[frame_index].pass_cb;
-    render_ctx->direct_cmd_list->SetGraphicsRootConstantBufferView(2, pass_cb->GetGPUVirtualAddress());
+    render_ctx->direct_cmd_list->SetGraphicsRootConstantBufferView(2, render_ctx->frame_resources[frame_index].pass_cb_address);
+
+    // -- root arguments survive pipeline changes (same root signature), so materials sharing
+    // a texture keep the table bound across the layers
+    UINT64 bound_table = 0;
 
-    // 1. draw opaque objs first (opaque pso is currently used)
+    // 0. draw terrain chunks
+    render_ctx->direct_cmd_list->SetPipelineState(render_ctx->psos[LAYER_TERRAIN]);
+    draw_terrain(
+        render_ctx->direct_cmd_list,
+        render_ctx->frame_resources[frame_index].obj_cb,
+        render_ctx->frame_resources[frame_index].mat_cb,
+        render_ctx->frame_resources[frame_index].terrain_chunks_vb_address,
+        render_ctx->cbv_srv_uav_descriptor_size,
+        render_ctx->srv_heap,
+        &render_ctx->all_ritems.ritems[RITEM_GRID],
+        render_ctx->terrain->selection_count,
+        &bound_table
+    );
+    // 1. draw opaque objs
+    render_ctx->direct_cmd_list->SetPipelineState(render_ctx->psos[LAYER_OPAQUE]);
     draw_render_items(
         render_ctx->direct_cmd_list,
         render_ctx->frame_resources[frame_index].obj_cb,
         render_ctx->frame_resources[frame_index].mat_cb,
         render_ctx->cbv_srv_uav_descriptor_size,
         render_ctx->srv_heap,
-        &render_ctx->opaque_ritems, frame_index
+        &render_ctx->opaque_ritems, frame_index,
+        &bound_table
     );
     // 2. draw alpha-tested box/crate
     render_ctx->direct_cmd_list->SetPipelineState(render_ctx->psos[LAYER_ALPHATESTED]);
@@ -1422,7 +1425,8 @@ draw_main (D3DRenderContext * render_ctx) {
         render_ctx->frame_resources[frame_index].mat_cb,
         render_ctx->cbv_srv_uav_descriptor_size,
         render_ctx->srv_heap,
-        &render_ctx->alphatested_ritems, frame_index
+        &render_ctx->alphatested_ritems, frame_index,
+        &bound_table
     );
     // 3. draw tree-sprites
     render_ctx->direct_cmd_list->SetPipelineState(render_ctx->psos[LAYER_ALPHATESTED_TREESPRITES]);
@@ -1432,7 +1436,8 @@ draw_main (D3DRenderContext * render_ctx) {
         render_ctx->frame_resources[frame_index].mat_cb,
         render_ctx->cbv_srv_uav_descriptor_size,
         render_ctx->srv_heap,
-        &render_ctx->alphatested_treesprites_ritems, frame_index
+        &render_ctx->alphatested_treesprites_ritems, frame_index,
+        &bound_table
     );
     // 4. draw transparent objs
     render_ctx->direct_cmd_list->SetPipelineState(render_ctx->psos[LAYER_TRANSPARENT]);
@@ -1442,7 +1447,8 @@ draw_main (D3DRenderContext * render_ctx) {
         render_ctx->frame_resources[frame_index].mat_cb,
         render_ctx->cbv_srv_uav_descriptor_size,
         render_ctx->srv_heap,
-        &render_ctx->transparent_ritems, frame_index
+        &render_ctx->transparent_ritems, frame_index,
+        &bound_table
     );
 
     // Imgui draw call
@@ -1457,7 +1463,7 @@ draw_main (D3DRenderContext * render_ctx) {
 
     ID3D12CommandList * cmd_lists [] = {render_ctx->direct_cmd_list};
     render_ctx->cmd_queue->ExecuteCommandLists(ARRAY_COUNT(cmd_lists), cmd_lists);
-
+    UploadRing_Submit(&render_ctx->upload_ring, render_ctx->cmd_queue);
 
     render_ctx->swapchain->Present(1 /*sync interval*/, 0 /*present flag*/);
 
@@ -1794,11 +1800,19 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     // Waves Initial Setup
     uint32_t const nrow = 256;
     uint32_t const ncols = 256;
-    uint32_t const N_VTX = nrow * ncols;
     size_t wave_size = Waves_CalculateRequiredSize(nrow, ncols);
     BYTE * wave_memory = (BYTE *)::malloc(wave_size);
     Waves * waves = Waves_Init(wave_memory, nrow, ncols, 1.0f, 0.03f, 4.0f, 0.2f);
 
+    // Terrain Initial Setup
+    size_t terrain_size = Terrain_CalculateRequiredSize(TERRAIN_LOD_COUNT, TERRAIN_MAX_CHUNKS);
+    BYTE * terrain_memory = (BYTE *)::malloc(terrain_size);
+    render_ctx->terrain = Terrain_Init(
+        terrain_memory, TERRAIN_LOD_COUNT, TERRAIN_MAX_CHUNKS,
+        TERRAIN_WORLD_SIZE, TERRAIN_GRID_DIM, TERRAIN_LOD0_RANGE,
+        calc_hill_height
+    );
+
     // Query Adapter (PhysicalDevice)
     IDXGIFactory * dxgi_factory = nullptr;
     CHECK_AND_FAIL(CreateDXGIFactory2(dxgiFactoryFlags, IID_PPV_ARGS(&dxgi_factory)));
@@ -1909,49 +1923,106 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
 
 // ========================================================================================================
 #pragma region Load Textures
-    // crate
-    strcpy_s(render_ctx->textures[TEX_CRATE01].name, "woodcrate01");
-    wcscpy_s(render_ctx->textures[TEX_CRATE01].filename, L"../Textures/WoodCrate02.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_CRATE01].filename,
-        &render_ctx->textures[TEX_CRATE01]
-    );
-    // water
-    strcpy_s(render_ctx->textures[TEX_WATER].name, "watertex");
-    wcscpy_s(render_ctx->textures[TEX_WATER].filename, L"../Textures/water1.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_WATER].filename,
-        &render_ctx->textures[TEX_WATER]
-    );
-    // grass
-    strcpy_s(render_ctx->textures[TEX_GRASS].name, "grasstex");
-    wcscpy_s(render_ctx->textures[TEX_GRASS].filename, L"../Textures/grass.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_GRASS].filename,
-        &render_ctx->textures[TEX_GRASS]
-    );
-    // wire_fence
-    strcpy_s(render_ctx->textures[TEX_WIREFENCE].name, "wirefencetex");
-    wcscpy_s(render_ctx->textures[TEX_WIREFENCE].filename, L"../Textures/WireFence.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_WIREFENCE].filename,
-        &render_ctx->textures[TEX_WIREFENCE]
-    );
-    // tree_array
-    strcpy_s(render_ctx->textures[TEX_TREEARRAY].name, "treearraytex");
-    wcscpy_s(render_ctx->textures[TEX_TREEARRAY].filename, L"../Textures/treeArray2.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_TREEARRAY].filename,
-        &render_ctx->textures[TEX_TREEARRAY]
-    );
-#pragma endregion
-
+    struct {
+        TEX_INDEX           index;
+        char const *        name;
+        wchar_t const *     filename;
+    } const texture_table [] = {
+        {TEX_CRATE01, "woodcrate01", L"../Textures/WoodCrate02.dds"},
+        {TEX_WATER, "watertex", L"../Textures/water1.dds"},
+        {TEX_GRASS, "grasstex", L"../Textures/grass.dds"},
+        {TEX_WIREFENCE, "wirefencetex", L"../Textures/WireFence.dds"},
+        {TEX_TREEARRAY, "treearraytex", L"../Textures/treeArray2.dds"},
+    };
+    static_assert(_countof(texture_table) == _COUNT_TEX, "Missing texture table entries");
+    wchar_t const * texture_paths[_COUNT_TEX];
+    int texture_entries[_COUNT_TEX];
+    for (UINT i = 0; i < _countof(texture_table); ++i) {
+        strcpy_s(render_ctx->textures[texture_table[i].index].name, texture_table[i].name);
+        wcscpy_s(render_ctx->textures[texture_table[i].index].filename, texture_table[i].filename);
+        texture_paths[i] = texture_table[i].filename;
+    }
+    // -- all textures are read in parallel and uploaded through the ring, identical images are loaded once
+    if (!UploadRing_Init(&render_ctx->upload_ring, render_ctx->device, UPLOAD_RING_SIZE)) {
+        ::printf("[ERROR] UploadRing_Init() failed at line %d. \n", __LINE__);
+        ::abort();
+    }
     create_descriptor_heaps(render_ctx);
+    TextureRegistry_Init(&render_ctx->texture_registry, render_ctx->device, render_ctx->srv_heap, 0, _COUNT_TEX);
+    if (!TextureBatch_Load(
+        render_ctx->device, render_ctx->direct_cmd_list, render_ctx->cmd_queue, render_ctx->direct_cmd_list_alloc, &render_ctx->texture_registry,
+        texture_paths, _COUNT_TEX, 0, DDS_LOADER_DEFAULT, texture_entries, &render_ctx->upload_ring
+    ))
+        printf("some textures could not be loaded\n");
+    for (UINT i = 0; i < _countof(texture_table); ++i) {
+        int entry = texture_entries[i];
+        render_ctx->texture_entries[texture_table[i].index] = entry;
+        render_ctx->textures[texture_table[i].index].resource = entry >= 0 ? render_ctx->texture_registry.entries[entry].resource : nullptr;
+    }
+
+    // -- materials sample texture arrays (one per size and format), the tree sprites an atlas of the tree images,
+    // so draws switch descriptor tables only between the shared textures
+    struct {
+        TEX_INDEX           index;
+        SHARED_TEX_INDEX    shared;
+    } const material_textures [] = {
+        {TEX_CRATE01, SHARED_TEX_MATERIALS},
+        {TEX_GRASS, SHARED_TEX_MATERIALS},
+        {TEX_WIREFENCE, SHARED_TEX_MATERIALS},
+        {TEX_WATER, SHARED_TEX_WATER},
+    };
+    UINT texture_srvs[_COUNT_TEX] = {};
+    UINT texture_slices[_COUNT_TEX] = {};
+    bool assembled = true;
+    for (UINT shared = SHARED_TEX_MATERIALS; shared <= SHARED_TEX_WATER; ++shared) {
+        TextureAssemblerImage images[_countof(material_textures)];
+        TextureAssemblerRegion regions[_countof(material_textures)];
+        TEX_INDEX indices[_countof(material_textures)];
+        UINT n_images = 0;
+        for (UINT i = 0; i < _countof(material_textures); ++i) {
+            if (material_textures[i].shared == shared) {
+                indices[n_images] = material_textures[i].index;
+                images[n_images++] = {render_ctx->textures[material_textures[i].index].resource, 0};
+            }
+        }
+        assembled = TextureAssembler_BuildArray(
+            render_ctx->device, render_ctx->direct_cmd_list, images, n_images, &render_ctx->shared_textures[shared], regions
+        ) && assembled;
+        for (UINT i = 0; i < n_images; ++i) {
+            texture_srvs[indices[i]] = _COUNT_TEX + shared;
+            texture_slices[indices[i]] = regions[i].slice;
+        }
+    }
+    ID3D12Resource * tree_array = render_ctx->textures[TEX_TREEARRAY].resource;
+    if (tree_array) {
+        TextureAssemblerImage images[MAX_TREE_IMAGES];
+        TextureAssemblerRegion regions[MAX_TREE_IMAGES];
+        UINT n_slices = tree_array->GetDesc().DepthOrArraySize;
+        render_ctx->n_tree_images = n_slices < MAX_TREE_IMAGES ? n_slices : MAX_TREE_IMAGES;
+        for (UINT i = 0; i < render_ctx->n_tree_images; ++i)
+            images[i] = {tree_array, i};
+        if (TextureAssembler_BuildAtlas(
+            render_ctx->device, render_ctx->direct_cmd_list, images, render_ctx->n_tree_images, D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION,
+            &render_ctx->shared_textures[SHARED_TEX_TREES], regions
+        )) {
+            for (UINT i = 0; i < render_ctx->n_tree_images; ++i)
+                render_ctx->tree_uv_transforms[i] = regions[i].uv_transform;
+        } else {
+            render_ctx->n_tree_images = 0;
+        }
+    }
+    texture_srvs[TEX_TREEARRAY] = _COUNT_TEX + SHARED_TEX_TREES;
+    assembled = assembled && render_ctx->n_tree_images > 0;
+    if (!assembled)
+        printf("some textures could not be assembled\n");
+    for (UINT i = 0; i < _COUNT_SHARED_TEX; ++i) {
+        if (render_ctx->shared_textures[i]) {
+            D3D12_CPU_DESCRIPTOR_HANDLE srv_handle = render_ctx->srv_heap->GetCPUDescriptorHandleForHeapStart();
+            srv_handle.ptr += (SIZE_T)render_ctx->cbv_srv_uav_descriptor_size * (_COUNT_TEX + i);
+            TextureAssembler_CreateSrv(render_ctx->device, render_ctx->shared_textures[i], SHARED_TEX_TREES != i, srv_handle);
+        }
+    }
+#pragma endregion
 
 #pragma region Dsv_Creation
 // Create the depth/stencil buffer and view.
@@ -2020,11 +2091,9 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     }
 #pragma endregion
 
-#pragma region Create CBuffers and Dynamic Vertex Buffer (waves_vb)
+#pragma region Create CBuffers
     UINT obj_cb_size = sizeof(ObjectConstants);
     UINT mat_cb_size = sizeof(MaterialConstants);
-    UINT pass_cb_size = sizeof(PassConstants);
-    UINT vertex_size = sizeof(Vertex);
     for (UINT i = 0; i < NUM_QUEUING_FRAMES; ++i) {
         // -- create a cmd-allocator for each frame
         res = render_ctx->device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE::D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&render_ctx->frame_resources[i].cmd_list_alloc));
@@ -2038,13 +2107,7 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
         // Initialize cb data
         ::memcpy(render_ctx->frame_resources[i].mat_cb_data_ptr, &render_ctx->frame_resources[i].mat_cb_data, sizeof(render_ctx->frame_resources[i].mat_cb_data));
 
-        create_upload_buffer(render_ctx->device, pass_cb_size * 1, &render_ctx->frame_resources[i].pass_cb_data_ptr, &render_ctx->frame_resources[i].pass_cb);
-        // Initialize cb data
-        ::memcpy(render_ctx->frame_resources[i].pass_cb_data_ptr, &render_ctx->frame_resources[i].pass_cb_data, sizeof(render_ctx->frame_resources[i].pass_cb_data));
-
-        create_upload_buffer(render_ctx->device, (UINT64)vertex_size * N_VTX, &render_ctx->frame_resources[i].waves_vb_data_ptr, &render_ctx->frame_resources[i].waves_vb);
-        // Initialize cb data
-        ::memcpy(render_ctx->frame_resources[i].waves_vb_data_ptr, &render_ctx->frame_resources[i].waves_vb_data, sizeof(render_ctx->frame_resources[i].waves_vb_data));
+        // -- pass constants, waves vertices and terrain instances are allocated from the upload ring every frame
     }
 #pragma endregion
 
@@ -2074,6 +2137,7 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     IDxcBlob * vertex_shader_code = nullptr;
     IDxcBlob * pixel_shader_code_opaque = nullptr;
     IDxcBlob * pixel_shader_code_alphatest = nullptr;
+    IDxcBlob * vertex_shader_code_terrain = nullptr;
     IDxcBlob * vertex_shader_code_tree = nullptr;
     IDxcBlob * geo_shader_code_tree = nullptr;
     IDxcBlob * pixel_shader_code_tree = nullptr;
@@ -2102,6 +2166,9 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
             hr = dxc_compiler->Compile(shader_blob, shaders_path, L"PixelShader_Main", L"ps_6_0", nullptr, 0, defines_alphatest, n_define_alphatest, include_handler, &dxc_res);
             dxc_res->GetStatus(&hr);
             dxc_res->GetResult(&pixel_shader_code_alphatest);
+            hr = dxc_compiler->Compile(shader_blob, shaders_path, L"TerrainVertexShader_Main", L"vs_6_0", nullptr, 0, nullptr, 0, include_handler, &dxc_res);
+            dxc_res->GetStatus(&hr);
+            dxc_res->GetResult(&vertex_shader_code_terrain);
             if (FAILED(hr)) {
                 if (dxc_res) {
                     IDxcBlobEncoding * errorsBlob = nullptr;
@@ -2152,6 +2219,7 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     _ASSERT_EXPR(vertex_shader_code, "invalid shader");
     _ASSERT_EXPR(pixel_shader_code_opaque, "invalid shader");
     _ASSERT_EXPR(pixel_shader_code_alphatest, "invalid shader");
+    _ASSERT_EXPR(vertex_shader_code_terrain, "invalid shader");
     _ASSERT_EXPR(vertex_shader_code_tree, "invalid shader");
     _ASSERT_EXPR(geo_shader_code_tree, "invalid shader");
     _ASSERT_EXPR(pixel_shader_code_tree, "invalid shader");
@@ -2166,16 +2234,17 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
         pixel_shader_code_alphatest,
         vertex_shader_code_tree,
         geo_shader_code_tree,
-        pixel_shader_code_tree
+        pixel_shader_code_tree,
+        vertex_shader_code_terrain
     );
 #pragma endregion PSO_Creation
 
 #pragma region Shapes_And_Renderitem_Creation
-    create_land_geometry(render_ctx);
+    create_terrain_geometry(render_ctx);
     create_water_geometry(waves->nrow, waves->ncol, waves->ntri, render_ctx);
     create_treesprites_geometry(render_ctx);
     create_shape_geometry(render_ctx);
-    create_materials(render_ctx->materials);
+    create_materials(texture_srvs, texture_slices, render_ctx->materials);
     create_render_items(
         &render_ctx->all_ritems,
         &render_ctx->opaque_ritems,
@@ -2199,6 +2268,7 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     CHECK_AND_FAIL(render_ctx->direct_cmd_list->Close());
     ID3D12CommandList * cmd_lists [] = {render_ctx->direct_cmd_list};
     render_ctx->cmd_queue->ExecuteCommandLists(ARRAY_COUNT(cmd_lists), cmd_lists);
+    UploadRing_Submit(&render_ctx->upload_ring, render_ctx->cmd_queue);
 
     //----------------
     // Create fence
@@ -2220,6 +2290,13 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     // we just want to wait for setup to complete before continuing.
     flush_command_queue(render_ctx);
 
+    // -- the loaded textures were only copied into the shared ones
+    for (unsigned i = 0; i < _COUNT_TEX; i++) {
+        TextureRegistry_Release(&render_ctx->texture_registry, render_ctx->texture_entries[i]);
+        render_ctx->texture_entries[i] = -1;
+        render_ctx->textures[i].resource = nullptr;
+    }
+
 #pragma endregion
 
 #pragma region Imgui Setup
@@ -2231,10 +2308,10 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
 
     // calculate imgui cpu & gpu handles on location on srv_heap
     D3D12_CPU_DESCRIPTOR_HANDLE imgui_cpu_handle = render_ctx->srv_heap->GetCPUDescriptorHandleForHeapStart();
-    imgui_cpu_handle.ptr += (render_ctx->cbv_srv_uav_descriptor_size * _COUNT_TEX);
+    imgui_cpu_handle.ptr += (render_ctx->cbv_srv_uav_descriptor_size * (_COUNT_TEX + _COUNT_SHARED_TEX));
 
     D3D12_GPU_DESCRIPTOR_HANDLE imgui_gpu_handle = render_ctx->srv_heap->GetGPUDescriptorHandleForHeapStart();
-    imgui_gpu_handle.ptr += (render_ctx->cbv_srv_uav_descriptor_size * _COUNT_TEX);
+    imgui_gpu_handle.ptr += (render_ctx->cbv_srv_uav_descriptor_size * (_COUNT_TEX + _COUNT_SHARED_TEX));
 
     // Setup Platform/Renderer backends
     ImGui_ImplWin32_Init(hwnd);
@@ -2294,6 +2371,13 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
         static int i_curr = 0;
         ImGui::Combo("Box Material", &i_curr, "   Wood\0   Wire-fenced\0\0");
 
+        ImGui::Text("Terrain: %u chunks (%u nodes visited)", render_ctx->terrain->selection_count, render_ctx->terrain->visited_nodes);
+        static double terrain_select_us = 0.0;
+        if (ImGui::Button("Benchmark Terrain Selection"))   // no culling (worst case), 1000 runs
+            terrain_select_us = Terrain_BenchmarkSelect(render_ctx->terrain, global_scene_ctx.eye_pos, nullptr, 1000);
+        ImGui::SameLine();
+        ImGui::Text("%.2f us/selection", terrain_select_us);
+
         ImGui::Text("\n\n");
         ImGui::Separator();
         ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
@@ -2311,6 +2395,7 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
         update_mat_cbuffers(render_ctx);
         update_pass_cbuffers(render_ctx, &global_timer);
         update_waves_vb(waves, render_ctx, &global_timer);
+        update_terrain_chunks(render_ctx->terrain, &global_scene_ctx, render_ctx);
 
         CHECK_AND_FAIL(draw_main(render_ctx));
         CHECK_AND_FAIL(move_to_next_frame(render_ctx, &render_ctx->frame_index, &render_ctx->backbuffer_index));
@@ -2341,21 +2426,14 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     for (size_t i = 0; i < NUM_QUEUING_FRAMES; i++) {
         render_ctx->frame_resources[i].obj_cb->Unmap(0, nullptr);
         render_ctx->frame_resources[i].mat_cb->Unmap(0, nullptr);
-        render_ctx->frame_resources[i].pass_cb->Unmap(0, nullptr);
-        render_ctx->frame_resources[i].waves_vb->Unmap(0, nullptr);
         render_ctx->frame_resources[i].obj_cb->Release();
         render_ctx->frame_resources[i].mat_cb->Release();
-        render_ctx->frame_resources[i].pass_cb->Release();
-        render_ctx->frame_resources[i].waves_vb->Release();
 
         render_ctx->frame_resources[i].cmd_list_alloc->Release();
     }
     for (unsigned i = 0; i < _COUNT_GEOM; i++) {
-        render_ctx->geom[i].ib_uploader->Release();
-        if (i != GEOM_WATER) {    // water uses a dynamic vb
-            render_ctx->geom[i].vb_uploader->Release();
+        if (i != GEOM_WATER)    // water uses a dynamic vb (in the upload ring)
             render_ctx->geom[i].vb_gpu->Release();
-        }
         render_ctx->geom[i].ib_gpu->Release();
     }   // is this a bug in d3d12sdklayers.dll ?
 
@@ -2368,6 +2446,7 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     vertex_shader_code_tree->Release();
     pixel_shader_code_alphatest->Release();
     pixel_shader_code_opaque->Release();
+    vertex_shader_code_terrain->Release();
     vertex_shader_code->Release();
 
     render_ctx->root_signature->Release();
@@ -2383,10 +2462,11 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
 
     render_ctx->depth_stencil_buffer->Release();
 
-    for (unsigned i = 0; i < _COUNT_TEX; i++) {
-        render_ctx->textures[i].upload_heap->Release();
-        render_ctx->textures[i].resource->Release();
+    for (unsigned i = 0; i < _COUNT_SHARED_TEX; i++) {
+        if (render_ctx->shared_textures[i])
+            render_ctx->shared_textures[i]->Release();
     }
+    UploadRing_Destroy(&render_ctx->upload_ring);
 
     //render_ctx->swapchain3->Release();
     render_ctx->swapchain->Release();
@@ -2396,6 +2476,7 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     render_ctx->device->Release();
     dxgi_factory->Release();
 
+    ::free(terrain_memory);
     ::free(wave_memory);
 
 #if (ENABLE_DEBUG_LAYER > 0)
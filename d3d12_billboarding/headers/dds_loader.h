@@ -11,6 +11,29 @@
 #include <stdint.h>
 #include <assert.h>
 
+#ifndef _WIN32
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// -- SIMD row conversion: SSE2 on every x86/x64 build, the byte shuffles need SSSE3
+// (MSVC always compiles them and checks the CPU at run time, other compilers need -mssse3)
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define DDS_CONVERT_SSE2
+#define DDS_CONVERT_SSSE3
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define DDS_CONVERT_SSE2
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define DDS_CONVERT_SSSE3
+#endif
+#endif
+
 #ifndef DDS_ALPHA_MODE_DEFINED
 #define DDS_ALPHA_MODE_DEFINED
 enum DDS_ALPHA_MODE : uint32_t {
@@ -26,6 +49,7 @@ enum DDS_LOADER_FLAGS {
     DDS_LOADER_DEFAULT      = 0,
     DDS_LOADER_FORCE_SRGB   = 0x1,
     DDS_LOADER_MIP_RESERVE  = 0x8,
+    DDS_LOADER_PREMULTIPLY_ALPHA = 0x10,    // straight alpha 8-bit RGBA/BGRA is premultiplied (callers that convert, see DDS_CONVERSION)
 };
 
 // HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW)
@@ -109,11 +133,193 @@ struct DDS_HEADER_DXT10 {
 
 #pragma pack(pop)
 
+//--------------------------------------------------------------------------------------
+// Format traits: one entry per DXGI_FORMAT, built at compile time so the per-mip
+// queries below are a table lookup (plus arithmetic for the surface layout)
+//--------------------------------------------------------------------------------------
+enum DDS_SURFACE_LAYOUT : uint8_t {
+    DDS_SURFACE_LINEAR  = 0,    // bitsPerPixel per texel
+    DDS_SURFACE_BC      = 1,    // 4x4 blocks of bytesPerElement
+    DDS_SURFACE_PACKED  = 2,    // pairs of texels (4:2:2) in bytesPerElement
+    DDS_SURFACE_PLANAR  = 3,    // luma rows (pairs of texels in bytesPerElement) then half height chroma rows
+    DDS_SURFACE_NV11    = 4,    // 4:1:1, Direct3D counts it as twice the luma rows
+};
+
+struct DDS_FORMAT_TRAITS {
+    uint8_t             bitsPerPixel;       // 0 if the loader doesn't know the format
+    uint8_t             bytesPerElement;    // block/pair size of the non-linear layouts
+    DDS_SURFACE_LAYOUT  layout;
+    uint8_t             planeCount;         // as D3D12_FEATURE_FORMAT_INFO reports it, 0 if unknown
+    bool                depthStencil;
+    DXGI_FORMAT         srgbFormat;         // sRGB twin, or the format itself
+};
+
+#define DDS_FORMAT_TRAITS_COUNT (DXGI_FORMAT_V408 + 1)
+
+struct DDS_FORMAT_TRAITS_TABLE {
+    DDS_FORMAT_TRAITS traits[DDS_FORMAT_TRAITS_COUNT];
+};
+
+template <size_t N>
+constexpr void
+SetFormatBitsPerPixel (DDS_FORMAT_TRAITS_TABLE & table, DXGI_FORMAT const (&formats)[N], uint8_t bpp) {
+    for (size_t i = 0; i < N; ++i) {
+        table.traits[formats[i]].bitsPerPixel = bpp;
+        table.traits[formats[i]].planeCount = 1;
+    }
+}
+template <size_t N>
+constexpr void
+SetFormatLayout (DDS_FORMAT_TRAITS_TABLE & table, DXGI_FORMAT const (&formats)[N], DDS_SURFACE_LAYOUT layout, uint8_t bpe) {
+    for (size_t i = 0; i < N; ++i) {
+        table.traits[formats[i]].layout = layout;
+        table.traits[formats[i]].bytesPerElement = bpe;
+    }
+}
+template <size_t N>
+constexpr void
+SetFormatPlaneCount (DDS_FORMAT_TRAITS_TABLE & table, DXGI_FORMAT const (&formats)[N], uint8_t planes) {
+    for (size_t i = 0; i < N; ++i)
+        table.traits[formats[i]].planeCount = planes;
+}
+constexpr DDS_FORMAT_TRAITS_TABLE
+BuildFormatTraitsTable () {
+    DDS_FORMAT_TRAITS_TABLE table = {};
+    for (UINT i = 0; i < DDS_FORMAT_TRAITS_COUNT; ++i)
+        table.traits[i].srgbFormat = static_cast<DXGI_FORMAT>(i);
+
+    constexpr DXGI_FORMAT bpp128[] = {
+        DXGI_FORMAT_R32G32B32A32_TYPELESS, DXGI_FORMAT_R32G32B32A32_FLOAT, DXGI_FORMAT_R32G32B32A32_UINT, DXGI_FORMAT_R32G32B32A32_SINT,
+    };
+    constexpr DXGI_FORMAT bpp96[] = {
+        DXGI_FORMAT_R32G32B32_TYPELESS, DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R32G32B32_UINT, DXGI_FORMAT_R32G32B32_SINT,
+    };
+    constexpr DXGI_FORMAT bpp64[] = {
+        DXGI_FORMAT_R16G16B16A16_TYPELESS, DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_R16G16B16A16_UNORM, DXGI_FORMAT_R16G16B16A16_UINT,
+        DXGI_FORMAT_R16G16B16A16_SNORM, DXGI_FORMAT_R16G16B16A16_SINT, DXGI_FORMAT_R32G32_TYPELESS, DXGI_FORMAT_R32G32_FLOAT,
+        DXGI_FORMAT_R32G32_UINT, DXGI_FORMAT_R32G32_SINT, DXGI_FORMAT_R32G8X24_TYPELESS, DXGI_FORMAT_D32_FLOAT_S8X24_UINT,
+        DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS, DXGI_FORMAT_X32_TYPELESS_G8X24_UINT, DXGI_FORMAT_Y416, DXGI_FORMAT_Y210,
+        DXGI_FORMAT_Y216,
+    };
+    constexpr DXGI_FORMAT bpp32[] = {
+        DXGI_FORMAT_R10G10B10A2_TYPELESS, DXGI_FORMAT_R10G10B10A2_UNORM, DXGI_FORMAT_R10G10B10A2_UINT, DXGI_FORMAT_R11G11B10_FLOAT,
+        DXGI_FORMAT_R8G8B8A8_TYPELESS, DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, DXGI_FORMAT_R8G8B8A8_UINT,
+        DXGI_FORMAT_R8G8B8A8_SNORM, DXGI_FORMAT_R8G8B8A8_SINT, DXGI_FORMAT_R16G16_TYPELESS, DXGI_FORMAT_R16G16_FLOAT,
+        DXGI_FORMAT_R16G16_UNORM, DXGI_FORMAT_R16G16_UINT, DXGI_FORMAT_R16G16_SNORM, DXGI_FORMAT_R16G16_SINT,
+        DXGI_FORMAT_R32_TYPELESS, DXGI_FORMAT_D32_FLOAT, DXGI_FORMAT_R32_FLOAT, DXGI_FORMAT_R32_UINT,
+        DXGI_FORMAT_R32_SINT, DXGI_FORMAT_R24G8_TYPELESS, DXGI_FORMAT_D24_UNORM_S8_UINT, DXGI_FORMAT_R24_UNORM_X8_TYPELESS,
+        DXGI_FORMAT_X24_TYPELESS_G8_UINT, DXGI_FORMAT_R9G9B9E5_SHAREDEXP, DXGI_FORMAT_R8G8_B8G8_UNORM, DXGI_FORMAT_G8R8_G8B8_UNORM,
+        DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_FORMAT_B8G8R8X8_UNORM, DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM, DXGI_FORMAT_B8G8R8A8_TYPELESS,
+        DXGI_FORMAT_B8G8R8A8_UNORM_SRGB, DXGI_FORMAT_B8G8R8X8_TYPELESS, DXGI_FORMAT_B8G8R8X8_UNORM_SRGB, DXGI_FORMAT_AYUV,
+        DXGI_FORMAT_Y410, DXGI_FORMAT_YUY2,
+    };
+    constexpr DXGI_FORMAT bpp24[] = {
+        DXGI_FORMAT_P010, DXGI_FORMAT_P016, DXGI_FORMAT_V408,
+    };
+    constexpr DXGI_FORMAT bpp16[] = {
+        DXGI_FORMAT_R8G8_TYPELESS, DXGI_FORMAT_R8G8_UNORM, DXGI_FORMAT_R8G8_UINT, DXGI_FORMAT_R8G8_SNORM,
+        DXGI_FORMAT_R8G8_SINT, DXGI_FORMAT_R16_TYPELESS, DXGI_FORMAT_R16_FLOAT, DXGI_FORMAT_D16_UNORM,
+        DXGI_FORMAT_R16_UNORM, DXGI_FORMAT_R16_UINT, DXGI_FORMAT_R16_SNORM, DXGI_FORMAT_R16_SINT,
+        DXGI_FORMAT_B5G6R5_UNORM, DXGI_FORMAT_B5G5R5A1_UNORM, DXGI_FORMAT_A8P8, DXGI_FORMAT_B4G4R4A4_UNORM,
+        DXGI_FORMAT_P208, DXGI_FORMAT_V208,
+    };
+    constexpr DXGI_FORMAT bpp12[] = {
+        DXGI_FORMAT_NV12, DXGI_FORMAT_420_OPAQUE, DXGI_FORMAT_NV11,
+    };
+    constexpr DXGI_FORMAT bpp8[] = {
+        DXGI_FORMAT_R8_TYPELESS, DXGI_FORMAT_R8_UNORM, DXGI_FORMAT_R8_UINT, DXGI_FORMAT_R8_SNORM,
+        DXGI_FORMAT_R8_SINT, DXGI_FORMAT_A8_UNORM, DXGI_FORMAT_BC2_TYPELESS, DXGI_FORMAT_BC2_UNORM,
+        DXGI_FORMAT_BC2_UNORM_SRGB, DXGI_FORMAT_BC3_TYPELESS, DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC3_UNORM_SRGB,
+        DXGI_FORMAT_BC5_TYPELESS, DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_BC5_SNORM, DXGI_FORMAT_BC6H_TYPELESS,
+        DXGI_FORMAT_BC6H_UF16, DXGI_FORMAT_BC6H_SF16, DXGI_FORMAT_BC7_TYPELESS, DXGI_FORMAT_BC7_UNORM,
+        DXGI_FORMAT_BC7_UNORM_SRGB, DXGI_FORMAT_AI44, DXGI_FORMAT_IA44, DXGI_FORMAT_P8,
+    };
+    constexpr DXGI_FORMAT bpp4[] = {
+        DXGI_FORMAT_BC1_TYPELESS, DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC1_UNORM_SRGB,
+        DXGI_FORMAT_BC4_TYPELESS, DXGI_FORMAT_BC4_UNORM, DXGI_FORMAT_BC4_SNORM,
+    };
+    constexpr DXGI_FORMAT bpp1[] = {
+        DXGI_FORMAT_R1_UNORM,
+    };
+    SetFormatBitsPerPixel(table, bpp128, 128);
+    SetFormatBitsPerPixel(table, bpp96, 96);
+    SetFormatBitsPerPixel(table, bpp64, 64);
+    SetFormatBitsPerPixel(table, bpp32, 32);
+    SetFormatBitsPerPixel(table, bpp24, 24);
+    SetFormatBitsPerPixel(table, bpp16, 16);
+    SetFormatBitsPerPixel(table, bpp12, 12);
+    SetFormatBitsPerPixel(table, bpp8, 8);
+    SetFormatBitsPerPixel(table, bpp4, 4);
+    SetFormatBitsPerPixel(table, bpp1, 1);
+
+    constexpr DXGI_FORMAT bc8[] = {
+        DXGI_FORMAT_BC1_TYPELESS, DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC1_UNORM_SRGB,
+        DXGI_FORMAT_BC4_TYPELESS, DXGI_FORMAT_BC4_UNORM, DXGI_FORMAT_BC4_SNORM,
+    };
+    constexpr DXGI_FORMAT bc16[] = {
+        DXGI_FORMAT_BC2_TYPELESS, DXGI_FORMAT_BC2_UNORM, DXGI_FORMAT_BC2_UNORM_SRGB,
+        DXGI_FORMAT_BC3_TYPELESS, DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC3_UNORM_SRGB,
+        DXGI_FORMAT_BC5_TYPELESS, DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_BC5_SNORM,
+        DXGI_FORMAT_BC6H_TYPELESS, DXGI_FORMAT_BC6H_UF16, DXGI_FORMAT_BC6H_SF16,
+        DXGI_FORMAT_BC7_TYPELESS, DXGI_FORMAT_BC7_UNORM, DXGI_FORMAT_BC7_UNORM_SRGB,
+    };
+    constexpr DXGI_FORMAT packed4[] = {DXGI_FORMAT_R8G8_B8G8_UNORM, DXGI_FORMAT_G8R8_G8B8_UNORM, DXGI_FORMAT_YUY2};
+    constexpr DXGI_FORMAT packed8[] = {DXGI_FORMAT_Y210, DXGI_FORMAT_Y216};
+    constexpr DXGI_FORMAT planar2[] = {DXGI_FORMAT_NV12, DXGI_FORMAT_420_OPAQUE, DXGI_FORMAT_P208};
+    constexpr DXGI_FORMAT planar4[] = {DXGI_FORMAT_P010, DXGI_FORMAT_P016};
+    constexpr DXGI_FORMAT nv11[] = {DXGI_FORMAT_NV11};
+    SetFormatLayout(table, bc8, DDS_SURFACE_BC, 8);
+    SetFormatLayout(table, bc16, DDS_SURFACE_BC, 16);
+    SetFormatLayout(table, packed4, DDS_SURFACE_PACKED, 4);
+    SetFormatLayout(table, packed8, DDS_SURFACE_PACKED, 8);
+    SetFormatLayout(table, planar2, DDS_SURFACE_PLANAR, 2);
+    SetFormatLayout(table, planar4, DDS_SURFACE_PLANAR, 4);
+    SetFormatLayout(table, nv11, DDS_SURFACE_NV11, 0);
+
+    // -- depth and stencil are separate planes (so are the formats that alias them), as are video luma/chroma
+    constexpr DXGI_FORMAT planes2[] = {
+        DXGI_FORMAT_R32G8X24_TYPELESS, DXGI_FORMAT_D32_FLOAT_S8X24_UINT, DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS, DXGI_FORMAT_X32_TYPELESS_G8X24_UINT,
+        DXGI_FORMAT_R24G8_TYPELESS, DXGI_FORMAT_D24_UNORM_S8_UINT, DXGI_FORMAT_R24_UNORM_X8_TYPELESS, DXGI_FORMAT_X24_TYPELESS_G8_UINT,
+        DXGI_FORMAT_NV12, DXGI_FORMAT_P010, DXGI_FORMAT_P016, DXGI_FORMAT_420_OPAQUE, DXGI_FORMAT_NV11, DXGI_FORMAT_P208,
+    };
+    constexpr DXGI_FORMAT planes3[] = {DXGI_FORMAT_V208, DXGI_FORMAT_V408};
+    SetFormatPlaneCount(table, planes2, 2);
+    SetFormatPlaneCount(table, planes3, 3);
+
+    constexpr DXGI_FORMAT depth_stencil[] = {
+        DXGI_FORMAT_R32G8X24_TYPELESS, DXGI_FORMAT_D32_FLOAT_S8X24_UINT, DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS, DXGI_FORMAT_X32_TYPELESS_G8X24_UINT,
+        DXGI_FORMAT_D32_FLOAT, DXGI_FORMAT_R24G8_TYPELESS, DXGI_FORMAT_D24_UNORM_S8_UINT, DXGI_FORMAT_R24_UNORM_X8_TYPELESS,
+        DXGI_FORMAT_X24_TYPELESS_G8_UINT, DXGI_FORMAT_D16_UNORM,
+    };
+    for (DXGI_FORMAT f : depth_stencil)
+        table.traits[f].depthStencil = true;
+
+    table.traits[DXGI_FORMAT_R8G8B8A8_UNORM].srgbFormat = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+    table.traits[DXGI_FORMAT_BC1_UNORM].srgbFormat = DXGI_FORMAT_BC1_UNORM_SRGB;
+    table.traits[DXGI_FORMAT_BC2_UNORM].srgbFormat = DXGI_FORMAT_BC2_UNORM_SRGB;
+    table.traits[DXGI_FORMAT_BC3_UNORM].srgbFormat = DXGI_FORMAT_BC3_UNORM_SRGB;
+    table.traits[DXGI_FORMAT_B8G8R8A8_UNORM].srgbFormat = DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+    table.traits[DXGI_FORMAT_B8G8R8X8_UNORM].srgbFormat = DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+    table.traits[DXGI_FORMAT_BC7_UNORM].srgbFormat = DXGI_FORMAT_BC7_UNORM_SRGB;
+    return table;
+}
+inline constexpr DDS_FORMAT_TRAITS_TABLE g_FormatTraits = BuildFormatTraitsTable();
+
+constexpr DDS_FORMAT_TRAITS const &
+GetFormatTraits (DXGI_FORMAT fmt) {
+    // -- formats past the table (e.g., sampler feedback) are unknown, like DXGI_FORMAT_UNKNOWN
+    return (static_cast<UINT>(fmt) < DDS_FORMAT_TRAITS_COUNT) ? g_FormatTraits.traits[fmt] : g_FormatTraits.traits[DXGI_FORMAT_UNKNOWN];
+}
 inline UINT8
 D3D12GetFormatPlaneCount (
     ID3D12Device * pDevice,
     DXGI_FORMAT Format
 ) {
+    UINT8 planes = GetFormatTraits(Format).planeCount;
+    if (planes > 0)
+        return planes;
+
+    // -- not in the table, ask the device
     D3D12_FEATURE_DATA_FORMAT_INFO formatInfo = {Format};
     if (FAILED(pDevice->CheckFeatureSupport(D3D12_FEATURE_FORMAT_INFO, &formatInfo, sizeof(formatInfo)))) {
         return 0;
@@ -124,155 +330,14 @@ D3D12GetFormatPlaneCount (
 //--------------------------------------------------------------------------------------
 // Return the BPP for a particular format
 //--------------------------------------------------------------------------------------
-inline size_t
+constexpr size_t
 BitsPerPixel (DXGI_FORMAT fmt) {
-    switch (fmt) {
-    case DXGI_FORMAT_R32G32B32A32_TYPELESS:
-    case DXGI_FORMAT_R32G32B32A32_FLOAT:
-    case DXGI_FORMAT_R32G32B32A32_UINT:
-    case DXGI_FORMAT_R32G32B32A32_SINT:
-        return 128;
-
-    case DXGI_FORMAT_R32G32B32_TYPELESS:
-    case DXGI_FORMAT_R32G32B32_FLOAT:
-    case DXGI_FORMAT_R32G32B32_UINT:
-    case DXGI_FORMAT_R32G32B32_SINT:
-        return 96;
-
-    case DXGI_FORMAT_R16G16B16A16_TYPELESS:
-    case DXGI_FORMAT_R16G16B16A16_FLOAT:
-    case DXGI_FORMAT_R16G16B16A16_UNORM:
-    case DXGI_FORMAT_R16G16B16A16_UINT:
-    case DXGI_FORMAT_R16G16B16A16_SNORM:
-    case DXGI_FORMAT_R16G16B16A16_SINT:
-    case DXGI_FORMAT_R32G32_TYPELESS:
-    case DXGI_FORMAT_R32G32_FLOAT:
-    case DXGI_FORMAT_R32G32_UINT:
-    case DXGI_FORMAT_R32G32_SINT:
-    case DXGI_FORMAT_R32G8X24_TYPELESS:
-    case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
-    case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
-    case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
-    case DXGI_FORMAT_Y416:
-    case DXGI_FORMAT_Y210:
-    case DXGI_FORMAT_Y216:
-        return 64;
-
-    case DXGI_FORMAT_R10G10B10A2_TYPELESS:
-    case DXGI_FORMAT_R10G10B10A2_UNORM:
-    case DXGI_FORMAT_R10G10B10A2_UINT:
-    case DXGI_FORMAT_R11G11B10_FLOAT:
-    case DXGI_FORMAT_R8G8B8A8_TYPELESS:
-    case DXGI_FORMAT_R8G8B8A8_UNORM:
-    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
-    case DXGI_FORMAT_R8G8B8A8_UINT:
-    case DXGI_FORMAT_R8G8B8A8_SNORM:
-    case DXGI_FORMAT_R8G8B8A8_SINT:
-    case DXGI_FORMAT_R16G16_TYPELESS:
-    case DXGI_FORMAT_R16G16_FLOAT:
-    case DXGI_FORMAT_R16G16_UNORM:
-    case DXGI_FORMAT_R16G16_UINT:
-    case DXGI_FORMAT_R16G16_SNORM:
-    case DXGI_FORMAT_R16G16_SINT:
-    case DXGI_FORMAT_R32_TYPELESS:
-    case DXGI_FORMAT_D32_FLOAT:
-    case DXGI_FORMAT_R32_FLOAT:
-    case DXGI_FORMAT_R32_UINT:
-    case DXGI_FORMAT_R32_SINT:
-    case DXGI_FORMAT_R24G8_TYPELESS:
-    case DXGI_FORMAT_D24_UNORM_S8_UINT:
-    case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
-    case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
-    case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
-    case DXGI_FORMAT_R8G8_B8G8_UNORM:
-    case DXGI_FORMAT_G8R8_G8B8_UNORM:
-    case DXGI_FORMAT_B8G8R8A8_UNORM:
-    case DXGI_FORMAT_B8G8R8X8_UNORM:
-    case DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM:
-    case DXGI_FORMAT_B8G8R8A8_TYPELESS:
-    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
-    case DXGI_FORMAT_B8G8R8X8_TYPELESS:
-    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
-    case DXGI_FORMAT_AYUV:
-    case DXGI_FORMAT_Y410:
-    case DXGI_FORMAT_YUY2:
-        return 32;
-
-    case DXGI_FORMAT_P010:
-    case DXGI_FORMAT_P016:
-    case DXGI_FORMAT_V408:
-        return 24;
-
-    case DXGI_FORMAT_R8G8_TYPELESS:
-    case DXGI_FORMAT_R8G8_UNORM:
-    case DXGI_FORMAT_R8G8_UINT:
-    case DXGI_FORMAT_R8G8_SNORM:
-    case DXGI_FORMAT_R8G8_SINT:
-    case DXGI_FORMAT_R16_TYPELESS:
-    case DXGI_FORMAT_R16_FLOAT:
-    case DXGI_FORMAT_D16_UNORM:
-    case DXGI_FORMAT_R16_UNORM:
-    case DXGI_FORMAT_R16_UINT:
-    case DXGI_FORMAT_R16_SNORM:
-    case DXGI_FORMAT_R16_SINT:
-    case DXGI_FORMAT_B5G6R5_UNORM:
-    case DXGI_FORMAT_B5G5R5A1_UNORM:
-    case DXGI_FORMAT_A8P8:
-    case DXGI_FORMAT_B4G4R4A4_UNORM:
-    case DXGI_FORMAT_P208:
-    case DXGI_FORMAT_V208:
-        return 16;
-
-    case DXGI_FORMAT_NV12:
-    case DXGI_FORMAT_420_OPAQUE:
-    case DXGI_FORMAT_NV11:
-        return 12;
-
-    case DXGI_FORMAT_R8_TYPELESS:
-    case DXGI_FORMAT_R8_UNORM:
-    case DXGI_FORMAT_R8_UINT:
-    case DXGI_FORMAT_R8_SNORM:
-    case DXGI_FORMAT_R8_SINT:
-    case DXGI_FORMAT_A8_UNORM:
-    case DXGI_FORMAT_BC2_TYPELESS:
-    case DXGI_FORMAT_BC2_UNORM:
-    case DXGI_FORMAT_BC2_UNORM_SRGB:
-    case DXGI_FORMAT_BC3_TYPELESS:
-    case DXGI_FORMAT_BC3_UNORM:
-    case DXGI_FORMAT_BC3_UNORM_SRGB:
-    case DXGI_FORMAT_BC5_TYPELESS:
-    case DXGI_FORMAT_BC5_UNORM:
-    case DXGI_FORMAT_BC5_SNORM:
-    case DXGI_FORMAT_BC6H_TYPELESS:
-    case DXGI_FORMAT_BC6H_UF16:
-    case DXGI_FORMAT_BC6H_SF16:
-    case DXGI_FORMAT_BC7_TYPELESS:
-    case DXGI_FORMAT_BC7_UNORM:
-    case DXGI_FORMAT_BC7_UNORM_SRGB:
-    case DXGI_FORMAT_AI44:
-    case DXGI_FORMAT_IA44:
-    case DXGI_FORMAT_P8:
-        return 8;
-
-    case DXGI_FORMAT_R1_UNORM:
-        return 1;
-
-    case DXGI_FORMAT_BC1_TYPELESS:
-    case DXGI_FORMAT_BC1_UNORM:
-    case DXGI_FORMAT_BC1_UNORM_SRGB:
-    case DXGI_FORMAT_BC4_TYPELESS:
-    case DXGI_FORMAT_BC4_UNORM:
-    case DXGI_FORMAT_BC4_SNORM:
-        return 4;
-
-    default:
-        return 0;
-    }
+    return GetFormatTraits(fmt).bitsPerPixel;
 }
 //--------------------------------------------------------------------------------------
 // Get surface information for a particular format
 //--------------------------------------------------------------------------------------
-inline HRESULT
+constexpr HRESULT
 GetSurfaceInfo (
     size_t width,
     size_t height,
@@ -285,71 +350,10 @@ GetSurfaceInfo (
     uint64_t rowBytes = 0;
     uint64_t numRows = 0;
 
-    bool bc = false;
-    bool packed = false;
-    bool planar = false;
-    size_t bpe = 0;
-    switch (fmt) {
-    case DXGI_FORMAT_BC1_TYPELESS:
-    case DXGI_FORMAT_BC1_UNORM:
-    case DXGI_FORMAT_BC1_UNORM_SRGB:
-    case DXGI_FORMAT_BC4_TYPELESS:
-    case DXGI_FORMAT_BC4_UNORM:
-    case DXGI_FORMAT_BC4_SNORM:
-        bc = true;
-        bpe = 8;
-        break;
-
-    case DXGI_FORMAT_BC2_TYPELESS:
-    case DXGI_FORMAT_BC2_UNORM:
-    case DXGI_FORMAT_BC2_UNORM_SRGB:
-    case DXGI_FORMAT_BC3_TYPELESS:
-    case DXGI_FORMAT_BC3_UNORM:
-    case DXGI_FORMAT_BC3_UNORM_SRGB:
-    case DXGI_FORMAT_BC5_TYPELESS:
-    case DXGI_FORMAT_BC5_UNORM:
-    case DXGI_FORMAT_BC5_SNORM:
-    case DXGI_FORMAT_BC6H_TYPELESS:
-    case DXGI_FORMAT_BC6H_UF16:
-    case DXGI_FORMAT_BC6H_SF16:
-    case DXGI_FORMAT_BC7_TYPELESS:
-    case DXGI_FORMAT_BC7_UNORM:
-    case DXGI_FORMAT_BC7_UNORM_SRGB:
-        bc = true;
-        bpe = 16;
-        break;
-
-    case DXGI_FORMAT_R8G8_B8G8_UNORM:
-    case DXGI_FORMAT_G8R8_G8B8_UNORM:
-    case DXGI_FORMAT_YUY2:
-        packed = true;
-        bpe = 4;
-        break;
-
-    case DXGI_FORMAT_Y210:
-    case DXGI_FORMAT_Y216:
-        packed = true;
-        bpe = 8;
-        break;
-
-    case DXGI_FORMAT_NV12:
-    case DXGI_FORMAT_420_OPAQUE:
-    case DXGI_FORMAT_P208:
-        planar = true;
-        bpe = 2;
-        break;
-
-    case DXGI_FORMAT_P010:
-    case DXGI_FORMAT_P016:
-        planar = true;
-        bpe = 4;
-        break;
-
-    default:
-        break;
-    }
-
-    if (bc) {
+    DDS_FORMAT_TRAITS const & traits = GetFormatTraits(fmt);
+    uint64_t bpe = traits.bytesPerElement;
+    switch (traits.layout) {
+    case DDS_SURFACE_BC: {
         uint64_t numBlocksWide = 0;
         if (width > 0) {
             uint64_t _temp =  (uint64_t(width) + 3u) / 4u;
@@ -357,32 +361,37 @@ GetSurfaceInfo (
         }
         uint64_t numBlocksHigh = 0;
         if (height > 0) {
-            uint64_t _temp =  (uint64_t(width) + 3u) / 4u;
+            uint64_t _temp =  (uint64_t(height) + 3u) / 4u;
             numBlocksHigh = 1u < _temp ? _temp : 1u;
         }
         rowBytes = numBlocksWide * bpe;
         numRows = numBlocksHigh;
         numBytes = rowBytes * numBlocksHigh;
-    } else if (packed) {
+    } break;
+    case DDS_SURFACE_PACKED:
         rowBytes = ((uint64_t(width) + 1u) >> 1) * bpe;
         numRows = uint64_t(height);
         numBytes = rowBytes * height;
-    } else if (fmt == DXGI_FORMAT_NV11) {
+        break;
+    case DDS_SURFACE_NV11:
         rowBytes = ((uint64_t(width) + 3u) >> 2) * 4u;
         numRows = uint64_t(height) * 2u; // Direct3D makes this simplifying assumption, although it is larger than the 4:1:1 data
         numBytes = rowBytes * numRows;
-    } else if (planar) {
+        break;
+    case DDS_SURFACE_PLANAR:
         rowBytes = ((uint64_t(width) + 1u) >> 1) * bpe;
         numBytes = (rowBytes * uint64_t(height)) + ((rowBytes * uint64_t(height) + 1u) >> 1);
         numRows = height + ((uint64_t(height) + 1u) >> 1);
-    } else {
-        size_t bpp = BitsPerPixel(fmt);
+        break;
+    default: {
+        size_t bpp = traits.bitsPerPixel;
         if (!bpp)
             return E_INVALIDARG;
 
         rowBytes = (uint64_t(width) * bpp + 7u) / 8u; // round up to nearest byte
         numRows = uint64_t(height);
         numBytes = rowBytes * height;
+    } break;
     }
 
 #if defined(_M_IX86) || defined(_M_ARM) || defined(_M_HYBRID_X86_ARM64)
@@ -406,6 +415,472 @@ GetSurfaceInfo (
     return S_OK;
 }
 //--------------------------------------------------------------------------------------
+constexpr DXGI_FORMAT
+MakeSRGB (DXGI_FORMAT format) {
+    // -- formats past the table have no twin
+    return static_cast<UINT>(format) < DDS_FORMAT_TRAITS_COUNT ? GetFormatTraits(format).srgbFormat : format;
+}
+constexpr bool
+IsDepthStencil (DXGI_FORMAT fmt) {
+    return GetFormatTraits(fmt).depthStencil;
+}
+//--------------------------------------------------------------------------------------
+// Static checks: the table is consistent and gives what the per-format switches it
+// replaced gave (one format per group, plus surface sizes of every layout)
+//--------------------------------------------------------------------------------------
+constexpr bool
+ValidateFormatTraits () {
+    for (UINT i = 0; i < DDS_FORMAT_TRAITS_COUNT; ++i) {
+        DDS_FORMAT_TRAITS const & t = g_FormatTraits.traits[i];
+        if (0 == t.bitsPerPixel) {
+            if (DDS_SURFACE_LINEAR != t.layout || 0 != t.planeCount || t.depthStencil || t.srgbFormat != static_cast<DXGI_FORMAT>(i))
+                return false;
+            continue;
+        }
+        if (0 == t.planeCount || (DDS_SURFACE_BC == t.layout && t.bytesPerElement != t.bitsPerPixel * 2))
+            return false;
+        DDS_FORMAT_TRAITS const & srgb = g_FormatTraits.traits[t.srgbFormat];
+        if (srgb.bitsPerPixel != t.bitsPerPixel || srgb.layout != t.layout || srgb.srgbFormat != t.srgbFormat)
+            return false;
+    }
+    return true;
+}
+constexpr size_t
+GetSurfaceNumBytes (size_t width, size_t height, DXGI_FORMAT fmt) {
+    size_t numBytes = 0;
+    return SUCCEEDED(GetSurfaceInfo(width, height, fmt, &numBytes, nullptr, nullptr)) ? numBytes : 0;
+}
+static_assert(ValidateFormatTraits(), "Inconsistent format traits");
+static_assert(BitsPerPixel(DXGI_FORMAT_R32G32B32A32_FLOAT) == 128 && BitsPerPixel(DXGI_FORMAT_R32G32B32_UINT) == 96, "");
+static_assert(BitsPerPixel(DXGI_FORMAT_R16G16B16A16_FLOAT) == 64 && BitsPerPixel(DXGI_FORMAT_Y216) == 64, "");
+static_assert(BitsPerPixel(DXGI_FORMAT_B8G8R8A8_UNORM_SRGB) == 32 && BitsPerPixel(DXGI_FORMAT_YUY2) == 32, "");
+static_assert(BitsPerPixel(DXGI_FORMAT_P010) == 24 && BitsPerPixel(DXGI_FORMAT_B5G6R5_UNORM) == 16, "");
+static_assert(BitsPerPixel(DXGI_FORMAT_NV12) == 12 && BitsPerPixel(DXGI_FORMAT_BC7_UNORM) == 8, "");
+static_assert(BitsPerPixel(DXGI_FORMAT_BC1_UNORM) == 4 && BitsPerPixel(DXGI_FORMAT_R1_UNORM) == 1, "");
+static_assert(BitsPerPixel(DXGI_FORMAT_UNKNOWN) == 0 && BitsPerPixel(DXGI_FORMAT_A4B4G4R4_UNORM) == 0, "");
+static_assert(MakeSRGB(DXGI_FORMAT_BC3_UNORM) == DXGI_FORMAT_BC3_UNORM_SRGB && MakeSRGB(DXGI_FORMAT_R16_FLOAT) == DXGI_FORMAT_R16_FLOAT, "");
+static_assert(MakeSRGB(DXGI_FORMAT_A4B4G4R4_UNORM) == DXGI_FORMAT_A4B4G4R4_UNORM, "");
+static_assert(IsDepthStencil(DXGI_FORMAT_D24_UNORM_S8_UINT) && !IsDepthStencil(DXGI_FORMAT_R32_FLOAT), "");
+static_assert(GetFormatTraits(DXGI_FORMAT_D32_FLOAT).planeCount == 1 && GetFormatTraits(DXGI_FORMAT_R24G8_TYPELESS).planeCount == 2, "");
+static_assert(GetFormatTraits(DXGI_FORMAT_NV12).planeCount == 2 && GetFormatTraits(DXGI_FORMAT_V408).planeCount == 3, "");
+static_assert(GetSurfaceNumBytes(512, 512, DXGI_FORMAT_BC1_UNORM) == 131072 && GetSurfaceNumBytes(1, 1, DXGI_FORMAT_BC3_UNORM) == 16, "");
+static_assert(GetSurfaceNumBytes(256, 64, DXGI_FORMAT_BC1_UNORM) == 8192, "");    // BC rows come from the height
+static_assert(GetSurfaceNumBytes(5, 3, DXGI_FORMAT_YUY2) == 36 && GetSurfaceNumBytes(8, 4, DXGI_FORMAT_NV12) == 48, "");
+static_assert(GetSurfaceNumBytes(8, 4, DXGI_FORMAT_NV11) == 64 && GetSurfaceNumBytes(9, 1, DXGI_FORMAT_R1_UNORM) == 2, "");
+static_assert(GetSurfaceNumBytes(3, 3, DXGI_FORMAT_R8G8B8A8_UNORM) == 36 && GetSurfaceNumBytes(4, 4, DXGI_FORMAT_UNKNOWN) == 0, "");
+//--------------------------------------------------------------------------------------
+// Copyable footprints computed on the CPU, laid out the way ID3D12Device::GetCopyableFootprints
+// does it: rows D3D12_TEXTURE_DATA_PITCH_ALIGNMENT apart, every subresource starting on
+// D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT and the total excluding the padding after the last row.
+// Nothing is allocated, the caller owns the arrays (see DDS_MAX_SUBRESOURCES)
+//--------------------------------------------------------------------------------------
+// Capacity of the caller storage for the subresources of one texture (the loader rejects textures with more),
+// e.g., a 2D array of 34 slices with full mip chains, or 5 mipped cube maps
+#define DDS_MAX_SUBRESOURCES 512
+
+constexpr uint64_t
+AlignFootprint (uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+// Fills the outputs that aren't null for subresources [firstSubresource, firstSubresource + numSubresources).
+// Planes have formats of their own, multi-plane formats return HRESULT_E_NOT_SUPPORTED (ask the device for those)
+constexpr HRESULT
+ComputeCopyableFootprints (
+    D3D12_RESOURCE_DESC const & desc,
+    UINT firstSubresource,
+    UINT numSubresources,
+    UINT64 baseOffset,
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT * layouts,
+    UINT * numRows,
+    UINT64 * rowSizes,
+    UINT64 * totalBytes
+) {
+    if (totalBytes) {
+        *totalBytes = UINT64_MAX;
+    }
+    if (baseOffset & (D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1)) {
+        return E_INVALIDARG;
+    }
+
+    if (D3D12_RESOURCE_DIMENSION_BUFFER == desc.Dimension) {
+        if (0 != firstSubresource || 1 != numSubresources || desc.Width > UINT32_MAX) {
+            return E_INVALIDARG;
+        }
+        if (layouts) {
+            layouts[0].Offset = baseOffset;
+            layouts[0].Footprint.Format = DXGI_FORMAT_UNKNOWN;
+            layouts[0].Footprint.Width = static_cast<UINT>(desc.Width);
+            layouts[0].Footprint.Height = 1;
+            layouts[0].Footprint.Depth = 1;
+            layouts[0].Footprint.RowPitch = static_cast<UINT>(AlignFootprint(desc.Width, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT));
+        }
+        if (numRows) {
+            numRows[0] = 1;
+        }
+        if (rowSizes) {
+            rowSizes[0] = desc.Width;
+        }
+        if (totalBytes) {
+            *totalBytes = desc.Width;
+        }
+        return S_OK;
+    }
+
+    DDS_FORMAT_TRAITS const & traits = GetFormatTraits(desc.Format);
+    if (traits.planeCount > 1) {
+        return HRESULT_E_NOT_SUPPORTED;
+    }
+    bool const volume = (D3D12_RESOURCE_DIMENSION_TEXTURE3D == desc.Dimension);
+    uint64_t const arraySize = volume ? 1 : desc.DepthOrArraySize;
+    if (0 == desc.MipLevels || 0 == arraySize ||
+        uint64_t(firstSubresource) + numSubresources > desc.MipLevels * arraySize) {
+        return E_INVALIDARG;
+    }
+
+    uint64_t offset = 0;
+    uint64_t total = 0;
+    for (UINT i = 0; i < numSubresources; ++i) {
+        UINT const mip = (firstSubresource + i) % desc.MipLevels;
+        uint64_t const w = (desc.Width >> mip) > 1 ? (desc.Width >> mip) : 1;
+        uint64_t const h = (desc.Height >> mip) > 1 ? (desc.Height >> mip) : 1;
+        uint64_t const d = volume && (desc.DepthOrArraySize >> mip) > 1 ? (desc.DepthOrArraySize >> mip) : 1;
+
+        size_t numBytes = 0;
+        size_t rowBytes = 0;
+        size_t rows = 0;
+        HRESULT hr = GetSurfaceInfo(static_cast<size_t>(w), static_cast<size_t>(h), desc.Format, &numBytes, &rowBytes, &rows);
+        if (FAILED(hr)) {
+            return hr;
+        }
+        uint64_t const rowPitch = AlignFootprint(rowBytes, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+        if (rowPitch > UINT32_MAX) {
+            return HRESULT_E_ARITHMETIC_OVERFLOW;
+        }
+
+        if (layouts) {
+            // -- footprints cover whole blocks (4x4) and whole pairs of texels
+            layouts[i].Offset = baseOffset + offset;
+            layouts[i].Footprint.Format = desc.Format;
+            layouts[i].Footprint.Width = static_cast<UINT>(
+                (DDS_SURFACE_BC == traits.layout) ? AlignFootprint(w, 4) :
+                (DDS_SURFACE_PACKED == traits.layout) ? AlignFootprint(w, 2) : w);
+            layouts[i].Footprint.Height = static_cast<UINT>((DDS_SURFACE_BC == traits.layout) ? AlignFootprint(h, 4) : h);
+            layouts[i].Footprint.Depth = static_cast<UINT>(d);
+            layouts[i].Footprint.RowPitch = static_cast<UINT>(rowPitch);
+        }
+        if (numRows) {
+            numRows[i] = static_cast<UINT>(rows);
+        }
+        if (rowSizes) {
+            rowSizes[i] = rowBytes;
+        }
+
+        total = offset + rowPitch * (rows * d - 1) + rowBytes;
+        offset = AlignFootprint(offset + rowPitch * rows * d, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+    }
+
+    if (totalBytes) {
+        *totalBytes = total;
+    }
+    return S_OK;
+}
+//--------------------------------------------------------------------------------------
+// Static checks: footprints of a few resources against hand computed layouts
+//--------------------------------------------------------------------------------------
+constexpr D3D12_RESOURCE_DESC
+MakeFootprintTestDesc (D3D12_RESOURCE_DIMENSION dim, DXGI_FORMAT fmt, uint64_t width, UINT height, UINT16 depthOrArraySize, UINT16 mips) {
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension = dim;
+    desc.Width = width;
+    desc.Height = height;
+    desc.DepthOrArraySize = depthOrArraySize;
+    desc.MipLevels = mips;
+    desc.Format = fmt;
+    desc.SampleDesc.Count = 1;
+    return desc;
+}
+constexpr bool
+ValidateCopyableFootprints () {
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT layouts[12] = {};
+    UINT rows[12] = {};
+    UINT64 sizes[12] = {};
+    UINT64 total = 0;
+
+    // -- 4x4 RGBA8: 3 padded rows and a tight last row
+    D3D12_RESOURCE_DESC desc = MakeFootprintTestDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8G8B8A8_UNORM, 4, 4, 1, 1);
+    if (FAILED(ComputeCopyableFootprints(desc, 0, 1, 0, layouts, rows, sizes, &total)) ||
+        784 != total || 256 != layouts[0].Footprint.RowPitch || 4 != rows[0] || 16 != sizes[0])
+        return false;
+
+    // -- 512x512 BC1, full chain: block rows, 256-byte pitches from mip 3, 512-byte placement from mip 7
+    desc = MakeFootprintTestDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_BC1_UNORM, 512, 512, 1, 10);
+    if (FAILED(ComputeCopyableFootprints(desc, 0, 10, 0, layouts, rows, sizes, &total)) ||
+        180744 != total || 131072 != layouts[1].Offset || 176128 != layouts[4].Offset ||
+        180224 != layouts[8].Offset || 180736 != layouts[9].Offset ||
+        1024 != layouts[0].Footprint.RowPitch || 256 != layouts[3].Footprint.RowPitch || 128 != rows[0] ||
+        4 != layouts[9].Footprint.Width || 4 != layouts[9].Footprint.Height || 1 != rows[9] || 8 != sizes[9])
+        return false;
+    // -- the same, one mip at a base offset
+    if (FAILED(ComputeCopyableFootprints(desc, 1, 1, 512, layouts, rows, sizes, &total)) ||
+        32768 != total || 512 != layouts[0].Offset || 256 != layouts[0].Footprint.Width)
+        return false;
+
+    // -- 2x2 cube map with 2 mips: subresources go face by face, mips within a face
+    desc = MakeFootprintTestDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8G8B8A8_UNORM, 2, 2, 6, 2);
+    if (FAILED(ComputeCopyableFootprints(desc, 0, 12, 0, layouts, rows, sizes, &total)) ||
+        5636 != total || 3584 != layouts[7].Offset || 1 != layouts[7].Footprint.Width || 2 != layouts[6].Footprint.Width)
+        return false;
+
+    // -- 4x4x4 volume with 2 mips: every slice of a mip is NumRows padded rows
+    desc = MakeFootprintTestDesc(D3D12_RESOURCE_DIMENSION_TEXTURE3D, DXGI_FORMAT_R8_UNORM, 4, 4, 4, 2);
+    if (FAILED(ComputeCopyableFootprints(desc, 0, 2, 0, layouts, rows, sizes, &total)) ||
+        4866 != total || 4096 != layouts[1].Offset || 2 != layouts[1].Footprint.Depth)
+        return false;
+
+    // -- 4:2:2 footprints cover whole pairs of texels
+    desc = MakeFootprintTestDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_YUY2, 5, 3, 1, 1);
+    if (FAILED(ComputeCopyableFootprints(desc, 0, 1, 0, layouts, rows, sizes, &total)) ||
+        524 != total || 6 != layouts[0].Footprint.Width || 12 != sizes[0])
+        return false;
+
+    // -- buffers are one row
+    desc = MakeFootprintTestDesc(D3D12_RESOURCE_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, 1000, 1, 1, 1);
+    if (FAILED(ComputeCopyableFootprints(desc, 0, 1, 0, layouts, rows, sizes, &total)) ||
+        1000 != total || 1024 != layouts[0].Footprint.RowPitch)
+        return false;
+
+    // -- what is left to the device, or invalid
+    desc = MakeFootprintTestDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_NV12, 8, 8, 1, 1);
+    if (HRESULT_E_NOT_SUPPORTED != ComputeCopyableFootprints(desc, 0, 1, 0, layouts, rows, sizes, &total))
+        return false;
+    desc = MakeFootprintTestDesc(D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8G8B8A8_UNORM, 4, 4, 1, 1);
+    if (E_INVALIDARG != ComputeCopyableFootprints(desc, 0, 1, 256, layouts, rows, sizes, &total) || UINT64_MAX != total ||
+        E_INVALIDARG != ComputeCopyableFootprints(desc, 1, 1, 0, layouts, rows, sizes, &total))
+        return false;
+    return true;
+}
+static_assert(ValidateCopyableFootprints(), "Copyable footprints don't match the Direct3D layout");
+//--------------------------------------------------------------------------------------
+// Pixel format conversion: legacy layouts without a usable DXGI format are converted
+// row by row while the caller copies the rows into the upload footprints (no intermediate image).
+// L8 and A8L8 already load as R8_UNORM and R8G8_UNORM, their rows are copied as they are
+//--------------------------------------------------------------------------------------
+enum DDS_CONVERSION : uint32_t {
+    DDS_CONVERSION_NONE = 0,            // rows are copied as they are
+    DDS_CONVERSION_BGR8_TO_RGBA8,       // D3DFMT_R8G8B8 (blue first in memory), opaque
+    DDS_CONVERSION_RGB8_TO_RGBA8,       // 24-bit with red first in memory, opaque
+    DDS_CONVERSION_BGRX8_TO_RGBA8,      // D3DFMT_X8R8G8B8, opaque
+    DDS_CONVERSION_RGBX8_TO_RGBA8,      // D3DFMT_X8B8G8R8, opaque
+    DDS_CONVERSION_A4L4_TO_R8G8,        // D3DFMT_A4L4, luminance to red and alpha to green (like A8L8)
+    DDS_CONVERSION_X1RGB5_TO_BGR5A1,    // D3DFMT_X1R5G5B5, alpha bit set
+    DDS_CONVERSION_X4RGB4_TO_BGRA4,     // D3DFMT_X4R4G4B4, alpha set
+    DDS_CONVERSION_PREMULTIPLY_RGBA8,   // 8-bit RGBA/BGRA with straight alpha, color times alpha in the stored encoding
+};
+
+// Bits per texel of the file's rows, 0 for DDS_CONVERSION_NONE (the rows are in the resource format)
+constexpr size_t
+GetConversionSourceBitsPerPixel (DDS_CONVERSION conversion) {
+    switch (conversion) {
+    case DDS_CONVERSION_BGR8_TO_RGBA8:
+    case DDS_CONVERSION_RGB8_TO_RGBA8:
+        return 24;
+    case DDS_CONVERSION_BGRX8_TO_RGBA8:
+    case DDS_CONVERSION_RGBX8_TO_RGBA8:
+    case DDS_CONVERSION_PREMULTIPLY_RGBA8:
+        return 32;
+    case DDS_CONVERSION_A4L4_TO_R8G8:
+        return 8;
+    case DDS_CONVERSION_X1RGB5_TO_BGR5A1:
+    case DDS_CONVERSION_X4RGB4_TO_BGRA4:
+        return 16;
+    default:
+        return 0;
+    }
+}
+#if defined(DDS_CONVERT_SSSE3)
+inline bool
+CpuHasSSSE3 () {
+#if defined(_MSC_VER)
+    static bool const ret = [] {
+        int info[4];
+        __cpuid(info, 1);
+        return 0 != (info[2] & (1 << 9));
+    }();
+    return ret;
+#else
+    return true;
+#endif
+}
+#endif
+#if defined(DDS_CONVERT_SSE2)
+// Converts the leading texels of a row with SIMD, returns how many it did (the rest is left to the scalar loop)
+inline size_t
+ConvertRowSIMD (DDS_CONVERSION conversion, uint8_t * dst, uint8_t const * src, size_t width) {
+    size_t x = 0;
+    __m128i const opaque32 = _mm_set1_epi32(static_cast<int>(0xff000000));
+    switch (conversion) {
+#if defined(DDS_CONVERT_SSSE3)
+    case DDS_CONVERSION_BGR8_TO_RGBA8:
+    case DDS_CONVERSION_RGB8_TO_RGBA8: {
+        if (!CpuHasSSSE3())
+            break;
+        // -- 16 texels from 3 loads: each 12-byte group is aligned to the bottom of a register and spread to 4 texels
+        __m128i const spread = (DDS_CONVERSION_BGR8_TO_RGBA8 == conversion)
+            ? _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+            : _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        for (; x + 16 <= width; x += 16) {
+            __m128i const * s = reinterpret_cast<__m128i const *>(src + 3 * x);
+            __m128i * d = reinterpret_cast<__m128i *>(dst + 4 * x);
+            __m128i a = _mm_loadu_si128(s + 0);
+            __m128i b = _mm_loadu_si128(s + 1);
+            __m128i c = _mm_loadu_si128(s + 2);
+            _mm_storeu_si128(d + 0, _mm_or_si128(_mm_shuffle_epi8(a, spread), opaque32));
+            _mm_storeu_si128(d + 1, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), spread), opaque32));
+            _mm_storeu_si128(d + 2, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8), spread), opaque32));
+            _mm_storeu_si128(d + 3, _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(c, 4), spread), opaque32));
+        }
+        break;
+    }
+    case DDS_CONVERSION_BGRX8_TO_RGBA8: {
+        if (!CpuHasSSSE3())
+            break;
+        __m128i const swap = _mm_setr_epi8(2, 1, 0, -1, 6, 5, 4, -1, 10, 9, 8, -1, 14, 13, 12, -1);
+        for (; x + 4 <= width; x += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + 4 * x));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 4 * x), _mm_or_si128(_mm_shuffle_epi8(v, swap), opaque32));
+        }
+        break;
+    }
+#endif
+    case DDS_CONVERSION_RGBX8_TO_RGBA8:
+        for (; x + 4 <= width; x += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + 4 * x));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 4 * x), _mm_or_si128(v, opaque32));
+        }
+        break;
+    case DDS_CONVERSION_A4L4_TO_R8G8: {
+        // -- nibbles widened to bytes (n * 17), luminance and alpha interleaved
+        __m128i const low = _mm_set1_epi8(0x0f);
+        for (; x + 16 <= width; x += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + x));
+            __m128i l = _mm_and_si128(v, low);
+            __m128i a = _mm_and_si128(_mm_srli_epi16(v, 4), low);
+            l = _mm_or_si128(l, _mm_slli_epi16(l, 4));
+            a = _mm_or_si128(a, _mm_slli_epi16(a, 4));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * x), _mm_unpacklo_epi8(l, a));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * x + 16), _mm_unpackhi_epi8(l, a));
+        }
+        break;
+    }
+    case DDS_CONVERSION_X1RGB5_TO_BGR5A1:
+    case DDS_CONVERSION_X4RGB4_TO_BGRA4: {
+        __m128i const opaque16 = _mm_set1_epi16(static_cast<short>((DDS_CONVERSION_X1RGB5_TO_BGR5A1 == conversion) ? 0x8000 : 0xf000));
+        for (; x + 8 <= width; x += 8) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + 2 * x));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * x), _mm_or_si128(v, opaque16));
+        }
+        break;
+    }
+    case DDS_CONVERSION_PREMULTIPLY_RGBA8: {
+        // -- 16-bit lanes: (c * a + 128) / 255 rounded, computed as (t + (t >> 8)) >> 8; alpha itself is kept
+        __m128i const zero = _mm_setzero_si128();
+        __m128i const half = _mm_set1_epi16(128);
+        for (; x + 4 <= width; x += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + 4 * x));
+            __m128i lo = _mm_unpacklo_epi8(v, zero);
+            __m128i hi = _mm_unpackhi_epi8(v, zero);
+            __m128i alpha_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            __m128i alpha_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            lo = _mm_add_epi16(_mm_mullo_epi16(lo, alpha_lo), half);
+            hi = _mm_add_epi16(_mm_mullo_epi16(hi, alpha_hi), half);
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+            __m128i color = _mm_packus_epi16(lo, hi);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 4 * x),
+                             _mm_or_si128(_mm_andnot_si128(opaque32, color), _mm_and_si128(v, opaque32)));
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return x;
+}
+#endif
+/*
+    Converts one row of width texels from the file's layout (GetConversionSourceBitsPerPixel) to the resource format.
+    dst and src don't overlap, neither has to be aligned. DDS_CONVERSION_NONE isn't a conversion (the caller copies those rows).
+*/
+inline void
+ConvertRow (DDS_CONVERSION conversion, uint8_t * dst, uint8_t const * src, size_t width) {
+    size_t x = 0;
+#if defined(DDS_CONVERT_SSE2)
+    x = ConvertRowSIMD(conversion, dst, src, width);
+#endif
+    // -- whatever SIMD didn't do: tails, and everything without SSE2/SSSE3
+    switch (conversion) {
+    case DDS_CONVERSION_BGR8_TO_RGBA8:
+        for (; x < width; ++x) {
+            dst[4 * x + 0] = src[3 * x + 2];
+            dst[4 * x + 1] = src[3 * x + 1];
+            dst[4 * x + 2] = src[3 * x + 0];
+            dst[4 * x + 3] = 0xff;
+        }
+        break;
+    case DDS_CONVERSION_RGB8_TO_RGBA8:
+        for (; x < width; ++x) {
+            dst[4 * x + 0] = src[3 * x + 0];
+            dst[4 * x + 1] = src[3 * x + 1];
+            dst[4 * x + 2] = src[3 * x + 2];
+            dst[4 * x + 3] = 0xff;
+        }
+        break;
+    case DDS_CONVERSION_BGRX8_TO_RGBA8:
+        for (; x < width; ++x) {
+            dst[4 * x + 0] = src[4 * x + 2];
+            dst[4 * x + 1] = src[4 * x + 1];
+            dst[4 * x + 2] = src[4 * x + 0];
+            dst[4 * x + 3] = 0xff;
+        }
+        break;
+    case DDS_CONVERSION_RGBX8_TO_RGBA8:
+        for (; x < width; ++x) {
+            dst[4 * x + 0] = src[4 * x + 0];
+            dst[4 * x + 1] = src[4 * x + 1];
+            dst[4 * x + 2] = src[4 * x + 2];
+            dst[4 * x + 3] = 0xff;
+        }
+        break;
+    case DDS_CONVERSION_A4L4_TO_R8G8:
+        for (; x < width; ++x) {
+            dst[2 * x + 0] = static_cast<uint8_t>((src[x] & 0x0f) * 17);
+            dst[2 * x + 1] = static_cast<uint8_t>((src[x] >> 4) * 17);
+        }
+        break;
+    case DDS_CONVERSION_X1RGB5_TO_BGR5A1:
+    case DDS_CONVERSION_X4RGB4_TO_BGRA4: {
+        uint8_t const opaque = (DDS_CONVERSION_X1RGB5_TO_BGR5A1 == conversion) ? 0x80 : 0xf0;
+        for (; x < width; ++x) {
+            dst[2 * x + 0] = src[2 * x + 0];
+            dst[2 * x + 1] = src[2 * x + 1] | opaque;
+        }
+        break;
+    }
+    case DDS_CONVERSION_PREMULTIPLY_RGBA8:
+        for (; x < width; ++x) {
+            uint32_t a = src[4 * x + 3];
+            for (size_t c = 0; c < 3; ++c) {
+                uint32_t t = src[4 * x + c] * a + 128;
+                dst[4 * x + c] = static_cast<uint8_t>((t + (t >> 8)) >> 8);
+            }
+            dst[4 * x + 3] = static_cast<uint8_t>(a);
+        }
+        break;
+    default:
+        break;
+    }
+}
+//--------------------------------------------------------------------------------------
 #define ISBITMASK( r,g,b,a ) ( ddpf.RBitMask == r && ddpf.GBitMask == g && ddpf.BBitMask == b && ddpf.ABitMask == a )
 inline DXGI_FORMAT
 GetDXGIFormat (DDS_PIXELFORMAT const & ddpf) {
@@ -603,54 +1078,107 @@ GetDXGIFormat (DDS_PIXELFORMAT const & ddpf) {
 
     return DXGI_FORMAT_UNKNOWN;
 }
-#undef ISBITMASK
-//--------------------------------------------------------------------------------------
-inline DXGI_FORMAT
-MakeSRGB (DXGI_FORMAT format) {
-    switch (format) {
-    case DXGI_FORMAT_R8G8B8A8_UNORM:
-        return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
-
-    case DXGI_FORMAT_BC1_UNORM:
-        return DXGI_FORMAT_BC1_UNORM_SRGB;
-
-    case DXGI_FORMAT_BC2_UNORM:
-        return DXGI_FORMAT_BC2_UNORM_SRGB;
-
-    case DXGI_FORMAT_BC3_UNORM:
-        return DXGI_FORMAT_BC3_UNORM_SRGB;
-
-    case DXGI_FORMAT_B8G8R8A8_UNORM:
-        return DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
-
-    case DXGI_FORMAT_B8G8R8X8_UNORM:
-        return DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+// Conversion of the legacy layouts that have no DXGI format (or an awkward one), format becomes the one they convert to
+inline DDS_CONVERSION
+GetLegacyConversion (DDS_PIXELFORMAT const & ddpf, DXGI_FORMAT & format) {
+    if (ddpf.flags & DDS_RGB) {
+        switch (ddpf.RGBBitCount) {
+        case 32:
+            if (ISBITMASK(0x00ff0000, 0x0000ff00, 0x000000ff, 0)) {
+                format = DXGI_FORMAT_R8G8B8A8_UNORM;
+                return DDS_CONVERSION_BGRX8_TO_RGBA8;
+            }
+            if (ISBITMASK(0x000000ff, 0x0000ff00, 0x00ff0000, 0)) {
+                format = DXGI_FORMAT_R8G8B8A8_UNORM;
+                return DDS_CONVERSION_RGBX8_TO_RGBA8;
+            }
+            break;
 
-    case DXGI_FORMAT_BC7_UNORM:
-        return DXGI_FORMAT_BC7_UNORM_SRGB;
+        case 24:
+            if (ISBITMASK(0x00ff0000, 0x0000ff00, 0x000000ff, 0)) {
+                format = DXGI_FORMAT_R8G8B8A8_UNORM;
+                return DDS_CONVERSION_BGR8_TO_RGBA8;
+            }
+            if (ISBITMASK(0x000000ff, 0x0000ff00, 0x00ff0000, 0)) {
+                format = DXGI_FORMAT_R8G8B8A8_UNORM;
+                return DDS_CONVERSION_RGB8_TO_RGBA8;
+            }
+            break;
 
-    default:
-        return format;
+        case 16:
+            if (ISBITMASK(0x7c00, 0x03e0, 0x001f, 0)) {
+                format = DXGI_FORMAT_B5G5R5A1_UNORM;
+                return DDS_CONVERSION_X1RGB5_TO_BGR5A1;
+            }
+            if (ISBITMASK(0x0f00, 0x00f0, 0x000f, 0)) {
+                format = DXGI_FORMAT_B4G4R4A4_UNORM;
+                return DDS_CONVERSION_X4RGB4_TO_BGRA4;
+            }
+            break;
+        }
+    } else if ((ddpf.flags & DDS_LUMINANCE) && 8 == ddpf.RGBBitCount) {
+        if (ISBITMASK(0x0f, 0, 0, 0xf0)) {
+            format = DXGI_FORMAT_R8G8_UNORM;
+            return DDS_CONVERSION_A4L4_TO_R8G8;
+        }
     }
+    return DDS_CONVERSION_NONE;
 }
-inline bool
-IsDepthStencil (DXGI_FORMAT fmt) {
-    switch (fmt) {
-    case DXGI_FORMAT_R32G8X24_TYPELESS:
-    case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
-    case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
-    case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
-    case DXGI_FORMAT_D32_FLOAT:
-    case DXGI_FORMAT_R24G8_TYPELESS:
-    case DXGI_FORMAT_D24_UNORM_S8_UINT:
-    case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
-    case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
-    case DXGI_FORMAT_D16_UNORM:
-        return true;
+#undef ISBITMASK
+inline DDS_ALPHA_MODE
+GetAlphaMode (const DDS_HEADER * header) {
+    if (header->ddspf.flags & DDS_FOURCC) {
+        if (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC) {
+            auto d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>(reinterpret_cast<const uint8_t*>(header) + sizeof(DDS_HEADER));
+#pragma warning (disable: 26812)
+            auto mode = static_cast<DDS_ALPHA_MODE>(d3d10ext->miscFlags2 & DDS_MISC_FLAGS2_ALPHA_MODE_MASK);
+#pragma warning (default: 26812)
+            switch (mode) {
+            case DDS_ALPHA_MODE_STRAIGHT:
+            case DDS_ALPHA_MODE_PREMULTIPLIED:
+            case DDS_ALPHA_MODE_OPAQUE:
+            case DDS_ALPHA_MODE_CUSTOM:
+                return mode;
 
-    default:
-        return false;
+            case DDS_ALPHA_MODE_UNKNOWN:
+            default:
+                break;
+            }
+        } else if ((MAKEFOURCC('D', 'X', 'T', '2') == header->ddspf.fourCC)
+                   || (MAKEFOURCC('D', 'X', 'T', '4') == header->ddspf.fourCC)) {
+            return DDS_ALPHA_MODE_PREMULTIPLIED;
+        }
     }
+
+    return DDS_ALPHA_MODE_UNKNOWN;
+}
+/*
+    Conversion the file's rows go through on the way to the upload heap. format is the resource format
+    the headers give (DXGI_FORMAT_UNKNOWN for legacy layouts without one) and becomes the converted format.
+*/
+inline DDS_CONVERSION
+GetDDSConversion (DDS_HEADER const * header, unsigned int loadFlags, DXGI_FORMAT & format) {
+    if (!((header->ddspf.flags & DDS_FOURCC) && (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC))) {
+        DDS_CONVERSION legacy = GetLegacyConversion(header->ddspf, format);
+        if (DDS_CONVERSION_NONE != legacy)
+            return legacy;
+    }
+    if (loadFlags & DDS_LOADER_PREMULTIPLY_ALPHA) {
+        // -- custom alpha isn't coverage, it's left alone like opaque and already premultiplied alpha
+        DDS_ALPHA_MODE alphaMode = GetAlphaMode(header);
+        if (DDS_ALPHA_MODE_STRAIGHT == alphaMode || DDS_ALPHA_MODE_UNKNOWN == alphaMode) {
+            switch (format) {
+            case DXGI_FORMAT_R8G8B8A8_UNORM:
+            case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            case DXGI_FORMAT_B8G8R8A8_UNORM:
+            case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+                return DDS_CONVERSION_PREMULTIPLY_RGBA8;
+            default:
+                break;
+            }
+        }
+    }
+    return DDS_CONVERSION_NONE;
 }
 //--------------------------------------------------------------------------------------
 inline void
@@ -696,6 +1224,7 @@ FillInitData (
     size_t arraySize,
     size_t numberOfPlanes,
     DXGI_FORMAT format,
+    DDS_CONVERSION conversion,
     size_t maxsize,
     size_t bitSize,
     uint8_t const * bitData,
@@ -703,8 +1232,9 @@ FillInitData (
     size_t& theight,
     size_t& tdepth,
     size_t& skipMip,
-    D3D12_SUBRESOURCE_DATA ** initData,
-    UINT n_subresources
+    D3D12_SUBRESOURCE_DATA * initData,
+    size_t maxInitData,
+    size_t& numInitData
 ) {
     if (!bitData) {
         return E_POINTER;
@@ -714,15 +1244,19 @@ FillInitData (
     twidth = 0;
     theight = 0;
     tdepth = 0;
+    numInitData = 0;
 
     size_t NumBytes = 0;
     size_t RowBytes = 0;
     const uint8_t* pEndBits = bitData + bitSize;
 
+    // -- rows that are converted on upload are measured in the file's layout
+    size_t const sourceBitsPerPixel = GetConversionSourceBitsPerPixel(conversion);
+
     // clear memory
-    memset(*initData, 0, n_subresources * sizeof(D3D12_SUBRESOURCE_DATA));
+    memset(initData, 0, maxInitData * sizeof(D3D12_SUBRESOURCE_DATA));
 
-    int _curr = 0;
+    size_t _curr = 0;
 
     for (size_t p = 0; p < numberOfPlanes; ++p) {
         const uint8_t* pSrcBits = bitData;
@@ -732,9 +1266,14 @@ FillInitData (
             size_t h = height;
             size_t d = depth;
             for (size_t i = 0; i < mipCount; i++) {
-                HRESULT hr = GetSurfaceInfo(w, h, format, &NumBytes, &RowBytes, nullptr);
-                if (FAILED(hr))
-                    return hr;
+                if (sourceBitsPerPixel > 0) {
+                    RowBytes = (w * sourceBitsPerPixel + 7) / 8;
+                    NumBytes = RowBytes * h;
+                } else {
+                    HRESULT hr = GetSurfaceInfo(w, h, format, &NumBytes, &RowBytes, nullptr);
+                    if (FAILED(hr))
+                        return hr;
+                }
 
                 if (NumBytes > UINT32_MAX || RowBytes > UINT32_MAX)
                     return HRESULT_E_ARITHMETIC_OVERFLOW;
@@ -755,7 +1294,10 @@ FillInitData (
 
                     AdjustPlaneResource(format, h, p, res);
 
-                    (*initData)[_curr] = res;
+                    if (_curr >= maxInitData) {
+                        return HRESULT_E_NOT_SUPPORTED;
+                    }
+                    initData[_curr] = res;
                     ++_curr;
                 } else if (!j) {
                     // Count number of skipped mipmaps (first item only)
@@ -784,10 +1326,8 @@ FillInitData (
         }
     }
 
-    if (*initData)
-        return S_OK;
-    else
-        return E_FAIL;
+    numInitData = _curr;
+    return _curr > 0 ? S_OK : E_FAIL;
 }
 template <UINT TNameLength>
 inline void
@@ -812,7 +1352,8 @@ CountMips (uint32_t width, uint32_t height) {
     }
     return count;
 }
-HRESULT CreateTextureResource (
+inline HRESULT
+CreateTextureResource (
     ID3D12Device * d3dDevice,
     D3D12_RESOURCE_DIMENSION resDim,
     size_t width,
@@ -868,6 +1409,11 @@ HRESULT CreateTextureResource (
 
     return hr;
 }
+/*
+    Creates the texture and points subresources into bitData. Callers that pass outConversion copy the rows
+    with ConvertRow when it isn't DDS_CONVERSION_NONE (the subresources are in the file's layout then),
+    without it files that need converting aren't supported.
+*/
 inline HRESULT
 CreateTextureFromDDS (
     ID3D12Device * d3dDevice,
@@ -878,11 +1424,16 @@ CreateTextureFromDDS (
     D3D12_RESOURCE_FLAGS resFlags,
     unsigned int loadFlags,
     ID3D12Resource ** texture,
-    D3D12_SUBRESOURCE_DATA ** subresources,
+    D3D12_SUBRESOURCE_DATA (&subresources)[DDS_MAX_SUBRESOURCES],
     UINT * n_subresources,
-    bool * outIsCubeMap
+    bool * outIsCubeMap,
+    DDS_CONVERSION * outConversion = nullptr
 ) {
     HRESULT hr = S_OK;
+    DDS_CONVERSION conversion = DDS_CONVERSION_NONE;
+    if (outConversion) {
+        *outConversion = DDS_CONVERSION_NONE;
+    }
 
     UINT width = header->width;
     UINT height = header->height;
@@ -921,6 +1472,9 @@ CreateTextureFromDDS (
         }
 
         format = d3d10ext->dxgiFormat;
+        if (outConversion) {
+            conversion = GetDDSConversion(header, loadFlags, format);
+        }
 
         switch (d3d10ext->resourceDimension) {
         case D3D12_RESOURCE_DIMENSION_TEXTURE1D:
@@ -956,6 +1510,9 @@ CreateTextureFromDDS (
         resDim = static_cast<D3D12_RESOURCE_DIMENSION>(d3d10ext->resourceDimension);
     } else {
         format = GetDXGIFormat(header->ddspf);
+        if (outConversion) {
+            conversion = GetDDSConversion(header, loadFlags, format);
+        }
 
         if (format == DXGI_FORMAT_UNKNOWN) {
             return HRESULT_E_NOT_SUPPORTED;
@@ -1046,17 +1603,20 @@ CreateTextureFromDDS (
     if (numberOfResources > D3D12_REQ_SUBRESOURCES)
         return E_INVALIDARG;
 
-    *n_subresources = (UINT)numberOfResources;
-    *subresources = (D3D12_SUBRESOURCE_DATA *)::malloc(numberOfResources * sizeof(D3D12_SUBRESOURCE_DATA));
+    // -- the subresources go to the caller's fixed storage
+    *n_subresources = 0;
+    if (numberOfResources > DDS_MAX_SUBRESOURCES)
+        return HRESULT_E_NOT_SUPPORTED;
 
     size_t skipMip = 0;
     size_t twidth = 0;
     size_t theight = 0;
     size_t tdepth = 0;
+    size_t numInitData = 0;
     hr = FillInitData(width, height, depth, mipCount, arraySize,
-                      numberOfPlanes, format,
+                      numberOfPlanes, format, conversion,
                       maxsize, bitSize, bitData,
-                      twidth, theight, tdepth, skipMip, subresources, *n_subresources);
+                      twidth, theight, tdepth, skipMip, subresources, numberOfResources, numInitData);
 
     if (SUCCEEDED(hr)) {
         size_t reservedMips = mipCount;
@@ -1069,18 +1629,15 @@ CreateTextureFromDDS (
                                    format, resFlags, loadFlags, texture);
 
         if (FAILED(hr) && !maxsize && (mipCount > 1)) {
-            // clear memory
-            memset(*subresources, 0, numberOfResources * sizeof(D3D12_SUBRESOURCE_DATA));
-
             maxsize = static_cast<size_t>(
                 (resDim == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
                 ? D3D12_REQ_TEXTURE3D_U_V_OR_W_DIMENSION
                 : D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION);
 
             hr = FillInitData(width, height, depth, mipCount, arraySize,
-                              numberOfPlanes, format,
+                              numberOfPlanes, format, conversion,
                               maxsize, bitSize, bitData,
-                              twidth, theight, tdepth, skipMip, subresources, *n_subresources);
+                              twidth, theight, tdepth, skipMip, subresources, numberOfResources, numInitData);
             if (SUCCEEDED(hr)) {
                 hr = CreateTextureResource(d3dDevice, resDim, twidth, theight, tdepth, mipCount - skipMip, arraySize,
                                            format, resFlags, loadFlags, texture);
@@ -1090,39 +1647,19 @@ CreateTextureFromDDS (
 
     if (FAILED(hr)) {
         // clear memory
-        memset(*subresources, 0, numberOfResources * sizeof(D3D12_SUBRESOURCE_DATA));
-    }
-
-    return hr;
-}
-inline DDS_ALPHA_MODE
-GetAlphaMode (const DDS_HEADER * header) {
-    if (header->ddspf.flags & DDS_FOURCC) {
-        if (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC) {
-            auto d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>(reinterpret_cast<const uint8_t*>(header) + sizeof(DDS_HEADER));
-#pragma warning (disable: 26812)
-            auto mode = static_cast<DDS_ALPHA_MODE>(d3d10ext->miscFlags2 & DDS_MISC_FLAGS2_ALPHA_MODE_MASK);
-#pragma warning (default: 26812)
-            switch (mode) {
-            case DDS_ALPHA_MODE_STRAIGHT:
-            case DDS_ALPHA_MODE_PREMULTIPLIED:
-            case DDS_ALPHA_MODE_OPAQUE:
-            case DDS_ALPHA_MODE_CUSTOM:
-                return mode;
-
-            case DDS_ALPHA_MODE_UNKNOWN:
-            default:
-                break;
-            }
-        } else if ((MAKEFOURCC('D', 'X', 'T', '2') == header->ddspf.fourCC)
-                   || (MAKEFOURCC('D', 'X', 'T', '4') == header->ddspf.fourCC)) {
-            return DDS_ALPHA_MODE_PREMULTIPLIED;
+        memset(subresources, 0, numberOfResources * sizeof(D3D12_SUBRESOURCE_DATA));
+    } else {
+        // -- mips skipped for maxsize aren't in the array
+        *n_subresources = static_cast<UINT>(numInitData);
+        if (outConversion) {
+            *outConversion = conversion;
         }
     }
 
-    return DDS_ALPHA_MODE_UNKNOWN;
+    return hr;
 }
-void SetDebugTextureInfo (
+inline void
+SetDebugTextureInfo (
     const wchar_t* fileName,
     ID3D12Resource** texture
 ) {
@@ -1143,116 +1680,37 @@ void SetDebugTextureInfo (
 #endif
     }
 
+// Validates the DDS headers of a file already in memory and points into it (nothing is copied)
 inline HRESULT
-LoadTextureDataFromFile (
-    wchar_t const * fileName,
-    uint8_t ** ddsData,
+LoadTextureDataFromMemory (
+    uint8_t const * ddsData,
+    size_t len,
     DDS_HEADER const ** header,
     uint8_t const ** bitData,
     size_t * bitSize
 ) {
-    if (!header || !bitData || !bitSize) {
+    if (!ddsData || !header || !bitData || !bitSize) {
         return E_POINTER;
     }
 
     *bitSize = 0;
 
-#ifdef WIN32
-    // open the file
-    HANDLE hFile = CreateFile2(fileName, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
-
-    if (!hFile) {
-        return HRESULT_FROM_WIN32(GetLastError());
-    }
-
-    // Get the file size
-    FILE_STANDARD_INFO fileInfo;
-    if (!GetFileInformationByHandleEx(hFile, FileStandardInfo, &fileInfo, sizeof(fileInfo))) {
-        return HRESULT_FROM_WIN32(GetLastError());
-    }
-
-    // File is too big for 32-bit allocation, so reject read
-    if (fileInfo.EndOfFile.HighPart > 0) {
-        return E_FAIL;
-    }
-
     // Need at least enough data to fill the header and magic number to be a valid DDS
-    if (fileInfo.EndOfFile.LowPart < (sizeof(uint32_t) + sizeof(DDS_HEADER))) {
+    if (len < (sizeof(uint32_t) + sizeof(DDS_HEADER))) {
         return E_FAIL;
     }
 
-    // create enough space for the file data
-    *ddsData = (uint8_t *)::malloc(fileInfo.EndOfFile.LowPart);
-    if (!*ddsData) {
-        return E_OUTOFMEMORY;
-    }
-
-    // read the data in
-    DWORD bytesRead = 0;
-    if (!ReadFile(hFile,
-                  *ddsData,
-                  fileInfo.EndOfFile.LowPart,
-                  &bytesRead,
-                  nullptr
-    )) {
-        ::free(*ddsData);
-        return HRESULT_FROM_WIN32(GetLastError());
-    }
-
-    if (bytesRead < fileInfo.EndOfFile.LowPart) {
-        ::free(*ddsData);
-        return E_FAIL;
-    }
-
-    size_t len = fileInfo.EndOfFile.LowPart;
-
-#else // !WIN32
-    std::ifstream inFile(std::filesystem::path(fileName), std::ios::in | std::ios::binary | std::ios::ate);
-    if (!inFile)
-        return E_FAIL;
-
-    std::streampos fileLen = inFile.tellg();
-    if (!inFile)
-        return E_FAIL;
-
-    // Need at least enough data to fill the header and magic number to be a valid DDS
-    if (fileLen < (sizeof(uint32_t) + sizeof(DDS_HEADER)))
-        return E_FAIL;
-
-    ddsData.reset(new (std::nothrow) uint8_t[size_t(fileLen)]);
-    if (!ddsData)
-        return E_OUTOFMEMORY;
-
-    inFile.seekg(0, std::ios::beg);
-    if (!inFile) {
-        ddsData.reset();
-        return E_FAIL;
-    }
-
-    inFile.read(reinterpret_cast<char*>(ddsData.get()), fileLen);
-    if (!inFile) {
-        ddsData.reset();
-        return E_FAIL;
-    }
-
-    inFile.close();
-
-    size_t len = fileLen;
-#endif
-
-        // DDS files always start with the same magic number ("DDS ")
-    auto dwMagicNumber = *reinterpret_cast<const uint32_t*>(*ddsData);
+    // DDS files always start with the same magic number ("DDS ")
+    auto dwMagicNumber = *reinterpret_cast<const uint32_t*>(ddsData);
     if (dwMagicNumber != DDS_MAGIC) {
-        ::free(*ddsData);
         return E_FAIL;
     }
 
-    auto hdr = reinterpret_cast<const DDS_HEADER*>(*ddsData + sizeof(uint32_t));
+    auto hdr = reinterpret_cast<const DDS_HEADER*>(ddsData + sizeof(uint32_t));
 
     // Verify header to validate DDS file
     if (hdr->size != sizeof(DDS_HEADER) ||
         hdr->ddspf.size != sizeof(DDS_PIXELFORMAT)) {
-        ::free(*ddsData);
         return E_FAIL;
     }
 
@@ -1262,7 +1720,6 @@ LoadTextureDataFromFile (
         (MAKEFOURCC('D', 'X', '1', '0') == hdr->ddspf.fourCC)) {
         // Must be long enough for both headers and magic value
         if (len < (sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10))) {
-            ::free(*ddsData);
             return E_FAIL;
         }
 
@@ -1273,11 +1730,120 @@ LoadTextureDataFromFile (
     *header = hdr;
     auto offset = sizeof(uint32_t) + sizeof(DDS_HEADER)
         + (bDXT10Header ? sizeof(DDS_HEADER_DXT10) : 0);
-    *bitData = *ddsData + offset;
+    *bitData = ddsData + offset;
     *bitSize = len - offset;
 
     return S_OK;
 }
+// Read-only mapping of a whole DDS file, the header and bitData returned by the loaders point into it
+struct DDS_FILE_DATA {
+    uint8_t const * data;
+    size_t          size;
+};
+// Unmaps the file, the header and bitData pointers (and subresources built from them) become invalid
+inline void
+ReleaseTextureData (DDS_FILE_DATA * fileData) {
+    if (fileData && fileData->data) {
+#ifdef _WIN32
+        UnmapViewOfFile(fileData->data);
+#else
+        munmap(const_cast<uint8_t *>(fileData->data), fileData->size);
+#endif
+    }
+    if (fileData) {
+        fileData->data = nullptr;
+        fileData->size = 0;
+    }
+}
+// Maps the file read-only and validates the DDS headers in place (nothing is copied)
+inline HRESULT
+LoadTextureDataFromFile (
+    wchar_t const * fileName,
+    DDS_FILE_DATA * fileData,
+    DDS_HEADER const ** header,
+    uint8_t const ** bitData,
+    size_t * bitSize
+) {
+    if (!fileData || !header || !bitData || !bitSize) {
+        return E_POINTER;
+    }
+
+    fileData->data = nullptr;
+    fileData->size = 0;
+    *bitSize = 0;
+
+#ifdef _WIN32
+    // open the file
+    HANDLE hFile = CreateFile2(fileName, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+    if (INVALID_HANDLE_VALUE == hFile) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    // Get the file size
+    FILE_STANDARD_INFO fileInfo;
+    if (!GetFileInformationByHandleEx(hFile, FileStandardInfo, &fileInfo, sizeof(fileInfo))) {
+        HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+        CloseHandle(hFile);
+        return hr;
+    }
+
+    // Reject files too big for 32-bit sizes or too small to hold the magic number and the header
+    if (fileInfo.EndOfFile.HighPart > 0 ||
+        fileInfo.EndOfFile.LowPart < (sizeof(uint32_t) + sizeof(DDS_HEADER))) {
+        CloseHandle(hFile);
+        return E_FAIL;
+    }
+    size_t len = fileInfo.EndOfFile.LowPart;
+
+    // the view keeps the mapping (and the file) alive until it's unmapped
+    HANDLE hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(hFile);
+    if (!hMapping) {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    void * view = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    HRESULT mapResult = view ? S_OK : HRESULT_FROM_WIN32(GetLastError());
+    CloseHandle(hMapping);
+    if (FAILED(mapResult)) {
+        return mapResult;
+    }
+
+#else // !_WIN32
+    int fd = open(std::filesystem::path(fileName).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return E_FAIL;
+    }
+
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0 || !S_ISREG(fileInfo.st_mode)) {
+        close(fd);
+        return E_FAIL;
+    }
+
+    // Reject files too big for 32-bit sizes or too small to hold the magic number and the header
+    if (uint64_t(fileInfo.st_size) > UINT32_MAX ||
+        size_t(fileInfo.st_size) < (sizeof(uint32_t) + sizeof(DDS_HEADER))) {
+        close(fd);
+        return E_FAIL;
+    }
+    size_t len = size_t(fileInfo.st_size);
+
+    // the mapping stays valid once the descriptor is closed
+    void * view = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == view) {
+        return E_OUTOFMEMORY;
+    }
+#endif
+
+    fileData->data = static_cast<uint8_t const *>(view);
+    fileData->size = len;
+
+    HRESULT hr = LoadTextureDataFromMemory(fileData->data, len, header, bitData, bitSize);
+    if (FAILED(hr))
+        ReleaseTextureData(fileData);
+    return hr;
+}
 inline HRESULT
 LoadDDSTextureFromFileEx (
     ID3D12Device * d3dDevice,
@@ -1286,8 +1852,8 @@ LoadDDSTextureFromFileEx (
     D3D12_RESOURCE_FLAGS resFlags,
     unsigned int loadFlags,
     ID3D12Resource ** texture,
-    uint8_t ** ddsData,
-    D3D12_SUBRESOURCE_DATA ** subresources,
+    DDS_FILE_DATA * ddsData,
+    D3D12_SUBRESOURCE_DATA (&subresources)[DDS_MAX_SUBRESOURCES],
     UINT * n_subresources,
     DDS_ALPHA_MODE * alphaMode,
     bool * isCubeMap
@@ -1339,8 +1905,8 @@ LoadDDSTextureFromFile (
     ID3D12Device * d3dDevice,
     const wchar_t * fileName,
     ID3D12Resource ** texture,
-    uint8_t ** ddsData,
-    D3D12_SUBRESOURCE_DATA ** subresources,
+    DDS_FILE_DATA * ddsData,
+    D3D12_SUBRESOURCE_DATA (&subresources)[DDS_MAX_SUBRESOURCES],
     UINT * n_subresources,
     size_t maxsize = 0,
     DDS_ALPHA_MODE * alphaMode = nullptr,
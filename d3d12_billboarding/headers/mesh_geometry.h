@@ -41,8 +41,8 @@ struct MeshGeometry {
     ID3D12Resource * vb_gpu;
     ID3D12Resource * ib_gpu;
 
-    ID3D12Resource * vb_uploader;
-    ID3D12Resource * ib_uploader;
+    // Where the vertices start in vb_gpu (non-zero for a vb suballocated in a shared buffer)
+    UINT64 vb_offset;
 
     DXGI_FORMAT index_format;
 
@@ -56,7 +56,7 @@ struct MeshGeometry {
 D3D12_VERTEX_BUFFER_VIEW
 Mesh_GetVertexBufferView (MeshGeometry * mesh) {
     D3D12_VERTEX_BUFFER_VIEW vbv;
-    vbv.BufferLocation = mesh->vb_gpu->GetGPUVirtualAddress();
+    vbv.BufferLocation = mesh->vb_gpu->GetGPUVirtualAddress() + mesh->vb_offset;
     vbv.StrideInBytes = mesh->vb_byte_stide;
     vbv.SizeInBytes = mesh->vb_byte_size;
 
@@ -81,7 +81,4 @@ Mesh_Dispose (MeshGeometry * mesh) {
 
     mesh->vb_gpu->Release();
     mesh->ib_gpu->Release();
-
-    mesh->vb_uploader->Release();
-    mesh->ib_uploader->Release();
 }
@@ -10,6 +10,7 @@
 
 #include "common.h"
 #include "mesh_geometry.h"
+#include "dds_loader.h"
 
 #define ARRAY_COUNT(arr)                sizeof(arr)/sizeof(arr[0])
 #define CLAMP_VALUE(val, lb, ub)        ((val) < (lb)) ? (lb) : ((val) > (ub) ? (ub) : (val))
@@ -88,8 +89,9 @@ struct MaterialConstants {
 
     // used in texture mapping
     XMFLOAT4X4  mat_transform;
+    UINT        diffuse_slice;  // slice of the diffuse texture array
 
-    float padding[40];  // Padding so the constant buffer is 256-byte aligned
+    float padding[39];  // Padding so the constant buffer is 256-byte aligned
 };
 static_assert(256 == sizeof(MaterialConstants), "Constant buffer size must be 256b aligned");
 
@@ -104,6 +106,9 @@ struct Material {
     // Index into SRV heap for diffuse texture.
     int diffuse_srvheap_index;
 
+    // Slice of the diffuse texture (materials share texture arrays).
+    int diffuse_slice;
+
     // Index into SRV heap for normal texture.
     int normal_srvheap_index;
 
@@ -136,9 +141,8 @@ struct FrameResource {
 
     // We cannot update a cbuffer until the GPU is done processing the commands
     // that reference it.  So each frame needs their own cbuffers.
-    ID3D12Resource * pass_cb;
-    PassConstants pass_cb_data;
-    uint8_t * pass_cb_data_ptr;
+    // Pass constants of the frame, allocated in the upload ring.
+    D3D12_GPU_VIRTUAL_ADDRESS pass_cb_address;
 
     ID3D12Resource * mat_cb;
     MaterialConstants mat_cb_data;
@@ -148,11 +152,8 @@ struct FrameResource {
     ObjectConstants obj_cb_data;
     uint8_t * obj_cb_data_ptr;
 
-    // We cannot update a dynamic vertex buffer until the GPU is done processing
-    // the commands that reference it.  So each frame needs their own.
-    ID3D12Resource * waves_vb;
-    Vertex waves_vb_data;
-    uint8_t * waves_vb_data_ptr;
+    // Per-instance data of the selected terrain chunks, allocated in the upload ring.
+    D3D12_GPU_VIRTUAL_ADDRESS terrain_chunks_vb_address;
 
     // Fence value to mark commands up to this fence point.  This lets us
     // check if these frame resources are still in use by the GPU.
@@ -259,117 +260,35 @@ create_upload_buffer (ID3D12Device * device, UINT64 total_size, BYTE ** mapped_d
     // NOTE(omid): Keeping things mapped for the lifetime of the resource is okay.
     // (*out_upload_buffer)->Unmap(0, nullptr /*aka full-range*/);
 }
-// Returns required size of a buffer to be used for data upload
-inline UINT64
-get_required_intermediate_size (
-    _In_ ID3D12Resource* dst_resource,
-    _In_range_(0, D3D12_REQ_SUBRESOURCES) UINT first_subresource,
-    _In_range_(0, D3D12_REQ_SUBRESOURCES - first_subresource) UINT n_subresources) {
-    D3D12_RESOURCE_DESC desc = dst_resource->GetDesc();
-    UINT64 required_size = 0;
-
-    ID3D12Device * device;
-    dst_resource->GetDevice(__uuidof(*device), reinterpret_cast<void**>(&device));
-    device->GetCopyableFootprints(&desc, first_subresource, n_subresources, 0, nullptr, nullptr, nullptr, &required_size);
-    device->Release();
-
-    return required_size;
-}
-// Heap-allocating UpdateSubresources implementation
- /*refer to heap-allocating UpdateSubresources implementation in d3dx12.h (towards the end)*/
+// Copyable footprints of a range of subresources, computed on the CPU (the device is only asked for multi-plane formats)
 inline UINT64
-update_subresources_heap (
-    _In_ ID3D12GraphicsCommandList * cmd_list,
-    _In_ ID3D12Resource * dest_resource,
-    _In_ ID3D12Resource * intermediate,
-    UINT64 intermediate_offset,
+get_copyable_footprints (
+    _In_ ID3D12Resource * resource,
     _In_range_(0, D3D12_REQ_SUBRESOURCES) UINT first_subresource,
     _In_range_(0, D3D12_REQ_SUBRESOURCES - first_subresource) UINT n_subresources,
-    _In_reads_(n_subresources) D3D12_SUBRESOURCE_DATA * src_data
+    UINT64 base_offset,
+    _Out_writes_opt_(n_subresources) D3D12_PLACED_SUBRESOURCE_FOOTPRINT * layouts,
+    _Out_writes_opt_(n_subresources) UINT * n_rows,
+    _Out_writes_opt_(n_subresources) UINT64 * row_sizes_in_bytes
 ) {
     UINT64 required_size = 0;
-    UINT64 mem_to_alloc = static_cast<UINT64>(sizeof(D3D12_PLACED_SUBRESOURCE_FOOTPRINT) + sizeof(UINT) + sizeof(UINT64)) * n_subresources;
-    if (mem_to_alloc > SIZE_MAX) {
-        return 0;
-    }
-    void * mem_ptr = HeapAlloc(GetProcessHeap(), 0, static_cast<SIZE_T>(mem_to_alloc));
-    if (mem_ptr == NULL) {
-        return 0;
+    D3D12_RESOURCE_DESC desc = resource->GetDesc();
+    if (HRESULT_E_NOT_SUPPORTED == ComputeCopyableFootprints(desc, first_subresource, n_subresources, base_offset, layouts, n_rows, row_sizes_in_bytes, &required_size)) {
+        ID3D12Device * device;
+        resource->GetDevice(__uuidof(*device), reinterpret_cast<void**>(&device));
+        device->GetCopyableFootprints(&desc, first_subresource, n_subresources, base_offset, layouts, n_rows, row_sizes_in_bytes, &required_size);
+        device->Release();
     }
-    D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts = reinterpret_cast<D3D12_PLACED_SUBRESOURCE_FOOTPRINT*>(mem_ptr);
-    UINT64* row_sizes_in_bytes = reinterpret_cast<UINT64*>(layouts + n_subresources);
-    UINT* n_rows = reinterpret_cast<UINT*>(row_sizes_in_bytes + n_subresources);
-
-    D3D12_RESOURCE_DESC desc = dest_resource->GetDesc();
-    ID3D12Device* device;
-    dest_resource->GetDevice(__uuidof(*device), reinterpret_cast<void**>(&device));
-    device->GetCopyableFootprints(&desc, first_subresource, n_subresources, intermediate_offset, layouts, n_rows, row_sizes_in_bytes, &required_size);
-    device->Release();
-
-#pragma region UpdateSubresources (Heap & Stack)
-    // Minor validation
-    D3D12_RESOURCE_DESC intermediate_desc = intermediate->GetDesc();
-    D3D12_RESOURCE_DESC destination_desc = dest_resource->GetDesc();
-    SIMPLE_ASSERT_FALSE((intermediate_desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER ||
-                         intermediate_desc.Width < required_size + layouts[0].Offset ||
-                         required_size > (SIZE_T) - 1 ||
-                         (destination_desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER &&
-                          (first_subresource != 0 || n_subresources != 1))), "validation failed!");
-
-    BYTE * data;
-    CHECK_AND_FAIL(intermediate->Map(0, NULL, reinterpret_cast<void**>(&data)));
-
-    for (UINT i = 0; i < n_subresources; ++i) {
-        if (row_sizes_in_bytes[i] > (SIZE_T)-1) return 0;
-        D3D12_MEMCPY_DEST dest_data = {data + layouts[i].Offset, layouts[i].Footprint.RowPitch, layouts[i].Footprint.RowPitch * (UINT64)n_rows[i]};
-        // -- Row-by-row memcpy
-        for (UINT z = 0; z < layouts[i].Footprint.Depth; ++z) {
-            BYTE * dest_slice = reinterpret_cast<BYTE*>(dest_data.pData) + dest_data.SlicePitch * z;
-            const BYTE * src_slice = reinterpret_cast<const BYTE*>(src_data[i].pData) + src_data[i].SlicePitch * z;
-            for (UINT y = 0; y < n_rows[i]; ++y) {
-                memcpy(dest_slice + dest_data.RowPitch * y,
-                       src_slice + src_data[i].RowPitch * y,
-                       row_sizes_in_bytes[i]);
-            }
-        }
-
-    }
-    intermediate->Unmap(0, NULL);
-
-    if (destination_desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) {
-
-        // TODO(omid): Do we need D3D12_BOX? 
-        D3D12_BOX src_box = {};
-        src_box.left = UINT(layouts[0].Offset);
-        src_box.top = 0;
-        src_box.front = 0;
-        src_box.right = UINT(layouts[0].Offset + layouts[0].Footprint.Width);
-        src_box.bottom = 1;
-        src_box.back = 1;
-
-        cmd_list->CopyBufferRegion(
-            dest_resource, 0, intermediate, layouts[0].Offset, layouts[0].Footprint.Width);
-    } else {
-        for (UINT i = 0; i < n_subresources; ++i) {
-            D3D12_TEXTURE_COPY_LOCATION loc_dst = {};
-            loc_dst.pResource = dest_resource;
-            loc_dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-            loc_dst.SubresourceIndex = i + first_subresource;
-
-            D3D12_TEXTURE_COPY_LOCATION loc_src = {};
-            loc_src.pResource = intermediate;
-            loc_src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
-            loc_src.PlacedFootprint = layouts[i];
-
-            cmd_list->CopyTextureRegion(&loc_dst, 0, 0, 0, &loc_src, nullptr);
-        }
-    }
-#pragma endregion
-
-    HeapFree(GetProcessHeap(), 0, mem_ptr);
     return required_size;
 }
-
+// Returns required size of a buffer to be used for data upload
+inline UINT64
+get_required_intermediate_size (
+    _In_ ID3D12Resource* dst_resource,
+    _In_range_(0, D3D12_REQ_SUBRESOURCES) UINT first_subresource,
+    _In_range_(0, D3D12_REQ_SUBRESOURCES - first_subresource) UINT n_subresources) {
+    return get_copyable_footprints(dst_resource, first_subresource, n_subresources, 0, nullptr, nullptr, nullptr);
+}
 // Stack-allocating UpdateSubresources
  /*refer to stack-allocating UpdateSubresources implementation in d3dx12.h (towards the end)*/
 template <UINT MAX_SUBRESOURCES>
@@ -386,16 +305,13 @@ update_subresources_stack (
     _ASSERT_EXPR(first_subresource < MAX_SUBRESOURCES, "invalid first_subresource");
     _ASSERT_EXPR(0 < n_subresources && n_subresources <= (MAX_SUBRESOURCES - first_subresource), "invalid n_subresources");
 
-    UINT64 required_size = 0;
     D3D12_PLACED_SUBRESOURCE_FOOTPRINT layouts[MAX_SUBRESOURCES];
     UINT n_rows[MAX_SUBRESOURCES];
     UINT64 row_sizes_in_bytes[MAX_SUBRESOURCES];
 
-    D3D12_RESOURCE_DESC desc = dest_resource->GetDesc();
-    ID3D12Device * device;
-    dest_resource->GetDevice(__uuidof(*device), reinterpret_cast<void**>(&device));
-    device->GetCopyableFootprints(&desc, first_subresource, n_subresources, intermediate_offset, layouts, n_rows, row_sizes_in_bytes, &required_size);
-    device->Release();
+    UINT64 required_size = get_copyable_footprints(
+        dest_resource, first_subresource, n_subresources, intermediate_offset, layouts, n_rows, row_sizes_in_bytes
+    );
 
     // Minor validation
     D3D12_RESOURCE_DESC intermediate_desc = intermediate->GetDesc();
@@ -456,11 +372,27 @@ update_subresources_stack (
     }
     return required_size;
 }
+// UpdateSubresources for a variable number of subresources (textures), footprints on the stack.
+// Up to DDS_MAX_SUBRESOURCES, which holds any texture the dds loader loads
+inline UINT64
+update_subresources (
+    _In_ ID3D12GraphicsCommandList * cmd_list,
+    _In_ ID3D12Resource * dest_resource,
+    _In_ ID3D12Resource * intermediate,
+    UINT64 intermediate_offset,
+    _In_range_(0, DDS_MAX_SUBRESOURCES) UINT first_subresource,
+    _In_range_(0, DDS_MAX_SUBRESOURCES - first_subresource) UINT n_subresources,
+    _In_reads_(n_subresources) D3D12_SUBRESOURCE_DATA * src_data
+) {
+    return update_subresources_stack<DDS_MAX_SUBRESOURCES>(
+        cmd_list, dest_resource, intermediate, intermediate_offset, first_subresource, n_subresources, src_data
+    );
+}
 static void
 create_default_buffer (
     ID3D12Device * device,
     ID3D12GraphicsCommandList * cmd_list,
-    void * init_data,
+    void const * init_data,
     UINT64 byte_size,
     ID3D12Resource ** default_buffer,
     ID3D12Resource ** upload_buffer
@@ -555,76 +487,86 @@ spherical_to_cartesian (float radius, float theta, float phi) {
     );
 }
 
-static void
-create_box (float width, float height, float depth, GeomVertex out_vtx [], uint16_t out_idx []) {
-
-    // Creating Vertices
+// -- fixed primitives are generated at compile time into read-only tables:
+// -- no allocation or repacking at load, the table is passed as is to the upload
+template <typename VertexType, UINT NVtx, UINT NIdx>
+struct StaticGeometry {
+    VertexType  vertices[NVtx];
+    uint16_t    indices[NIdx];
+};
+constexpr void
+set_static_vertex (GeomVertex & v, XMFLOAT3 const & p, XMFLOAT3 const & n, XMFLOAT3 const & t, XMFLOAT2 const & uv) {
+    v.Position = p;
+    v.Normal = n;
+    v.TangentU = t;
+    v.TexC = uv;
+}
+constexpr void
+set_static_vertex (Vertex & v, XMFLOAT3 const & p, XMFLOAT3 const & n, XMFLOAT3 const &, XMFLOAT2 const & uv) {
+    v.position = p;
+    v.normal = n;
+    v.texc = uv;
+}
+// 24 vertices (4 per face, faces don't share normals), 36 indices
+template <typename VertexType>
+constexpr StaticGeometry<VertexType, 24, 36>
+make_box_geometry (float width, float height, float depth) {
+    // unit box: corner signs and texcoords per vertex, normal and tangent per face
+    // face order: front, back, top, bottom, left, right
+    constexpr signed char corners[24][3] = {
+        {-1, -1, -1}, {-1, +1, -1}, {+1, +1, -1}, {+1, -1, -1},
+        {-1, -1, +1}, {+1, -1, +1}, {+1, +1, +1}, {-1, +1, +1},
+        {-1, +1, -1}, {-1, +1, +1}, {+1, +1, +1}, {+1, +1, -1},
+        {-1, -1, -1}, {+1, -1, -1}, {+1, -1, +1}, {-1, -1, +1},
+        {-1, -1, +1}, {-1, +1, +1}, {-1, +1, -1}, {-1, -1, -1},
+        {+1, -1, -1}, {+1, +1, -1}, {+1, +1, +1}, {+1, -1, +1}
+    };
+    constexpr float texcoords[24][2] = {
+        {0.0f, 1.0f}, {0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f},
+        {1.0f, 1.0f}, {0.0f, 1.0f}, {0.0f, 0.0f}, {1.0f, 0.0f},
+        {0.0f, 1.0f}, {0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f},
+        {1.0f, 1.0f}, {0.0f, 1.0f}, {0.0f, 0.0f}, {1.0f, 0.0f},
+        {0.0f, 1.0f}, {0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f},
+        {0.0f, 1.0f}, {0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}
+    };
+    constexpr float normals[6][3] = {
+        {0.0f, 0.0f, -1.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f},
+        {0.0f, -1.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}
+    };
+    constexpr float tangents[6][3] = {
+        {1.0f, 0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f},
+        {-1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, -1.0f}, {0.0f, 0.0f, 1.0f}
+    };
 
     float half_width = 0.5f * width;
     float half_height = 0.5f * height;
     float half_depth = 0.5f * depth;
 
-    // Fill in the front face vertex data.
-    out_vtx[0] = {.Position = {-half_width, -half_height, -half_depth}, .Normal = { 0.0f, 0.0f, -1.0f}, .TangentU = {1.0f, 0.0f, 0.0f}, .TexC = {0.0f, 1.0f}};
-    out_vtx[1] = {.Position = {-half_width, +half_height, -half_depth}, .Normal = { 0.0f, 0.0f, -1.0f}, .TangentU = {1.0f, 0.0f, 0.0f}, .TexC = {0.0f, 0.0f}};
-    out_vtx[2] = {.Position = {+half_width, +half_height, -half_depth}, .Normal = { 0.0f, 0.0f, -1.0f}, .TangentU = {1.0f, 0.0f, 0.0f}, .TexC = {1.0f, 0.0f}};
-    out_vtx[3] = {.Position = {+half_width, -half_height, -half_depth}, .Normal = { 0.0f, 0.0f, -1.0f}, .TangentU = {1.0f, 0.0f, 0.0f}, .TexC = {1.0f, 1.0f}};
-
-    // Fill in the back face vertex data.
-    out_vtx[4] = {.Position = {-half_width, -half_height, +half_depth}, .Normal = { 0.0f, 0.0f, 1.0f}, .TangentU = {-1.0f, 0.0f, 0.0f}, .TexC = {1.0f, 1.0f}};
-    out_vtx[5] = {.Position = {+half_width, -half_height, +half_depth}, .Normal = { 0.0f, 0.0f, 1.0f}, .TangentU = {-1.0f, 0.0f, 0.0f}, .TexC = {0.0f, 1.0f}};
-    out_vtx[6] = {.Position = {+half_width, +half_height, +half_depth}, .Normal = { 0.0f, 0.0f, 1.0f}, .TangentU = {-1.0f, 0.0f, 0.0f}, .TexC = {0.0f, 0.0f}};
-    out_vtx[7] = {.Position = {-half_width, +half_height, +half_depth}, .Normal = { 0.0f, 0.0f, 1.0f}, .TangentU = {-1.0f, 0.0f, 0.0f}, .TexC = {1.0f, 0.0f}};
-
-    // Fill in the top face vertex data.
-    out_vtx[8] = {.Position = {-half_width, +half_height, -half_depth}, .Normal = { 0.0f, 1.0f, 0.0f}, .TangentU = {1.0f, 0.0f, 0.0f}, .TexC = {0.0f, 1.0f}};
-    out_vtx[9] = {.Position = {-half_width, +half_height, +half_depth}, .Normal = { 0.0f, 1.0f, 0.0f}, .TangentU = {1.0f, 0.0f, 0.0f}, .TexC = {0.0f, 0.0f}};
-    out_vtx[10] = {.Position = {+half_width, +half_height, +half_depth}, .Normal = { 0.0f, 1.0f, 0.0f}, .TangentU = {1.0f, 0.0f, 0.0f}, .TexC = {1.0f, 0.0f}};
-    out_vtx[11] = {.Position = {+half_width, +half_height, -half_depth}, .Normal = { 0.0f, 1.0f, 0.0f}, .TangentU = {1.0f, 0.0f, 0.0f}, .TexC = {1.0f, 1.0f}};
-
-    // Fill in the bottom face vertex data.
-    out_vtx[12] = {.Position = {-half_width, -half_height, -half_depth}, .Normal = { 0.0f, -1.0f, 0.0f}, .TangentU = {-1.0f, 0.0f, 0.0f}, .TexC = {1.0f, 1.0f}};
-    out_vtx[13] = {.Position = {+half_width, -half_height, -half_depth}, .Normal = { 0.0f, -1.0f, 0.0f}, .TangentU = {-1.0f, 0.0f, 0.0f}, .TexC = {0.0f, 1.0f}};
-    out_vtx[14] = {.Position = {+half_width, -half_height, +half_depth}, .Normal = { 0.0f, -1.0f, 0.0f}, .TangentU = {-1.0f, 0.0f, 0.0f}, .TexC = {0.0f, 0.0f}};
-    out_vtx[15] = {.Position = {-half_width, -half_height, +half_depth}, .Normal = { 0.0f, -1.0f, 0.0f}, .TangentU = {-1.0f, 0.0f, 0.0f}, .TexC = {1.0f, 0.0f}};
-
-    // Fill in the left face vertex data.
-    out_vtx[16] = {.Position = {-half_width, -half_height, +half_depth}, .Normal = { -1.0f, 0.0f, 0.0f}, .TangentU = {0.0f, 0.0f, -1.0f}, .TexC = {0.0f, 1.0f}};
-    out_vtx[17] = {.Position = {-half_width, +half_height, +half_depth}, .Normal = { -1.0f, 0.0f, 0.0f}, .TangentU = {0.0f, 0.0f, -1.0f}, .TexC = {0.0f, 0.0f}};
-    out_vtx[18] = {.Position = {-half_width, +half_height, -half_depth}, .Normal = { -1.0f, 0.0f, 0.0f}, .TangentU = {0.0f, 0.0f, -1.0f}, .TexC = {1.0f, 0.0f}};
-    out_vtx[19] = {.Position = {-half_width, -half_height, -half_depth}, .Normal = { -1.0f, 0.0f, 0.0f}, .TangentU = {0.0f, 0.0f, -1.0f}, .TexC = {1.0f, 1.0f}};
-
-    // Fill in the right face vertex data.
-    out_vtx[20] = {.Position = {+half_width, -half_height, -half_depth}, .Normal = { 1.0f, 0.0f, 0.0f}, .TangentU = {0.0f, 0.0f, 1.0f}, .TexC = {0.0f, 1.0f}};
-    out_vtx[21] = {.Position = {+half_width, +half_height, -half_depth}, .Normal = { 1.0f, 0.0f, 0.0f}, .TangentU = {0.0f, 0.0f, 1.0f}, .TexC = {0.0f, 0.0f}};
-    out_vtx[22] = {.Position = {+half_width, +half_height, +half_depth}, .Normal = { 1.0f, 0.0f, 0.0f}, .TangentU = {0.0f, 0.0f, 1.0f}, .TexC = {1.0f, 0.0f}};
-    out_vtx[23] = {.Position = {+half_width, -half_height, +half_depth}, .Normal = { 1.0f, 0.0f, 0.0f}, .TangentU = {0.0f, 0.0f, 1.0f}, .TexC = {1.0f, 1.0f}};
-
-    // -- Creating Indices 
-
-    // Fill in the front face index data
-    out_idx[0] = 0; out_idx[1] = 1; out_idx[2] = 2;
-    out_idx[3] = 0; out_idx[4] = 2; out_idx[5] = 3;
-
-    // Fill in the back face index data
-    out_idx[6] = 4; out_idx[7] = 5; out_idx[8] = 6;
-    out_idx[9] = 4; out_idx[10] = 6; out_idx[11] = 7;
-
-    // Fill in the top face index data
-    out_idx[12] = 8; out_idx[13] = 9; out_idx[14] = 10;
-    out_idx[15] = 8; out_idx[16] = 10; out_idx[17] = 11;
-
-    // Fill in the bottom face index data
-    out_idx[18] = 12; out_idx[19] = 13; out_idx[20] = 14;
-    out_idx[21] = 12; out_idx[22] = 14; out_idx[23] = 15;
-
-    // Fill in the left face index data
-    out_idx[24] = 16; out_idx[25] = 17; out_idx[26] = 18;
-    out_idx[27] = 16; out_idx[28] = 18; out_idx[29] = 19;
-
-    // Fill in the right face index data
-    out_idx[30] = 20; out_idx[31] = 21; out_idx[32] = 22;
-    out_idx[33] = 20; out_idx[34] = 22; out_idx[35] = 23;
+    StaticGeometry<VertexType, 24, 36> ret = {};
+    for (int f = 0; f < 6; ++f) {
+        XMFLOAT3 n = XMFLOAT3(normals[f][0], normals[f][1], normals[f][2]);
+        XMFLOAT3 t = XMFLOAT3(tangents[f][0], tangents[f][1], tangents[f][2]);
+        for (int c = 0; c < 4; ++c) {
+            int v = 4 * f + c;
+            XMFLOAT3 p = XMFLOAT3(corners[v][0] * half_width, corners[v][1] * half_height, corners[v][2] * half_depth);
+            set_static_vertex(ret.vertices[v], p, n, t, XMFLOAT2(texcoords[v][0], texcoords[v][1]));
+        }
+        // two triangles per face: (0, 1, 2), (0, 2, 3)
+        constexpr int face_indices[6] = {0, 1, 2, 0, 2, 3};
+        for (int i = 0; i < 6; ++i)
+            ret.indices[6 * f + i] = (uint16_t)(4 * f + face_indices[i]);
+    }
+    return ret;
+}
+// one instance per vertex type and extents, evaluated by the compiler
+template <typename VertexType, float Width, float Height, float Depth>
+inline constexpr StaticGeometry<VertexType, 24, 36> box_geometry = make_box_geometry<VertexType>(Width, Height, Depth);
+
+static void
+create_box (float width, float height, float depth, GeomVertex out_vtx [], uint16_t out_idx []) {
+    StaticGeometry<GeomVertex, 24, 36> box = make_box_geometry<GeomVertex>(width, height, depth);
+    memcpy(out_vtx, box.vertices, sizeof(box.vertices));
+    memcpy(out_idx, box.indices, sizeof(box.indices));
 }
 static void
 create_sphere (float radius, GeomVertex out_vtx [], uint16_t out_idx []) {
@@ -10,7 +10,8 @@
 
 #include "light_utils.hlsl"
 
-Texture2D global_diffuse_map : register(t0);
+// materials share texture arrays, global_diffuse_slice picks theirs
+Texture2DArray global_diffuse_map : register(t0);
 SamplerState global_sam_point_wrap : register(s0);
 SamplerState global_sam_point_clamp : register(s1);
 SamplerState global_sam_linear_wrap : register(s2);
@@ -57,6 +58,7 @@ cbuffer MaterialConstantBuffer : register(b2) {
     float3 global_fresnel_r0;
     float global_roughness;
     float4x4 global_mat_transform;
+    uint global_diffuse_slice;
 };
 
 struct VertexShaderInput {
@@ -90,10 +92,60 @@ VertexShader_Main (VertexShaderInput vin) {
 
     return result;
 }
+// NOTE(omid): Must match TERRAIN_GRID_DIM (d3d_billboarding.cpp)
+#define TERRAIN_GRID_DIM 16.0f
+
+struct TerrainVertexShaderInput {
+    float2 grid_pos : GRIDPOS;          // per-vertex: integer coords on the chunk grid
+    float4 chunk : CHUNK0;              // per-instance: origin_x, origin_z, size, lod
+    float2 morph_range : CHUNK1;        // per-instance: morph_start, morph_end
+};
+float
+calc_hill_height (float x, float z) {
+    return 0.3f * (z * sin(0.1f * x) + x * cos(0.1f * z));
+}
+float3
+calc_hill_normal (float x, float z) {
+    // n = (-df/dx, 1, -df/dz)
+    float3 n = float3(
+        -0.03f * z * cos(0.1f * x) - 0.3f * cos(0.1f * z),
+        1.0f,
+        -0.3f * sin(0.1f * x) + 0.03f * x * sin(0.1f * z)
+    );
+    return normalize(n);
+}
+VertexShaderOutput
+TerrainVertexShader_Main (TerrainVertexShaderInput vin) {
+    VertexShaderOutput result = (VertexShaderOutput) 0.0f;
+
+    float2 chunk_origin = vin.chunk.xy;
+    float quad_size = vin.chunk.z / TERRAIN_GRID_DIM;
+
+    // -- geomorph: odd grid vertices slide onto the coarser (half resolution) grid
+    // as the distance to the eye approaches the end of the chunk lod range
+    float2 pos_xz = chunk_origin + vin.grid_pos * quad_size;
+    float3 approx_pos = float3(pos_xz.x, calc_hill_height(pos_xz.x, pos_xz.y), pos_xz.y);
+    float dist = distance(approx_pos, global_eye_pos_w);
+    float morph = saturate((dist - vin.morph_range.x) / (vin.morph_range.y - vin.morph_range.x));
+    float2 grid_pos = vin.grid_pos - frac(vin.grid_pos * 0.5f) * 2.0f * morph;
+    pos_xz = chunk_origin + grid_pos * quad_size;
+
+    float4 pos_world = float4(pos_xz.x, calc_hill_height(pos_xz.x, pos_xz.y), pos_xz.y, 1.0f);
+    result.pos_world = pos_world.xyz;
+    result.normal_world = calc_hill_normal(pos_xz.x, pos_xz.y);
+    result.pos_homogenous_clip_space = mul(pos_world, global_view_proj);
+
+    // texture tiles the same as the former 320x320 land grid (tex_transform scales it)
+    float2 uv = float2(pos_xz.x, -pos_xz.y) / 320.0f;
+    float4 texc = mul(float4(uv, 0.0f, 1.0f), global_tex_transform);
+    result.texc = mul(texc, global_mat_transform).xy;
+
+    return result;
+}
 float4
 PixelShader_Main (VertexShaderOutput pin) : SV_Target {
     float4 diffuse_albedo =
-        global_diffuse_map.Sample(global_sam_anisotropic_wrap, pin.texc) * global_diffuse_albedo;
+        global_diffuse_map.Sample(global_sam_anisotropic_wrap, float3(pin.texc, global_diffuse_slice)) * global_diffuse_albedo;
 
 #ifdef ALPHA_TEST
     clip(diffuse_albedo.a - 0.1f);
@@ -10,7 +10,8 @@
 
 #include "light_utils.hlsl"
 
-Texture2DArray global_tree_map_array : register(t0);
+// atlas of the tree images, each sprite vertex carries the uv transform of its image
+Texture2D global_tree_atlas : register(t0);
 
 SamplerState global_sam_point_wrap : register(s0);
 SamplerState global_sam_point_clamp : register(s1);
@@ -58,22 +59,24 @@ cbuffer MaterialConstantBuffer : register(b2) {
     float3 global_fresnel_r0;
     float global_roughness;
     float4x4 global_mat_transform;
+    uint global_diffuse_slice;
 };
 
 struct VertexShaderInput {
     float3 pos_world : POSITION;
     float2 size_world : SIZE;
+    float4 uv_transform : UVTRANSFORM;
 };
 struct VertexShaderOutput {
     float3 center_world : Position;
     float2 size_world : SIZE;
+    float4 uv_transform : UVTRANSFORM;
 };
 struct GeoShaderOutput {
     float4 pos_homogenous : SV_Position;
     float3 pos_world : POSITION;
     float3 normal_world : NORMAL;
     float2 texc : TEXCOORD;
-    uint primt_Id : SV_PrimitiveID;
 };
 VertexShaderOutput
 VS_Main (VertexShaderInput vin) {
@@ -82,6 +85,7 @@ VS_Main (VertexShaderInput vin) {
     // just pass data over geo shader
     result.center_world = vin.pos_world;
     result.size_world = vin.size_world;
+    result.uv_transform = vin.uv_transform;
 
     return result;
 }
@@ -89,7 +93,6 @@ VS_Main (VertexShaderInput vin) {
 void
 GS_Main (
     point VertexShaderOutput gin[1],
-    uint prim_id : SV_PrimitiveID,
     inout TriangleStream<GeoShaderOutput> triangle_stream
 ) {
     // compute local coord sys of sprite rel to world space
@@ -125,8 +128,7 @@ GS_Main (
         gout.pos_homogenous = mul(v[i], global_view_proj);
         gout.pos_world = v[i].xyz;
         gout.normal_world = look;
-        gout.texc = texc[i];
-        gout.primt_Id = prim_id;
+        gout.texc = texc[i] * gin[0].uv_transform.xy + gin[0].uv_transform.zw;
         
         triangle_stream.Append(gout);
     }
@@ -135,9 +137,9 @@ GS_Main (
 float4
 PS_Main (GeoShaderOutput pin) : SV_Target {
     
-    float3 uvw = float3(pin.texc, pin.primt_Id % 3);
+    // clamp: wrapping would pull the images on the atlas edges from the opposite edge
     float4 diffuse_albedo =
-        global_tree_map_array.Sample(global_sam_anisotropic_wrap, uvw) * global_diffuse_albedo;
+        global_tree_atlas.Sample(global_sam_anisotropic_clamp, pin.texc) * global_diffuse_albedo;
 
 #ifdef ALPHA_TEST
     clip(diffuse_albedo.a - 0.1f);
@@ -0,0 +1,214 @@
+#include "terrain.h"
+
+#include <float.h>
+#include <chrono>
+
+using namespace DirectX;
+
+enum TERRAIN_SELECT_RESULT {
+    SELECT_CULLED = 0,
+    SELECT_OUT_OF_RANGE = 1,
+    SELECT_DONE = 2,
+};
+
+static int
+nodes_per_side (Terrain * terrain, int lod) {
+    return 1 << (terrain->lod_count - 1 - lod);
+}
+size_t
+Terrain_CalculateRequiredSize (int lod_count, UINT max_selection) {
+    _ASSERT_EXPR(lod_count > 0 && lod_count <= TERRAIN_MAX_LODS, "Invalid terrain lod count");
+    size_t n_nodes = 0;
+    for (int lod = 0; lod < lod_count; ++lod) {
+        size_t n = (size_t)1 << (lod_count - 1 - lod);
+        n_nodes += n * n;
+    }
+    return sizeof(Terrain) + n_nodes * sizeof(TerrainNode) + max_selection * sizeof(TerrainChunkDraw);
+}
+Terrain *
+Terrain_Init (
+    BYTE * memory, int lod_count, UINT max_selection,
+    float world_size, int grid_dim, float lod0_range,
+    TerrainHeightFunc height_func
+) {
+    _ASSERT_EXPR(grid_dim > 1 && grid_dim < 256 && 0 == (grid_dim & 1), "Chunk grid dimension must be even and fit 16-bit indices");
+
+    Terrain * ret = reinterpret_cast<Terrain *>(memory);
+    ret->world_size = world_size;
+    ret->origin_x = -0.5f * world_size;
+    ret->origin_z = -0.5f * world_size;
+    ret->lod_count = lod_count;
+    ret->grid_dim = grid_dim;
+
+    float prev_range = 0.0f;
+    for (int lod = 0; lod < lod_count; ++lod) {
+        ret->lod_ranges[lod] = lod0_range * (float)(1 << lod);
+        ret->morph_starts[lod] = prev_range + (ret->lod_ranges[lod] - prev_range) * TERRAIN_MORPH_START_RATIO;
+        prev_range = ret->lod_ranges[lod];
+    }
+
+    // Setup pointers (arrays)
+    BYTE * ptr = memory + sizeof(Terrain);
+    for (int lod = 0; lod < lod_count; ++lod) {
+        int n = nodes_per_side(ret, lod);
+        ret->nodes[lod] = reinterpret_cast<TerrainNode *>(ptr);
+        ptr += sizeof(TerrainNode) * n * n;
+    }
+    ret->selection = reinterpret_cast<TerrainChunkDraw *>(ptr);
+    ret->selection_count = 0;
+    ret->max_selection = max_selection;
+    ret->visited_nodes = 0;
+
+    // -- leaves: sample the height function on the chunk grid
+    int nleaf = nodes_per_side(ret, 0);
+    float leaf_size = world_size / nleaf;
+    float step = leaf_size / grid_dim;
+    for (int j = 0; j < nleaf; ++j) {
+        for (int i = 0; i < nleaf; ++i) {
+            float x0 = ret->origin_x + i * leaf_size;
+            float z0 = ret->origin_z + j * leaf_size;
+            float min_y = FLT_MAX;
+            float max_y = -FLT_MAX;
+            for (int gz = 0; gz <= grid_dim; ++gz) {
+                for (int gx = 0; gx <= grid_dim; ++gx) {
+                    float y = height_func(x0 + gx * step, z0 + gz * step);
+                    min_y = y < min_y ? y : min_y;
+                    max_y = y > max_y ? y : max_y;
+                }
+            }
+            ret->nodes[0][j * nleaf + i] = {.min_y = min_y, .max_y = max_y};
+        }
+    }
+    // -- parents: merge children bounds
+    for (int lod = 1; lod < lod_count; ++lod) {
+        int n = nodes_per_side(ret, lod);
+        int nc = n * 2;
+        TerrainNode * children = ret->nodes[lod - 1];
+        for (int j = 0; j < n; ++j) {
+            for (int i = 0; i < n; ++i) {
+                TerrainNode c0 = children[(2 * j) * nc + 2 * i];
+                TerrainNode c1 = children[(2 * j) * nc + 2 * i + 1];
+                TerrainNode c2 = children[(2 * j + 1) * nc + 2 * i];
+                TerrainNode c3 = children[(2 * j + 1) * nc + 2 * i + 1];
+                TerrainNode node;
+                node.min_y = fminf(fminf(c0.min_y, c1.min_y), fminf(c2.min_y, c3.min_y));
+                node.max_y = fmaxf(fmaxf(c0.max_y, c1.max_y), fmaxf(c2.max_y, c3.max_y));
+                ret->nodes[lod][j * n + i] = node;
+            }
+        }
+    }
+
+    return ret;
+}
+static bool
+box_intersects_sphere (BoundingBox const & box, XMFLOAT3 const & center, float radius) {
+    // squared distance from the sphere center to the closest point of the box
+    float d2 = 0.0f;
+    float c[3] = {center.x, center.y, center.z};
+    float bc[3] = {box.Center.x, box.Center.y, box.Center.z};
+    float be[3] = {box.Extents.x, box.Extents.y, box.Extents.z};
+    for (int k = 0; k < 3; ++k) {
+        float d = fabsf(c[k] - bc[k]) - be[k];
+        if (d > 0.0f)
+            d2 += d * d;
+    }
+    return d2 <= radius * radius;
+}
+static void
+add_chunk (Terrain * terrain, float x, float z, float size, int lod) {
+    if (terrain->selection_count < terrain->max_selection) {
+        TerrainChunkDraw * chunk = &terrain->selection[terrain->selection_count++];
+        chunk->origin_x = x;
+        chunk->origin_z = z;
+        chunk->size = size;
+        chunk->lod = (float)lod;
+        chunk->morph_start = terrain->morph_starts[lod];
+        chunk->morph_end = terrain->lod_ranges[lod];
+    }
+}
+static TERRAIN_SELECT_RESULT
+select_node (
+    Terrain * terrain, int lod, int nx, int nz,
+    XMFLOAT3 const & eye_pos, BoundingFrustum const * frustum, bool fully_inside
+) {
+    terrain->visited_nodes++;
+
+    int n = nodes_per_side(terrain, lod);
+    float size = terrain->world_size / n;
+    float x0 = terrain->origin_x + nx * size;
+    float z0 = terrain->origin_z + nz * size;
+    TerrainNode node = terrain->nodes[lod][nz * n + nx];
+
+    BoundingBox box;
+    box.Center = XMFLOAT3(x0 + 0.5f * size, 0.5f * (node.min_y + node.max_y), z0 + 0.5f * size);
+    box.Extents = XMFLOAT3(0.5f * size, 0.5f * (node.max_y - node.min_y), 0.5f * size);
+
+    // -- once a node is fully inside the frustum its subtree is too
+    if (frustum && !fully_inside) {
+        ContainmentType containment = frustum->Contains(box);
+        if (DISJOINT == containment)
+            return SELECT_CULLED;
+        fully_inside = (CONTAINS == containment);
+    }
+
+    if (!box_intersects_sphere(box, eye_pos, terrain->lod_ranges[lod]))
+        return SELECT_OUT_OF_RANGE;
+
+    // -- node is within its range but not within the next finer one: draw it as a whole
+    if (0 == lod || !box_intersects_sphere(box, eye_pos, terrain->lod_ranges[lod - 1])) {
+        add_chunk(terrain, x0, z0, size, lod);
+        return SELECT_DONE;
+    }
+
+    // -- otherwise refine; children out of the finer range are still drawn at the child size,
+    // they are fully morphed in the vertex shader (i.e., they look like this node's lod)
+    float child_size = 0.5f * size;
+    for (int k = 0; k < 4; ++k) {
+        int cx = 2 * nx + (k & 1);
+        int cz = 2 * nz + (k >> 1);
+        if (SELECT_OUT_OF_RANGE == select_node(terrain, lod - 1, cx, cz, eye_pos, frustum, fully_inside))
+            add_chunk(terrain, terrain->origin_x + cx * child_size, terrain->origin_z + cz * child_size, child_size, lod - 1);
+    }
+    return SELECT_DONE;
+}
+void
+Terrain_Select (Terrain * terrain, XMFLOAT3 const & eye_pos, BoundingFrustum const * frustum) {
+    terrain->selection_count = 0;
+    terrain->visited_nodes = 0;
+
+    int root_lod = terrain->lod_count - 1;
+    if (SELECT_OUT_OF_RANGE == select_node(terrain, root_lod, 0, 0, eye_pos, frustum, false))
+        add_chunk(terrain, terrain->origin_x, terrain->origin_z, terrain->world_size, root_lod);
+}
+double
+Terrain_BenchmarkSelect (Terrain * terrain, XMFLOAT3 const & eye_pos, BoundingFrustum const * frustum, int n_iterations) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < n_iterations; ++i)
+        Terrain_Select(terrain, eye_pos, frustum);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double total_us = std::chrono::duration<double, std::micro>(end - start).count();
+    return n_iterations > 0 ? total_us / n_iterations : 0.0;
+}
+void
+Terrain_CreateChunkMesh (int grid_dim, XMFLOAT2 out_vtx [], uint16_t out_idx []) {
+    int n = grid_dim + 1;
+    for (int j = 0; j < n; ++j)
+        for (int i = 0; i < n; ++i)
+            out_vtx[j * n + i] = XMFLOAT2((float)i, (float)j);
+
+    // clockwise winding when viewed from above (+y), x to the right and z forward
+    int k = 0;
+    for (int j = 0; j < grid_dim; ++j) {
+        for (int i = 0; i < grid_dim; ++i) {
+            out_idx[k + 0] = (uint16_t)(j * n + i);
+            out_idx[k + 1] = (uint16_t)((j + 1) * n + i);
+            out_idx[k + 2] = (uint16_t)(j * n + i + 1);
+
+            out_idx[k + 3] = (uint16_t)(j * n + i + 1);
+            out_idx[k + 4] = (uint16_t)((j + 1) * n + i);
+            out_idx[k + 5] = (uint16_t)((j + 1) * n + i + 1);
+            k += 6;
+        }
+    }
+}
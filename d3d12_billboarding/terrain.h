@@ -0,0 +1,86 @@
+#pragma once
+#include "headers/common.h"
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+// NOTE(omid): Chunked LOD terrain (CDLOD, [Strugar 2010]).
+// The terrain is an implicit quadtree over a square region. Every node is drawn with
+// the same (grid_dim x grid_dim) chunk mesh scaled to the node size, so each tree level
+// is one LOD. Per frame Terrain_Select() walks the tree from the root and only descends
+// into nodes that are visible and within the next finer LOD range, i.e., it is
+// O(visible nodes) and independent of the terrain size.
+// The vertex shader morphs odd grid vertices onto the coarser grid as the distance
+// approaches the end of a LOD range, so there are no cracks or pops between LODs.
+
+#define TERRAIN_MAX_LODS            12
+#define TERRAIN_MORPH_START_RATIO   0.66f
+
+typedef float (*TerrainHeightFunc)(float x, float z);
+
+// Per-instance data of a selected chunk (fed to the vertex shader as an instance stream).
+struct TerrainChunkDraw {
+    float origin_x;
+    float origin_z;
+    float size;
+    float lod;
+    float morph_start;
+    float morph_end;
+};
+// Height bounds of a quadtree node
+struct TerrainNode {
+    float min_y;
+    float max_y;
+};
+struct Terrain {
+    float world_size;
+    float origin_x;     // min corner of the terrain
+    float origin_z;
+
+    int lod_count;      // tree depth; lod 0 is the finest (leaves), lod_count-1 is the root
+    int grid_dim;       // quads per chunk side
+
+    float lod_ranges[TERRAIN_MAX_LODS];
+    float morph_starts[TERRAIN_MAX_LODS];
+
+    // nodes[lod] is a (n x n) array with n = 1 << (lod_count - 1 - lod)
+    TerrainNode * nodes[TERRAIN_MAX_LODS];
+
+    TerrainChunkDraw *  selection;
+    UINT                selection_count;
+    UINT                max_selection;
+
+    // stats of the last selection
+    UINT                visited_nodes;
+};
+
+size_t
+Terrain_CalculateRequiredSize (int lod_count, UINT max_selection);
+
+/*
+    lod0_range is the view distance covered by the finest LOD, every coarser LOD doubles it.
+    Height bounds are precomputed by sampling height_func at the chunk grid resolution of the leaves.
+*/
+Terrain *
+Terrain_Init (
+    BYTE * memory, int lod_count, UINT max_selection,
+    float world_size, int grid_dim, float lod0_range,
+    TerrainHeightFunc height_func
+);
+
+/*
+    Fills terrain->selection with the chunks to draw this frame.
+    frustum is in world space (pass nullptr to skip culling).
+*/
+void
+Terrain_Select (Terrain * terrain, DirectX::XMFLOAT3 const & eye_pos, DirectX::BoundingFrustum const * frustum);
+
+/*
+    Runs the selection n_iterations times and returns average time per selection (in microseconds).
+    CPU-only; can be used headless to benchmark large terrains.
+*/
+double
+Terrain_BenchmarkSelect (Terrain * terrain, DirectX::XMFLOAT3 const & eye_pos, DirectX::BoundingFrustum const * frustum, int n_iterations);
+
+// Chunk mesh: (grid_dim + 1)^2 vertices of integer grid coordinates, 6 * grid_dim^2 indices
+void
+Terrain_CreateChunkMesh (int grid_dim, DirectX::XMFLOAT2 out_vtx [], uint16_t out_idx []);
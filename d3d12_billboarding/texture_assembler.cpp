@@ -0,0 +1,304 @@
+#include "texture_assembler.h"
+#include "headers/dds_loader.h"
+
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include <imgui/imstb_rectpack.h>
+
+using namespace DirectX;
+
+// -- texels per block side, 0 for formats whose subresources can't be copied into a part of another one
+static UINT
+block_dim (DXGI_FORMAT format) {
+    DDS_FORMAT_TRAITS const & traits = GetFormatTraits(format);
+    if (0 == traits.bitsPerPixel || traits.planeCount > 1 || traits.depthStencil)
+        return 0;
+    if (DDS_SURFACE_BC == traits.layout)
+        return 4;
+    if (DDS_SURFACE_PACKED == traits.layout)
+        return 2;
+    return 1;
+}
+static ID3D12Resource *
+create_texture (ID3D12Device * device, DXGI_FORMAT format, UINT width, UINT height, UINT array_size, UINT mip_count) {
+    D3D12_HEAP_PROPERTIES heap_props = {};
+    heap_props.Type = D3D12_HEAP_TYPE_DEFAULT;
+    heap_props.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    heap_props.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    heap_props.CreationNodeMask = 1;
+    heap_props.VisibleNodeMask = 1;
+
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    desc.Width = width;
+    desc.Height = height;
+    desc.DepthOrArraySize = (UINT16)array_size;
+    desc.MipLevels = (UINT16)mip_count;
+    desc.Format = format;
+    desc.SampleDesc.Count = 1;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    // -- committed resources start zeroed, so atlas gutters are transparent black
+    ID3D12Resource * texture = nullptr;
+    if (FAILED(device->CreateCommittedResource(&heap_props, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&texture))))
+        return nullptr;
+    return texture;
+}
+static void
+set_transition (D3D12_RESOURCE_BARRIER * barrier, ID3D12Resource * resource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after) {
+    barrier->Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier->Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    barrier->Transition.pResource = resource;
+    barrier->Transition.StateBefore = before;
+    barrier->Transition.StateAfter = after;
+    barrier->Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+}
+// -- sources to COPY_SOURCE, mips [0, mip_count) of every image into its region, then everything to PIXEL_SHADER_RESOURCE
+static void
+record_copies (
+    ID3D12GraphicsCommandList * cmd_list,
+    ID3D12Resource * texture, UINT mip_count,
+    TextureAssemblerImage const images [], UINT n_images,
+    TextureAssemblerRegion const regions []
+) {
+    // -- several images can be slices of one resource, it only gets one barrier
+    D3D12_RESOURCE_BARRIER barriers[TEXTURE_ASSEMBLER_MAX_IMAGES + 1];
+    UINT n_sources = 0;
+    for (UINT i = 0; i < n_images; ++i) {
+        if (nullptr == images[i].resource)
+            continue;
+        UINT j = 0;
+        while (j < n_sources && barriers[j].Transition.pResource != images[i].resource)
+            ++j;
+        if (j == n_sources)
+            set_transition(&barriers[n_sources++], images[i].resource, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    }
+    cmd_list->ResourceBarrier(n_sources, barriers);
+
+    for (UINT i = 0; i < n_images; ++i) {
+        if (nullptr == images[i].resource)
+            continue;
+        UINT src_mips = images[i].resource->GetDesc().MipLevels;
+        for (UINT mip = 0; mip < mip_count; ++mip) {
+            D3D12_TEXTURE_COPY_LOCATION loc_dst = {};
+            loc_dst.pResource = texture;
+            loc_dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+            loc_dst.SubresourceIndex = mip + regions[i].slice * mip_count;
+
+            D3D12_TEXTURE_COPY_LOCATION loc_src = {};
+            loc_src.pResource = images[i].resource;
+            loc_src.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+            loc_src.SubresourceIndex = mip + images[i].slice * src_mips;
+
+            cmd_list->CopyTextureRegion(&loc_dst, regions[i].x >> mip, regions[i].y >> mip, 0, &loc_src, nullptr);
+        }
+    }
+
+    for (UINT j = 0; j < n_sources; ++j) {
+        barriers[j].Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_SOURCE;
+        barriers[j].Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    }
+    set_transition(&barriers[n_sources], texture, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    cmd_list->ResourceBarrier(n_sources + 1, barriers);
+}
+bool
+TextureAssembler_PackAtlas (
+    UINT const widths [], UINT const heights [], UINT n_images,
+    UINT align, UINT max_dim,
+    UINT * out_width, UINT * out_height,
+    TextureAssemblerRegion out_regions []
+) {
+    _ASSERT_EXPR(n_images <= TEXTURE_ASSEMBLER_MAX_IMAGES, "too many images for one atlas");
+    if (0 == n_images || 0 == align)
+        return false;
+
+    // -- packing in cells of align texels keeps every rect aligned, the gutter rounds up to whole cells
+    UINT gutter = (TEXTURE_ASSEMBLER_ATLAS_GUTTER + align - 1) / align;
+    UINT max_cells = max_dim / align;
+    stbrp_rect rects[TEXTURE_ASSEMBLER_MAX_IMAGES];
+    UINT64 area = 0;
+    UINT dim = align;
+    for (UINT i = 0; i < n_images; ++i) {
+        _ASSERT_EXPR(0 == widths[i] % align && 0 == heights[i] % align, "atlas image not a multiple of the alignment");
+        rects[i] = {};
+        rects[i].id = (int)i;
+        rects[i].w = (stbrp_coord)(widths[i] / align + gutter);
+        rects[i].h = (stbrp_coord)(heights[i] / align + gutter);
+        area += (UINT64)widths[i] * heights[i];
+        while (dim < widths[i] || dim < heights[i])
+            dim *= 2;
+    }
+    // -- grow from the smallest power of two square that could hold the images, widening before heightening
+    UINT width = dim;
+    UINT height = dim;
+    while ((UINT64)width * height < area) {
+        if (width <= height)
+            width *= 2;
+        else
+            height *= 2;
+    }
+    // -- the target is one gutter wider and taller, images may touch the right and bottom edges
+    stbrp_node * nodes = (stbrp_node *)::malloc(sizeof(stbrp_node) * (max_cells + gutter));
+    bool packed = false;
+    while (!packed && width <= max_dim && height <= max_dim) {
+        stbrp_context context;
+        int n_cells = (int)(width / align + gutter);
+        stbrp_init_target(&context, n_cells, (int)(height / align + gutter), nodes, n_cells);
+        packed = 1 == stbrp_pack_rects(&context, rects, (int)n_images);
+        if (!packed) {
+            if (width <= height)
+                width *= 2;
+            else
+                height *= 2;
+        }
+    }
+    ::free(nodes);
+    if (!packed)
+        return false;
+
+    for (UINT i = 0; i < n_images; ++i) {
+        TextureAssemblerRegion * region = &out_regions[i];
+        region->slice = 0;
+        region->x = (UINT)rects[i].x * align;
+        region->y = (UINT)rects[i].y * align;
+        region->width = widths[i];
+        region->height = heights[i];
+        region->uv_transform = XMFLOAT4(
+            (float)widths[i] / (float)width, (float)heights[i] / (float)height,
+            (float)region->x / (float)width, (float)region->y / (float)height
+        );
+    }
+    *out_width = width;
+    *out_height = height;
+    return true;
+}
+bool
+TextureAssembler_BuildArray (
+    ID3D12Device * device,
+    ID3D12GraphicsCommandList * cmd_list,
+    TextureAssemblerImage const images [], UINT n_images,
+    ID3D12Resource ** out_texture,
+    TextureAssemblerRegion out_regions []
+) {
+    _ASSERT_EXPR(n_images <= TEXTURE_ASSEMBLER_MAX_IMAGES, "too many images for one array");
+    *out_texture = nullptr;
+    D3D12_RESOURCE_DESC desc = {};
+    UINT mip_count = 0;
+    for (UINT i = 0; i < n_images; ++i) {
+        if (nullptr == images[i].resource)
+            continue;
+        D3D12_RESOURCE_DESC image_desc = images[i].resource->GetDesc();
+        if (D3D12_RESOURCE_DIMENSION_TEXTURE2D != image_desc.Dimension || images[i].slice >= image_desc.DepthOrArraySize)
+            return false;
+        if (0 == mip_count) {
+            desc = image_desc;
+            mip_count = image_desc.MipLevels;
+        } else if (image_desc.Format != desc.Format || image_desc.Width != desc.Width || image_desc.Height != desc.Height) {
+            return false;
+        }
+        if (image_desc.MipLevels < mip_count)
+            mip_count = image_desc.MipLevels;
+    }
+    if (0 == mip_count || 0 == block_dim(desc.Format))
+        return false;
+
+    for (UINT i = 0; i < n_images; ++i) {
+        TextureAssemblerRegion * region = &out_regions[i];
+        region->slice = nullptr == images[i].resource ? 0 : i;
+        region->x = 0;
+        region->y = 0;
+        region->width = (UINT)desc.Width;
+        region->height = desc.Height;
+        region->uv_transform = XMFLOAT4(1.0f, 1.0f, 0.0f, 0.0f);
+    }
+    ID3D12Resource * texture = create_texture(device, desc.Format, (UINT)desc.Width, desc.Height, n_images, mip_count);
+    if (nullptr == texture)
+        return false;
+    record_copies(cmd_list, texture, mip_count, images, n_images, out_regions);
+    *out_texture = texture;
+    return true;
+}
+bool
+TextureAssembler_BuildAtlas (
+    ID3D12Device * device,
+    ID3D12GraphicsCommandList * cmd_list,
+    TextureAssemblerImage const images [], UINT n_images,
+    UINT max_dim,
+    ID3D12Resource ** out_texture,
+    TextureAssemblerRegion out_regions []
+) {
+    _ASSERT_EXPR(n_images <= TEXTURE_ASSEMBLER_MAX_IMAGES, "too many images for one atlas");
+    *out_texture = nullptr;
+    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    UINT mip_count = 0;
+    UINT widths[TEXTURE_ASSEMBLER_MAX_IMAGES];
+    UINT heights[TEXTURE_ASSEMBLER_MAX_IMAGES];
+    UINT packed_images[TEXTURE_ASSEMBLER_MAX_IMAGES];
+    UINT n_packed = 0;
+    for (UINT i = 0; i < n_images; ++i) {
+        if (nullptr == images[i].resource)
+            continue;
+        D3D12_RESOURCE_DESC image_desc = images[i].resource->GetDesc();
+        if (D3D12_RESOURCE_DIMENSION_TEXTURE2D != image_desc.Dimension || images[i].slice >= image_desc.DepthOrArraySize)
+            return false;
+        if (0 == n_packed) {
+            format = image_desc.Format;
+            mip_count = image_desc.MipLevels;
+        } else if (image_desc.Format != format) {
+            return false;
+        }
+        if (image_desc.MipLevels < mip_count)
+            mip_count = image_desc.MipLevels;
+        widths[n_packed] = (UINT)image_desc.Width;
+        heights[n_packed] = image_desc.Height;
+        packed_images[n_packed++] = i;
+    }
+    UINT block = 0 == n_packed ? 0 : block_dim(format);
+    if (0 == block)
+        return false;
+
+    // -- drop mips until every image splits into whole blocks down to the last one
+    UINT align = block << (mip_count - 1);
+    for (UINT i = 0; i < n_packed; ++i) {
+        while (align > block && (0 != widths[i] % align || 0 != heights[i] % align)) {
+            align /= 2;
+            --mip_count;
+        }
+        if (0 != widths[i] % align || 0 != heights[i] % align)
+            return false;
+    }
+
+    TextureAssemblerRegion packed_regions[TEXTURE_ASSEMBLER_MAX_IMAGES];
+    UINT width = 0;
+    UINT height = 0;
+    if (!TextureAssembler_PackAtlas(widths, heights, n_packed, align, max_dim, &width, &height, packed_regions))
+        return false;
+    for (UINT i = 0; i < n_images; ++i)
+        out_regions[i] = {0, 0, 0, width, height, XMFLOAT4(1.0f, 1.0f, 0.0f, 0.0f)};
+    for (UINT i = 0; i < n_packed; ++i)
+        out_regions[packed_images[i]] = packed_regions[i];
+
+    ID3D12Resource * texture = create_texture(device, format, width, height, 1, mip_count);
+    if (nullptr == texture)
+        return false;
+    record_copies(cmd_list, texture, mip_count, images, n_images, out_regions);
+    *out_texture = texture;
+    return true;
+}
+void
+TextureAssembler_CreateSrv (ID3D12Device * device, ID3D12Resource * texture, bool as_array, D3D12_CPU_DESCRIPTOR_HANDLE handle) {
+    D3D12_RESOURCE_DESC desc = texture->GetDesc();
+    D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
+    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srv_desc.Format = desc.Format;
+    if (as_array || desc.DepthOrArraySize > 1) {
+        srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+        srv_desc.Texture2DArray.MipLevels = desc.MipLevels;
+        srv_desc.Texture2DArray.ArraySize = desc.DepthOrArraySize;
+    } else {
+        srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+        srv_desc.Texture2D.MipLevels = desc.MipLevels;
+    }
+    device->CreateShaderResourceView(texture, &srv_desc, handle);
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "headers/common.h"
+
+// NOTE(omid): Load-time assembly of shared textures out of textures that are already loaded
+// (GPU copies recorded on the caller's command list, no texel goes through the CPU):
+//  - arrays: images of the same format and size become the slices of one Texture2DArray,
+//    materials then differ by a slice index instead of by SRV
+//  - atlases: images of the same format are packed into one 2D texture (stb_rectpack, imgui's imstb_rectpack.h),
+//    every image gets the UV scale/offset that maps its [0, 1] UVs onto its rect
+// Atlas rects start on multiples of (block size << (mips - 1)) so every mip of an image lands on whole texels
+// (whole blocks for BC formats), and are followed by TEXTURE_ASSEMBLER_ATLAS_GUTTER empty texels so filtering
+// doesn't bleed between neighbors. Atlas images can't tile (wrap addressing would sample the neighbors),
+// textures that tile belong in arrays.
+
+#define TEXTURE_ASSEMBLER_MAX_IMAGES    64
+#define TEXTURE_ASSEMBLER_ATLAS_GUTTER  4   // empty texels right and below every atlas image (mip 0)
+
+// One image to assemble: an array slice of a 2D texture in D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
+struct TextureAssemblerImage {
+    ID3D12Resource *    resource;   // nullptr (e.g., a failed load) skips the image
+    UINT                slice;
+};
+// Where an image ended up in the assembled texture
+struct TextureAssemblerRegion {
+    UINT                slice;          // array slice
+    UINT                x, y;           // top left texel of mip 0
+    UINT                width, height;
+    DirectX::XMFLOAT4   uv_transform;   // uv * xy + zw maps the image's UVs into the assembled texture
+};
+
+/*
+    Packs n_images rects of widths x heights into the smallest power of two atlas (up to max_dim x max_dim) that fits them,
+    with rect positions and the atlas size multiples of align and a gutter after each rect.
+    widths/heights must be multiples of align. Returns false if they don't fit.
+*/
+bool
+TextureAssembler_PackAtlas (
+    UINT const widths [], UINT const heights [], UINT n_images,
+    UINT align, UINT max_dim,
+    UINT * out_width, UINT * out_height,
+    TextureAssemblerRegion out_regions []
+);
+
+/*
+    Records the copies of the images into a new Texture2DArray, one slice per image in order (the region of a skipped
+    image is slice 0). The images must share format and size, the array keeps the smallest mip count among them.
+    *out_texture is in D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE once cmd_list has executed, the images must stay alive until then.
+    Returns false (and no texture) if there is no image or they don't match.
+*/
+bool
+TextureAssembler_BuildArray (
+    ID3D12Device * device,
+    ID3D12GraphicsCommandList * cmd_list,
+    TextureAssemblerImage const images [], UINT n_images,
+    ID3D12Resource ** out_texture,
+    TextureAssemblerRegion out_regions []
+);
+
+/*
+    Same as TextureAssembler_BuildArray but packs the images into one 2D atlas of at most max_dim x max_dim
+    (the region of a skipped image is the whole atlas). The images must share format, the atlas keeps as many mips
+    as every image can be split into along block boundaries.
+*/
+bool
+TextureAssembler_BuildAtlas (
+    ID3D12Device * device,
+    ID3D12GraphicsCommandList * cmd_list,
+    TextureAssemblerImage const images [], UINT n_images,
+    UINT max_dim,
+    ID3D12Resource ** out_texture,
+    TextureAssemblerRegion out_regions []
+);
+
+// SRV of a 2D texture, as_array views it as a Texture2DArray (of one slice for a plain texture)
+void
+TextureAssembler_CreateSrv (ID3D12Device * device, ID3D12Resource * texture, bool as_array, D3D12_CPU_DESCRIPTOR_HANDLE handle);
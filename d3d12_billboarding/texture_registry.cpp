@@ -0,0 +1,229 @@
+#include "texture_registry.h"
+#include "headers/dds_loader.h"
+
+// -- XXH64 (reference algorithm, little-endian reads)
+static uint64_t const XXH_PRIME64_1 = 0x9E3779B185EBCA87ull;
+static uint64_t const XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+static uint64_t const XXH_PRIME64_3 = 0x165667B19E3779F9ull;
+static uint64_t const XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+static uint64_t const XXH_PRIME64_5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t
+rotl64 (uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+static inline uint64_t
+read64 (BYTE const * p) {
+    uint64_t ret;
+    memcpy(&ret, p, sizeof(ret));
+    return ret;
+}
+static inline uint32_t
+read32 (BYTE const * p) {
+    uint32_t ret;
+    memcpy(&ret, p, sizeof(ret));
+    return ret;
+}
+static inline uint64_t
+xxh64_round (uint64_t acc, uint64_t input) {
+    acc += input * XXH_PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * XXH_PRIME64_1;
+}
+static inline uint64_t
+xxh64_merge_round (uint64_t acc, uint64_t val) {
+    acc ^= xxh64_round(0, val);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+static uint64_t
+xxh64 (void const * data, size_t size, uint64_t seed) {
+    BYTE const * p = reinterpret_cast<BYTE const *>(data);
+    BYTE const * end = p + size;
+    uint64_t h;
+
+    // -- 4 independent lanes over 32-byte stripes
+    if (size >= 32) {
+        uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+        uint64_t v2 = seed + XXH_PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - XXH_PRIME64_1;
+        BYTE const * limit = end - 32;
+        do {
+            v1 = xxh64_round(v1, read64(p + 0));
+            v2 = xxh64_round(v2, read64(p + 8));
+            v3 = xxh64_round(v3, read64(p + 16));
+            v4 = xxh64_round(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh64_merge_round(h, v1);
+        h = xxh64_merge_round(h, v2);
+        h = xxh64_merge_round(h, v3);
+        h = xxh64_merge_round(h, v4);
+    } else {
+        h = seed + XXH_PRIME64_5;
+    }
+    h += (uint64_t)size;
+
+    // -- tail
+    for (; p + 8 <= end; p += 8) {
+        h ^= xxh64_round(0, read64(p));
+        h = rotl64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)read32(p) * XXH_PRIME64_1;
+        h = rotl64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= (*p) * XXH_PRIME64_5;
+        h = rotl64(h, 11) * XXH_PRIME64_1;
+    }
+
+    // -- avalanche
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+// What the DDS headers describe, in the same terms whichever header flavor the file uses (hashed as raw bytes, no padding)
+struct TextureContentDesc {
+    uint32_t    format;
+    uint32_t    dimension;
+    uint32_t    width;
+    uint32_t    height;
+    uint32_t    depth;
+    uint32_t    array_size;
+    uint32_t    mip_count;
+    uint32_t    cube_map;
+    uint32_t    conversion; // DDS_CONVERSION the texels go through (format is the converted one)
+};
+static_assert(sizeof(TextureContentDesc) == 9 * sizeof(uint32_t), "TextureContentDesc is hashed as raw bytes");
+
+void
+TextureRegistry_Init (TextureRegistry * registry, ID3D12Device * device, ID3D12DescriptorHeap * srv_heap, UINT first_srv, UINT n_srvs) {
+    registry->device = device;
+    registry->srv_heap = srv_heap;
+    registry->first_srv = first_srv;
+    registry->descriptor_size = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    registry->n_slots = n_srvs < TEXTURE_REGISTRY_MAX_ENTRIES ? n_srvs : TEXTURE_REGISTRY_MAX_ENTRIES;
+    memset(registry->entries, 0, sizeof(registry->entries));
+}
+bool
+TextureRegistry_HashDDS (BYTE const * dds_data, size_t dds_size, unsigned int load_flags, uint64_t * out_hash) {
+    DDS_HEADER const * header = nullptr;
+    uint8_t const * bit_data = nullptr;
+    size_t bit_size = 0;
+    if (FAILED(LoadTextureDataFromMemory(dds_data, dds_size, &header, &bit_data, &bit_size)))
+        return false;
+
+    TextureContentDesc desc = {};
+    desc.width = header->width;
+    desc.height = header->height;
+    desc.depth = 1;
+    desc.array_size = 1;
+    desc.mip_count = header->mipMapCount > 0 ? header->mipMapCount : 1;
+    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    if ((header->ddspf.flags & DDS_FOURCC) && (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC)) {
+        DDS_HEADER_DXT10 const * d3d10ext = reinterpret_cast<DDS_HEADER_DXT10 const *>(header + 1);
+        format = d3d10ext->dxgiFormat;
+        desc.dimension = d3d10ext->resourceDimension;
+        desc.array_size = d3d10ext->arraySize;
+        desc.cube_map = (d3d10ext->miscFlag & 0x4 /* RESOURCE_MISC_TEXTURECUBE */) ? 1 : 0;
+        if (D3D12_RESOURCE_DIMENSION_TEXTURE1D == desc.dimension)
+            desc.height = 1;
+        if (D3D12_RESOURCE_DIMENSION_TEXTURE3D == desc.dimension)
+            desc.depth = header->depth;
+    } else {
+        format = GetDXGIFormat(header->ddspf);
+        if (header->flags & DDS_HEADER_FLAGS_VOLUME) {
+            desc.dimension = D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+            desc.depth = header->depth;
+        } else {
+            desc.dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+            desc.cube_map = (header->caps2 & DDS_CUBEMAP) ? 1 : 0;
+        }
+    }
+    desc.conversion = GetDDSConversion(header, load_flags, format);
+    desc.format = format;
+    *out_hash = xxh64(bit_data, bit_size, xxh64(&desc, sizeof(desc), 0));
+    return true;
+}
+int
+TextureRegistry_Acquire (TextureRegistry * registry, uint64_t hash) {
+    for (UINT i = 0; i < registry->n_slots; ++i) {
+        TextureRegistryEntry * entry = &registry->entries[i];
+        if (entry->ref_count > 0 && entry->hash == hash) {
+            ++entry->ref_count;
+            return (int)i;
+        }
+    }
+    return -1;
+}
+int
+TextureRegistry_Add (TextureRegistry * registry, uint64_t hash, ID3D12Resource * resource, bool is_cube_map) {
+    UINT slot = 0;
+    while (slot < registry->n_slots && registry->entries[slot].ref_count > 0)
+        ++slot;
+    if (slot == registry->n_slots)
+        return -1;
+
+    // -- the view matches what the resource is, so shaders declare the same type they'd declare for the file
+    D3D12_RESOURCE_DESC desc = resource->GetDesc();
+    D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
+    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srv_desc.Format = desc.Format;
+    if (D3D12_RESOURCE_DIMENSION_TEXTURE3D == desc.Dimension) {
+        srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE3D;
+        srv_desc.Texture3D.MipLevels = desc.MipLevels;
+    } else if (is_cube_map && desc.DepthOrArraySize > 6) {
+        srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBEARRAY;
+        srv_desc.TextureCubeArray.MipLevels = desc.MipLevels;
+        srv_desc.TextureCubeArray.NumCubes = desc.DepthOrArraySize / 6;
+    } else if (is_cube_map) {
+        srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+        srv_desc.TextureCube.MipLevels = desc.MipLevels;
+    } else if (D3D12_RESOURCE_DIMENSION_TEXTURE1D == desc.Dimension && desc.DepthOrArraySize > 1) {
+        srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE1DARRAY;
+        srv_desc.Texture1DArray.MipLevels = desc.MipLevels;
+        srv_desc.Texture1DArray.ArraySize = desc.DepthOrArraySize;
+    } else if (D3D12_RESOURCE_DIMENSION_TEXTURE1D == desc.Dimension) {
+        srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE1D;
+        srv_desc.Texture1D.MipLevels = desc.MipLevels;
+    } else if (desc.DepthOrArraySize > 1) {
+        srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+        srv_desc.Texture2DArray.MipLevels = desc.MipLevels;
+        srv_desc.Texture2DArray.ArraySize = desc.DepthOrArraySize;
+    } else {
+        srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+        srv_desc.Texture2D.MipLevels = desc.MipLevels;
+    }
+    D3D12_CPU_DESCRIPTOR_HANDLE handle = registry->srv_heap->GetCPUDescriptorHandleForHeapStart();
+    handle.ptr += (SIZE_T)registry->descriptor_size * TextureRegistry_GetSrvIndex(registry, (int)slot);
+    registry->device->CreateShaderResourceView(resource, &srv_desc, handle);
+
+    TextureRegistryEntry * entry = &registry->entries[slot];
+    entry->hash = hash;
+    entry->resource = resource;
+    entry->ref_count = 1;
+    return (int)slot;
+}
+void
+TextureRegistry_Release (TextureRegistry * registry, int entry) {
+    if (entry < 0)
+        return;
+    TextureRegistryEntry * e = &registry->entries[entry];
+    _ASSERT_EXPR(e->ref_count > 0, "texture registry entry released too many times");
+    if (--e->ref_count > 0)
+        return;
+    e->resource->Release();
+    e->resource = nullptr;
+    e->hash = 0;
+}
+UINT
+TextureRegistry_GetSrvIndex (TextureRegistry const * registry, int entry) {
+    return registry->first_srv + (UINT)entry;
+}
@@ -0,0 +1,194 @@
+#include "upload_ring.h"
+
+static inline UINT64
+align_up (UINT64 x, UINT64 align) {
+    return (x + align - 1) & ~(align - 1);
+}
+// -- the ring size is a multiple of UPLOAD_RING_MAX_ALIGNMENT, not necessarily a power of two
+static inline UINT64
+next_wrap (UINT64 position, UINT64 size) {
+    return (position + size - 1) / size * size;
+}
+static void
+set_transition (D3D12_RESOURCE_BARRIER * barrier, ID3D12Resource * resource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after) {
+    barrier->Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier->Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    barrier->Transition.pResource = resource;
+    barrier->Transition.StateBefore = before;
+    barrier->Transition.StateAfter = after;
+    barrier->Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+}
+
+void
+UploadRingState_Init (UploadRingState * state, UINT64 size) {
+    memset(state, 0, sizeof(UploadRingState));
+    state->size = size;
+}
+bool
+UploadRingState_Alloc (UploadRingState * state, UINT64 size, UINT64 align, UINT64 * out_offset, UINT64 * out_wait_value) {
+    _ASSERT_EXPR(0 != align && 0 == (align & (align - 1)) && align <= UPLOAD_RING_MAX_ALIGNMENT, "upload ring alignment must be a power of two");
+    *out_wait_value = 0;
+    if (0 == size || size > state->size)
+        return false;
+
+    // -- nothing in flight: restart at offset 0 so the whole buffer is contiguous
+    if (state->tail == state->head)
+        state->head = state->tail = state->submitted = next_wrap(state->head, state->size);
+    // -- the size is a multiple of every alignment, so positions aligned in the ring are aligned in the buffer
+    UINT64 start = align_up(state->head, align);
+    if (start % state->size + size > state->size)
+        start = next_wrap(start, state->size);
+    if (start + size - state->tail <= state->size) {
+        state->head = start + size;
+        *out_offset = start % state->size;
+        return true;
+    }
+    if (state->n_submits > 0)
+        *out_wait_value = state->submits[state->first_submit].fence_value;
+    return false;
+}
+void
+UploadRingState_Submit (UploadRingState * state, UINT64 fence_value) {
+    if (state->head == state->submitted)
+        return;
+    if (UPLOAD_RING_MAX_SUBMITS == state->n_submits) {
+        // -- no room to track it apart: the newest submit waits for this one too
+        UploadRingSubmit * newest = &state->submits[(state->first_submit + state->n_submits - 1) % UPLOAD_RING_MAX_SUBMITS];
+        newest->fence_value = fence_value;
+        newest->end = state->head;
+    } else {
+        state->submits[(state->first_submit + state->n_submits) % UPLOAD_RING_MAX_SUBMITS] = {fence_value, state->head};
+        ++state->n_submits;
+    }
+    state->submitted = state->head;
+}
+void
+UploadRingState_Retire (UploadRingState * state, UINT64 completed_value) {
+    while (state->n_submits > 0 && state->submits[state->first_submit].fence_value <= completed_value) {
+        state->tail = state->submits[state->first_submit].end;
+        state->first_submit = (state->first_submit + 1) % UPLOAD_RING_MAX_SUBMITS;
+        --state->n_submits;
+    }
+}
+
+bool
+UploadRing_Init (UploadRing * ring, ID3D12Device * device, UINT64 size) {
+    memset(ring, 0, sizeof(UploadRing));
+    size = align_up(size, UPLOAD_RING_MAX_ALIGNMENT);
+
+    D3D12_HEAP_PROPERTIES heap_props = {};
+    heap_props.Type = D3D12_HEAP_TYPE_UPLOAD;
+    heap_props.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    heap_props.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    heap_props.CreationNodeMask = 1;
+    heap_props.VisibleNodeMask = 1;
+
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    desc.Width = size;
+    desc.Height = 1;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = 1;
+    desc.Format = DXGI_FORMAT_UNKNOWN;
+    desc.SampleDesc.Count = 1;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    if (FAILED(device->CreateCommittedResource(&heap_props, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&ring->buffer))))
+        return false;
+
+    // -- mapped for the ring's lifetime, the CPU never reads it
+    D3D12_RANGE read_range = {};
+    ring->fence_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (FAILED(ring->buffer->Map(0, &read_range, reinterpret_cast<void **>(&ring->cpu_base))) ||
+        FAILED(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&ring->fence))) ||
+        nullptr == ring->fence_event) {
+        UploadRing_Destroy(ring);
+        return false;
+    }
+    ring->gpu_base = ring->buffer->GetGPUVirtualAddress();
+    UploadRingState_Init(&ring->state, size);
+    return true;
+}
+bool
+UploadRing_Alloc (UploadRing * ring, UINT64 size, UINT64 align, UploadRingAllocation * out) {
+    UINT64 offset = 0;
+    UINT64 wait_value = 0;
+    while (!UploadRingState_Alloc(&ring->state, size, align, &offset, &wait_value)) {
+        if (0 == wait_value)
+            return false;
+        // -- retire what the GPU already finished, wait only if the oldest submit in the way isn't among it
+        UINT64 completed = ring->fence->GetCompletedValue();
+        if (completed < wait_value) {
+            if (FAILED(ring->fence->SetEventOnCompletion(wait_value, ring->fence_event)))
+                return false;
+            WaitForSingleObject(ring->fence_event, INFINITE);
+            completed = ring->fence->GetCompletedValue();
+        }
+        UploadRingState_Retire(&ring->state, completed);
+    }
+    out->buffer = ring->buffer;
+    out->offset = offset;
+    out->cpu = ring->cpu_base + offset;
+    out->gpu = ring->gpu_base + offset;
+    return true;
+}
+void
+UploadRing_Submit (UploadRing * ring, ID3D12CommandQueue * cmd_queue) {
+    if (ring->state.head == ring->state.submitted)
+        return;
+    ++ring->fence_value;
+    cmd_queue->Signal(ring->fence, ring->fence_value);
+    UploadRingState_Submit(&ring->state, ring->fence_value);
+}
+ID3D12Resource *
+UploadRing_CreateBuffer (UploadRing * ring, ID3D12Device * device, ID3D12GraphicsCommandList * cmd_list, void const * init_data, UINT64 byte_size) {
+    D3D12_HEAP_PROPERTIES heap_props = {};
+    heap_props.Type = D3D12_HEAP_TYPE_DEFAULT;
+    heap_props.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    heap_props.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    heap_props.CreationNodeMask = 1;
+    heap_props.VisibleNodeMask = 1;
+
+    D3D12_RESOURCE_DESC desc = {};
+    desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    desc.Width = byte_size;
+    desc.Height = 1;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = 1;
+    desc.Format = DXGI_FORMAT_UNKNOWN;
+    desc.SampleDesc.Count = 1;
+    desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    ID3D12Resource * buffer = nullptr;
+    if (FAILED(device->CreateCommittedResource(&heap_props, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&buffer))))
+        return nullptr;
+    UploadRingAllocation alloc = {};
+    if (!UploadRing_Alloc(ring, byte_size, 16, &alloc)) {
+        buffer->Release();
+        return nullptr;
+    }
+    memcpy(alloc.cpu, init_data, byte_size);
+
+    D3D12_RESOURCE_BARRIER barrier = {};
+    set_transition(&barrier, buffer, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST);
+    cmd_list->ResourceBarrier(1, &barrier);
+    cmd_list->CopyBufferRegion(buffer, 0, alloc.buffer, alloc.offset, byte_size);
+    set_transition(&barrier, buffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ);
+    cmd_list->ResourceBarrier(1, &barrier);
+    return buffer;
+}
+void
+UploadRing_Destroy (UploadRing * ring) {
+    if (ring->fence_event)
+        CloseHandle(ring->fence_event);
+    if (ring->fence)
+        ring->fence->Release();
+    if (ring->buffer) {
+        if (ring->cpu_base)
+            ring->buffer->Unmap(0, nullptr);
+        ring->buffer->Release();
+    }
+    memset(ring, 0, sizeof(UploadRing));
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "headers/common.h"
+
+// NOTE(omid): One persistently mapped upload buffer for everything the CPU hands to the GPU
+// (texture footprints, buffer copies, per-frame constants and vertices) instead of an upload resource per upload:
+//  - allocations are carved from the head of the ring, aligned as the caller asks
+//    (D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT for footprints, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT for cbuffers)
+//  - UploadRing_Submit, called after executing the command lists that read the allocations, signals the ring's fence;
+//    everything allocated since the previous submit retires once the GPU reaches that value
+//  - an allocation that doesn't fit drops what the GPU is done with, and only waits on the fence
+//    when it would wrap onto work still in flight
+// An allocation never straddles the end of the buffer, it skips to the start (the skipped bytes retire with it).
+// UploadRingState is the allocator without any D3D object, it runs against whatever completed fence value it is given.
+
+#define UPLOAD_RING_MAX_SUBMITS     64
+#define UPLOAD_RING_MAX_ALIGNMENT   D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT  // the ring size is a multiple of it
+
+struct UploadRingSubmit {
+    UINT64      fence_value;
+    UINT64      end;            // head when it was submitted
+};
+struct UploadRingState {
+    UINT64              size;
+    // -- positions count bytes since creation, the buffer offset is position % size
+    UINT64              head;       // next free byte
+    UINT64              tail;       // first byte the GPU may still read
+    UINT64              submitted;  // head at the last submit
+    UploadRingSubmit    submits[UPLOAD_RING_MAX_SUBMITS];   // in flight, oldest first (circular)
+    UINT                first_submit;
+    UINT                n_submits;
+};
+struct UploadRing {
+    ID3D12Resource *            buffer;
+    BYTE *                      cpu_base;
+    D3D12_GPU_VIRTUAL_ADDRESS   gpu_base;
+    ID3D12Fence *               fence;
+    HANDLE                      fence_event;
+    UINT64                      fence_value;    // last value signaled
+    UploadRingState             state;
+};
+struct UploadRingAllocation {
+    ID3D12Resource *            buffer;     // the ring's buffer
+    UINT64                      offset;     // in buffer
+    BYTE *                      cpu;
+    D3D12_GPU_VIRTUAL_ADDRESS   gpu;
+};
+
+// -- allocator
+
+void
+UploadRingState_Init (UploadRingState * state, UINT64 size);
+
+/*
+    Allocates size bytes aligned to align (a power of two, at most UPLOAD_RING_MAX_ALIGNMENT) and sets *out_offset.
+    If the ring is too full, returns false and sets *out_wait_value to the fence value to wait for before retiring and trying again,
+    or to 0 if waiting can't help (size is larger than the ring or than what isn't submitted yet leaves free).
+*/
+bool
+UploadRingState_Alloc (UploadRingState * state, UINT64 size, UINT64 align, UINT64 * out_offset, UINT64 * out_wait_value);
+
+// Everything allocated since the previous submit retires once the fence reaches fence_value (values must increase)
+void
+UploadRingState_Submit (UploadRingState * state, UINT64 fence_value);
+
+// Frees what the submits up to completed_value hold
+void
+UploadRingState_Retire (UploadRingState * state, UINT64 completed_value);
+
+// -- D3D12 ring
+
+// size is rounded up to a multiple of UPLOAD_RING_MAX_ALIGNMENT
+bool
+UploadRing_Init (UploadRing * ring, ID3D12Device * device, UINT64 size);
+
+// Blocks only when the ring wraps onto in-flight work, returns false if waiting can't make room
+bool
+UploadRing_Alloc (UploadRing * ring, UINT64 size, UINT64 align, UploadRingAllocation * out);
+
+// Call after ExecuteCommandLists of the command lists that read what was allocated since the previous submit
+void
+UploadRing_Submit (UploadRing * ring, ID3D12CommandQueue * cmd_queue);
+
+/*
+    Creates a default heap buffer holding init_data: the bytes go through the ring and cmd_list records the copy.
+    The buffer ends up in D3D12_RESOURCE_STATE_GENERIC_READ. Returns nullptr if the buffer or the ring allocation fails.
+*/
+ID3D12Resource *
+UploadRing_CreateBuffer (UploadRing * ring, ID3D12Device * device, ID3D12GraphicsCommandList * cmd_list, void const * init_data, UINT64 byte_size);
+
+// The GPU must be done with the ring (e.g., after flushing the queue)
+void
+UploadRing_Destroy (UploadRing * ring);
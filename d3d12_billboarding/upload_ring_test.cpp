@@ -0,0 +1,155 @@
+// NOTE(omid): CPU test of the upload ring allocator (UploadRingState), no device needed.
+// A simulated fence stands in for the GPU: submits signal it, and the test decides when the GPU reaches a value.
+// It's the upload_ring_test project of misc_d3d12.sln (console app), or from a developer command prompt in this folder:
+//      cl /nologo /std:c++latest /EHsc upload_ring_test.cpp upload_ring.cpp d3d12.lib && upload_ring_test.exe
+// It returns nonzero if a check fails.
+
+#include "upload_ring.h"
+
+struct SimFence {
+    UINT64  signaled;   // last value submitted
+    UINT64  completed;  // last value the "GPU" reached
+};
+
+static int n_fails = 0;
+#define CHECK(exp) do { if (!(exp)) { ::printf("[FAIL] %s at line %d. \n", #exp, __LINE__); ++n_fails; } } while (0)
+
+static void
+submit (UploadRingState * state, SimFence * fence) {
+    UploadRingState_Submit(state, ++fence->signaled);
+}
+static void
+complete (UploadRingState * state, SimFence * fence, UINT64 value) {
+    fence->completed = value;
+    UploadRingState_Retire(state, fence->completed);
+}
+
+static void
+test_alloc_align () {
+    UploadRingState state;
+    UploadRingState_Init(&state, 1024);
+    UINT64 offset = ~0ull, wait = ~0ull;
+    CHECK(UploadRingState_Alloc(&state, 100, 1, &offset, &wait) && 0 == offset && 0 == wait);
+    CHECK(UploadRingState_Alloc(&state, 10, 256, &offset, &wait) && 256 == offset);
+    CHECK(UploadRingState_Alloc(&state, 1, 16, &offset, &wait) && 272 == offset);
+    CHECK(UploadRingState_Alloc(&state, 1, 512, &offset, &wait) && 512 == offset);
+    // -- empty and oversized requests never fit
+    CHECK(!UploadRingState_Alloc(&state, 0, 1, &offset, &wait) && 0 == wait);
+    CHECK(!UploadRingState_Alloc(&state, 2048, 1, &offset, &wait) && 0 == wait);
+}
+static void
+test_wrap () {
+    UploadRingState state;
+    SimFence fence = {};
+    UploadRingState_Init(&state, 1024);
+    UINT64 offset, wait;
+    CHECK(UploadRingState_Alloc(&state, 600, 1, &offset, &wait) && 0 == offset);
+    submit(&state, &fence);
+    CHECK(UploadRingState_Alloc(&state, 300, 1, &offset, &wait) && 600 == offset);
+    submit(&state, &fence);
+    complete(&state, &fence, 1);
+    // -- 124 bytes left at the end: the allocation skips them and starts at offset 0
+    CHECK(UploadRingState_Alloc(&state, 200, 1, &offset, &wait) && 0 == offset);
+    CHECK(offset + 200 <= 600);
+
+    // -- same with a size that isn't a power of two (any multiple of the largest alignment is allowed)
+    UploadRingState odd;
+    SimFence odd_fence = {};
+    UploadRingState_Init(&odd, 3 * 256);
+    CHECK(UploadRingState_Alloc(&odd, 500, 1, &offset, &wait) && 0 == offset);
+    submit(&odd, &odd_fence);
+    CHECK(UploadRingState_Alloc(&odd, 200, 256, &offset, &wait) && 512 == offset);
+    submit(&odd, &odd_fence);
+    complete(&odd, &odd_fence, 1);
+    CHECK(UploadRingState_Alloc(&odd, 300, 1, &offset, &wait) && 0 == offset);
+}
+static void
+test_blocked_wait_value () {
+    UploadRingState state;
+    SimFence fence = {};
+    UploadRingState_Init(&state, 1024);
+    UINT64 offset, wait;
+    CHECK(UploadRingState_Alloc(&state, 400, 1, &offset, &wait));
+    submit(&state, &fence);
+    CHECK(UploadRingState_Alloc(&state, 400, 1, &offset, &wait));
+    submit(&state, &fence);
+    // -- the oldest submit in flight is the one to wait for
+    CHECK(!UploadRingState_Alloc(&state, 400, 1, &offset, &wait) && 1 == wait);
+    // -- unsubmitted bytes in the way: waiting can't help
+    UploadRingState blocked;
+    UploadRingState_Init(&blocked, 1024);
+    CHECK(UploadRingState_Alloc(&blocked, 800, 1, &offset, &wait));
+    CHECK(!UploadRingState_Alloc(&blocked, 400, 1, &offset, &wait) && 0 == wait);
+}
+static void
+test_retire () {
+    UploadRingState state;
+    SimFence fence = {};
+    UploadRingState_Init(&state, 1024);
+    UINT64 offset, wait;
+    CHECK(UploadRingState_Alloc(&state, 400, 1, &offset, &wait));
+    submit(&state, &fence);
+    CHECK(UploadRingState_Alloc(&state, 400, 1, &offset, &wait));
+    submit(&state, &fence);
+    CHECK(!UploadRingState_Alloc(&state, 400, 1, &offset, &wait) && 1 == wait);
+    // -- the GPU hasn't reached it yet, nothing retires
+    complete(&state, &fence, 0);
+    CHECK(0 == state.tail && 2 == state.n_submits);
+    CHECK(!UploadRingState_Alloc(&state, 400, 1, &offset, &wait) && 1 == wait);
+    // -- it has: the first submit's bytes are free again
+    complete(&state, &fence, wait);
+    CHECK(400 == state.tail && 1 == state.n_submits);
+    CHECK(UploadRingState_Alloc(&state, 400, 1, &offset, &wait) && 0 == offset);
+    // -- submitting without new allocations tracks nothing
+    submit(&state, &fence);
+    UploadRingState_Submit(&state, ++fence.signaled);
+    CHECK(2 == state.n_submits);
+}
+static void
+test_reset_when_empty () {
+    UploadRingState state;
+    SimFence fence = {};
+    UploadRingState_Init(&state, 1024);
+    UINT64 offset, wait;
+    CHECK(UploadRingState_Alloc(&state, 700, 1, &offset, &wait));
+    submit(&state, &fence);
+    complete(&state, &fence, fence.signaled);
+    CHECK(state.tail == state.head && 0 == state.n_submits);
+    // -- nothing in flight: the head goes back to offset 0, so the whole ring is one contiguous block
+    CHECK(UploadRingState_Alloc(&state, 1024, 1, &offset, &wait) && 0 == offset);
+}
+static void
+test_submit_overflow () {
+    UploadRingState state;
+    SimFence fence = {};
+    UploadRingState_Init(&state, 1 << 20);
+    UINT64 offset, wait;
+    for (UINT i = 0; i < UPLOAD_RING_MAX_SUBMITS + 10; ++i) {
+        CHECK(UploadRingState_Alloc(&state, 100, 1, &offset, &wait));
+        submit(&state, &fence);
+    }
+    // -- the queue is full, the newest entry absorbed the last 11 submits
+    CHECK(UPLOAD_RING_MAX_SUBMITS == state.n_submits);
+    complete(&state, &fence, UPLOAD_RING_MAX_SUBMITS - 1);
+    CHECK(1 == state.n_submits && (UPLOAD_RING_MAX_SUBMITS - 1) * 100 == state.tail);
+    // -- the merged entry retires only once its last value is reached
+    complete(&state, &fence, UPLOAD_RING_MAX_SUBMITS);
+    CHECK(1 == state.n_submits);
+    complete(&state, &fence, fence.signaled);
+    CHECK(0 == state.n_submits && state.tail == state.head);
+}
+
+int
+main () {
+    test_alloc_align();
+    test_wrap();
+    test_blocked_wait_value();
+    test_retire();
+    test_reset_when_empty();
+    test_submit_overflow();
+    if (n_fails)
+        ::printf("upload ring: %d checks failed \n", n_fails);
+    else
+        ::printf("upload ring: all checks passed \n");
+    return n_fails ? 1 : 0;
+}
@@ -14,6 +14,9 @@
 #include "gpu_waves.h"
 #include "blur_filter.h"
 #include "sobel_filter.h"
+#include "texture_batch.h"
+#include "texture_registry.h"
+#include "upload_ring.h"
 
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_win32.h>
@@ -41,6 +44,7 @@
 
 #define NUM_BACKBUFFERS         2
 #define NUM_QUEUING_FRAMES      3
+#define UPLOAD_RING_SIZE        (4 * 1024 * 1024)   // startup textures, the batch executes early if they don't fit
 
 enum RENDER_LAYER : int {
     LAYER_OPAQUE = 0,
@@ -227,77 +231,20 @@ struct D3DRenderContext {
     ID3D12Resource *                depth_stencil_buffer;
 
     Material                        materials[_COUNT_MATERIAL];
-    Texture                         textures[_COUNT_TEX];
+    Texture                         textures[_COUNT_TEX];   // resources are owned by the registry
     IDxcBlob *                      shaders[_COUNT_SHADERS];
-};
-static void
-load_texture (
-    ID3D12Device * device,
-    ID3D12GraphicsCommandList * cmd_list,
-    wchar_t const * tex_path,
-    Texture * out_texture
-) {
-
-    uint8_t * ddsData;
-    D3D12_SUBRESOURCE_DATA * subresources;
-    UINT n_subresources = 0;
-
-    LoadDDSTextureFromFile(device, tex_path, &out_texture->resource, &ddsData, &subresources, &n_subresources);
-
-    UINT64 upload_buffer_size = get_required_intermediate_size(out_texture->resource, 0,
-                                                               n_subresources);
-
-   // Create the GPU upload buffer.
-    D3D12_HEAP_PROPERTIES heap_props = {};
-    heap_props.Type = D3D12_HEAP_TYPE_UPLOAD;
-    heap_props.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-    heap_props.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-    heap_props.CreationNodeMask = 1;
-    heap_props.VisibleNodeMask = 1;
-
-    D3D12_RESOURCE_DESC desc = {};
-    desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-    desc.Alignment = 0;
-    desc.Width = upload_buffer_size;
-    desc.Height = 1;
-    desc.DepthOrArraySize = 1;
-    desc.MipLevels = 1;
-    desc.Format = DXGI_FORMAT_UNKNOWN;
-    // TODO(omid): do we need to set 4x MSAA here? 
-    desc.SampleDesc.Count = 1;
-    desc.SampleDesc.Quality = 0;
-    desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-    desc.Flags = D3D12_RESOURCE_FLAG_NONE;
-
-    device->CreateCommittedResource(
-        &heap_props,
-        D3D12_HEAP_FLAG_NONE,
-        &desc,
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        nullptr,
-        IID_PPV_ARGS(&out_texture->upload_heap)
-    );
-
-    // Use Heap-allocating UpdateSubresources implementation for variable number of subresources (which is the case for textures).
-    update_subresources_heap(
-        cmd_list, out_texture->resource, out_texture->upload_heap,
-        0, 0, n_subresources, subresources
-    );
-
-    resource_usage_transition(
-        cmd_list, out_texture->resource,
-        D3D12_RESOURCE_STATE_COPY_DEST,
-        D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
-    );
 
-    ::free(subresources);
-    ::free(ddsData);
-}
+    // Textures shared by content, owns the texture SRVs (the first _COUNT_TEX descriptors of srv_heap)
+    TextureRegistry                 texture_registry;
+    int                             texture_entries[_COUNT_TEX];
+    UploadRing                      upload_ring;    // startup uploads only, destroyed once they're done
+};
+// texture_srvs: SRV index of each TEX_INDEX (textures with the same contents share one)
 static void
-create_materials (Material out_materials []) {
+create_materials (UINT const texture_srvs [], Material out_materials []) {
     strcpy_s(out_materials[MAT_GRASS].name, "grass");
     out_materials[MAT_GRASS].mat_cbuffer_index = 0;
-    out_materials[MAT_GRASS].diffuse_srvheap_index = 0;
+    out_materials[MAT_GRASS].diffuse_srvheap_index = texture_srvs[TEX_GRASS];
     out_materials[MAT_GRASS].diffuse_albedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
     out_materials[MAT_GRASS].fresnel_r0 = XMFLOAT3(0.01f, 0.01f, 0.01f);
     out_materials[MAT_GRASS].roughness = 0.125f;
@@ -306,7 +253,7 @@ create_materials (Material out_materials []) {
 
     strcpy_s(out_materials[MAT_WATER].name, "water");
     out_materials[MAT_WATER].mat_cbuffer_index = 1;
-    out_materials[MAT_WATER].diffuse_srvheap_index = 1;
+    out_materials[MAT_WATER].diffuse_srvheap_index = texture_srvs[TEX_WATER];
     out_materials[MAT_WATER].diffuse_albedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 0.5f);
     out_materials[MAT_WATER].fresnel_r0 = XMFLOAT3(0.1f, 0.1f, 0.1f);
     out_materials[MAT_WATER].roughness = 0.0f;
@@ -315,7 +262,7 @@ create_materials (Material out_materials []) {
 
     strcpy_s(out_materials[MAT_WOOD_CRATE].name, "wood_crate");
     out_materials[MAT_WOOD_CRATE].mat_cbuffer_index = 2;
-    out_materials[MAT_WOOD_CRATE].diffuse_srvheap_index = 2;
+    out_materials[MAT_WOOD_CRATE].diffuse_srvheap_index = texture_srvs[TEX_CRATE01];
     out_materials[MAT_WOOD_CRATE].diffuse_albedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
     out_materials[MAT_WOOD_CRATE].fresnel_r0 = XMFLOAT3(0.05f, 0.05f, 0.05f);
     out_materials[MAT_WOOD_CRATE].roughness = 0.2f;
@@ -324,7 +271,7 @@ create_materials (Material out_materials []) {
 
     strcpy_s(out_materials[MAT_WIRED_CRATE].name, "wired_crate");
     out_materials[MAT_WIRED_CRATE].mat_cbuffer_index = 3;
-    out_materials[MAT_WIRED_CRATE].diffuse_srvheap_index = 3;
+    out_materials[MAT_WIRED_CRATE].diffuse_srvheap_index = texture_srvs[TEX_WIREFENCE];
     out_materials[MAT_WIRED_CRATE].diffuse_albedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
     out_materials[MAT_WIRED_CRATE].fresnel_r0 = XMFLOAT3(0.05f, 0.05f, 0.05f);
     out_materials[MAT_WIRED_CRATE].roughness = 0.2f;
@@ -333,7 +280,7 @@ create_materials (Material out_materials []) {
 
     strcpy_s(out_materials[MAT_TREE_SPRITE].name, "tree_sprites");
     out_materials[MAT_TREE_SPRITE].mat_cbuffer_index = 4;
-    out_materials[MAT_TREE_SPRITE].diffuse_srvheap_index = 4;
+    out_materials[MAT_TREE_SPRITE].diffuse_srvheap_index = texture_srvs[TEX_TREEARRAY];
     out_materials[MAT_TREE_SPRITE].diffuse_albedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
     out_materials[MAT_TREE_SPRITE].fresnel_r0 = XMFLOAT3(0.01f, 0.01f, 0.01f);
     out_materials[MAT_TREE_SPRITE].roughness = 0.125f;
@@ -361,39 +308,18 @@ calc_hill_normal (float x, float z) {
 static void
 create_shape_geometry (D3DRenderContext * render_ctx) {
 
-    // required sizes
-    int nvtx = 24;
-    int nidx = 36;
-
-    Vertex *    vertices = (Vertex *)::malloc(sizeof(Vertex) * nvtx);
-    uint16_t *  indices = (uint16_t *)::malloc(sizeof(uint16_t) * nidx);
-    BYTE *      scratch = (BYTE *)::malloc(sizeof(GeomVertex) * nvtx + sizeof(uint16_t) * nidx);
-
-    // box
-    UINT bsz = sizeof(GeomVertex) * nvtx;
-    GeomVertex *    box_vertices = reinterpret_cast<GeomVertex *>(scratch);
-    uint16_t *      box_indices = reinterpret_cast<uint16_t *>(scratch + bsz);
-
-    create_box(8.0f, 8.0f, 8.0f, box_vertices, box_indices);
+    // box (read-only table built at compile time, uploaded as is)
+    StaticGeometry<Vertex, 24, 36> const & box = box_geometry<Vertex, 8.0f, 8.0f, 8.0f>;
+    UINT nvtx = ARRAY_COUNT(box.vertices);
+    UINT nidx = ARRAY_COUNT(box.indices);
+    Vertex const *      vertices = box.vertices;
+    uint16_t const *    indices = box.indices;
 
     SubmeshGeometry box_submesh = {};
     box_submesh.index_count = nidx;
     box_submesh.start_index_location = 0;
     box_submesh.base_vertex_location = 0;
 
-    UINT k = 0;
-    for (size_t i = 0; i < nvtx; ++i, ++k) {
-        vertices[k].position = box_vertices[i].Position;
-        vertices[k].normal = box_vertices[i].Normal;
-        vertices[k].texc = box_vertices[i].TexC;
-    }
-
-    // -- pack indices
-    k = 0;
-    for (size_t i = 0; i < nidx; ++i, ++k) {
-        indices[k] = box_indices[i];
-    }
-
     UINT vb_byte_size = nvtx * sizeof(Vertex);
     UINT ib_byte_size = nidx * sizeof(uint16_t);
 
@@ -416,11 +342,6 @@ create_shape_geometry (D3DRenderContext * render_ctx) {
 
     render_ctx->geom[GEOM_BOX].submesh_names[0] = "box";
     render_ctx->geom[GEOM_BOX].submesh_geoms[0] = box_submesh;
-
-    // -- cleanup
-    free(scratch);
-    free(indices);
-    free(vertices);
 }
 static void
 create_land_geometry (D3DRenderContext * render_ctx) {
@@ -729,7 +650,7 @@ create_descriptor_heaps (
     OffscreenRenderTarget * ort
 ) {
 
-    // Create Shader Resource View descriptor heap
+    // Create Shader Resource View descriptor heap (the texture SRVs are created by the texture registry)
     D3D12_DESCRIPTOR_HEAP_DESC srv_heap_desc = {};
     srv_heap_desc.NumDescriptors = _COUNT_TEX +
         6 +     /* GpuWaves descriptors */
@@ -741,69 +662,6 @@ create_descriptor_heaps (
     srv_heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
     render_ctx->device->CreateDescriptorHeap(&srv_heap_desc, IID_PPV_ARGS(&render_ctx->srv_heap));
 
-    // Fill out the heap with actual descriptors
-    D3D12_CPU_DESCRIPTOR_HANDLE descriptor_cpu_handle = render_ctx->srv_heap->GetCPUDescriptorHandleForHeapStart();
-
-    // grass texture
-    ID3D12Resource * grass_tex = render_ctx->textures[TEX_GRASS].resource;
-    D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
-    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srv_desc.Format = grass_tex->GetDesc().Format;
-    srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srv_desc.Texture2D.MostDetailedMip = 0;
-    srv_desc.Texture2D.MipLevels = grass_tex->GetDesc().MipLevels;
-    srv_desc.Texture2D.ResourceMinLODClamp = 0.0f;
-    render_ctx->device->CreateShaderResourceView(grass_tex, &srv_desc, descriptor_cpu_handle);
-
-    // water texture
-    ID3D12Resource * water_tex = render_ctx->textures[TEX_WATER].resource;
-    memset(&srv_desc, 0, sizeof(srv_desc));         // reset desc
-    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srv_desc.Format = water_tex->GetDesc().Format;
-    srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srv_desc.Texture2D.MostDetailedMip = 0;
-    srv_desc.Texture2D.MipLevels = water_tex->GetDesc().MipLevels;
-    srv_desc.Texture2D.ResourceMinLODClamp = 0.0f;
-    descriptor_cpu_handle.ptr += render_ctx->cbv_srv_uav_descriptor_size;   // next descriptr
-    render_ctx->device->CreateShaderResourceView(water_tex, &srv_desc, descriptor_cpu_handle);
-
-    // crate texture
-    ID3D12Resource * box_tex = render_ctx->textures[TEX_CRATE01].resource;
-    memset(&srv_desc, 0, sizeof(srv_desc)); // reset desc
-    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srv_desc.Format = box_tex->GetDesc().Format;
-    srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srv_desc.Texture2D.MostDetailedMip = 0;
-    srv_desc.Texture2D.MipLevels = box_tex->GetDesc().MipLevels;
-    srv_desc.Texture2D.ResourceMinLODClamp = 0.0f;
-    descriptor_cpu_handle.ptr += render_ctx->cbv_srv_uav_descriptor_size;   // next descriptor
-    render_ctx->device->CreateShaderResourceView(box_tex, &srv_desc, descriptor_cpu_handle);
-
-    // wire_fence texture
-    ID3D12Resource * wire_tex = render_ctx->textures[TEX_WIREFENCE].resource;
-    memset(&srv_desc, 0, sizeof(srv_desc)); // reset desc
-    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srv_desc.Format = wire_tex->GetDesc().Format;
-    srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srv_desc.Texture2D.MostDetailedMip = 0;
-    srv_desc.Texture2D.MipLevels = wire_tex->GetDesc().MipLevels;
-    srv_desc.Texture2D.ResourceMinLODClamp = 0.0f;
-    descriptor_cpu_handle.ptr += render_ctx->cbv_srv_uav_descriptor_size;   // next descriptor
-    render_ctx->device->CreateShaderResourceView(wire_tex, &srv_desc, descriptor_cpu_handle);
-
-    // tree_array texture
-    ID3D12Resource * tree_tex = render_ctx->textures[TEX_TREEARRAY].resource;
-    memset(&srv_desc, 0, sizeof(srv_desc)); // reset desc
-    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srv_desc.Format = tree_tex->GetDesc().Format;
-    srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
-    srv_desc.Texture2DArray.MostDetailedMip = 0;
-    srv_desc.Texture2DArray.MipLevels = tree_tex->GetDesc().MipLevels;
-    srv_desc.Texture2DArray.FirstArraySlice = 0;
-    srv_desc.Texture2DArray.ArraySize = tree_tex->GetDesc().DepthOrArraySize;
-    descriptor_cpu_handle.ptr += render_ctx->cbv_srv_uav_descriptor_size;   // next descriptor
-    render_ctx->device->CreateShaderResourceView(tree_tex, &srv_desc, descriptor_cpu_handle);
-
     //
     // Create GpuWaves descriptors
     //
@@ -2496,49 +2354,6 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     if (render_ctx->cmd_queue)
         CHECK_AND_FAIL(dxgi_factory->CreateSwapChain(render_ctx->cmd_queue, &swapchain_desc, &render_ctx->swapchain));
 
-// ========================================================================================================
-#pragma region Load Textures
-    // crate
-    strcpy_s(render_ctx->textures[TEX_CRATE01].name, "woodcrate01");
-    wcscpy_s(render_ctx->textures[TEX_CRATE01].filename, L"../Textures/WoodCrate02.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_CRATE01].filename,
-        &render_ctx->textures[TEX_CRATE01]
-    );
-    // water
-    strcpy_s(render_ctx->textures[TEX_WATER].name, "watertex");
-    wcscpy_s(render_ctx->textures[TEX_WATER].filename, L"../Textures/water1.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_WATER].filename,
-        &render_ctx->textures[TEX_WATER]
-    );
-    // grass
-    strcpy_s(render_ctx->textures[TEX_GRASS].name, "grasstex");
-    wcscpy_s(render_ctx->textures[TEX_GRASS].filename, L"../Textures/grass.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_GRASS].filename,
-        &render_ctx->textures[TEX_GRASS]
-    );
-    // wire_fence
-    strcpy_s(render_ctx->textures[TEX_WIREFENCE].name, "wirefencetex");
-    wcscpy_s(render_ctx->textures[TEX_WIREFENCE].filename, L"../Textures/WireFence.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_WIREFENCE].filename,
-        &render_ctx->textures[TEX_WIREFENCE]
-    );
-    // tree_array
-    strcpy_s(render_ctx->textures[TEX_TREEARRAY].name, "treearraytex");
-    wcscpy_s(render_ctx->textures[TEX_TREEARRAY].filename, L"../Textures/treeArray2.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_TREEARRAY].filename,
-        &render_ctx->textures[TEX_TREEARRAY]
-    );
-#pragma endregion
 
     // Waves Initial Setup
     uint32_t const nrow = 256;
@@ -2578,6 +2393,45 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
 
     create_descriptor_heaps(render_ctx, waves, global_blur_filter, &global_sobel_filter, &global_offscreen_rendertarget);
 
+// ========================================================================================================
+#pragma region Load Textures
+    struct {
+        TEX_INDEX           index;
+        char const *        name;
+        wchar_t const *     filename;
+    } const texture_table [] = {
+        {TEX_CRATE01, "woodcrate01", L"../Textures/WoodCrate02.dds"},
+        {TEX_WATER, "watertex", L"../Textures/water1.dds"},
+        {TEX_GRASS, "grasstex", L"../Textures/grass.dds"},
+        {TEX_WIREFENCE, "wirefencetex", L"../Textures/WireFence.dds"},
+        {TEX_TREEARRAY, "treearraytex", L"../Textures/treeArray2.dds"},
+    };
+    static_assert(_countof(texture_table) == _COUNT_TEX, "Missing texture table entries");
+    wchar_t const * texture_paths[_COUNT_TEX];
+    int texture_entries[_COUNT_TEX];
+    for (UINT i = 0; i < _countof(texture_table); ++i) {
+        strcpy_s(render_ctx->textures[texture_table[i].index].name, texture_table[i].name);
+        wcscpy_s(render_ctx->textures[texture_table[i].index].filename, texture_table[i].filename);
+        texture_paths[i] = texture_table[i].filename;
+    }
+    // -- all textures are read in parallel and uploaded through the ring, identical images are loaded once
+    if (!UploadRing_Init(&render_ctx->upload_ring, render_ctx->device, UPLOAD_RING_SIZE)) {
+        ::printf("[ERROR] UploadRing_Init() failed at line %d. \n", __LINE__);
+        ::abort();
+    }
+    TextureRegistry_Init(&render_ctx->texture_registry, render_ctx->device, render_ctx->srv_heap, 0, _COUNT_TEX);
+    if (!TextureBatch_Load(
+        render_ctx->device, render_ctx->direct_cmd_list, render_ctx->cmd_queue, render_ctx->direct_cmd_list_alloc, &render_ctx->texture_registry,
+        texture_paths, _COUNT_TEX, 0, DDS_LOADER_DEFAULT, texture_entries, &render_ctx->upload_ring
+    ))
+        printf("some textures could not be loaded\n");
+    for (UINT i = 0; i < _countof(texture_table); ++i) {
+        int entry = texture_entries[i];
+        render_ctx->texture_entries[texture_table[i].index] = entry;
+        render_ctx->textures[texture_table[i].index].resource = entry >= 0 ? render_ctx->texture_registry.entries[entry].resource : nullptr;
+    }
+#pragma endregion
+
 #pragma region Dsv_Creation
 // Create the depth/stencil buffer and view.
     D3D12_RESOURCE_DESC ds_desc;
@@ -2739,7 +2593,11 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     create_water_geometry(waves->nrow, waves->ncol, waves->ntri, render_ctx);
     create_treesprites_geometry(render_ctx);
     create_shape_geometry(render_ctx);
-    create_materials(render_ctx->materials);
+    // -- a texture that failed to load leaves its materials on the first SRV
+    UINT texture_srvs[_COUNT_TEX];
+    for (UINT i = 0; i < _COUNT_TEX; ++i)
+        texture_srvs[i] = render_ctx->texture_entries[i] >= 0 ? TextureRegistry_GetSrvIndex(&render_ctx->texture_registry, render_ctx->texture_entries[i]) : 0;
+    create_materials(texture_srvs, render_ctx->materials);
     create_render_items(render_ctx, waves);
 
 #pragma endregion Shapes_And_Renderitem_Creation
@@ -2751,6 +2609,7 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     CHECK_AND_FAIL(render_ctx->direct_cmd_list->Close());
     ID3D12CommandList * cmd_lists [] = {render_ctx->direct_cmd_list};
     render_ctx->cmd_queue->ExecuteCommandLists(ARRAY_COUNT(cmd_lists), cmd_lists);
+    UploadRing_Submit(&render_ctx->upload_ring, render_ctx->cmd_queue);
 
     //----------------
     // Create fence
@@ -2772,6 +2631,9 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     // we just want to wait for setup to complete before continuing.
     flush_command_queue(render_ctx);
 
+    // -- nothing else goes through the ring
+    UploadRing_Destroy(&render_ctx->upload_ring);
+
 #pragma endregion
 
 #pragma region Imgui Setup
@@ -2976,10 +2838,8 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
 
     render_ctx->depth_stencil_buffer->Release();
 
-    for (unsigned i = 0; i < _COUNT_TEX; i++) {
-        render_ctx->textures[i].upload_heap->Release();
-        render_ctx->textures[i].resource->Release();
-    }
+    for (unsigned i = 0; i < _COUNT_TEX; i++)
+        TextureRegistry_Release(&render_ctx->texture_registry, render_ctx->texture_entries[i]);
 
     //render_ctx->swapchain3->Release();
     render_ctx->swapchain->Release();
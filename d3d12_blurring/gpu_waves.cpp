@@ -105,11 +105,11 @@ GpuWaves_Init (BYTE * memory, ID3D12GraphicsCommandList* cmdlist, ID3D12Device *
     // curr_sol should be GENERIC_READ so it can be read by vertex shader
     //
     resource_usage_transition(cmdlist, ret->prev_sol, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST);
-    update_subresources_heap(cmdlist, ret->prev_sol, ret->prev_upload_buffer, 0, 0, num_2dsubresources, &subresource_data);
+    update_subresources(cmdlist, ret->prev_sol, ret->prev_upload_buffer, 0, 0, num_2dsubresources, &subresource_data);
     resource_usage_transition(cmdlist, ret->prev_sol, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
     resource_usage_transition(cmdlist, ret->curr_sol, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST);
-    update_subresources_heap(cmdlist, ret->curr_sol, ret->curr_upload_buffer, 0, 0, num_2dsubresources, &subresource_data);
+    update_subresources(cmdlist, ret->curr_sol, ret->curr_upload_buffer, 0, 0, num_2dsubresources, &subresource_data);
     resource_usage_transition(cmdlist, ret->curr_sol, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ);
 
     resource_usage_transition(cmdlist, ret->next_sol, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
@@ -0,0 +1,44 @@
+#pragma once
+#include "headers/common.h"
+
+// NOTE(omid): Loads a whole texture table in one go instead of one texture after another:
+//  1. workers map the DDS files and hash their contents (see TextureRegistry_HashDDS)
+//  2. the caller looks the hashes up: images the registry already has, or that an earlier path of the
+//     table has, only take a reference (the same image under another name is loaded once)
+//  3. workers create the resources of the new images and query their footprints
+//  4. the caller takes an allocation of the upload ring per new image; when the next one doesn't fit,
+//     the images allocated so far go through 5. and 6. and the command list is executed to make room
+//     (so the table isn't limited to the size of the ring, only each image is)
+//  5. workers copy the subresources into their footprints in chunks of rows (about TEXTURE_BATCH_COPY_BYTES
+//     each, so one big texture doesn't leave the other threads idle); legacy pixel layouts are converted
+//     on the way, straight into the footprints (see DDS_CONVERSION)
+//  6. the caller records every copy followed by a single batch of barriers
+//  7. the new images are added to the registry (which creates their SRVs)
+
+#define TEXTURE_BATCH_MAX_THREADS   16
+#define TEXTURE_BATCH_COPY_BYTES    (256 * 1024)    // upload bytes a copy job aims for
+
+struct TextureRegistry;
+struct UploadRing;
+
+/*
+    Loads paths[i] and sets out_entries[i] to its registry entry (one reference per path).
+    The footprints are allocated from upload_ring, submit it (UploadRing_Submit) after executing cmd_list.
+    If the ring fills up, cmd_list is closed, executed on cmd_queue (the ring is submitted) and reset with cmd_allocator,
+    which must be the allocator it was recording with.
+    n_threads = 0 means hardware concurrency, load_flags are DDS_LOADER_FLAGS (e.g., DDS_LOADER_PREMULTIPLY_ALPHA).
+    Returns false if any texture failed (its entry is -1, the others are still loaded).
+*/
+bool
+TextureBatch_Load (
+    ID3D12Device * device,
+    ID3D12GraphicsCommandList * cmd_list,
+    ID3D12CommandQueue * cmd_queue,
+    ID3D12CommandAllocator * cmd_allocator,
+    TextureRegistry * registry,
+    wchar_t const * const paths [], UINT n_textures,
+    UINT n_threads,
+    unsigned int load_flags,
+    int out_entries [],
+    UploadRing * upload_ring
+);
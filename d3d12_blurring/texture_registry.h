@@ -0,0 +1,57 @@
+#pragma once
+#include "headers/common.h"
+
+// NOTE(omid): Textures shared by content instead of by file name.
+// An image is identified by a hash (XXH64) of the resource it describes (format, size, mips, array/cube/volume, texel conversion)
+// and of its texel data, so the same image under two names (or loaded twice) is one resource and one SRV:
+//  - entries are refcounted, every texture table slot that resolved to an entry holds one reference
+//  - entry i owns descriptor first_srv + i of the caller's heap, its SRV is created when the entry is added
+//    and the descriptor is reused once the last reference is released
+// Releasing doesn't wait for the GPU, the caller releases once nothing in flight samples the texture.
+
+#define TEXTURE_REGISTRY_MAX_ENTRIES    64
+
+struct TextureRegistryEntry {
+    uint64_t            hash;
+    ID3D12Resource *    resource;
+    UINT                ref_count;  // 0 for a free slot
+};
+struct TextureRegistry {
+    ID3D12Device *          device;
+    ID3D12DescriptorHeap *  srv_heap;
+    UINT                    first_srv;
+    UINT                    descriptor_size;
+    UINT                    n_slots;    // descriptors the registry may use, at most TEXTURE_REGISTRY_MAX_ENTRIES
+    TextureRegistryEntry    entries[TEXTURE_REGISTRY_MAX_ENTRIES];
+};
+
+// The registry hands out descriptors [first_srv, first_srv + n_srvs) of srv_heap
+void
+TextureRegistry_Init (TextureRegistry * registry, ID3D12Device * device, ID3D12DescriptorHeap * srv_heap, UINT first_srv, UINT n_srvs);
+
+/*
+    Content hash of a whole DDS file in memory (names, writer specific header fields and padding aren't part of it),
+    loaded with load_flags (DDS_LOADER_FLAGS that convert the texels make a different image).
+    Returns false if the headers aren't valid.
+*/
+bool
+TextureRegistry_HashDDS (BYTE const * dds_data, size_t dds_size, unsigned int load_flags, uint64_t * out_hash);
+
+// Entry holding the image with that hash (one more reference), -1 if there is none
+int
+TextureRegistry_Acquire (TextureRegistry * registry, uint64_t hash);
+
+/*
+    Adds the resource under hash with one reference (the registry takes over the caller's reference)
+    and creates its SRV. Returns -1 if every slot is taken, the resource is left to the caller then.
+*/
+int
+TextureRegistry_Add (TextureRegistry * registry, uint64_t hash, ID3D12Resource * resource, bool is_cube_map);
+
+// Drops one reference, the last one releases the resource and frees the slot
+void
+TextureRegistry_Release (TextureRegistry * registry, int entry);
+
+// Index of the entry's SRV in the heap the registry was given
+UINT
+TextureRegistry_GetSrvIndex (TextureRegistry const * registry, int entry);
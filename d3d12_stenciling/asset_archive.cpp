@@ -0,0 +1,426 @@
+#include "asset_archive.h"
+#include "asset_cache.h"
+
+#include <algorithm>
+
+// -- LZ4 block format: sequences of [token | literal length | literals | offset | match length]
+#define LZ4_MIN_MATCH       4
+#define LZ4_LAST_LITERALS   5       // the block always ends with at least 5 literals
+#define LZ4_MF_LIMIT        12      // the last match starts at least 12 bytes before the end
+#define LZ4_MAX_OFFSET      65535
+#define LZ4_HASH_BITS       16
+
+static inline uint32_t
+read32 (BYTE const * p) {
+    uint32_t ret;
+    memcpy(&ret, p, sizeof(ret));
+    return ret;
+}
+static inline uint32_t
+lz4_hash (uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+static size_t
+lz4_compress_bound (size_t size) {
+    return size + size / 255 + 16;
+}
+static BYTE *
+lz4_write_length (BYTE * op, size_t length) {
+    for (; length >= 255; length -= 255)
+        *op++ = 255;
+    *op++ = (BYTE)length;
+    return op;
+}
+// Greedy single-probe compressor, returns the compressed size (dst holds lz4_compress_bound bytes)
+static size_t
+lz4_compress (BYTE const * src, size_t size, BYTE * dst, uint32_t * hash_table) {
+    memset(hash_table, 0xff, sizeof(uint32_t) << LZ4_HASH_BITS);
+    BYTE * op = dst;
+    size_t anchor = 0;
+    if (size > LZ4_MF_LIMIT) {
+        size_t match_limit = size - LZ4_LAST_LITERALS;
+        size_t ip = 0;
+        UINT misses = 0;
+        while (ip + LZ4_MF_LIMIT <= size) {
+            uint32_t sequence = read32(src + ip);
+            uint32_t h = lz4_hash(sequence);
+            uint32_t ref = hash_table[h];
+            hash_table[h] = (uint32_t)ip;
+            if (UINT32_MAX == ref || ip - ref > LZ4_MAX_OFFSET || read32(src + ref) != sequence) {
+                ip += 1 + (misses++ >> 6);  // skip faster through data that doesn't compress
+                continue;
+            }
+            misses = 0;
+
+            size_t match_length = LZ4_MIN_MATCH;
+            while (ip + match_length < match_limit && src[ref + match_length] == src[ip + match_length])
+                ++match_length;
+
+            // -- sequence
+            size_t literal_length = ip - anchor;
+            size_t ml = match_length - LZ4_MIN_MATCH;
+            BYTE * token = op++;
+            *token = (BYTE)(((literal_length < 15 ? literal_length : 15) << 4) | (ml < 15 ? ml : 15));
+            if (literal_length >= 15)
+                op = lz4_write_length(op, literal_length - 15);
+            memcpy(op, src + anchor, literal_length);
+            op += literal_length;
+            size_t offset = ip - ref;
+            *op++ = (BYTE)(offset & 0xff);
+            *op++ = (BYTE)(offset >> 8);
+            if (ml >= 15)
+                op = lz4_write_length(op, ml - 15);
+
+            ip += match_length;
+            anchor = ip;
+        }
+    }
+
+    // -- last literals
+    size_t literal_length = size - anchor;
+    *op++ = (BYTE)((literal_length < 15 ? literal_length : 15) << 4);
+    if (literal_length >= 15)
+        op = lz4_write_length(op, literal_length - 15);
+    memcpy(op, src + anchor, literal_length);
+    op += literal_length;
+    return (size_t)(op - dst);
+}
+static bool
+lz4_read_length (BYTE const * src, size_t size, size_t * ip, size_t * length) {
+    BYTE b;
+    do {
+        if (*ip >= size)
+            return false;
+        b = src[(*ip)++];
+        *length += b;
+    } while (255 == b);
+    return true;
+}
+// Bounds-checked decoder, fails on anything that doesn't decode to exactly dst_size bytes
+static bool
+lz4_decompress (BYTE const * src, size_t size, BYTE * dst, size_t dst_size) {
+    size_t ip = 0;
+    size_t op = 0;
+    while (ip < size) {
+        BYTE token = src[ip++];
+
+        size_t literal_length = token >> 4;
+        if (15 == literal_length && !lz4_read_length(src, size, &ip, &literal_length))
+            return false;
+        if (literal_length > size - ip || literal_length > dst_size - op)
+            return false;
+        memcpy(dst + op, src + ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+        if (ip == size)
+            break;  // last sequence has no match
+
+        if (size - ip < 2)
+            return false;
+        size_t offset = src[ip] | ((size_t)src[ip + 1] << 8);
+        ip += 2;
+        if (0 == offset || offset > op)
+            return false;
+        size_t match_length = token & 15;
+        if (15 == match_length && !lz4_read_length(src, size, &ip, &match_length))
+            return false;
+        match_length += LZ4_MIN_MATCH;
+        if (match_length > dst_size - op)
+            return false;
+
+        // -- the match may overlap the bytes it produces
+        BYTE const * match = dst + op - offset;
+        if (offset >= match_length) {
+            memcpy(dst + op, match, match_length);
+        } else {
+            for (size_t i = 0; i < match_length; ++i)
+                dst[op + i] = match[i];
+        }
+        op += match_length;
+    }
+    return op == dst_size;
+}
+
+// -- names
+static UINT
+normalize_name (char const * path, char * out) {
+    // leading "./" and "../" (either separator)
+    for (;;) {
+        if ('.' == path[0] && ('/' == path[1] || '\\' == path[1]))
+            path += 2;
+        else if ('.' == path[0] && '.' == path[1] && ('/' == path[2] || '\\' == path[2]))
+            path += 3;
+        else
+            break;
+    }
+    UINT length = 0;
+    for (; path[length]; ++length) {
+        if (length + 1 >= ASSET_ARCHIVE_MAX_NAME)
+            return 0;
+        char c = path[length];
+        if ('\\' == c)
+            c = '/';
+        else if (c >= 'A' && c <= 'Z')
+            c = c - 'A' + 'a';
+        out[length] = c;
+    }
+    out[length] = '\0';
+    return length;
+}
+uint64_t
+AssetArchive_HashSources (AssetArchiveSource const sources [], UINT n_sources) {
+    uint64_t ret = ASSET_ARCHIVE_VERSION;
+    char name[ASSET_ARCHIVE_MAX_NAME];
+    for (UINT i = 0; i < n_sources; ++i) {
+        UINT name_length = normalize_name(sources[i].path, name);
+        BYTE compress = sources[i].compress ? 1 : 0;
+        ret = AssetCache_Hash(name, name_length + 1, ret);
+        ret = AssetCache_Hash(&compress, 1, ret);
+    }
+    return ret;
+}
+// Size and last write time of a loose file, false if it's not there
+static bool
+get_source_stamp (char const * path, uint64_t * out_size, uint64_t * out_write_time) {
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (!::GetFileAttributesExA(path, GetFileExInfoStandard, &attributes))
+        return false;
+    *out_size = ((uint64_t)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+    *out_write_time = ((uint64_t)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+    return true;
+}
+
+// -- builder
+struct BuildEntry {
+    char        name[ASSET_ARCHIVE_MAX_NAME];
+    MappedFile  file;
+    BYTE *      compressed;     // null if stored as is
+    size_t      stored_size;
+};
+static uint64_t
+align_offset (uint64_t offset) {
+    return (offset + ASSET_ARCHIVE_ALIGNMENT - 1) & ~(uint64_t)(ASSET_ARCHIVE_ALIGNMENT - 1);
+}
+static bool
+write_blob (FILE * f, uint64_t * offset, uint64_t blob_offset, void const * data, size_t size) {
+    static BYTE const zeros[ASSET_ARCHIVE_ALIGNMENT] = {};
+    size_t padding = (size_t)(blob_offset - *offset);
+    if (padding > 0 && padding != fwrite(zeros, 1, padding, f))
+        return false;
+    if (size > 0 && size != fwrite(data, 1, size, f))
+        return false;
+    *offset = blob_offset + size;
+    return true;
+}
+bool
+AssetArchive_Build (char const * path, AssetArchiveSource const sources [], UINT n_sources) {
+    BuildEntry * build = (BuildEntry *)::calloc(n_sources, sizeof(BuildEntry));
+    AssetArchiveEntry * toc = (AssetArchiveEntry *)::calloc(n_sources, sizeof(AssetArchiveEntry));
+    uint32_t * hash_table = (uint32_t *)::malloc(sizeof(uint32_t) << LZ4_HASH_BITS);
+
+    // -- read (and compress) the sources
+    bool ret = true;
+    uint64_t names_size = 0;
+    for (UINT i = 0; ret && i < n_sources; ++i) {
+        BuildEntry * e = &build[i];
+        toc[i].name_length = normalize_name(sources[i].path, e->name);
+        // -- stamped before reading, a write in between only costs a repack next time
+        uint64_t stamp_size = 0;
+        get_source_stamp(sources[i].path, &stamp_size, &toc[i].source_write_time);
+        ret = toc[i].name_length > 0 && MappedFile_Open(sources[i].path, &e->file);
+        if (!ret) {
+            printf("could not pack %s\n", sources[i].path);
+            break;
+        }
+        toc[i].name_hash = AssetCache_Hash(e->name, toc[i].name_length, 0);
+        toc[i].name_offset = (uint32_t)names_size;
+        toc[i].size = e->file.size;
+        names_size += toc[i].name_length;
+
+        // -- keep compression only if it saves at least an eighth
+        e->stored_size = e->file.size;
+        if (sources[i].compress) {
+            e->compressed = (BYTE *)::malloc(lz4_compress_bound(e->file.size));
+            size_t compressed_size = lz4_compress(e->file.data, e->file.size, e->compressed, hash_table);
+            if (compressed_size <= e->file.size - e->file.size / 8) {
+                e->stored_size = compressed_size;
+                toc[i].compression = ASSET_ARCHIVE_COMPRESSION_LZ4;
+            } else {
+                ::free(e->compressed);
+                e->compressed = nullptr;
+            }
+        }
+        toc[i].stored_size = e->stored_size;
+
+        for (UINT j = 0; j < i; ++j) {
+            if (toc[j].name_hash == toc[i].name_hash && 0 == strcmp(build[j].name, e->name)) {
+                printf("%s is packed twice\n", e->name);
+                ret = false;
+            }
+        }
+    }
+
+    // -- layout: header, TOC, names, then the entries in source order
+    AssetArchiveHeader header = {};
+    header.magic = ASSET_ARCHIVE_MAGIC;
+    header.version = ASSET_ARCHIVE_VERSION;
+    header.entry_count = n_sources;
+    header.toc_offset = sizeof(AssetArchiveHeader);
+    header.names_offset = header.toc_offset + sizeof(AssetArchiveEntry) * n_sources;
+    header.names_size = names_size;
+    header.sources_hash = AssetArchive_HashSources(sources, n_sources);
+    uint64_t data_offset = header.names_offset + names_size;
+    for (UINT i = 0; i < n_sources; ++i) {
+        toc[i].offset = align_offset(data_offset);
+        data_offset = toc[i].offset + toc[i].stored_size;
+    }
+
+    FILE * f = nullptr;
+    if (ret && (0 != fopen_s(&f, path, "wb") || nullptr == f))
+        ret = false;
+    if (ret) {
+        uint64_t offset = 0;
+        ret = write_blob(f, &offset, 0, &header, sizeof(header));
+
+        // -- TOC sorted by name hash for the lookup
+        AssetArchiveEntry * sorted_toc = (AssetArchiveEntry *)::malloc(sizeof(AssetArchiveEntry) * n_sources);
+        memcpy(sorted_toc, toc, sizeof(AssetArchiveEntry) * n_sources);
+        std::sort(sorted_toc, sorted_toc + n_sources, [](AssetArchiveEntry const & a, AssetArchiveEntry const & b) {
+            return a.name_hash < b.name_hash;
+        });
+        ret = ret && write_blob(f, &offset, header.toc_offset, sorted_toc, sizeof(AssetArchiveEntry) * n_sources);
+        ::free(sorted_toc);
+
+        for (UINT i = 0; ret && i < n_sources; ++i)
+            ret = write_blob(f, &offset, offset, build[i].name, toc[i].name_length);
+        for (UINT i = 0; ret && i < n_sources; ++i) {
+            BYTE const * data = build[i].compressed ? build[i].compressed : build[i].file.data;
+            ret = write_blob(f, &offset, toc[i].offset, data, build[i].stored_size);
+        }
+        if (0 != fclose(f))
+            ret = false;
+        if (!ret)
+            remove(path);   // never leave a truncated archive behind
+    }
+
+    // -- cleanup
+    for (UINT i = 0; i < n_sources; ++i) {
+        MappedFile_Close(&build[i].file);
+        ::free(build[i].compressed);
+    }
+    ::free(hash_table);
+    ::free(toc);
+    ::free(build);
+    return ret;
+}
+
+// -- reader
+bool
+AssetArchive_Open (char const * path, AssetArchive * out) {
+    *out = {};
+    if (!MappedFile_Open(path, &out->file))
+        return false;
+
+    AssetArchiveHeader const * header = reinterpret_cast<AssetArchiveHeader const *>(out->file.data);
+    size_t file_size = out->file.size;
+    bool ret =
+        file_size >= sizeof(AssetArchiveHeader) &&
+        ASSET_ARCHIVE_MAGIC == header->magic &&
+        ASSET_ARCHIVE_VERSION == header->version &&
+        0 == header->toc_offset % alignof(AssetArchiveEntry) &&
+        header->toc_offset <= file_size &&
+        header->entry_count <= (file_size - header->toc_offset) / sizeof(AssetArchiveEntry) &&
+        header->names_offset <= file_size &&
+        header->names_size <= file_size - header->names_offset;
+    if (!ret) {
+        AssetArchive_Close(out);
+        return false;
+    }
+    out->header = header;
+    out->entries = reinterpret_cast<AssetArchiveEntry const *>(out->file.data + header->toc_offset);
+    out->names = reinterpret_cast<char const *>(out->file.data + header->names_offset);
+
+    // -- entries lie in the file, names in the table, and the TOC is sorted
+    for (UINT i = 0; i < header->entry_count; ++i) {
+        AssetArchiveEntry const & e = out->entries[i];
+        bool valid =
+            0 == e.offset % ASSET_ARCHIVE_ALIGNMENT &&
+            e.offset <= file_size &&
+            e.stored_size <= file_size - e.offset &&
+            (uint64_t)e.name_offset + e.name_length <= header->names_size &&
+            (ASSET_ARCHIVE_COMPRESSION_LZ4 == e.compression ||
+             (ASSET_ARCHIVE_COMPRESSION_NONE == e.compression && e.stored_size == e.size)) &&
+            (0 == i || out->entries[i - 1].name_hash <= e.name_hash);
+        if (!valid) {
+            AssetArchive_Close(out);
+            return false;
+        }
+    }
+    return true;
+}
+bool
+AssetArchive_IsUpToDate (AssetArchive const * archive, AssetArchiveSource const sources [], UINT n_sources) {
+    if (nullptr == archive->header || AssetArchive_HashSources(sources, n_sources) != archive->header->sources_hash)
+        return false;
+    for (UINT i = 0; i < n_sources; ++i) {
+        int entry = AssetArchive_Find(archive, sources[i].path);
+        if (entry < 0)
+            return false;
+        uint64_t size = 0;
+        uint64_t write_time = 0;
+        if (get_source_stamp(sources[i].path, &size, &write_time) &&
+            (size != archive->entries[entry].size || write_time != archive->entries[entry].source_write_time))
+            return false;
+    }
+    return true;
+}
+void
+AssetArchive_Close (AssetArchive * archive) {
+    MappedFile_Close(&archive->file);
+    *archive = {};
+}
+int
+AssetArchive_Find (AssetArchive const * archive, char const * path) {
+    if (nullptr == archive->header)
+        return -1;
+    char name[ASSET_ARCHIVE_MAX_NAME];
+    UINT name_length = normalize_name(path, name);
+    if (0 == name_length)
+        return -1;
+    uint64_t hash = AssetCache_Hash(name, name_length, 0);
+
+    AssetArchiveEntry const * begin = archive->entries;
+    AssetArchiveEntry const * end = begin + archive->header->entry_count;
+    AssetArchiveEntry const * it = std::lower_bound(begin, end, hash, [](AssetArchiveEntry const & e, uint64_t h) {
+        return e.name_hash < h;
+    });
+    for (; it != end && it->name_hash == hash; ++it)
+        if (it->name_length == name_length && 0 == memcmp(archive->names + it->name_offset, name, name_length))
+            return (int)(it - begin);
+    return -1;
+}
+int
+AssetArchive_FindW (AssetArchive const * archive, wchar_t const * path) {
+    // -- names are ASCII
+    char narrow[ASSET_ARCHIVE_MAX_NAME];
+    UINT i = 0;
+    for (; path[i]; ++i) {
+        if (i + 1 >= ASSET_ARCHIVE_MAX_NAME || path[i] > 127)
+            return -1;
+        narrow[i] = (char)path[i];
+    }
+    narrow[i] = '\0';
+    return AssetArchive_Find(archive, narrow);
+}
+bool
+AssetArchive_Extract (AssetArchive const * archive, int entry, void * dst, size_t dst_size) {
+    AssetArchiveEntry const & e = archive->entries[entry];
+    if (dst_size < e.size)
+        return false;
+    BYTE const * data = AssetArchive_GetStoredData(archive, entry);
+    if (ASSET_ARCHIVE_COMPRESSION_NONE == e.compression) {
+        memcpy(dst, data, (size_t)e.size);
+        return true;
+    }
+    return lz4_decompress(data, (size_t)e.stored_size, reinterpret_cast<BYTE *>(dst), (size_t)e.size);
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "mapped_file.h"
+
+// NOTE(omid): Packed archive of loose asset files (textures, models, ...), served from one mapping:
+//   [ header | table of contents | name table | entry 0 | entry 1 | ... ]
+// - entries are addressed by their normalized relative path: lowercase, '/' separators and no leading
+//   "./" or "../", so "../Textures/ice.dds" and "textures\\ice.dds" both name "textures/ice.dds"
+// - the TOC is sorted by the XXH64 of the names, a lookup is a binary search plus one name compare
+// - entry data is ASSET_ARCHIVE_ALIGNMENT aligned and laid out in build order, so loading in that
+//   order reads the file front to back
+// - an entry is either stored as is (usable straight from the mapping) or LZ4 compressed
+//   (standard LZ4 block format), the builder keeps compression only where it actually pays off
+// - every entry remembers the size and last write time of the loose file it was packed from,
+//   AssetArchive_IsUpToDate compares them against the sources to tell when a repack is needed
+
+#define ASSET_ARCHIVE_MAGIC         0x4b415041u     // "APAK"
+#define ASSET_ARCHIVE_VERSION       2u
+#define ASSET_ARCHIVE_ALIGNMENT     4096u
+#define ASSET_ARCHIVE_MAX_NAME      260
+
+enum ASSET_ARCHIVE_COMPRESSION : uint32_t {
+    ASSET_ARCHIVE_COMPRESSION_NONE = 0,
+    ASSET_ARCHIVE_COMPRESSION_LZ4 = 1
+};
+
+struct AssetArchiveEntry {
+    uint64_t    name_hash;
+    uint64_t    offset;             // from the beginning of the file
+    uint64_t    stored_size;        // bytes in the archive
+    uint64_t    size;               // bytes once extracted
+    uint32_t    name_offset;        // into the name table (not null-terminated)
+    uint32_t    name_length;
+    uint32_t    compression;
+    uint32_t    reserved;
+    uint64_t    source_write_time;  // FILETIME of the loose file when it was packed (its size is size)
+};
+static_assert(56 == sizeof(AssetArchiveEntry), "Archive entry layout changed");
+
+struct AssetArchiveHeader {
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    entry_count;
+    uint32_t    reserved;
+
+    uint64_t    toc_offset;
+    uint64_t    names_offset;
+    uint64_t    names_size;
+
+    // hash of the build inputs (names and compression flags), tells if the archive matches a source list
+    uint64_t    sources_hash;
+};
+static_assert(48 == sizeof(AssetArchiveHeader), "Archive header layout changed");
+
+struct AssetArchive {
+    MappedFile                  file;
+
+    AssetArchiveHeader const *  header;
+    AssetArchiveEntry const *   entries;
+    char const *                names;
+};
+
+// A loose file to pack, it's named after its normalized path
+struct AssetArchiveSource {
+    char const *    path;
+    bool            compress;
+};
+
+// Hash of a source list as stored in the header
+uint64_t
+AssetArchive_HashSources (AssetArchiveSource const sources [], UINT n_sources);
+
+/*
+    True if the archive was built from this source list and no loose source changed since (size or last write time).
+    A source that isn't on disk anymore is served from the archive as it is.
+*/
+bool
+AssetArchive_IsUpToDate (AssetArchive const * archive, AssetArchiveSource const sources [], UINT n_sources);
+
+/*
+    Packs the sources in the given order. Returns false (and leaves no file behind)
+    if a source can't be read, two sources share a name or the file can't be written.
+*/
+bool
+AssetArchive_Build (char const * path, AssetArchiveSource const sources [], UINT n_sources);
+
+/*
+    Maps the archive and validates the header, TOC and name table.
+    Returns false if it's missing or malformed.
+*/
+bool
+AssetArchive_Open (char const * path, AssetArchive * out);
+
+void
+AssetArchive_Close (AssetArchive * archive);
+
+// Entry index of a path (normalized before the lookup), -1 if it's not packed or the archive isn't open
+int
+AssetArchive_Find (AssetArchive const * archive, char const * path);
+int
+AssetArchive_FindW (AssetArchive const * archive, wchar_t const * path);
+
+// Stored bytes of an entry, ready to use without a copy if the entry isn't compressed
+inline BYTE const *
+AssetArchive_GetStoredData (AssetArchive const * archive, int entry) {
+    return archive->file.data + archive->entries[entry].offset;
+}
+
+/*
+    Copies or decompresses an entry into dst (at least entries[entry].size bytes).
+    Returns false if the compressed data is corrupt.
+*/
+bool
+AssetArchive_Extract (AssetArchive const * archive, int entry, void * dst, size_t dst_size);
@@ -0,0 +1,196 @@
+#include "asset_cache.h"
+
+#include <algorithm>
+
+// -- XXH64 (reference algorithm, little-endian reads)
+static uint64_t const XXH_PRIME64_1 = 0x9E3779B185EBCA87ull;
+static uint64_t const XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+static uint64_t const XXH_PRIME64_3 = 0x165667B19E3779F9ull;
+static uint64_t const XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+static uint64_t const XXH_PRIME64_5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t
+rotl64 (uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+static inline uint64_t
+read64 (BYTE const * p) {
+    uint64_t ret;
+    memcpy(&ret, p, sizeof(ret));
+    return ret;
+}
+static inline uint32_t
+read32 (BYTE const * p) {
+    uint32_t ret;
+    memcpy(&ret, p, sizeof(ret));
+    return ret;
+}
+static inline uint64_t
+xxh64_round (uint64_t acc, uint64_t input) {
+    acc += input * XXH_PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * XXH_PRIME64_1;
+}
+static inline uint64_t
+xxh64_merge_round (uint64_t acc, uint64_t val) {
+    acc ^= xxh64_round(0, val);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+uint64_t
+AssetCache_Hash (void const * data, size_t size, uint64_t seed) {
+    BYTE const * p = reinterpret_cast<BYTE const *>(data);
+    BYTE const * end = p + size;
+    uint64_t h;
+
+    // -- 4 independent lanes over 32-byte stripes
+    if (size >= 32) {
+        uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+        uint64_t v2 = seed + XXH_PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - XXH_PRIME64_1;
+        BYTE const * limit = end - 32;
+        do {
+            v1 = xxh64_round(v1, read64(p + 0));
+            v2 = xxh64_round(v2, read64(p + 8));
+            v3 = xxh64_round(v3, read64(p + 16));
+            v4 = xxh64_round(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh64_merge_round(h, v1);
+        h = xxh64_merge_round(h, v2);
+        h = xxh64_merge_round(h, v3);
+        h = xxh64_merge_round(h, v4);
+    } else {
+        h = seed + XXH_PRIME64_5;
+    }
+    h += (uint64_t)size;
+
+    // -- tail
+    for (; p + 8 <= end; p += 8) {
+        h ^= xxh64_round(0, read64(p));
+        h = rotl64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)read32(p) * XXH_PRIME64_1;
+        h = rotl64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= (*p) * XXH_PRIME64_5;
+        h = rotl64(h, 11) * XXH_PRIME64_1;
+    }
+
+    // -- avalanche
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+uint64_t
+AssetCache_MakeKey (void const * source, size_t source_size, void const * params, size_t params_size) {
+    return AssetCache_Hash(source, source_size, AssetCache_Hash(params, params_size, 0));
+}
+bool
+AssetCache_Init (AssetCache * cache, char const * dir, uint64_t max_bytes) {
+    *cache = {};
+    if (strlen(dir) + 1 > sizeof(cache->dir))
+        return false;
+    strcpy_s(cache->dir, sizeof(cache->dir), dir);
+    cache->max_bytes = max_bytes;
+    return ::CreateDirectoryA(dir, nullptr) || ERROR_ALREADY_EXISTS == ::GetLastError();
+}
+void
+AssetCache_GetPath (AssetCache const * cache, uint64_t key, char * out_path, size_t out_size) {
+    sprintf_s(out_path, out_size, "%s/%016llx.bin", cache->dir, (unsigned long long)key);
+}
+void
+AssetCache_GetTempPath (AssetCache const * cache, uint64_t key, char * out_path, size_t out_size) {
+    sprintf_s(
+        out_path, out_size, "%s/%016llx.%lu.%lu.tmp",
+        cache->dir, (unsigned long long)key, (unsigned long)::GetCurrentProcessId(), (unsigned long)::GetCurrentThreadId()
+    );
+}
+bool
+AssetCache_Lookup (AssetCache * cache, uint64_t key) {
+    char path[ASSET_CACHE_MAX_PATH];
+    AssetCache_GetPath(cache, key, path, sizeof(path));
+
+    // -- only the attributes are opened, readers mapping the entry are not disturbed
+    HANDLE file = ::CreateFileA(
+        path, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+    );
+    if (INVALID_HANDLE_VALUE == file)
+        return false;
+    FILETIME now;
+    ::GetSystemTimeAsFileTime(&now);
+    ::SetFileTime(file, nullptr, nullptr, &now);
+    ::CloseHandle(file);
+    return true;
+}
+struct CacheEntry {
+    char        name[ASSET_CACHE_MAX_PATH];
+    uint64_t    size;
+    uint64_t    last_write;
+};
+static void
+evict (AssetCache * cache, uint64_t keep_key) {
+    char pattern[ASSET_CACHE_MAX_PATH];
+    char keep_name[32];
+    sprintf_s(pattern, sizeof(pattern), "%s/*.bin", cache->dir);
+    sprintf_s(keep_name, sizeof(keep_name), "%016llx.bin", (unsigned long long)keep_key);
+
+    // -- list entries, stop early if the budget holds
+    WIN32_FIND_DATAA find_data;
+    HANDLE find = ::FindFirstFileA(pattern, &find_data);
+    if (INVALID_HANDLE_VALUE == find)
+        return;
+    UINT n_entries = 0;
+    UINT max_entries = 64;
+    CacheEntry * entries = (CacheEntry *)::malloc(sizeof(CacheEntry) * max_entries);
+    uint64_t total = 0;
+    do {
+        if (find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+        if (n_entries == max_entries) {
+            max_entries *= 2;
+            entries = (CacheEntry *)::realloc(entries, sizeof(CacheEntry) * max_entries);
+        }
+        CacheEntry * e = &entries[n_entries++];
+        strcpy_s(e->name, sizeof(e->name), find_data.cFileName);
+        e->size = ((uint64_t)find_data.nFileSizeHigh << 32) | find_data.nFileSizeLow;
+        e->last_write = ((uint64_t)find_data.ftLastWriteTime.dwHighDateTime << 32) | find_data.ftLastWriteTime.dwLowDateTime;
+        total += e->size;
+    } while (::FindNextFileA(find, &find_data));
+    ::FindClose(find);
+
+    // -- oldest first
+    if (total > cache->max_bytes) {
+        std::sort(entries, entries + n_entries, [](CacheEntry const & a, CacheEntry const & b) {
+            return a.last_write < b.last_write;
+        });
+        for (UINT i = 0; i < n_entries && total > cache->max_bytes; ++i) {
+            if (0 == strcmp(entries[i].name, keep_name))
+                continue;
+            char path[ASSET_CACHE_MAX_PATH];
+            sprintf_s(path, sizeof(path), "%s/%s", cache->dir, entries[i].name);
+            if (::DeleteFileA(path))    // fails while another process has the entry mapped, skip it then
+                total -= entries[i].size;
+        }
+    }
+    ::free(entries);
+}
+bool
+AssetCache_Commit (AssetCache * cache, uint64_t key, char const * tmp_path) {
+    char path[ASSET_CACHE_MAX_PATH];
+    AssetCache_GetPath(cache, key, path, sizeof(path));
+    if (!::MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING)) {
+        ::DeleteFileA(tmp_path);
+        return false;
+    }
+    evict(cache, key);
+    return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "headers/common.h"
+
+// NOTE(omid): On-disk cache of derived data (baked meshes, processed textures, ...).
+// An entry is keyed by a 64-bit hash (XXH64) of the source bytes seeded with the hash of the
+// processing parameters, so editing the source or changing any import setting gives a new key and
+// stale entries can never be hit. Entries are plain files <dir>/<key>.bin:
+//  - producers write into a temporary file and AssetCache_Commit renames it over the entry,
+//    so readers never see a partial file (even with several processes sharing the cache)
+//  - a hit refreshes the entry's last write time, eviction removes the least recently used
+//    entries until the directory fits max_bytes again
+
+#define ASSET_CACHE_MAX_PATH    260
+
+struct AssetCache {
+    char        dir[ASSET_CACHE_MAX_PATH];
+    uint64_t    max_bytes;
+};
+
+// Creates the directory if needed
+bool
+AssetCache_Init (AssetCache * cache, char const * dir, uint64_t max_bytes);
+
+// XXH64 of the buffer
+uint64_t
+AssetCache_Hash (void const * data, size_t size, uint64_t seed);
+
+/*
+    Key of the data derived from source with the given parameters.
+    params is hashed as raw bytes, so it must not contain padding or pointers.
+*/
+uint64_t
+AssetCache_MakeKey (void const * source, size_t source_size, void const * params, size_t params_size);
+
+void
+AssetCache_GetPath (AssetCache const * cache, uint64_t key, char * out_path, size_t out_size);
+
+// Returns true on a hit (and marks the entry as recently used)
+bool
+AssetCache_Lookup (AssetCache * cache, uint64_t key);
+
+// Temporary file to produce the entry into (unique per process and thread)
+void
+AssetCache_GetTempPath (AssetCache const * cache, uint64_t key, char * out_path, size_t out_size);
+
+/*
+    Atomically replaces the entry with tmp_path, then evicts least recently used entries
+    (never the one just stored) if the cache is over budget. tmp_path is deleted on failure.
+*/
+bool
+AssetCache_Commit (AssetCache * cache, uint64_t key, char const * tmp_path);
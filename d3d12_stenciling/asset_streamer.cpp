@@ -0,0 +1,241 @@
+#include "asset_streamer.h"
+
+#include <new>
+
+#define STREAMER_HEADER_SIZE    ((sizeof(AssetStreamer) + 63) & ~(size_t)63)
+#define MAX_POLL_BATCH          64
+
+// -- heap of job slots: higher priority first, then older first
+static inline bool
+runs_before (AssetJob const * jobs, UINT a, UINT b) {
+    if (jobs[a].request.priority != jobs[b].request.priority)
+        return jobs[a].request.priority > jobs[b].request.priority;
+    return jobs[a].order < jobs[b].order;
+}
+static void
+heap_push (AssetJob const * jobs, UINT * heap, UINT * n, UINT slot) {
+    UINT i = (*n)++;
+    while (i > 0) {
+        UINT parent = (i - 1) / 2;
+        if (!runs_before(jobs, slot, heap[parent]))
+            break;
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = slot;
+}
+static UINT
+heap_pop (AssetJob const * jobs, UINT * heap, UINT * n) {
+    UINT ret = heap[0];
+    UINT last = heap[--(*n)];
+    UINT i = 0;
+    for (;;) {
+        UINT child = 2 * i + 1;
+        if (child >= *n)
+            break;
+        if (child + 1 < *n && runs_before(jobs, heap[child + 1], heap[child]))
+            ++child;
+        if (!runs_before(jobs, heap[child], last))
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (*n > 0)
+        heap[i] = last;
+    return ret;
+}
+static bool
+read_file_range (wchar_t const * path, uint64_t offset, size_t size, BYTE ** out_data, size_t * out_size) {
+    *out_data = nullptr;
+    *out_size = 0;
+    HANDLE file = ::CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (INVALID_HANDLE_VALUE == file)
+        return false;
+    LARGE_INTEGER file_size = {};
+    LARGE_INTEGER start = {};
+    start.QuadPart = (LONGLONG)offset;
+    bool ret = ::GetFileSizeEx(file, &file_size) && (uint64_t)file_size.QuadPart > offset &&
+        ::SetFilePointerEx(file, start, nullptr, FILE_BEGIN);
+    uint64_t available = ret ? (uint64_t)file_size.QuadPart - offset : 0;
+    size_t to_read = available < size ? (size_t)available : size;
+    BYTE * data = ret ? (BYTE *)::malloc(to_read) : nullptr;
+    size_t n_read = 0;
+    while (data && n_read < to_read) {
+        size_t remaining = to_read - n_read;
+        DWORD chunk = (DWORD)(remaining < ASSET_STREAMER_READ_CHUNK ? remaining : ASSET_STREAMER_READ_CHUNK);
+        DWORD chunk_read = 0;
+        if (!::ReadFile(file, data + n_read, chunk, &chunk_read, nullptr) || 0 == chunk_read)
+            break;
+        n_read += chunk_read;
+    }
+    ::CloseHandle(file);
+    if (nullptr == data || n_read != to_read) {
+        ::free(data);
+        return false;
+    }
+    *out_data = data;
+    *out_size = n_read;
+    return true;
+}
+static void
+io_thread_main (AssetStreamer * streamer) {
+    std::unique_lock<std::mutex> guard(streamer->lock);
+    for (;;) {
+        streamer->io_cv.wait(guard, [streamer]() { return streamer->quit || streamer->n_io > 0; });
+        if (streamer->quit)
+            return;
+        UINT slot = heap_pop(streamer->jobs, streamer->io_queue, &streamer->n_io);
+        AssetJob * job = &streamer->jobs[slot];
+
+        guard.unlock();
+        if (job->request.read)
+            job->ok = job->request.read(job->request.user_data, &job->data, &job->size);
+        else
+            job->ok = read_file_range(job->request.path, 0, SIZE_MAX, &job->data, &job->size);
+        guard.lock();
+
+        if (job->ok && job->request.decode) {
+            heap_push(streamer->jobs, streamer->decode_queue, &streamer->n_decode, slot);
+            streamer->decode_cv.notify_one();
+        } else {
+            streamer->completed[streamer->n_completed++] = slot;
+        }
+    }
+}
+static void
+decode_thread_main (AssetStreamer * streamer) {
+    std::unique_lock<std::mutex> guard(streamer->lock);
+    for (;;) {
+        streamer->decode_cv.wait(guard, [streamer]() { return streamer->quit || streamer->n_decode > 0; });
+        if (streamer->quit)
+            return;
+        UINT slot = heap_pop(streamer->jobs, streamer->decode_queue, &streamer->n_decode);
+        AssetJob * job = &streamer->jobs[slot];
+
+        guard.unlock();
+        job->ok = job->request.decode(job->request.user_data, job->data, job->size);
+        guard.lock();
+
+        streamer->completed[streamer->n_completed++] = slot;
+    }
+}
+size_t
+AssetStreamer_CalculateRequiredSize (UINT max_jobs) {
+    return
+        STREAMER_HEADER_SIZE +
+        sizeof(AssetJob) * max_jobs +
+        sizeof(UINT) * max_jobs * 4;    // free list, io queue, decode queue, completed
+}
+AssetStreamer *
+AssetStreamer_Init (BYTE * memory, UINT max_jobs, UINT n_io_threads, UINT n_decode_threads) {
+    if (0 == n_decode_threads) {
+        UINT n_cores = std::thread::hardware_concurrency();
+        n_decode_threads = n_cores > 1 ? n_cores - 1 : 1;
+    }
+    _ASSERT_EXPR(n_io_threads >= 1 && n_io_threads <= ASSET_STREAMER_MAX_IO_THREADS, "Invalid streamer I/O thread count");
+    if (n_decode_threads > ASSET_STREAMER_MAX_DECODE_THREADS)
+        n_decode_threads = ASSET_STREAMER_MAX_DECODE_THREADS;
+
+    AssetStreamer * ret = new (memory) AssetStreamer();
+    ret->max_jobs = max_jobs;
+
+    // Setup pointers (arrays)
+    ret->jobs = reinterpret_cast<AssetJob *>(memory + STREAMER_HEADER_SIZE);
+    ret->free_slots = reinterpret_cast<UINT *>(ret->jobs + max_jobs);
+    ret->io_queue = ret->free_slots + max_jobs;
+    ret->decode_queue = ret->io_queue + max_jobs;
+    ret->completed = ret->decode_queue + max_jobs;
+
+    // -- lowest slots are handed out first
+    ret->n_free = max_jobs;
+    for (UINT i = 0; i < max_jobs; ++i)
+        ret->free_slots[i] = max_jobs - 1 - i;
+
+    ret->n_io_threads = n_io_threads;
+    ret->n_decode_threads = n_decode_threads;
+    for (UINT i = 0; i < n_io_threads; ++i)
+        ret->io_threads[i] = std::thread(io_thread_main, ret);
+    for (UINT i = 0; i < n_decode_threads; ++i)
+        ret->decode_threads[i] = std::thread(decode_thread_main, ret);
+    return ret;
+}
+void
+AssetStreamer_Deinit (AssetStreamer * streamer) {
+    {
+        std::lock_guard<std::mutex> guard(streamer->lock);
+        streamer->quit = true;
+    }
+    streamer->io_cv.notify_all();
+    streamer->decode_cv.notify_all();
+    for (UINT i = 0; i < streamer->n_io_threads; ++i)
+        streamer->io_threads[i].join();
+    for (UINT i = 0; i < streamer->n_decode_threads; ++i)
+        streamer->decode_threads[i].join();
+
+    // -- slots not on the free list may still hold file data (free() ignores the null ones)
+    bool * is_free = (bool *)::calloc(streamer->max_jobs, sizeof(bool));
+    for (UINT i = 0; i < streamer->n_free; ++i)
+        is_free[streamer->free_slots[i]] = true;
+    for (UINT i = 0; i < streamer->max_jobs; ++i)
+        if (!is_free[i])
+            ::free(streamer->jobs[i].data);
+    ::free(is_free);
+
+    streamer->~AssetStreamer();
+}
+bool
+AssetStreamer_Submit (AssetStreamer * streamer, AssetRequest const & request) {
+    std::lock_guard<std::mutex> guard(streamer->lock);
+    if (0 == streamer->n_free)
+        return false;
+    UINT slot = streamer->free_slots[--streamer->n_free];
+    AssetJob * job = &streamer->jobs[slot];
+    job->request = request;
+    job->order = streamer->next_order++;
+    job->data = nullptr;
+    job->size = 0;
+    job->ok = false;
+    heap_push(streamer->jobs, streamer->io_queue, &streamer->n_io, slot);
+    streamer->n_pending++;
+    streamer->io_cv.notify_one();
+    return true;
+}
+UINT
+AssetStreamer_Poll (AssetStreamer * streamer, UINT max_completions) {
+    UINT slots[MAX_POLL_BATCH];
+    UINT n = 0;
+    {
+        std::lock_guard<std::mutex> guard(streamer->lock);
+        n = streamer->n_completed;
+        if (n > max_completions)
+            n = max_completions;
+        if (n > MAX_POLL_BATCH)
+            n = MAX_POLL_BATCH;
+        memcpy(slots, streamer->completed, sizeof(UINT) * n);
+        memmove(streamer->completed, streamer->completed + n, sizeof(UINT) * (streamer->n_completed - n));
+        streamer->n_completed -= n;
+    }
+
+    // -- callbacks run without the lock, they may submit new requests
+    for (UINT i = 0; i < n; ++i) {
+        AssetJob * job = &streamer->jobs[slots[i]];
+        job->request.complete(job->request.user_data, job->data, job->size, job->ok);
+        ::free(job->data);
+        job->data = nullptr;
+    }
+
+    std::lock_guard<std::mutex> guard(streamer->lock);
+    for (UINT i = 0; i < n; ++i)
+        streamer->free_slots[streamer->n_free++] = slots[i];
+    streamer->n_pending -= n;
+    return n;
+}
+UINT
+AssetStreamer_PendingCount (AssetStreamer * streamer) {
+    std::lock_guard<std::mutex> guard(streamer->lock);
+    return streamer->n_pending;
+}
+bool
+AssetStreamer_ReadFileRange (wchar_t const * path, uint64_t offset, size_t size, BYTE ** out_data, size_t * out_size) {
+    return read_file_range(path, offset, size, out_data, out_size);
+}
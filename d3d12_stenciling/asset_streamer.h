@@ -0,0 +1,108 @@
+#pragma once
+
+#include "headers/common.h"
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+// NOTE(omid): Asynchronous asset loading in three stages:
+//  1. I/O threads read whole files (or the ranges a read callback asks for) with large sequential reads (one request at a time per thread)
+//  2. decode workers turn the file bytes into something ready for the GPU (parse headers, create resources, ...)
+//  3. the main thread polls finished requests once per frame and runs their completion callbacks,
+//     which is where GPU uploads are recorded and placeholders get swapped for the real asset
+// Both the I/O and the decode queues are priority queues (higher priority first, FIFO among equals),
+// so what matters most on screen is read and decoded first.
+// Request slots, queues and the completion list live in the caller-provided memory block.
+
+#define ASSET_STREAMER_MAX_IO_THREADS       4
+#define ASSET_STREAMER_MAX_DECODE_THREADS   16
+#define ASSET_STREAMER_READ_CHUNK           (4 * 1024 * 1024)   // bytes per ReadFile call
+
+// I/O thread: replaces the file read for data that doesn't come from a loose file (malloc'd, freed by the streamer)
+typedef bool (*AssetReadFunc) (void * user_data, BYTE ** out_data, size_t * out_size);
+// Worker thread: returns false if the data can't be used (the completion then receives ok = false)
+typedef bool (*AssetDecodeFunc) (void * user_data, BYTE const * file_data, size_t file_size);
+// Main thread (AssetStreamer_Poll): file_data is released right after the callback returns
+typedef void (*AssetCompleteFunc) (void * user_data, BYTE const * file_data, size_t file_size, bool ok);
+
+struct AssetRequest {
+    wchar_t const *     path;       // must stay valid until the request completes
+    int                 priority;
+    AssetReadFunc       read;       // optional, path is ignored if set
+    AssetDecodeFunc     decode;     // optional
+    AssetCompleteFunc   complete;
+    void *              user_data;
+};
+
+struct AssetJob {
+    AssetRequest    request;
+    uint64_t        order;          // submission order, breaks priority ties
+    BYTE *          data;
+    size_t          size;
+    bool            ok;
+};
+
+struct AssetStreamer {
+    UINT        max_jobs;
+    AssetJob *  jobs;
+
+    // job slots: free list, binary heaps for the two stages, FIFO of finished jobs
+    UINT *      free_slots;
+    UINT        n_free;
+    UINT *      io_queue;
+    UINT        n_io;
+    UINT *      decode_queue;
+    UINT        n_decode;
+    UINT *      completed;
+    UINT        n_completed;
+
+    uint64_t    next_order;
+    UINT        n_pending;          // submitted and not polled yet
+    bool        quit;
+
+    std::mutex              lock;
+    std::condition_variable io_cv;
+    std::condition_variable decode_cv;
+
+    UINT        n_io_threads;
+    UINT        n_decode_threads;
+    std::thread io_threads[ASSET_STREAMER_MAX_IO_THREADS];
+    std::thread decode_threads[ASSET_STREAMER_MAX_DECODE_THREADS];
+};
+
+size_t
+AssetStreamer_CalculateRequiredSize (UINT max_jobs);
+
+/*
+    Starts the threads. n_decode_threads = 0 uses the hardware concurrency minus the main thread.
+*/
+AssetStreamer *
+AssetStreamer_Init (BYTE * memory, UINT max_jobs, UINT n_io_threads, UINT n_decode_threads);
+
+/*
+    Stops the threads (requests not started yet are dropped without completion, running ones finish first)
+    and releases the file data of every request that wasn't polled.
+*/
+void
+AssetStreamer_Deinit (AssetStreamer * streamer);
+
+// Returns false if all request slots are in use
+bool
+AssetStreamer_Submit (AssetStreamer * streamer, AssetRequest const & request);
+
+// Runs the completion callbacks of up to max_completions finished requests, returns how many ran
+UINT
+AssetStreamer_Poll (AssetStreamer * streamer, UINT max_completions);
+
+// Requests submitted and not completed (polled) yet
+UINT
+AssetStreamer_PendingCount (AssetStreamer * streamer);
+
+/*
+    Reads up to size bytes of a file starting at offset into a malloc'd buffer, for AssetReadFunc callbacks
+    that only need part of a file. The read stops early at the end of the file (*out_size tells how much
+    was read); returns false if the file can't be read or offset is past its end.
+*/
+bool
+AssetStreamer_ReadFileRange (wchar_t const * path, uint64_t offset, size_t size, BYTE ** out_data, size_t * out_size);
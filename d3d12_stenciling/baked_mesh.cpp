@@ -0,0 +1,129 @@
+#include "baked_mesh.h"
+#include "culling.h"
+
+static uint64_t
+align_offset (uint64_t offset) {
+    return (offset + BAKED_MESH_ALIGNMENT - 1) & ~(uint64_t)(BAKED_MESH_ALIGNMENT - 1);
+}
+// blob [offset, offset + size) lies in the file and starts at an aligned offset
+static bool
+is_valid_blob (uint64_t offset, uint64_t size, size_t file_size) {
+    return
+        0 == offset % BAKED_MESH_ALIGNMENT &&
+        offset <= file_size &&
+        size <= file_size - offset;
+}
+// largest of the indices [first, first + count)
+static uint32_t
+max_index (void const * indices, UINT index_size, uint32_t first, uint32_t count) {
+    uint32_t ret = 0;
+    if (2 == index_size) {
+        uint16_t const * indices16 = reinterpret_cast<uint16_t const *>(indices) + first;
+        for (uint32_t i = 0; i < count; ++i)
+            ret = indices16[i] > ret ? indices16[i] : ret;
+    } else {
+        uint32_t const * indices32 = reinterpret_cast<uint32_t const *>(indices) + first;
+        for (uint32_t i = 0; i < count; ++i)
+            ret = indices32[i] > ret ? indices32[i] : ret;
+    }
+    return ret;
+}
+bool
+BakedMesh_Open (char const * path, UINT expected_vertex_stride, BakedMesh * out) {
+    *out = {};
+    if (!MappedFile_Open(path, &out->file))
+        return false;
+
+    BakedMeshHeader const * header = reinterpret_cast<BakedMeshHeader const *>(out->file.data);
+    size_t file_size = out->file.size;
+    bool ret =
+        file_size >= sizeof(BakedMeshHeader) &&
+        BAKED_MESH_MAGIC == header->magic &&
+        BAKED_MESH_VERSION == header->version &&
+        expected_vertex_stride == header->vertex_stride &&
+        (2 == header->index_size || 4 == header->index_size) &&
+        is_valid_blob(header->submesh_offset, sizeof(BakedSubmesh) * (uint64_t)header->submesh_count, file_size) &&
+        is_valid_blob(header->vertex_offset, (uint64_t)header->vertex_stride * header->vertex_count, file_size) &&
+        is_valid_blob(header->index_offset, (uint64_t)header->index_size * header->index_count, file_size);
+    if (!ret) {
+        BakedMesh_Close(out);
+        return false;
+    }
+
+    out->header = header;
+    out->submeshes = reinterpret_cast<BakedSubmesh const *>(out->file.data + header->submesh_offset);
+    out->vertices = out->file.data + header->vertex_offset;
+    out->indices = out->file.data + header->index_offset;
+
+    // -- every index has to land in the vertex blob, a corrupt file must not make the GPU read past it
+    // -- (the whole index blob is drawn against the whole vertex blob, submeshes against their base vertex)
+    if (header->index_count > 0 && max_index(out->indices, header->index_size, 0, header->index_count) >= header->vertex_count) {
+        BakedMesh_Close(out);
+        return false;
+    }
+    for (UINT i = 0; i < header->submesh_count; ++i) {
+        BakedSubmesh const & sm = out->submeshes[i];
+        if ((uint64_t)sm.start_index + sm.index_count > header->index_count ||
+            sm.base_vertex < 0 || (uint32_t)sm.base_vertex > header->vertex_count ||
+            (sm.index_count > 0 && max_index(out->indices, header->index_size, sm.start_index, sm.index_count) >= header->vertex_count - (uint32_t)sm.base_vertex)) {
+            BakedMesh_Close(out);
+            return false;
+        }
+    }
+    return true;
+}
+void
+BakedMesh_Close (BakedMesh * mesh) {
+    MappedFile_Close(&mesh->file);
+    *mesh = {};
+}
+static bool
+write_blob (FILE * f, uint64_t * offset, uint64_t blob_offset, void const * data, size_t size) {
+    static BYTE const zeros[BAKED_MESH_ALIGNMENT] = {};
+    size_t padding = (size_t)(blob_offset - *offset);
+    if (padding > 0 && padding != fwrite(zeros, 1, padding, f))
+        return false;
+    if (size > 0 && size != fwrite(data, 1, size, f))
+        return false;
+    *offset = blob_offset + size;
+    return true;
+}
+bool
+BakedMesh_Write (char const * path, BakedMeshDesc const & desc) {
+    _ASSERT_EXPR(2 == desc.index_size || 4 == desc.index_size, "Invalid baked mesh index size");
+
+    size_t submeshes_size = sizeof(BakedSubmesh) * desc.submesh_count;
+    size_t vertices_size = (size_t)desc.vertex_stride * desc.vertex_count;
+    size_t indices_size = (size_t)desc.index_size * desc.index_count;
+
+    BakedMeshHeader header = {};
+    header.magic = BAKED_MESH_MAGIC;
+    header.version = BAKED_MESH_VERSION;
+    header.vertex_stride = desc.vertex_stride;
+    header.vertex_count = desc.vertex_count;
+    header.index_size = desc.index_size;
+    header.index_count = desc.index_count;
+    header.submesh_count = desc.submesh_count;
+    header.submesh_offset = align_offset(sizeof(BakedMeshHeader));
+    header.vertex_offset = align_offset(header.submesh_offset + submeshes_size);
+    header.index_offset = align_offset(header.vertex_offset + vertices_size);
+
+    DirectX::BoundingBox bounds = compute_vertex_bounds(desc.vertices, desc.vertex_count, desc.vertex_stride);
+    memcpy(header.center, &bounds.Center, sizeof(header.center));
+    memcpy(header.extents, &bounds.Extents, sizeof(header.extents));
+
+    FILE * f = nullptr;
+    if (0 != fopen_s(&f, path, "wb") || nullptr == f)
+        return false;
+    uint64_t offset = 0;
+    bool ret =
+        write_blob(f, &offset, 0, &header, sizeof(header)) &&
+        write_blob(f, &offset, header.submesh_offset, desc.submeshes, submeshes_size) &&
+        write_blob(f, &offset, header.vertex_offset, desc.vertices, vertices_size) &&
+        write_blob(f, &offset, header.index_offset, desc.indices, indices_size);
+    if (0 != fclose(f))
+        ret = false;
+    if (!ret)
+        remove(path);   // never leave a truncated file behind
+    return ret;
+}
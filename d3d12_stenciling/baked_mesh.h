@@ -0,0 +1,83 @@
+#pragma once
+
+#include "mapped_file.h"
+
+// NOTE(omid): Baked mesh container, the processed form of a model ready for upload:
+//   [ header | submesh table | vertices | indices ]
+// Every blob starts at a BAKED_MESH_ALIGNMENT boundary from the beginning of the file, so once the file
+// is mapped the vertex and index pointers can be handed to the upload path as they are (no parse, no copy).
+// The version is bumped whenever the layout or the baking steps change, stale files are simply rebaked.
+
+#define BAKED_MESH_MAGIC        0x48534d42u     // "BMSH"
+#define BAKED_MESH_VERSION      3u
+#define BAKED_MESH_ALIGNMENT    64u
+
+struct BakedSubmesh {
+    uint32_t    index_count;
+    uint32_t    start_index;
+    int32_t     base_vertex;
+    uint32_t    reserved;
+
+    // local-space bounding box
+    float       center[3];
+    float       extents[3];
+};
+static_assert(40 == sizeof(BakedSubmesh), "Baked submesh layout changed");
+
+struct BakedMeshHeader {
+    uint32_t    magic;
+    uint32_t    version;
+
+    uint32_t    vertex_stride;
+    uint32_t    vertex_count;
+    uint32_t    index_size;         // 2 or 4 bytes
+    uint32_t    index_count;
+    uint32_t    submesh_count;
+    uint32_t    reserved;
+
+    // byte offsets from the beginning of the file
+    uint64_t    submesh_offset;
+    uint64_t    vertex_offset;
+    uint64_t    index_offset;
+
+    // bounding box of the whole mesh
+    float       center[3];
+    float       extents[3];
+};
+static_assert(80 == sizeof(BakedMeshHeader), "Baked mesh header layout changed");
+
+struct BakedMesh {
+    MappedFile                  file;
+
+    BakedMeshHeader const *     header;
+    BakedSubmesh const *        submeshes;
+    void const *                vertices;
+    void const *                indices;
+};
+
+// What BakedMesh_Write stores (positions are expected at the beginning of each vertex)
+struct BakedMeshDesc {
+    void const *            vertices;
+    UINT                    vertex_count;
+    UINT                    vertex_stride;
+
+    void const *            indices;
+    UINT                    index_count;
+    UINT                    index_size;
+
+    BakedSubmesh const *    submeshes;
+    UINT                    submesh_count;
+};
+
+/*
+    Maps the file and validates it against the expected vertex stride (header, version, blob ranges, indices).
+    Returns false if it's missing, malformed or baked for another vertex layout.
+*/
+bool
+BakedMesh_Open (char const * path, UINT expected_vertex_stride, BakedMesh * out);
+
+void
+BakedMesh_Close (BakedMesh * mesh);
+
+bool
+BakedMesh_Write (char const * path, BakedMeshDesc const & desc);
@@ -0,0 +1,666 @@
+#include "bc_codec.h"
+
+#include <float.h>
+#include <math.h>
+#include <thread>
+
+using namespace DirectX;
+
+// -- formats
+
+enum BC_KIND {
+    BC_KIND_BC1 = 0,
+    BC_KIND_BC3 = 1,
+    BC_KIND_BC4 = 2,
+    BC_KIND_BC5 = 3
+};
+struct BCFormat {
+    DXGI_FORMAT     format;
+    BC_KIND         kind;
+    bool            snorm;
+    DXGI_FORMAT     image_format;
+};
+static BCFormat const bc_formats [] = {
+    {DXGI_FORMAT_BC1_UNORM,         BC_KIND_BC1, false, DXGI_FORMAT_R8G8B8A8_UNORM},
+    {DXGI_FORMAT_BC1_UNORM_SRGB,    BC_KIND_BC1, false, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB},
+    {DXGI_FORMAT_BC3_UNORM,         BC_KIND_BC3, false, DXGI_FORMAT_R8G8B8A8_UNORM},
+    {DXGI_FORMAT_BC3_UNORM_SRGB,    BC_KIND_BC3, false, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB},
+    {DXGI_FORMAT_BC4_UNORM,         BC_KIND_BC4, false, DXGI_FORMAT_R8G8B8A8_UNORM},
+    {DXGI_FORMAT_BC4_SNORM,         BC_KIND_BC4, true, DXGI_FORMAT_R8G8B8A8_SNORM},
+    {DXGI_FORMAT_BC5_UNORM,         BC_KIND_BC5, false, DXGI_FORMAT_R8G8B8A8_UNORM},
+    {DXGI_FORMAT_BC5_SNORM,         BC_KIND_BC5, true, DXGI_FORMAT_R8G8B8A8_SNORM},
+};
+static BCFormat const *
+find_bc_format (DXGI_FORMAT format) {
+    for (UINT i = 0; i < _countof(bc_formats); ++i)
+        if (bc_formats[i].format == format)
+            return &bc_formats[i];
+    return nullptr;
+}
+static UINT
+block_bytes (BC_KIND kind) {
+    return (BC_KIND_BC1 == kind || BC_KIND_BC4 == kind) ? 8 : 16;
+}
+
+// -- color blocks (565 endpoints, 2-bit indices)
+
+static uint16_t
+quantize_565 (XMVECTOR color) {
+    XMFLOAT4A c;
+    XMStoreFloat4A(&c, XMVectorClamp(color, XMVectorZero(), XMVectorReplicate(255.0f)));
+    uint32_t r = (uint32_t)(c.x * (31.0f / 255.0f) + 0.5f);
+    uint32_t g = (uint32_t)(c.y * (63.0f / 255.0f) + 0.5f);
+    uint32_t b = (uint32_t)(c.z * (31.0f / 255.0f) + 0.5f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+static void
+expand_565 (uint16_t c, int out [3]) {
+    int r = (c >> 11) & 0x1f;
+    int g = (c >> 5) & 0x3f;
+    int b = c & 0x1f;
+    out[0] = (r << 3) | (r >> 2);
+    out[1] = (g << 2) | (g >> 4);
+    out[2] = (b << 3) | (b >> 2);
+}
+// Shared by the encoder (to pick indices) and the decoder, so both agree on the rounding
+static void
+color_palette (uint16_t c0, uint16_t c1, bool four_colors, int out [4][4]) {
+    expand_565(c0, out[0]);
+    expand_565(c1, out[1]);
+    out[0][3] = out[1][3] = 255;
+    for (int i = 0; i < 3; ++i) {
+        if (four_colors) {
+            out[2][i] = (2 * out[0][i] + out[1][i] + 1) / 3;
+            out[3][i] = (out[0][i] + 2 * out[1][i] + 1) / 3;
+        } else {
+            out[2][i] = (out[0][i] + out[1][i] + 1) / 2;
+            out[3][i] = 0;
+        }
+    }
+    out[2][3] = 255;
+    out[3][3] = four_colors ? 255 : 0;
+}
+// Closest palette entry per texel, transparent texels take index 3 in the 3-color mode
+static uint32_t
+color_indices (BYTE const pixels [16][4], uint16_t c0, uint16_t c1, bool four_colors, bool transparent, uint32_t * out_error) {
+    int palette[4][4];
+    color_palette(c0, c1, four_colors, palette);
+    int n_entries = four_colors ? 4 : 3;
+    uint32_t indices = 0;
+    uint32_t error = 0;
+    for (int t = 0; t < 16; ++t) {
+        if (transparent && pixels[t][3] < 128) {
+            indices |= 3u << (2 * t);
+            continue;
+        }
+        uint32_t best = UINT32_MAX;
+        int best_i = 0;
+        for (int i = 0; i < n_entries; ++i) {
+            int dr = (int)pixels[t][0] - palette[i][0];
+            int dg = (int)pixels[t][1] - palette[i][1];
+            int db = (int)pixels[t][2] - palette[i][2];
+            uint32_t d = (uint32_t)(dr * dr + dg * dg + db * db);
+            if (d < best) {
+                best = d;
+                best_i = i;
+            }
+        }
+        indices |= (uint32_t)best_i << (2 * t);
+        error += best;
+    }
+    *out_error = error;
+    return indices;
+}
+struct ColorCandidate {
+    uint16_t    c0;
+    uint16_t    c1;
+    uint32_t    indices;
+    uint32_t    error;
+};
+static void
+evaluate_color (BYTE const pixels [16][4], uint16_t c0, uint16_t c1, bool four_colors, bool transparent, ColorCandidate * best) {
+    uint32_t error = 0;
+    uint32_t indices = color_indices(pixels, c0, c1, four_colors, transparent, &error);
+    if (error < best->error) {
+        best->c0 = c0;
+        best->c1 = c1;
+        best->indices = indices;
+        best->error = error;
+    }
+}
+// Principal axis of the colors (largest eigenvector of the covariance, by power iteration)
+static XMVECTOR
+principal_axis (XMVECTOR const points [], UINT n_points, XMVECTOR mean) {
+    float cov[6] = {};
+    for (UINT i = 0; i < n_points; ++i) {
+        XMFLOAT4A d;
+        XMStoreFloat4A(&d, XMVectorSubtract(points[i], mean));
+        cov[0] += d.x * d.x;
+        cov[1] += d.x * d.y;
+        cov[2] += d.x * d.z;
+        cov[3] += d.y * d.y;
+        cov[4] += d.y * d.z;
+        cov[5] += d.z * d.z;
+    }
+    XMVECTOR row0 = XMVectorSet(cov[0], cov[1], cov[2], 0.0f);
+    XMVECTOR row1 = XMVectorSet(cov[1], cov[3], cov[4], 0.0f);
+    XMVECTOR row2 = XMVectorSet(cov[2], cov[4], cov[5], 0.0f);
+    XMVECTOR axis = XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f);
+    for (int i = 0; i < 8; ++i) {
+        XMVECTOR next = XMVectorSet(
+            XMVectorGetX(XMVector3Dot(row0, axis)),
+            XMVectorGetX(XMVector3Dot(row1, axis)),
+            XMVectorGetX(XMVector3Dot(row2, axis)),
+            0.0f
+        );
+        float len = XMVectorGetX(XMVector3Length(next));
+        if (len < 1e-6f)
+            break;
+        axis = XMVectorScale(next, 1.0f / len);
+    }
+    return XMVector3Normalize(axis);
+}
+/*
+    Least squares endpoints for every split of the sorted points over the 4 palette entries
+    (a gets weight 1, 2/3, 1/3, 0 in order), scored on the quantized endpoints.
+*/
+static void
+cluster_fit (BYTE const pixels [16][4], XMVECTOR const sorted [], UINT n_points, ColorCandidate * best) {
+    XMVECTOR prefix[17];
+    prefix[0] = XMVectorZero();
+    for (UINT i = 0; i < n_points; ++i)
+        prefix[i + 1] = XMVectorAdd(prefix[i], sorted[i]);
+    XMVECTOR total = prefix[n_points];
+
+    float best_score = FLT_MAX;
+    uint16_t best_a = 0;
+    uint16_t best_b = 0;
+    for (UINT i = 0; i <= n_points; ++i) {
+        for (UINT j = i; j <= n_points; ++j) {
+            for (UINT k = j; k <= n_points; ++k) {
+                float n1 = (float)(j - i);
+                float n2 = (float)(k - j);
+                float alpha2 = (float)i + n1 * (4.0f / 9.0f) + n2 * (1.0f / 9.0f);
+                float beta2 = n1 * (1.0f / 9.0f) + n2 * (4.0f / 9.0f) + (float)(n_points - k);
+                float alphabeta = (n1 + n2) * (2.0f / 9.0f);
+                float det = alpha2 * beta2 - alphabeta * alphabeta;
+                if (fabsf(det) < 1e-6f)
+                    continue;
+                XMVECTOR alphax = XMVectorAdd(prefix[i], XMVectorAdd(
+                    XMVectorScale(XMVectorSubtract(prefix[j], prefix[i]), 2.0f / 3.0f),
+                    XMVectorScale(XMVectorSubtract(prefix[k], prefix[j]), 1.0f / 3.0f)));
+                XMVECTOR betax = XMVectorSubtract(total, alphax);
+                XMVECTOR a = XMVectorScale(XMVectorSubtract(XMVectorScale(alphax, beta2), XMVectorScale(betax, alphabeta)), 1.0f / det);
+                XMVECTOR b = XMVectorScale(XMVectorSubtract(XMVectorScale(betax, alpha2), XMVectorScale(alphax, alphabeta)), 1.0f / det);
+
+                // -- score what will actually be stored
+                uint16_t qa = quantize_565(a);
+                uint16_t qb = quantize_565(b);
+                int ea[3], eb[3];
+                expand_565(qa, ea);
+                expand_565(qb, eb);
+                a = XMVectorSet((float)ea[0], (float)ea[1], (float)ea[2], 0.0f);
+                b = XMVectorSet((float)eb[0], (float)eb[1], (float)eb[2], 0.0f);
+                float score =
+                    alpha2 * XMVectorGetX(XMVector3Dot(a, a)) + beta2 * XMVectorGetX(XMVector3Dot(b, b)) +
+                    2.0f * (alphabeta * XMVectorGetX(XMVector3Dot(a, b)) - XMVectorGetX(XMVector3Dot(a, alphax)) - XMVectorGetX(XMVector3Dot(b, betax)));
+                if (score < best_score) {
+                    best_score = score;
+                    best_a = qa;
+                    best_b = qb;
+                }
+            }
+        }
+    }
+    if (best_score < FLT_MAX)
+        evaluate_color(pixels, best_a, best_b, true, false, best);
+}
+static void
+encode_color_block (BYTE const pixels [16][4], bool bc1, BC_QUALITY quality, BYTE * out) {
+    // -- BC1 switches to the 3-color mode for punch-through alpha, BC3 colors are always 4-color
+    bool transparent = false;
+    if (bc1)
+        for (int t = 0; t < 16; ++t)
+            transparent |= pixels[t][3] < 128;
+
+    XMVECTOR points[16];
+    UINT n_points = 0;
+    XMVECTOR mean = XMVectorZero();
+    for (int t = 0; t < 16; ++t) {
+        if (transparent && pixels[t][3] < 128)
+            continue;
+        points[n_points] = XMVectorSet((float)pixels[t][0], (float)pixels[t][1], (float)pixels[t][2], 0.0f);
+        mean = XMVectorAdd(mean, points[n_points]);
+        ++n_points;
+    }
+
+    ColorCandidate best = {0, 0, transparent ? 0xffffffffu : 0u, UINT32_MAX};
+    if (n_points > 0) {
+        mean = XMVectorScale(mean, 1.0f / (float)n_points);
+        XMVECTOR axis = principal_axis(points, n_points, mean);
+
+        // -- range fit: extremes along the axis
+        float t_min = FLT_MAX;
+        float t_max = -FLT_MAX;
+        float t_values[16];
+        for (UINT i = 0; i < n_points; ++i) {
+            t_values[i] = XMVectorGetX(XMVector3Dot(XMVectorSubtract(points[i], mean), axis));
+            t_min = fminf(t_min, t_values[i]);
+            t_max = fmaxf(t_max, t_values[i]);
+        }
+        uint16_t c_max = quantize_565(XMVectorMultiplyAdd(axis, XMVectorReplicate(t_max), mean));
+        uint16_t c_min = quantize_565(XMVectorMultiplyAdd(axis, XMVectorReplicate(t_min), mean));
+        evaluate_color(pixels, c_max, c_min, !transparent, transparent, &best);
+
+        if (BC_QUALITY_CLUSTER_FIT == quality && !transparent && n_points > 1) {
+            // -- insertion sort by projection, at most 16 points
+            XMVECTOR sorted[16];
+            for (UINT i = 0; i < n_points; ++i) {
+                UINT j = i;
+                for (; j > 0 && t_values[j - 1] > t_values[i]; --j) {}
+                float t = t_values[i];
+                XMVECTOR p = points[i];
+                for (UINT k = i; k > j; --k) {
+                    t_values[k] = t_values[k - 1];
+                    sorted[k] = sorted[k - 1];
+                }
+                t_values[j] = t;
+                sorted[j] = p;
+            }
+            cluster_fit(pixels, sorted, n_points, &best);
+        }
+    }
+
+    // -- BC1 picks the mode from the endpoint order (c0 > c1 is 4-color), swap to match
+    uint16_t c0 = best.c0;
+    uint16_t c1 = best.c1;
+    uint32_t indices = best.indices;
+    if (bc1 && !transparent && c0 < c1) {
+        c0 = best.c1;
+        c1 = best.c0;
+        indices ^= 0x55555555u;     // 0 <-> 1, 2 <-> 3
+    } else if (bc1 && !transparent && c0 == c1) {
+        indices = 0;                // decoded as 3-color, only index 0 is the same color
+    } else if (transparent && c0 > c1) {
+        c0 = best.c1;
+        c1 = best.c0;
+        for (int t = 0; t < 16; ++t) {
+            uint32_t i = (indices >> (2 * t)) & 3;
+            if (i < 2)
+                indices ^= 1u << (2 * t);   // 0 <-> 1, 2 and 3 stay
+        }
+    }
+    out[0] = (BYTE)(c0 & 0xff);
+    out[1] = (BYTE)(c0 >> 8);
+    out[2] = (BYTE)(c1 & 0xff);
+    out[3] = (BYTE)(c1 >> 8);
+    memcpy(out + 4, &indices, sizeof(indices));
+}
+static void
+decode_color_block (BYTE const * block, bool bc1, BYTE out [16][4]) {
+    uint16_t c0 = (uint16_t)(block[0] | (block[1] << 8));
+    uint16_t c1 = (uint16_t)(block[2] | (block[3] << 8));
+    uint32_t indices;
+    memcpy(&indices, block + 4, sizeof(indices));
+    int palette[4][4];
+    color_palette(c0, c1, !bc1 || c0 > c1, palette);
+    for (int t = 0; t < 16; ++t) {
+        int const * c = palette[(indices >> (2 * t)) & 3];
+        for (int i = 0; i < 4; ++i)
+            out[t][i] = (BYTE)c[i];
+    }
+}
+
+// -- single channel blocks (8-bit endpoints, 3-bit indices)
+
+static int
+round_div (int num, int den) {
+    return num >= 0 ? (num + den / 2) / den : -((-num + den / 2) / den);
+}
+// e0 > e1: 8 interpolated values, otherwise 6 plus the range limits
+static void
+channel_palette (int e0, int e1, bool snorm, int out [8]) {
+    out[0] = e0;
+    out[1] = e1;
+    if (e0 > e1) {
+        for (int i = 1; i < 7; ++i)
+            out[i + 1] = round_div((7 - i) * e0 + i * e1, 7);
+    } else {
+        for (int i = 1; i < 5; ++i)
+            out[i + 1] = round_div((5 - i) * e0 + i * e1, 5);
+        out[6] = snorm ? -127 : 0;
+        out[7] = snorm ? 127 : 255;
+    }
+}
+static uint64_t
+channel_indices (int const values [16], int e0, int e1, bool snorm, uint32_t * out_error) {
+    int palette[8];
+    channel_palette(e0, e1, snorm, palette);
+    uint64_t indices = 0;
+    uint32_t error = 0;
+    for (int t = 0; t < 16; ++t) {
+        uint32_t best = UINT32_MAX;
+        int best_i = 0;
+        for (int i = 0; i < 8; ++i) {
+            int d = values[t] - palette[i];
+            if ((uint32_t)(d * d) < best) {
+                best = (uint32_t)(d * d);
+                best_i = i;
+            }
+        }
+        indices |= (uint64_t)best_i << (3 * t);
+        error += best;
+    }
+    *out_error = error;
+    return indices;
+}
+struct ChannelCandidate {
+    int         e0;
+    int         e1;
+    uint64_t    indices;
+    uint32_t    error;
+};
+static void
+evaluate_channel (int const values [16], int e0, int e1, bool snorm, ChannelCandidate * best) {
+    int lo = snorm ? -127 : 0;
+    int hi = snorm ? 127 : 255;
+    if (e0 < lo || e0 > hi || e1 < lo || e1 > hi)
+        return;
+    uint32_t error = 0;
+    uint64_t indices = channel_indices(values, e0, e1, snorm, &error);
+    if (error < best->error) {
+        best->e0 = e0;
+        best->e1 = e1;
+        best->indices = indices;
+        best->error = error;
+    }
+}
+// Least squares endpoints for the current indices, only texels on interpolated entries count
+static void
+refine_channel (int const values [16], bool snorm, ChannelCandidate * best) {
+    bool eight = best->e0 > best->e1;
+    float alpha2 = 0.0f, beta2 = 0.0f, alphabeta = 0.0f, alphax = 0.0f, betax = 0.0f;
+    for (int t = 0; t < 16; ++t) {
+        int i = (int)((best->indices >> (3 * t)) & 7);
+        float w;    // weight of e0
+        if (eight)
+            w = 0 == i ? 1.0f : (1 == i ? 0.0f : (float)(8 - i) / 7.0f);
+        else if (i < 6)
+            w = 0 == i ? 1.0f : (1 == i ? 0.0f : (float)(6 - i) / 5.0f);
+        else
+            continue;
+        alpha2 += w * w;
+        beta2 += (1.0f - w) * (1.0f - w);
+        alphabeta += w * (1.0f - w);
+        alphax += w * (float)values[t];
+        betax += (1.0f - w) * (float)values[t];
+    }
+    float det = alpha2 * beta2 - alphabeta * alphabeta;
+    if (fabsf(det) < 1e-6f)
+        return;
+    int e0 = (int)lrintf((alphax * beta2 - betax * alphabeta) / det);
+    int e1 = (int)lrintf((betax * alpha2 - alphax * alphabeta) / det);
+    int lo = snorm ? -127 : 0;
+    int hi = snorm ? 127 : 255;
+    e0 = e0 < lo ? lo : (e0 > hi ? hi : e0);
+    e1 = e1 < lo ? lo : (e1 > hi ? hi : e1);
+    // -- keep the mode the indices were picked for
+    if (eight ? e0 > e1 : e0 <= e1)
+        evaluate_channel(values, e0, e1, snorm, best);
+}
+static void
+encode_channel_block (int const values [16], bool snorm, BC_QUALITY quality, BYTE * out) {
+    int lo = snorm ? -127 : 0;
+    int hi = snorm ? 127 : 255;
+    int v_min = hi, v_max = lo;
+    int inner_min = hi, inner_max = lo;     // ignoring the values the 6 value mode has for free
+    for (int t = 0; t < 16; ++t) {
+        v_min = values[t] < v_min ? values[t] : v_min;
+        v_max = values[t] > v_max ? values[t] : v_max;
+        if (values[t] != lo && values[t] != hi) {
+            inner_min = values[t] < inner_min ? values[t] : inner_min;
+            inner_max = values[t] > inner_max ? values[t] : inner_max;
+        }
+    }
+    ChannelCandidate best = {0, 0, 0, UINT32_MAX};
+    evaluate_channel(values, v_max, v_min, snorm, &best);
+    if (inner_min <= inner_max)
+        evaluate_channel(values, inner_min, inner_max, snorm, &best);
+
+    if (BC_QUALITY_CLUSTER_FIT == quality && best.error > 0) {
+        for (int pass = 0; pass < 2; ++pass)
+            refine_channel(values, snorm, &best);
+        int e0 = best.e0;
+        int e1 = best.e1;
+        for (int d0 = -2; d0 <= 2; ++d0)
+            for (int d1 = -2; d1 <= 2; ++d1)
+                evaluate_channel(values, e0 + d0, e1 + d1, snorm, &best);
+    }
+    out[0] = (BYTE)best.e0;     // two's complement for SNORM
+    out[1] = (BYTE)best.e1;
+    for (int i = 0; i < 6; ++i)
+        out[2 + i] = (BYTE)(best.indices >> (8 * i));
+}
+static void
+decode_channel_block (BYTE const * block, bool snorm, int out [16]) {
+    int e0 = snorm ? (int)(int8_t)block[0] : (int)block[0];
+    int e1 = snorm ? (int)(int8_t)block[1] : (int)block[1];
+    // -- -128 decodes as -127
+    e0 = e0 < -127 ? -127 : e0;
+    e1 = e1 < -127 ? -127 : e1;
+    int palette[8];
+    channel_palette(e0, e1, snorm, palette);
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i)
+        indices |= (uint64_t)block[2 + i] << (8 * i);
+    for (int t = 0; t < 16; ++t)
+        out[t] = palette[(indices >> (3 * t)) & 7];
+}
+
+// -- images
+
+struct CodecJob {
+    BCFormat const *    bcf;
+    UINT                width;
+    UINT                height;
+    UINT                blocks_x;
+    BYTE const *        image;
+    BYTE *              out_image;
+    size_t              row_pitch;
+    BYTE const *        blocks;
+    BYTE *              out_blocks;
+    BC_QUALITY          quality;
+};
+static void
+encode_block_rows (CodecJob const * job, UINT first_row, UINT last_row) {
+    BCFormat const * bcf = job->bcf;
+    UINT n_bytes = block_bytes(bcf->kind);
+    for (UINT by = first_row; by < last_row; ++by) {
+        for (UINT bx = 0; bx < job->blocks_x; ++bx) {
+            // -- edge blocks replicate the last row/column
+            BYTE pixels[16][4];
+            for (UINT t = 0; t < 16; ++t) {
+                UINT x = bx * 4 + (t & 3);
+                UINT y = by * 4 + (t >> 2);
+                x = x < job->width ? x : job->width - 1;
+                y = y < job->height ? y : job->height - 1;
+                memcpy(pixels[t], job->image + job->row_pitch * y + (size_t)x * 4, 4);
+            }
+            BYTE * out = job->out_blocks + ((size_t)by * job->blocks_x + bx) * n_bytes;
+            int values[16];
+            switch (bcf->kind) {
+            case BC_KIND_BC1:
+                encode_color_block(pixels, true, job->quality, out);
+                break;
+            case BC_KIND_BC3:
+                for (int t = 0; t < 16; ++t)
+                    values[t] = pixels[t][3];
+                encode_channel_block(values, false, job->quality, out);
+                encode_color_block(pixels, false, job->quality, out + 8);
+                break;
+            default:
+                for (UINT c = 0; c < (BC_KIND_BC5 == bcf->kind ? 2u : 1u); ++c) {
+                    for (int t = 0; t < 16; ++t) {
+                        values[t] = bcf->snorm ? (int)(int8_t)pixels[t][c] : (int)pixels[t][c];
+                        values[t] = values[t] < -127 ? -127 : values[t];
+                    }
+                    encode_channel_block(values, bcf->snorm, job->quality, out + 8 * c);
+                }
+                break;
+            }
+        }
+    }
+}
+static void
+decode_block_rows (CodecJob const * job, UINT first_row, UINT last_row) {
+    BCFormat const * bcf = job->bcf;
+    UINT n_bytes = block_bytes(bcf->kind);
+    BYTE one = bcf->snorm ? 127 : 255;
+    for (UINT by = first_row; by < last_row; ++by) {
+        for (UINT bx = 0; bx < job->blocks_x; ++bx) {
+            BYTE const * block = job->blocks + ((size_t)by * job->blocks_x + bx) * n_bytes;
+            BYTE pixels[16][4];
+            int values[16];
+            switch (bcf->kind) {
+            case BC_KIND_BC1:
+                decode_color_block(block, true, pixels);
+                break;
+            case BC_KIND_BC3:
+                decode_color_block(block + 8, false, pixels);
+                decode_channel_block(block, false, values);
+                for (int t = 0; t < 16; ++t)
+                    pixels[t][3] = (BYTE)values[t];
+                break;
+            default:
+                for (int t = 0; t < 16; ++t) {
+                    pixels[t][1] = pixels[t][2] = 0;
+                    pixels[t][3] = one;
+                }
+                for (UINT c = 0; c < (BC_KIND_BC5 == bcf->kind ? 2u : 1u); ++c) {
+                    decode_channel_block(block + 8 * c, bcf->snorm, values);
+                    for (int t = 0; t < 16; ++t)
+                        pixels[t][c] = (BYTE)(int8_t)values[t];
+                }
+                break;
+            }
+            for (UINT t = 0; t < 16; ++t) {
+                UINT x = bx * 4 + (t & 3);
+                UINT y = by * 4 + (t >> 2);
+                if (x < job->width && y < job->height)
+                    memcpy(job->out_image + job->row_pitch * y + (size_t)x * 4, pixels[t], 4);
+            }
+        }
+    }
+}
+// Contiguous block row ranges, thread 0 is the caller
+static void
+run_block_rows (void (*fn)(CodecJob const *, UINT, UINT), CodecJob const * job, UINT n_rows, UINT n_threads) {
+    UINT max_threads = n_threads > 0 ? n_threads : std::thread::hardware_concurrency();
+    max_threads = max_threads < 1 ? 1 : (max_threads > BC_CODEC_MAX_THREADS ? BC_CODEC_MAX_THREADS : max_threads);
+    UINT n = (UINT)(((uint64_t)n_rows * job->blocks_x) / BC_CODEC_MIN_BLOCKS_PER_THREAD);
+    n = n > n_rows ? n_rows : n;
+    n = n < 1 ? 1 : (n > max_threads ? max_threads : n);
+
+    std::thread threads[BC_CODEC_MAX_THREADS];
+    for (UINT i = 1; i < n; ++i)
+        threads[i] = std::thread(fn, job, (UINT)((uint64_t)n_rows * i / n), (UINT)((uint64_t)n_rows * (i + 1) / n));
+    fn(job, 0, (UINT)((uint64_t)n_rows / n));
+    for (UINT i = 1; i < n; ++i)
+        threads[i].join();
+}
+
+bool
+BCCodec_IsSupported (DXGI_FORMAT format) {
+    return nullptr != find_bc_format(format);
+}
+UINT
+BCCodec_BlockBytes (DXGI_FORMAT format) {
+    BCFormat const * bcf = find_bc_format(format);
+    return bcf ? block_bytes(bcf->kind) : 0;
+}
+size_t
+BCCodec_CalculateSize (DXGI_FORMAT format, UINT width, UINT height) {
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * BCCodec_BlockBytes(format);
+}
+DXGI_FORMAT
+BCCodec_GetImageFormat (DXGI_FORMAT format) {
+    BCFormat const * bcf = find_bc_format(format);
+    return bcf ? bcf->image_format : DXGI_FORMAT_UNKNOWN;
+}
+bool
+BCCodec_Encode (
+    DXGI_FORMAT format, UINT width, UINT height,
+    BYTE const * image, size_t row_pitch,
+    BCSettings const & settings,
+    BYTE * out_blocks
+) {
+    BCFormat const * bcf = find_bc_format(format);
+    if (nullptr == bcf || 0 == width || 0 == height)
+        return false;
+    CodecJob job = {};
+    job.bcf = bcf;
+    job.width = width;
+    job.height = height;
+    job.blocks_x = (width + 3) / 4;
+    job.image = image;
+    job.row_pitch = row_pitch;
+    job.out_blocks = out_blocks;
+    job.quality = settings.quality;
+    run_block_rows(encode_block_rows, &job, (height + 3) / 4, settings.n_threads);
+    return true;
+}
+bool
+BCCodec_Decode (
+    DXGI_FORMAT format, UINT width, UINT height,
+    BYTE const * blocks,
+    BYTE * out_image, size_t out_row_pitch,
+    UINT n_threads
+) {
+    BCFormat const * bcf = find_bc_format(format);
+    if (nullptr == bcf || 0 == width || 0 == height)
+        return false;
+    CodecJob job = {};
+    job.bcf = bcf;
+    job.width = width;
+    job.height = height;
+    job.blocks_x = (width + 3) / 4;
+    job.out_image = out_image;
+    job.row_pitch = out_row_pitch;
+    job.blocks = blocks;
+    run_block_rows(decode_block_rows, &job, (height + 3) / 4, n_threads);
+    return true;
+}
+double
+BCCodec_PSNR (
+    DXGI_FORMAT format, UINT width, UINT height,
+    BYTE const * image_a, size_t pitch_a,
+    BYTE const * image_b, size_t pitch_b
+) {
+    BCFormat const * bcf = find_bc_format(format);
+    if (nullptr == bcf || 0 == width || 0 == height)
+        return 0.0;
+    UINT n_channels = 4;
+    switch (bcf->kind) {
+    case BC_KIND_BC1: n_channels = 3; break;
+    case BC_KIND_BC4: n_channels = 1; break;
+    case BC_KIND_BC5: n_channels = 2; break;
+    default: break;
+    }
+    uint64_t sum = 0;
+    for (UINT y = 0; y < height; ++y) {
+        BYTE const * a = image_a + pitch_a * y;
+        BYTE const * b = image_b + pitch_b * y;
+        for (UINT x = 0; x < width; ++x) {
+            for (UINT c = 0; c < n_channels; ++c) {
+                int va = bcf->snorm ? (int)(int8_t)a[x * 4 + c] : (int)a[x * 4 + c];
+                int vb = bcf->snorm ? (int)(int8_t)b[x * 4 + c] : (int)b[x * 4 + c];
+                sum += (uint64_t)((va - vb) * (va - vb));
+            }
+        }
+    }
+    if (0 == sum)
+        return INFINITY;
+    double peak = bcf->snorm ? 254.0 : 255.0;
+    double mse = (double)sum / ((double)width * height * n_channels);
+    return 10.0 * log10(peak * peak / mse);
+}
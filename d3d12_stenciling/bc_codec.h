@@ -0,0 +1,85 @@
+#pragma once
+
+#include "headers/common.h"
+
+// NOTE(omid): Block compression (BC1, BC3, BC4, BC5) encoder and decoder for 8-bit RGBA images.
+// Every 4x4 block is encoded on its own (edge blocks replicate the last row/column) and the block
+// rows are split into contiguous ranges over threads (thread 0 is the caller).
+//
+// Color blocks (BC1, and the color half of BC3):
+//  - range fit:    endpoints are the extremes of the colors along their principal axis (covariance
+//                  + power iteration, on XMVECTORs), indices pick the closest palette entry
+//  - cluster fit:  every ordering-preserving split of the block's colors (projected on the axis)
+//                  over the 4 palette entries is tried, endpoints are the least squares solution
+//                  for the split; the best of that and the range fit is kept (much slower)
+// BC1 blocks with any alpha below 128 use the 3-color mode (index 3 is transparent black).
+//
+// Single channel blocks (BC4, BC5 and the alpha of BC3): both the 8 value and the 6 value (+ min/max)
+// modes are tried; cluster fit also refines the endpoints with least squares and a small search around them.
+//
+// Images are R8G8B8A8 (UNORM bytes, or SNORM bytes for the SNORM formats). sRGB formats are encoded
+// as their bytes (interpolation happens before the sRGB decode on the GPU too).
+
+#define BC_CODEC_MAX_THREADS                16
+#define BC_CODEC_MIN_BLOCKS_PER_THREAD      1024
+
+enum BC_QUALITY : uint32_t {
+    BC_QUALITY_RANGE_FIT = 0,
+    BC_QUALITY_CLUSTER_FIT = 1
+};
+
+struct BCSettings {
+    BC_QUALITY  quality;
+    UINT        n_threads;  // 0 means hardware concurrency
+};
+
+// BC1, BC3 (UNORM and SRGB), BC4 and BC5 (UNORM and SNORM)
+bool
+BCCodec_IsSupported (DXGI_FORMAT format);
+
+// 8 for BC1 and BC4, 16 for BC3 and BC5 (0 if not supported)
+UINT
+BCCodec_BlockBytes (DXGI_FORMAT format);
+
+// Bytes of one compressed surface of width x height (partial blocks are whole blocks)
+size_t
+BCCodec_CalculateSize (DXGI_FORMAT format, UINT width, UINT height);
+
+// Uncompressed format the image (or the decoded image) of a BC format is in
+DXGI_FORMAT
+BCCodec_GetImageFormat (DXGI_FORMAT format);
+
+/*
+    Encodes a R8G8B8A8 image (row_pitch bytes between rows) into BCCodec_CalculateSize(format, width, height)
+    bytes of out_blocks, rows of blocks back to back. Returns false if the format isn't supported.
+*/
+bool
+BCCodec_Encode (
+    DXGI_FORMAT format, UINT width, UINT height,
+    BYTE const * image, size_t row_pitch,
+    BCSettings const & settings,
+    BYTE * out_blocks
+);
+
+/*
+    Decodes blocks (rows of blocks back to back) into a R8G8B8A8 image (out_row_pitch bytes between rows).
+    BC4 decodes to (r, 0, 0, 1) and BC5 to (r, g, 0, 1). Returns false if the format isn't supported.
+*/
+bool
+BCCodec_Decode (
+    DXGI_FORMAT format, UINT width, UINT height,
+    BYTE const * blocks,
+    BYTE * out_image, size_t out_row_pitch,
+    UINT n_threads
+);
+
+/*
+    PSNR (dB) between two R8G8B8A8 images over the channels the format stores
+    (rgb for BC1, rgba for BC3, r for BC4, rg for BC5). INFINITY if they're identical.
+*/
+double
+BCCodec_PSNR (
+    DXGI_FORMAT format, UINT width, UINT height,
+    BYTE const * image_a, size_t pitch_a,
+    BYTE const * image_b, size_t pitch_b
+);
@@ -0,0 +1,144 @@
+// NOTE(omid): CPU test of the block compression codec (bc_codec), no device needed.
+// A smooth image is encoded with both qualities and decoded, BCCodec_PSNR has to stay above a floor per format
+// (cluster fit never worse than range fit). BC1 blocks are decoded against a reference decoder written from the spec.
+// It's the bc_codec_test project of misc_d3d12.sln (console app), or from a developer command prompt in this folder:
+//      cl /nologo /std:c++latest /EHsc bc_codec_test.cpp bc_codec.cpp && bc_codec_test.exe
+// It returns nonzero if a check fails.
+
+#include "bc_codec.h"
+
+static int n_fails = 0;
+#define CHECK(exp) do { if (!(exp)) { ::printf("[FAIL] %s at line %d. \n", #exp, __LINE__); ++n_fails; } } while (0)
+
+// Sine, ramp and cosine in rgb, alpha ramps along the diagonal (opaque for BC1), SNORM formats get signed bytes
+static void
+fill_smooth_image (BYTE * image, UINT width, UINT height, bool opaque, bool snorm) {
+    for (UINT y = 0; y < height; ++y) {
+        for (UINT x = 0; x < width; ++x) {
+            float fx = (float)x / width;
+            float fy = (float)y / height;
+            BYTE * texel = &image[(y * width + x) * 4];
+            texel[0] = (BYTE)(127.5f + 127.0f * sinf(fx * 6.28f));
+            texel[1] = (BYTE)(255.0f * fy);
+            texel[2] = (BYTE)(127.5f + 127.0f * cosf((fx + fy) * 3.0f));
+            texel[3] = opaque ? 255 : (BYTE)(255.0f * fx * fy);
+            if (snorm) {
+                for (UINT c = 0; c < 4; ++c)
+                    texel[c] = (BYTE)(int8_t)((int)texel[c] - 128 < -127 ? -127 : (int)texel[c] - 128);
+            }
+        }
+    }
+}
+
+// -- BC1 as the D3D spec has it: 565 endpoints with the high bits replicated, the middle colors at 1/3 and 2/3
+// (or 1/2 and transparent black when color0 <= color1), interpolated exactly and rounded
+static void
+reference_decode_bc1 (BYTE const * block, BYTE out [16][4]) {
+    uint16_t c0 = (uint16_t)(block[0] | (block[1] << 8));
+    uint16_t c1 = (uint16_t)(block[2] | (block[3] << 8));
+    float palette [4][4];
+    uint16_t endpoints [2] = {c0, c1};
+    for (UINT i = 0; i < 2; ++i) {
+        UINT r = (endpoints[i] >> 11) & 0x1f, g = (endpoints[i] >> 5) & 0x3f, b = endpoints[i] & 0x1f;
+        palette[i][0] = (float)((r << 3) | (r >> 2));
+        palette[i][1] = (float)((g << 2) | (g >> 4));
+        palette[i][2] = (float)((b << 3) | (b >> 2));
+        palette[i][3] = 255.0f;
+    }
+    for (UINT c = 0; c < 4; ++c) {
+        if (c0 > c1) {
+            palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+            palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+        } else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2.0f;
+            palette[3][c] = 0.0f;
+        }
+    }
+    uint32_t indices = (uint32_t)block[4] | ((uint32_t)block[5] << 8) | ((uint32_t)block[6] << 16) | ((uint32_t)block[7] << 24);
+    for (UINT t = 0; t < 16; ++t)
+        for (UINT c = 0; c < 4; ++c)
+            out[t][c] = (BYTE)(palette[(indices >> (2 * t)) & 3][c] + 0.5f);
+}
+static void
+test_bc1_decode () {
+    BYTE blocks [64][8];
+    // -- red and blue in 4-color mode (indices 0, 1, 2, 3 in every row)
+    BYTE const four_color [8] = {0x00, 0xf8, 0x1f, 0x00, 0xe4, 0xe4, 0xe4, 0xe4};
+    // -- the same endpoints swapped: 3-color mode, index 3 is transparent black
+    BYTE const three_color [8] = {0x1f, 0x00, 0x00, 0xf8, 0xe4, 0xe4, 0xe4, 0xe4};
+    // -- equal endpoints are 3-color too
+    BYTE const equal [8] = {0x34, 0x12, 0x34, 0x12, 0x1b, 0x1b, 0x1b, 0x1b};
+    ::memcpy(blocks[0], four_color, 8);
+    ::memcpy(blocks[1], three_color, 8);
+    ::memcpy(blocks[2], equal, 8);
+    uint32_t seed = 0x2545f491u;
+    for (UINT i = 3; i < _countof(blocks); ++i) {
+        for (UINT j = 0; j < 8; ++j) {
+            seed = seed * 1664525u + 1013904223u;
+            blocks[i][j] = (BYTE)(seed >> 24);
+        }
+    }
+
+    // -- 32x32 texels, 8x8 blocks
+    UINT const width = 32, height = 32;
+    BYTE image [height][width][4];
+    CHECK(BCCodec_Decode(DXGI_FORMAT_BC1_UNORM, width, height, &blocks[0][0], &image[0][0][0], width * 4, 1));
+    for (UINT b = 0; b < _countof(blocks); ++b) {
+        BYTE expected [16][4];
+        reference_decode_bc1(blocks[b], expected);
+        for (UINT t = 0; t < 16; ++t) {
+            BYTE const * texel = image[(b / 8) * 4 + t / 4][(b % 8) * 4 + t % 4];
+            for (UINT c = 0; c < 3; ++c)
+                CHECK(abs((int)texel[c] - (int)expected[t][c]) <= 1);
+            CHECK(texel[3] == expected[t][3]);
+        }
+    }
+    // -- the endpoints of the hand-made blocks are exact
+    CHECK(255 == image[0][0][0] && 0 == image[0][0][2] && 0 == image[0][1][0] && 255 == image[0][1][2]);
+    CHECK(0 == image[0][7][0] && 0 == image[0][7][3] && 255 == image[0][6][3]);
+}
+static void
+test_psnr (DXGI_FORMAT format, UINT width, UINT height, double min_range_fit, double min_cluster_fit) {
+    bool snorm = DXGI_FORMAT_BC4_SNORM == format || DXGI_FORMAT_BC5_SNORM == format;
+    bool opaque = DXGI_FORMAT_BC1_UNORM == format || DXGI_FORMAT_BC1_UNORM_SRGB == format;
+    BYTE * image = (BYTE *)::malloc(width * height * 4);
+    BYTE * decoded = (BYTE *)::malloc(width * height * 4);
+    BYTE * blocks = (BYTE *)::malloc(BCCodec_CalculateSize(format, width, height));
+    fill_smooth_image(image, width, height, opaque, snorm);
+
+    double psnr [2];
+    for (UINT q = 0; q < 2; ++q) {
+        BCSettings settings = {};
+        settings.quality = (BC_QUALITY)q;
+        settings.n_threads = 1;
+        CHECK(BCCodec_Encode(format, width, height, image, width * 4, settings, blocks));
+        CHECK(BCCodec_Decode(format, width, height, blocks, decoded, width * 4, 1));
+        psnr[q] = BCCodec_PSNR(format, width, height, image, width * 4, decoded, width * 4);
+    }
+    if (psnr[0] < min_range_fit || psnr[1] < min_cluster_fit)
+        ::printf("format %d: %.2f dB (range fit), %.2f dB (cluster fit) \n", (int)format, psnr[0], psnr[1]);
+    CHECK(psnr[0] >= min_range_fit);
+    CHECK(psnr[1] >= min_cluster_fit);
+    CHECK(psnr[1] >= psnr[0] - 0.05);
+    ::free(blocks);
+    ::free(decoded);
+    ::free(image);
+}
+
+int
+main () {
+    test_bc1_decode();
+    // -- floors just under what the codec reaches (range fit, cluster fit).
+    // Single channel formats get a smaller image, at 256x256 red and green are exact in every block.
+    test_psnr(DXGI_FORMAT_BC1_UNORM, 256, 256, 43.0, 45.0);
+    test_psnr(DXGI_FORMAT_BC3_UNORM, 256, 256, 45.0, 46.0);
+    test_psnr(DXGI_FORMAT_BC4_UNORM, 128, 128, 53.5, 56.0);
+    test_psnr(DXGI_FORMAT_BC4_SNORM, 128, 128, 53.5, 56.0);
+    test_psnr(DXGI_FORMAT_BC5_UNORM, 128, 128, 56.5, 59.0);
+    test_psnr(DXGI_FORMAT_BC5_SNORM, 128, 128, 56.5, 59.0);
+    if (n_fails)
+        ::printf("bc codec: %d checks failed \n", n_fails);
+    else
+        ::printf("bc codec: all checks passed \n");
+    return n_fails ? 1 : 0;
+}
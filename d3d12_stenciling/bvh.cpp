@@ -0,0 +1,580 @@
+#include "bvh.h"
+
+#include <float.h>
+#include <math.h>
+#include <algorithm>
+
+using namespace DirectX;
+
+// sign bits of the 4 lanes (bit k set if lane k is all ones)
+static uint32_t
+lane_mask (FXMVECTOR v) {
+#if defined(_XM_SSE_INTRINSICS_)
+    return (uint32_t)_mm_movemask_ps(v);
+#else
+    uint32_t lanes[4];
+    XMStoreInt4(lanes, v);
+    return (lanes[0] >> 31) | ((lanes[1] >> 31) << 1) | ((lanes[2] >> 31) << 2) | ((lanes[3] >> 31) << 3);
+#endif
+}
+static float
+half_area (XMFLOAT3 const & bmin, XMFLOAT3 const & bmax) {
+    float dx = bmax.x - bmin.x;
+    float dy = bmax.y - bmin.y;
+    float dz = bmax.z - bmin.z;
+    return dx * dy + dy * dz + dz * dx;
+}
+static float
+get_axis (XMFLOAT3 const & v, int axis) {
+    return 0 == axis ? v.x : (1 == axis ? v.y : v.z);
+}
+static void
+grow (XMFLOAT3 * bmin, XMFLOAT3 * bmax, XMFLOAT3 const & pmin, XMFLOAT3 const & pmax) {
+    XMStoreFloat3(bmin, XMVectorMin(XMLoadFloat3(bmin), XMLoadFloat3(&pmin)));
+    XMStoreFloat3(bmax, XMVectorMax(XMLoadFloat3(bmax), XMLoadFloat3(&pmax)));
+}
+size_t
+Bvh_CalculateRequiredSize (UINT max_items) {
+    // a binary tree with one item per leaf has 2n - 1 nodes, the 4-wide tree fewer than n
+    size_t n_build_nodes = max_items > 0 ? 2 * (size_t)max_items - 1 : 0;
+    size_t n_nodes = max_items > 0 ? max_items : 0;
+    return sizeof(Bvh) +
+        2 * sizeof(XMFLOAT3) * max_items + sizeof(UINT) * max_items +
+        sizeof(BvhBuildNode) * n_build_nodes + sizeof(BvhNode) * n_nodes;
+}
+Bvh *
+Bvh_Init (BYTE * memory, UINT max_items) {
+    memset(memory, 0, Bvh_CalculateRequiredSize(max_items));
+
+    Bvh * ret = reinterpret_cast<Bvh *>(memory);
+    ret->max_items = max_items;
+    ret->n_items = 0;
+    ret->n_build_nodes = 0;
+    ret->n_nodes = 0;
+    ret->dirty = false;
+
+    // Setup pointers (arrays)
+    BYTE * ptr = memory + sizeof(Bvh);
+    ret->nodes = reinterpret_cast<BvhNode *>(ptr);
+    ptr += sizeof(BvhNode) * max_items;
+    ret->build_nodes = reinterpret_cast<BvhBuildNode *>(ptr);
+    ptr += sizeof(BvhBuildNode) * (max_items > 0 ? 2 * (size_t)max_items - 1 : 0);
+    ret->item_min = reinterpret_cast<XMFLOAT3 *>(ptr);
+    ptr += sizeof(XMFLOAT3) * max_items;
+    ret->item_max = reinterpret_cast<XMFLOAT3 *>(ptr);
+    ptr += sizeof(XMFLOAT3) * max_items;
+    ret->item_order = reinterpret_cast<UINT *>(ptr);
+
+    return ret;
+}
+void
+Bvh_SetItem (Bvh * bvh, UINT index, BoundingBox const & local_bounds, XMFLOAT4X4 const & world) {
+    _ASSERT_EXPR(index < bvh->max_items, "BVH item index out of range");
+
+    BoundingBox world_bounds;
+    local_bounds.Transform(world_bounds, XMLoadFloat4x4(&world));
+
+    XMVECTOR c = XMLoadFloat3(&world_bounds.Center);
+    XMVECTOR e = XMLoadFloat3(&world_bounds.Extents);
+    XMStoreFloat3(&bvh->item_min[index], XMVectorSubtract(c, e));
+    XMStoreFloat3(&bvh->item_max[index], XMVectorAdd(c, e));
+
+    if (index >= bvh->n_items)
+        bvh->n_items = index + 1;
+    bvh->dirty = true;
+}
+//
+// -- build
+//
+// median_split ignores the SAH and halves the range along the largest centroid extent (bounded depth)
+static UINT
+build_binary (Bvh * bvh, UINT first, UINT count, bool median_split) {
+    UINT node_index = bvh->n_build_nodes++;
+    BvhBuildNode * node = &bvh->build_nodes[node_index];
+    node->first = first;
+    node->count = count;
+    node->left = node->right = 0;
+
+    // -- bounds of the items and of their centroids
+    UINT * order = bvh->item_order;
+    XMFLOAT3 bmin = bvh->item_min[order[first]];
+    XMFLOAT3 bmax = bvh->item_max[order[first]];
+    XMFLOAT3 cmin, cmax;
+    XMStoreFloat3(&cmin, XMVectorScale(XMVectorAdd(XMLoadFloat3(&bmin), XMLoadFloat3(&bmax)), 0.5f));
+    cmax = cmin;
+    for (UINT i = first + 1; i < first + count; ++i) {
+        grow(&bmin, &bmax, bvh->item_min[order[i]], bvh->item_max[order[i]]);
+        XMFLOAT3 c;
+        XMStoreFloat3(&c, XMVectorScale(XMVectorAdd(XMLoadFloat3(&bvh->item_min[order[i]]), XMLoadFloat3(&bvh->item_max[order[i]])), 0.5f));
+        grow(&cmin, &cmax, c, c);
+    }
+    node->min = bmin;
+    node->max = bmax;
+    if (1 == count)
+        return node_index;
+
+    // -- split along the largest centroid extent, binned SAH picks the plane
+    XMFLOAT3 cext = XMFLOAT3(cmax.x - cmin.x, cmax.y - cmin.y, cmax.z - cmin.z);
+    int axis = (cext.x >= cext.y && cext.x >= cext.z) ? 0 : (cext.y >= cext.z ? 1 : 2);
+    float axis_min = get_axis(cmin, axis);
+    float axis_ext = get_axis(cext, axis);
+
+    UINT mid = first + count / 2;
+    if (median_split) {
+        auto centroid = [&](UINT item) {
+            return get_axis(bvh->item_min[item], axis) + get_axis(bvh->item_max[item], axis);
+        };
+        std::nth_element(order + first, order + mid, order + first + count, [&](UINT a, UINT b) {
+            return centroid(a) < centroid(b);
+        });
+    } else if (axis_ext > 0.0f) {
+        struct Bin {
+            XMFLOAT3 min;
+            XMFLOAT3 max;
+            UINT count;
+        } bins[BVH_SAH_BINS];
+        for (int b = 0; b < BVH_SAH_BINS; ++b) {
+            bins[b].min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+            bins[b].max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            bins[b].count = 0;
+        }
+        float scale = BVH_SAH_BINS / axis_ext;
+        auto bin_of = [&](UINT item) {
+            float c = 0.5f * (get_axis(bvh->item_min[item], axis) + get_axis(bvh->item_max[item], axis));
+            int b = (int)((c - axis_min) * scale);
+            return b < BVH_SAH_BINS ? b : BVH_SAH_BINS - 1;
+        };
+        for (UINT i = first; i < first + count; ++i) {
+            Bin * bin = &bins[bin_of(order[i])];
+            grow(&bin->min, &bin->max, bvh->item_min[order[i]], bvh->item_max[order[i]]);
+            bin->count++;
+        }
+
+        // -- sweep from the right to get suffix areas, then from the left to evaluate every plane
+        float right_cost[BVH_SAH_BINS];
+        XMFLOAT3 rmin = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+        XMFLOAT3 rmax = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        UINT rcount = 0;
+        for (int b = BVH_SAH_BINS - 1; b > 0; --b) {
+            grow(&rmin, &rmax, bins[b].min, bins[b].max);
+            rcount += bins[b].count;
+            right_cost[b] = rcount > 0 ? half_area(rmin, rmax) * rcount : 0.0f;
+        }
+        XMFLOAT3 lmin = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+        XMFLOAT3 lmax = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        UINT lcount = 0;
+        float best_cost = FLT_MAX;
+        int best_split = -1;
+        for (int b = 0; b < BVH_SAH_BINS - 1; ++b) {
+            grow(&lmin, &lmax, bins[b].min, bins[b].max);
+            lcount += bins[b].count;
+            if (0 == lcount || count == lcount)
+                continue;
+            float cost = half_area(lmin, lmax) * lcount + right_cost[b + 1];
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_split = b;
+            }
+        }
+
+        if (best_split >= 0) {
+            // -- partition in place: items in bins [0, best_split] go left
+            UINT i = first;
+            UINT j = first + count;
+            while (i < j) {
+                if (bin_of(order[i]) <= best_split) {
+                    ++i;
+                } else {
+                    --j;
+                    UINT tmp = order[i];
+                    order[i] = order[j];
+                    order[j] = tmp;
+                }
+            }
+            mid = i;
+        }
+    }
+    // NOTE(omid): coincident centroids (or no useful plane) fall back to an even split of the range
+
+    UINT left = build_binary(bvh, first, mid - first, median_split);
+    UINT right = build_binary(bvh, mid, first + count - mid, median_split);
+    bvh->build_nodes[node_index].left = left;
+    bvh->build_nodes[node_index].right = right;
+    return node_index;
+}
+static void
+set_lane_bounds (BvhNode * node, int lane, XMFLOAT3 const & bmin, XMFLOAT3 const & bmax) {
+    node->min_x[lane] = bmin.x; node->min_y[lane] = bmin.y; node->min_z[lane] = bmin.z;
+    node->max_x[lane] = bmax.x; node->max_y[lane] = bmax.y; node->max_z[lane] = bmax.z;
+}
+// Collapses the binary subtree rooted at build_index into 4-wide nodes at the given level, returns the node index
+static UINT
+collapse (Bvh * bvh, UINT build_index, UINT level) {
+    BvhBuildNode const * nodes = bvh->build_nodes;
+
+    // -- pull grandchildren up: open the largest inner child until there are 4 children
+    UINT children[4] = {nodes[build_index].left, nodes[build_index].right};
+    int n_children = 2;
+    while (n_children < 4) {
+        int best = -1;
+        float best_area = -1.0f;
+        for (int k = 0; k < n_children; ++k) {
+            BvhBuildNode const * c = &nodes[children[k]];
+            float area = half_area(c->min, c->max);
+            if (c->count > 1 && area > best_area) {
+                best_area = area;
+                best = k;
+            }
+        }
+        if (best < 0)
+            break;
+        UINT opened = children[best];
+        children[best] = nodes[opened].left;
+        children[n_children++] = nodes[opened].right;
+    }
+
+    UINT node_index = bvh->n_nodes++;
+    BvhNode * node = &bvh->nodes[node_index];
+    if (level + 1 > bvh->depth)
+        bvh->depth = level + 1;
+    for (int k = 0; k < 4; ++k) {
+        if (k < n_children) {
+            BvhBuildNode const * c = &nodes[children[k]];
+            set_lane_bounds(node, k, c->min, c->max);
+            node->first[k] = c->first;
+            node->count[k] = c->count;
+            node->child[k] = 0;
+        } else {
+            // empty lanes get an inverted box, so they fail every overlap test
+            set_lane_bounds(node, k, XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX), XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+            node->first[k] = 0;
+            node->count[k] = 0;
+            node->child[k] = 0;
+        }
+    }
+    // -- children are emitted after their parent (Bvh_Refit relies on it)
+    for (int k = 0; k < n_children; ++k) {
+        BvhBuildNode const * c = &nodes[children[k]];
+        node->child[k] = (1 == c->count) ?
+            ~(int32_t)bvh->item_order[c->first] :
+            (int32_t)collapse(bvh, children[k], level + 1);
+    }
+    return node_index;
+}
+void
+Bvh_Build (Bvh * bvh) {
+    bvh->n_build_nodes = 0;
+    bvh->n_nodes = 0;
+    bvh->depth = 0;
+    bvh->dirty = false;
+
+    UINT n_items = bvh->n_items;
+    if (0 == n_items)
+        return;
+    for (UINT i = 0; i < n_items; ++i)
+        bvh->item_order[i] = i;
+
+    build_binary(bvh, 0, n_items, false);
+
+    if (1 == n_items) {
+        // -- a single leaf still needs a root to hold its lane
+        BvhNode * root = &bvh->nodes[bvh->n_nodes++];
+        for (int k = 0; k < 4; ++k) {
+            set_lane_bounds(root, k, XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX), XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+            root->first[k] = root->count[k] = 0;
+            root->child[k] = 0;
+        }
+        set_lane_bounds(root, 0, bvh->item_min[0], bvh->item_max[0]);
+        root->count[0] = 1;
+        root->child[0] = ~0;
+        bvh->depth = 1;
+    } else {
+        collapse(bvh, 0, 0);
+        if (3 * bvh->depth + 1 > BVH_STACK_SIZE) {
+            // -- clustered input can make the SAH peel items off one by one, median splits keep the traversal stacks bounded
+            bvh->n_build_nodes = 0;
+            bvh->n_nodes = 0;
+            bvh->depth = 0;
+            build_binary(bvh, 0, n_items, true);
+            collapse(bvh, 0, 0);
+        }
+    }
+    _ASSERT_EXPR(3 * bvh->depth + 1 <= BVH_STACK_SIZE, "BVH too deep for the traversal stack");
+}
+void
+Bvh_Refit (Bvh * bvh) {
+    if (!bvh->dirty)
+        return;
+
+    // -- children are stored after their parent, a reverse sweep sees every child before its parent
+    for (UINT n = bvh->n_nodes; n-- > 0;) {
+        BvhNode * node = &bvh->nodes[n];
+        for (int k = 0; k < 4; ++k) {
+            if (0 == node->count[k])
+                continue;
+            int32_t child = node->child[k];
+            if (child < 0) {
+                set_lane_bounds(node, k, bvh->item_min[~child], bvh->item_max[~child]);
+            } else {
+                BvhNode const * c = &bvh->nodes[child];
+                // empty lanes of the child are inverted, so they don't affect the reduction
+                XMVECTOR mn = XMVectorMin(
+                    XMVectorMin(XMVectorSet(c->min_x[0], c->min_y[0], c->min_z[0], 0.0f), XMVectorSet(c->min_x[1], c->min_y[1], c->min_z[1], 0.0f)),
+                    XMVectorMin(XMVectorSet(c->min_x[2], c->min_y[2], c->min_z[2], 0.0f), XMVectorSet(c->min_x[3], c->min_y[3], c->min_z[3], 0.0f))
+                );
+                XMVECTOR mx = XMVectorMax(
+                    XMVectorMax(XMVectorSet(c->max_x[0], c->max_y[0], c->max_z[0], 0.0f), XMVectorSet(c->max_x[1], c->max_y[1], c->max_z[1], 0.0f)),
+                    XMVectorMax(XMVectorSet(c->max_x[2], c->max_y[2], c->max_z[2], 0.0f), XMVectorSet(c->max_x[3], c->max_y[3], c->max_z[3], 0.0f))
+                );
+                XMFLOAT3 bmin, bmax;
+                XMStoreFloat3(&bmin, mn);
+                XMStoreFloat3(&bmax, mx);
+                set_lane_bounds(node, k, bmin, bmax);
+            }
+        }
+    }
+    bvh->dirty = false;
+}
+//
+// -- queries
+//
+struct NodeLanes {
+    XMVECTOR min_x, min_y, min_z;
+    XMVECTOR max_x, max_y, max_z;
+};
+static NodeLanes
+load_lanes (BvhNode const * node) {
+    NodeLanes ret;
+    ret.min_x = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const *>(node->min_x));
+    ret.min_y = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const *>(node->min_y));
+    ret.min_z = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const *>(node->min_z));
+    ret.max_x = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const *>(node->max_x));
+    ret.max_y = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const *>(node->max_y));
+    ret.max_z = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const *>(node->max_z));
+    return ret;
+}
+static uint32_t
+used_lanes (BvhNode const * node) {
+    return (node->count[0] ? 1u : 0u) | (node->count[1] ? 2u : 0u) | (node->count[2] ? 4u : 0u) | (node->count[3] ? 8u : 0u);
+}
+static UINT
+emit_range (Bvh const * bvh, UINT first, UINT count, UINT out_items [], UINT n_out, UINT max_out) {
+    for (UINT i = 0; i < count && n_out < max_out; ++i)
+        out_items[n_out++] = bvh->item_order[first + i];
+    return n_out;
+}
+UINT
+Bvh_QueryFrustum (Bvh const * bvh, BoundingFrustum const & frustum, UINT out_items [], UINT max_out) {
+    if (0 == bvh->n_nodes)
+        return 0;
+
+    // -- world-space planes, normals point outward (splatted, lanes are the 4 children)
+    XMVECTOR planes[6];
+    frustum.GetPlanes(&planes[0], &planes[1], &planes[2], &planes[3], &planes[4], &planes[5]);
+    XMVECTOR px[6], py[6], pz[6], pw[6];
+    XMVECTOR abs_px[6], abs_py[6], abs_pz[6];
+    for (int p = 0; p < 6; ++p) {
+        px[p] = XMVectorSplatX(planes[p]);
+        py[p] = XMVectorSplatY(planes[p]);
+        pz[p] = XMVectorSplatZ(planes[p]);
+        pw[p] = XMVectorSplatW(planes[p]);
+        abs_px[p] = XMVectorAbs(px[p]);
+        abs_py[p] = XMVectorAbs(py[p]);
+        abs_pz[p] = XMVectorAbs(pz[p]);
+    }
+    XMVECTOR half = XMVectorReplicate(0.5f);
+
+    UINT n_out = 0;
+    UINT stack[BVH_STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0 && n_out < max_out) {
+        BvhNode const * node = &bvh->nodes[stack[--top]];
+        NodeLanes lanes = load_lanes(node);
+
+        XMVECTOR cx = XMVectorMultiply(XMVectorAdd(lanes.min_x, lanes.max_x), half);
+        XMVECTOR cy = XMVectorMultiply(XMVectorAdd(lanes.min_y, lanes.max_y), half);
+        XMVECTOR cz = XMVectorMultiply(XMVectorAdd(lanes.min_z, lanes.max_z), half);
+        XMVECTOR ex = XMVectorMultiply(XMVectorSubtract(lanes.max_x, lanes.min_x), half);
+        XMVECTOR ey = XMVectorMultiply(XMVectorSubtract(lanes.max_y, lanes.min_y), half);
+        XMVECTOR ez = XMVectorMultiply(XMVectorSubtract(lanes.max_z, lanes.min_z), half);
+
+        // outside: farther in front of any plane than the projected radius
+        // inside: behind every plane by more than the projected radius
+        XMVECTOR outside = XMVectorFalseInt();
+        XMVECTOR inside = XMVectorTrueInt();
+        for (int p = 0; p < 6; ++p) {
+            XMVECTOR dist = XMVectorMultiplyAdd(cz, pz[p], XMVectorMultiplyAdd(cy, py[p], XMVectorMultiplyAdd(cx, px[p], pw[p])));
+            XMVECTOR radius = XMVectorMultiplyAdd(ez, abs_pz[p], XMVectorMultiplyAdd(ey, abs_py[p], XMVectorMultiply(ex, abs_px[p])));
+            outside = XMVectorOrInt(outside, XMVectorGreater(dist, radius));
+            inside = XMVectorAndInt(inside, XMVectorLess(dist, XMVectorNegate(radius)));
+        }
+        uint32_t hit = ~lane_mask(outside) & used_lanes(node);
+        uint32_t contained = lane_mask(inside) & hit;
+
+        for (int k = 0; k < 4; ++k) {
+            if (0 == (hit & (1u << k)))
+                continue;
+            int32_t child = node->child[k];
+            if (child < 0) {
+                if (n_out < max_out)
+                    out_items[n_out++] = (UINT)~child;
+            } else if (contained & (1u << k)) {
+                // the whole subtree is visible, no need to descend
+                n_out = emit_range(bvh, node->first[k], node->count[k], out_items, n_out, max_out);
+            } else {
+                _ASSERT_EXPR(top < BVH_STACK_SIZE, "BVH traversal stack overflow");
+                stack[top++] = (UINT)child;
+            }
+        }
+    }
+    return n_out;
+}
+UINT
+Bvh_QuerySphere (Bvh const * bvh, BoundingSphere const & sphere, UINT out_items [], UINT max_out) {
+    if (0 == bvh->n_nodes)
+        return 0;
+
+    XMVECTOR sx = XMVectorReplicate(sphere.Center.x);
+    XMVECTOR sy = XMVectorReplicate(sphere.Center.y);
+    XMVECTOR sz = XMVectorReplicate(sphere.Center.z);
+    XMVECTOR r2 = XMVectorReplicate(sphere.Radius * sphere.Radius);
+    XMVECTOR zero = XMVectorZero();
+
+    UINT n_out = 0;
+    UINT stack[BVH_STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0 && n_out < max_out) {
+        BvhNode const * node = &bvh->nodes[stack[--top]];
+        NodeLanes lanes = load_lanes(node);
+
+        // squared distance from the center to the closest point of each box
+        XMVECTOR dx = XMVectorMax(XMVectorMax(XMVectorSubtract(lanes.min_x, sx), XMVectorSubtract(sx, lanes.max_x)), zero);
+        XMVECTOR dy = XMVectorMax(XMVectorMax(XMVectorSubtract(lanes.min_y, sy), XMVectorSubtract(sy, lanes.max_y)), zero);
+        XMVECTOR dz = XMVectorMax(XMVectorMax(XMVectorSubtract(lanes.min_z, sz), XMVectorSubtract(sz, lanes.max_z)), zero);
+        XMVECTOR d2 = XMVectorMultiplyAdd(dz, dz, XMVectorMultiplyAdd(dy, dy, XMVectorMultiply(dx, dx)));
+        uint32_t hit = lane_mask(XMVectorLessOrEqual(d2, r2)) & used_lanes(node);
+
+        for (int k = 0; k < 4; ++k) {
+            if (0 == (hit & (1u << k)))
+                continue;
+            int32_t child = node->child[k];
+            if (child < 0) {
+                if (n_out < max_out)
+                    out_items[n_out++] = (UINT)~child;
+            } else {
+                _ASSERT_EXPR(top < BVH_STACK_SIZE, "BVH traversal stack overflow");
+                stack[top++] = (UINT)child;
+            }
+        }
+    }
+    return n_out;
+}
+// A zero direction component would give 0 * inf = NaN in the slab test for an origin on a slab plane,
+// a tiny one keeps the products finite (the ray is still parallel for any practical purpose)
+static float
+nonzero (float d) {
+    return fabsf(d) < 1e-20f ? copysignf(1e-20f, d) : d;
+}
+bool
+Bvh_RayCast (
+    Bvh const * bvh,
+    XMFLOAT3 const & origin, XMFLOAT3 const & dir, float max_t,
+    BvhRayHitFunc hit_func, void * user_data,
+    UINT * out_item, float * out_t
+) {
+    if (0 == bvh->n_nodes)
+        return false;
+
+    XMVECTOR ox = XMVectorReplicate(origin.x);
+    XMVECTOR oy = XMVectorReplicate(origin.y);
+    XMVECTOR oz = XMVectorReplicate(origin.z);
+    XMVECTOR inv_x = XMVectorReplicate(1.0f / nonzero(dir.x));
+    XMVECTOR inv_y = XMVectorReplicate(1.0f / nonzero(dir.y));
+    XMVECTOR inv_z = XMVectorReplicate(1.0f / nonzero(dir.z));
+    XMVECTOR zero = XMVectorZero();
+
+    bool found = false;
+    UINT best_item = 0;
+    float best_t = max_t;
+
+    // entries remember the box entry distance, so subtrees behind the current hit are skipped when popped
+    struct StackEntry {
+        UINT node;
+        float t;
+    } stack[BVH_STACK_SIZE];
+    int top = 0;
+    stack[top++] = {0, 0.0f};
+    while (top > 0) {
+        StackEntry entry = stack[--top];
+        if (entry.t > best_t)
+            continue;
+        BvhNode const * node = &bvh->nodes[entry.node];
+        NodeLanes lanes = load_lanes(node);
+
+        // -- slab test of the 4 boxes
+        XMVECTOR t0x = XMVectorMultiply(XMVectorSubtract(lanes.min_x, ox), inv_x);
+        XMVECTOR t1x = XMVectorMultiply(XMVectorSubtract(lanes.max_x, ox), inv_x);
+        XMVECTOR t0y = XMVectorMultiply(XMVectorSubtract(lanes.min_y, oy), inv_y);
+        XMVECTOR t1y = XMVectorMultiply(XMVectorSubtract(lanes.max_y, oy), inv_y);
+        XMVECTOR t0z = XMVectorMultiply(XMVectorSubtract(lanes.min_z, oz), inv_z);
+        XMVECTOR t1z = XMVectorMultiply(XMVectorSubtract(lanes.max_z, oz), inv_z);
+        XMVECTOR tnear = XMVectorMax(XMVectorMax(XMVectorMin(t0x, t1x), XMVectorMin(t0y, t1y)), XMVectorMax(XMVectorMin(t0z, t1z), zero));
+        XMVECTOR tfar = XMVectorMin(XMVectorMin(XMVectorMax(t0x, t1x), XMVectorMax(t0y, t1y)), XMVectorMin(XMVectorMax(t0z, t1z), XMVectorReplicate(best_t)));
+        uint32_t hit = lane_mask(XMVectorLessOrEqual(tnear, tfar)) & used_lanes(node);
+        if (0 == hit)
+            continue;
+
+        XMFLOAT4 near4;
+        XMStoreFloat4(&near4, tnear);
+        float tn[4] = {near4.x, near4.y, near4.z, near4.w};
+
+        // -- order hit lanes front to back (at most 4, insertion sort)
+        int order[4];
+        int n_hit = 0;
+        for (int k = 0; k < 4; ++k) {
+            if (0 == (hit & (1u << k)))
+                continue;
+            int j = n_hit++;
+            while (j > 0 && tn[order[j - 1]] > tn[k]) {
+                order[j] = order[j - 1];
+                --j;
+            }
+            order[j] = k;
+        }
+        // leaves are resolved right away (closest first), inner nodes pushed far to near so the nearest pops first
+        for (int i = 0; i < n_hit; ++i) {
+            int k = order[i];
+            int32_t child = node->child[k];
+            if (child >= 0 || tn[k] > best_t)
+                continue;
+            float t = best_t;
+            if (hit_func) {
+                if (!hit_func(user_data, (UINT)~child, origin, dir, &t) || t > best_t)
+                    continue;
+            } else {
+                t = tn[k];
+            }
+            best_t = t;
+            best_item = (UINT)~child;
+            found = true;
+        }
+        for (int i = n_hit; i-- > 0;) {
+            int k = order[i];
+            int32_t child = node->child[k];
+            if (child < 0 || tn[k] > best_t)
+                continue;
+            _ASSERT_EXPR(top < BVH_STACK_SIZE, "BVH traversal stack overflow");
+            stack[top++] = {(UINT)child, tn[k]};
+        }
+    }
+
+    if (found) {
+        if (out_item)
+            *out_item = best_item;
+        if (out_t)
+            *out_t = best_t;
+    }
+    return found;
+}
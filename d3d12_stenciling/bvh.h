@@ -0,0 +1,107 @@
+#pragma once
+
+#include "headers/common.h"
+
+// NOTE(omid): Bounding volume hierarchy over render item bounds.
+// Built top-down with binned SAH into a binary tree, which is then collapsed into 4-wide nodes,
+// so traversal tests the 4 child boxes of a node at once (one SIMD lane per child).
+// Every leaf lane references exactly one item. Nodes are stored parent before children,
+// which lets Bvh_Refit update the boxes in one reverse sweep when items move.
+// Item slots are addressed by the caller (e.g., obj_cbuffer_index of the render items).
+// Traversal stacks hold at most 3 * depth + 1 nodes (each pop pushes up to 4 children); Bvh_Build falls back
+// to median splits (depth of log2(n)) when the SAH tree is too deep for BVH_STACK_SIZE.
+
+#define BVH_SAH_BINS            12
+#define BVH_STACK_SIZE          256
+
+struct BvhNode {
+    float min_x[4];
+    float min_y[4];
+    float min_z[4];
+    float max_x[4];
+    float max_y[4];
+    float max_z[4];
+
+    // child >= 0 is an inner node index, child < 0 is a leaf lane holding item ~child
+    int32_t child[4];
+    // subtree items are item_order[first, first + count), count == 0 marks an empty lane
+    UINT first[4];
+    UINT count[4];
+};
+// Intermediate binary tree (build only)
+struct BvhBuildNode {
+    DirectX::XMFLOAT3 min;
+    DirectX::XMFLOAT3 max;
+    UINT left;
+    UINT right;
+    UINT first;
+    UINT count;
+};
+struct Bvh {
+    UINT max_items;
+    UINT n_items;       // one past the highest slot in use
+
+    // world-space item boxes
+    DirectX::XMFLOAT3 * item_min;
+    DirectX::XMFLOAT3 * item_max;
+    UINT * item_order;
+
+    BvhBuildNode *  build_nodes;
+    UINT            n_build_nodes;
+
+    BvhNode *   nodes;
+    UINT        n_nodes;
+    UINT        depth;  // levels of 4-wide nodes
+
+    bool dirty;         // an item box has changed since the last build/refit
+};
+
+/*
+    Narrow phase of a ray cast, called for every item whose box is hit (closest boxes first).
+    Returns true and writes a smaller *inout_t if the item is hit closer than *inout_t.
+*/
+typedef bool (*BvhRayHitFunc)(
+    void * user_data, UINT item,
+    DirectX::XMFLOAT3 const & origin, DirectX::XMFLOAT3 const & dir, float * inout_t
+);
+
+size_t
+Bvh_CalculateRequiredSize (UINT max_items);
+
+Bvh *
+Bvh_Init (BYTE * memory, UINT max_items);
+
+// Transforms the local box by world and stores the resulting world-space AABB in the slot
+void
+Bvh_SetItem (Bvh * bvh, UINT index, DirectX::BoundingBox const & local_bounds, DirectX::XMFLOAT4X4 const & world);
+
+// Rebuilds the tree over items [0, n_items)
+void
+Bvh_Build (Bvh * bvh);
+
+// Updates node boxes after items moved (tree topology is kept), no-op if nothing changed
+void
+Bvh_Refit (Bvh * bvh);
+
+/*
+    Queries write up to max_out item indices and return the number written.
+    Frustum is in world space.
+*/
+UINT
+Bvh_QueryFrustum (Bvh const * bvh, DirectX::BoundingFrustum const & frustum, UINT out_items [], UINT max_out);
+
+UINT
+Bvh_QuerySphere (Bvh const * bvh, DirectX::BoundingSphere const & sphere, UINT out_items [], UINT max_out);
+
+/*
+    Closest hit along origin + t * dir, t in [0, max_t].
+    hit_func refines box hits (pass nullptr to accept the box entry distance).
+    Returns false if nothing is hit.
+*/
+bool
+Bvh_RayCast (
+    Bvh const * bvh,
+    DirectX::XMFLOAT3 const & origin, DirectX::XMFLOAT3 const & dir, float max_t,
+    BvhRayHitFunc hit_func, void * user_data,
+    UINT * out_item, float * out_t
+);
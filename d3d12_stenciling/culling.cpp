@@ -0,0 +1,150 @@
+#include "culling.h"
+
+using namespace DirectX;
+
+static UINT
+padded_count (UINT n) {
+    return (n + 3) & ~3u;
+}
+// sign bits of the 4 lanes (bit k set if lane k is all ones)
+static uint32_t
+lane_mask (FXMVECTOR v) {
+#if defined(_XM_SSE_INTRINSICS_)
+    return (uint32_t)_mm_movemask_ps(v);
+#else
+    uint32_t lanes[4];
+    XMStoreInt4(lanes, v);
+    return (lanes[0] >> 31) | ((lanes[1] >> 31) << 1) | ((lanes[2] >> 31) << 2) | ((lanes[3] >> 31) << 3);
+#endif
+}
+size_t
+CullingSet_CalculateRequiredSize (UINT max_items) {
+    UINT n = padded_count(max_items);
+    return sizeof(CullingSet) + 6 * sizeof(float) * n + sizeof(uint8_t) * n + sizeof(UINT) * n;
+}
+CullingSet *
+CullingSet_Init (BYTE * memory, UINT max_items) {
+    UINT n = padded_count(max_items);
+    memset(memory, 0, CullingSet_CalculateRequiredSize(max_items));
+
+    CullingSet * ret = reinterpret_cast<CullingSet *>(memory);
+    ret->max_items = max_items;
+    ret->n_items = 0;
+    ret->n_visible = 0;
+
+    // Setup pointers (arrays)
+    float * ptr = reinterpret_cast<float *>(memory + sizeof(CullingSet));
+    ret->center_x = ptr; ptr += n;
+    ret->center_y = ptr; ptr += n;
+    ret->center_z = ptr; ptr += n;
+    ret->extent_x = ptr; ptr += n;
+    ret->extent_y = ptr; ptr += n;
+    ret->extent_z = ptr; ptr += n;
+    ret->visible_indices = reinterpret_cast<UINT *>(ptr);
+    ret->visible = reinterpret_cast<uint8_t *>(ret->visible_indices + n);
+
+    return ret;
+}
+void
+CullingSet_SetItem (CullingSet * set, UINT index, BoundingBox const & local_bounds, XMFLOAT4X4 const & world) {
+    _ASSERT_EXPR(index < set->max_items, "Culling item index out of range");
+
+    BoundingBox world_bounds;
+    local_bounds.Transform(world_bounds, XMLoadFloat4x4(&world));
+
+    set->center_x[index] = world_bounds.Center.x;
+    set->center_y[index] = world_bounds.Center.y;
+    set->center_z[index] = world_bounds.Center.z;
+    set->extent_x[index] = world_bounds.Extents.x;
+    set->extent_y[index] = world_bounds.Extents.y;
+    set->extent_z[index] = world_bounds.Extents.z;
+
+    if (index >= set->n_items)
+        set->n_items = index + 1;
+}
+UINT
+CullingSet_Cull (CullingSet * set, BoundingFrustum const & frustum) {
+    // -- world-space planes, normals point outward
+    XMVECTOR planes[6];
+    frustum.GetPlanes(&planes[0], &planes[1], &planes[2], &planes[3], &planes[4], &planes[5]);
+
+    // splat plane components once, every lane tests a different box against the same plane
+    XMVECTOR px[6], py[6], pz[6], pw[6];
+    XMVECTOR abs_px[6], abs_py[6], abs_pz[6];
+    for (int p = 0; p < 6; ++p) {
+        px[p] = XMVectorSplatX(planes[p]);
+        py[p] = XMVectorSplatY(planes[p]);
+        pz[p] = XMVectorSplatZ(planes[p]);
+        pw[p] = XMVectorSplatW(planes[p]);
+        abs_px[p] = XMVectorAbs(px[p]);
+        abs_py[p] = XMVectorAbs(py[p]);
+        abs_pz[p] = XMVectorAbs(pz[p]);
+    }
+
+    UINT n_items = set->n_items;
+    UINT n_visible = 0;
+    UINT * out = set->visible_indices;
+    for (UINT i = 0; i < n_items; i += 4) {
+        XMVECTOR cx = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const *>(set->center_x + i));
+        XMVECTOR cy = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const *>(set->center_y + i));
+        XMVECTOR cz = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const *>(set->center_z + i));
+        XMVECTOR ex = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const *>(set->extent_x + i));
+        XMVECTOR ey = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const *>(set->extent_y + i));
+        XMVECTOR ez = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const *>(set->extent_z + i));
+
+        // a box is outside if its center is farther in front of any plane than its projected radius
+        XMVECTOR outside = XMVectorFalseInt();
+        for (int p = 0; p < 6; ++p) {
+            XMVECTOR dist = XMVectorMultiplyAdd(cz, pz[p], XMVectorMultiplyAdd(cy, py[p], XMVectorMultiplyAdd(cx, px[p], pw[p])));
+            XMVECTOR radius = XMVectorMultiplyAdd(ez, abs_pz[p], XMVectorMultiplyAdd(ey, abs_py[p], XMVectorMultiply(ex, abs_px[p])));
+            outside = XMVectorOrInt(outside, XMVectorGreater(dist, radius));
+        }
+
+        uint32_t mask = ~lane_mask(outside) & 0xf;
+        if (n_items - i < 4)    // ignore padding lanes
+            mask &= (1u << (n_items - i)) - 1;
+
+        // -- branchless compaction (visible_indices is padded, so writing past n_visible is fine)
+        for (UINT k = 0; k < 4; ++k) {
+            uint32_t bit = (mask >> k) & 1;
+            set->visible[i + k] = (uint8_t)bit;
+            out[n_visible] = i + k;
+            n_visible += bit;
+        }
+    }
+    set->n_visible = n_visible;
+    return n_visible;
+}
+BoundingBox
+compute_vertex_bounds (void const * vertices, UINT nvtx, UINT stride) {
+    BoundingBox ret = {};
+    if (0 == nvtx)
+        return ret;
+
+    BYTE const * ptr = reinterpret_cast<BYTE const *>(vertices);
+    XMVECTOR vmin0 = XMLoadFloat3(reinterpret_cast<XMFLOAT3 const *>(ptr));
+    XMVECTOR vmax0 = vmin0;
+    XMVECTOR vmin1 = vmin0;
+    XMVECTOR vmax1 = vmin0;
+
+    UINT i = 0;
+    if (stride >= sizeof(XMFLOAT4)) {
+        // -- a full 4-float load stays inside the vertex (w is ignored),
+        // two independent accumulators to hide min/max latency
+        for (; i + 2 <= nvtx; i += 2) {
+            XMVECTOR p0 = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const *>(ptr + (size_t)i * stride));
+            XMVECTOR p1 = XMLoadFloat4(reinterpret_cast<XMFLOAT4 const *>(ptr + (size_t)(i + 1) * stride));
+            vmin0 = XMVectorMin(vmin0, p0);
+            vmax0 = XMVectorMax(vmax0, p0);
+            vmin1 = XMVectorMin(vmin1, p1);
+            vmax1 = XMVectorMax(vmax1, p1);
+        }
+    }
+    for (; i < nvtx; ++i) {
+        XMVECTOR p = XMLoadFloat3(reinterpret_cast<XMFLOAT3 const *>(ptr + (size_t)i * stride));
+        vmin0 = XMVectorMin(vmin0, p);
+        vmax0 = XMVectorMax(vmax0, p);
+    }
+    BoundingBox::CreateFromPoints(ret, XMVectorMin(vmin0, vmin1), XMVectorMax(vmax0, vmax1));
+    return ret;
+}
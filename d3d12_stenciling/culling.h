@@ -0,0 +1,48 @@
+#pragma once
+
+#include "headers/common.h"
+
+// NOTE(omid): Frustum culling over world-space AABBs stored as SoA (one float array per component),
+// so a single pass tests 4 boxes at a time against each frustum plane (one SIMD lane per box).
+// Item slots are addressed by the caller (e.g., obj_cbuffer_index of the render items).
+struct CullingSet {
+    UINT max_items;
+    UINT n_items;       // one past the highest slot in use
+
+    // world-space boxes (arrays padded to a multiple of 4)
+    float * center_x;
+    float * center_y;
+    float * center_z;
+    float * extent_x;
+    float * extent_y;
+    float * extent_z;
+
+    // results of the last CullingSet_Cull
+    uint8_t *   visible;            // per slot, 1 if visible
+    UINT *      visible_indices;    // compact list of visible slots
+    UINT        n_visible;
+};
+
+size_t
+CullingSet_CalculateRequiredSize (UINT max_items);
+
+CullingSet *
+CullingSet_Init (BYTE * memory, UINT max_items);
+
+// Transforms the local box by world and stores the resulting world-space AABB in the slot
+void
+CullingSet_SetItem (CullingSet * set, UINT index, DirectX::BoundingBox const & local_bounds, DirectX::XMFLOAT4X4 const & world);
+
+/*
+    Tests all the items against a world-space frustum,
+    fills set->visible and set->visible_indices and returns the number of visible items.
+*/
+UINT
+CullingSet_Cull (CullingSet * set, DirectX::BoundingFrustum const & frustum);
+
+/*
+    Vectorized min/max reduction over vertex positions.
+    Position is expected at the beginning of each vertex (stride bytes apart).
+*/
+DirectX::BoundingBox
+compute_vertex_bounds (void const * vertices, UINT nvtx, UINT stride);
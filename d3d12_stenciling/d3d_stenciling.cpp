@@ -9,10 +9,27 @@
 
 #include <dxcapi.h>
 
+#include <float.h>
+
 #include "headers/utils.h"
 #include "headers/game_timer.h"
 #include "headers/dds_loader.h"
 
+#include "geometry_pool.h"
+#include "culling.h"
+#include "bvh.h"
+#include "mesh_weld.h"
+#include "text_model.h"
+#include "baked_mesh.h"
+#include "asset_cache.h"
+#include "asset_streamer.h"
+#include "asset_archive.h"
+#include "texcoords.h"
+#include "mip_streaming.h"
+#include "mip_gen.h"
+#include "geosphere.h"
+#include "tangents.h"
+
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_win32.h>
 #include <imgui/imgui_impl_dx12.h>
@@ -30,6 +47,28 @@
 #define NUM_BACKBUFFERS         2
 #define NUM_QUEUING_FRAMES      3
 
+// geometry pool capacity, streamed meshes included (skull is ~31k vertices and ~181k indices, car ~2k and ~6k)
+#define GEOMPOOL_MAX_VERTICES   (64 * 1024)
+#define GEOMPOOL_MAX_INDICES16  (256 * 1024)
+#define GEOMPOOL_MAX_INDICES32  (256 * 1024)
+
+// ball next to the mirror (the geosphere level sets its detail: 10 * 4^level + 2 vertices)
+#define BALL_RADIUS             0.75f
+#define BALL_GEOSPHERE_LEVEL    3
+
+// car parked along the back of the floor (the model is ~12 units long)
+#define CAR_SCALE               0.25f
+
+// on-disk derived data budget, least recently used entries are evicted beyond it
+#define ASSET_CACHE_MAX_BYTES   (256ull * 1024 * 1024)
+
+// loose textures and models are packed here on first run (repacked when a source is edited)
+#define ASSET_ARCHIVE_PATH      "./assets.pak"
+
+// background loading: request slots, and uploads recorded per frame at most
+#define STREAMER_MAX_JOBS           16
+#define STREAMER_UPLOADS_PER_FRAME  2
+
 enum RENDER_LAYERS : int {
     LAYER_OPAQUE = 0,
     LAYER_TRANSPARENT = 1,
@@ -50,12 +89,23 @@ enum ALL_RENDERITEMS {
     RITEM_REFLECTED_FLOOR = 5,
     RITEM_REFLECTED_SHADOW = 6,
     RITEM_SHADOWED_SKULL = 7,
+    RITEM_BALL = 8,
+    RITEM_REFLECTED_BALL = 9,
+    RITEM_CAR = 10,
+    RITEM_REFLECTED_CAR = 11,
 
     _COUNT_RENDERITEM
 };
+static char const * ritem_names [_COUNT_RENDERITEM] = {
+    "floor", "wall", "mirror", "skull",
+    "reflected skull", "reflected floor", "reflected shadow", "skull shadow",
+    "ball", "reflected ball", "car", "reflected car"
+};
 enum GEOM_INDEX {
     GEOM_ROOM = 0,
     GEOM_SKULL = 1,
+    GEOM_BALL = 2,
+    GEOM_CAR = 3,
 
     _COUNT_GEOM
 };
@@ -81,6 +131,9 @@ enum TEX_INDEX {
 
     _COUNT_TEX
 };
+// srv_heap: a view per texture, the imgui font, then a second view per texture
+// (a streamed texture alternates between its two views each time its clamp drops)
+#define SRV_SECOND_VIEWS        (_COUNT_TEX + 1)
 enum SAMPLER_INDEX {
     SAMPLER_POINT_WRAP = 0,
     SAMPLER_POINT_CLAMP = 1,
@@ -125,10 +178,64 @@ bool global_resizing;
 bool global_mouse_active;
 SceneContext global_scene_ctx;
 
+struct D3DRenderContext;
 struct RenderItemArray {
     RenderItem  ritems[_COUNT_RENDERITEM];
     uint32_t    size;
 };
+// A texture loaded by the streamer, and the material waiting for it
+struct StreamedTexture {
+    D3DRenderContext *          render_ctx;
+    TEX_INDEX                   tex;
+    MAT_INDEX                   mat;
+    int                         archive_entry;  // -1 for a loose file
+
+    // filled by the decode worker, consumed by the upload on the main thread
+    D3D12_SUBRESOURCE_DATA      subresources[DDS_MAX_SUBRESOURCES];
+    UINT                        n_subresources;
+    UINT                        first_subresource;
+
+    // Mip tail first, then one mip per request (only one request in flight per texture).
+    // layout and whole_file are written by the first read, the main thread looks at them once the tail landed.
+    MipStreamingLayout          layout;
+    bool                        whole_file;     // not streamable, all mips came at once
+    bool                        tail_loaded;
+    bool                        in_flight;
+    bool                        failed;         // stop asking for mips after an error
+    int                         priority;
+
+    // Textures authored without mips are baked first (full chain into the asset cache) by a request of their own,
+    // the baked DDS is then streamed instead of the source. baked_path is written by the bake worker (empty if
+    // the source is streamed as is).
+    bool                        bake_mips;
+    char                        baked_path[ASSET_CACHE_MAX_PATH];
+    UINT                        loading_mip;
+    UINT                        resident_mip;   // most detailed mip uploaded (the view's min LOD clamp)
+    UINT                        srv_index;      // view the material uses, the other one may still be in flight
+    UINT                        desired_mip;    // most detailed mip any visible item needs
+    ID3D12Resource *            mip_upload_heaps[MIP_STREAMING_MAX_MIPS];
+
+    // Streaming fence value that covers the copy out of an upload heap (0 until the copy is recorded),
+    // the heap is released once the fence has passed it
+    UINT64                      tail_upload_fence;      // textures[tex].upload_heap
+    UINT64                      mip_upload_fences[MIP_STREAMING_MAX_MIPS];
+};
+// A text model loaded by the streamer, the render items drawing its geometry are hidden until it's uploaded
+struct StreamedMesh {
+    D3DRenderContext *          render_ctx;
+    char const *                src_path;
+    wchar_t                     filename[64];   // loose files are read by the streamer itself
+    int                         archive_entry;  // -1 for a loose file
+    GEOM_INDEX                  geom;
+    char const *                name;
+
+    // opened by the decode worker (cached bake or a new one), closed once the main thread staged it
+    BakedMesh                   mesh;
+
+    // the copy out of the uploader is covered by upload_fence (0 until it's recorded)
+    ID3D12Resource *            uploader;
+    UINT64                      upload_fence;
+};
 struct D3DRenderContext {
     // Used formats
     struct {
@@ -172,8 +279,24 @@ struct D3DRenderContext {
     RenderItemArray                 shadow_ritems;
     RenderItemArray                 reflected_shadow_ritems;
 
+    // Derived data (baked meshes) keyed by the hash of their source and import settings
+    AssetCache                      asset_cache;
+    // Source assets, loose files are only read if they are not packed
+    AssetArchive                    archive;
+
+    // All static meshes share the pool buffer, geom[] only holds views into it.
+    GeometryPool *                  geom_pool;
     MeshGeometry                    geom[_COUNT_GEOM];
 
+    // World-space bounds of render items (slot = obj_cbuffer_index) and per-frame visibility
+    CullingSet *                    culling;
+    // Hierarchy over the same world-space bounds (refit as items move), used for picking
+    Bvh *                           bvh;
+
+    // Result of the last pick (ALL_RENDERITEMS index or -1)
+    int                             picked_ritem;
+    float                           picked_dist;
+
     // Synchronization stuff
     UINT                            frame_index;
     HANDLE                          fence_event;
@@ -189,23 +312,25 @@ struct D3DRenderContext {
 
     Material                        materials[_COUNT_MATERIAL];
     Texture                         textures[_COUNT_TEX];
+
+    // Textures read and decoded in the background, their materials show the white placeholder until uploaded
+    AssetStreamer *                 streamer;
+    StreamedTexture                 streamed_textures[_COUNT_TEX - 1];
+    StreamedMesh                    streamed_skull;
+    // Signaled (monotonically) after every frame, tells when the upload heaps of a frame can go
+    ID3D12Fence *                   streaming_fence;
+    UINT64                          streaming_fence_value;
 };
-static void
-load_texture (
+// Upload buffer big enough for a range of subresources of the texture
+static HRESULT
+create_texture_upload_heap (
     ID3D12Device * device,
-    ID3D12GraphicsCommandList * cmd_list,
-    wchar_t const * tex_path,
-    Texture * out_texture
+    ID3D12Resource * texture,
+    UINT first_subresource,
+    UINT n_subresources,
+    ID3D12Resource ** out_upload_heap
 ) {
-
-    uint8_t * ddsData;
-    D3D12_SUBRESOURCE_DATA * subresources;
-    UINT n_subresources = 0;
-
-    LoadDDSTextureFromFile(device, tex_path, &out_texture->resource, &ddsData, &subresources, &n_subresources);
-
-    UINT64 upload_buffer_size = get_required_intermediate_size(out_texture->resource, 0,
-                                                               n_subresources);
+    UINT64 upload_buffer_size = get_required_intermediate_size(texture, first_subresource, n_subresources);
 
    // Create the GPU upload buffer.
     D3D12_HEAP_PROPERTIES heap_props = {};
@@ -228,32 +353,162 @@ load_texture (
     desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
     desc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
-    device->CreateCommittedResource(
+    return device->CreateCommittedResource(
         &heap_props,
         D3D12_HEAP_FLAG_NONE,
         &desc,
         D3D12_RESOURCE_STATE_GENERIC_READ,
         nullptr,
-        IID_PPV_ARGS(&out_texture->upload_heap)
+        IID_PPV_ARGS(out_upload_heap)
     );
-
+}
+// Records the copy from the upload heap and the transition (of all subresources) to a shader resource
+static void
+record_texture_upload (
+    ID3D12GraphicsCommandList * cmd_list,
+    Texture * texture,
+    UINT first_subresource,
+    UINT n_subresources,
+    D3D12_SUBRESOURCE_DATA * subresources
+) {
     D3D12_RESOURCE_BARRIER barrier = {};
     barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
     barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-    barrier.Transition.pResource = out_texture->resource;
+    barrier.Transition.pResource = texture->resource;
     barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
     barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
     barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
 
-    // Use Heap-allocating UpdateSubresources implementation for variable number of subresources (which is the case for textures).
-    update_subresources_heap(
-        cmd_list, out_texture->resource, out_texture->upload_heap,
-        0, 0, n_subresources, subresources
+    // Variable number of subresources (which is the case for textures), footprints on the stack.
+    update_subresources(
+        cmd_list, texture->resource, texture->upload_heap,
+        0, first_subresource, n_subresources, subresources
     );
     cmd_list->ResourceBarrier(1, &barrier);
+}
+// Extracts a packed asset into a malloc'd buffer
+static bool
+read_archived_asset (AssetArchive const * archive, int entry, BYTE ** out_data, size_t * out_size) {
+    size_t size = (size_t)archive->entries[entry].size;
+    BYTE * data = (BYTE *)::malloc(size);
+    if (nullptr == data || !AssetArchive_Extract(archive, entry, data, size)) {
+        ::free(data);
+        return false;
+    }
+    *out_data = data;
+    *out_size = size;
+    return true;
+}
+// Everything the demo reads at startup, in the order it's needed.
+// Streamed textures are stored as is, so their mips can be read straight from the mapping.
+static AssetArchiveSource const archive_sources [] = {
+    {"../Textures/white1x1.dds", true},
+    {"../Textures/checkboard.dds", false},
+    {"../Textures/bricks3.dds", false},
+    {"../Textures/ice.dds", false},
+    {"./models/skull.txt", true},
+    {"./models/car.txt", true},
+};
+static void
+open_asset_archive (AssetArchive * archive) {
+    // -- pack the sources if there is no archive yet, it was built from another source list or a source changed
+    if (AssetArchive_Open(ASSET_ARCHIVE_PATH, archive) && AssetArchive_IsUpToDate(archive, archive_sources, _countof(archive_sources)))
+        return;
+    AssetArchive_Close(archive);
+    if (!AssetArchive_Build(ASSET_ARCHIVE_PATH, archive_sources, _countof(archive_sources)) ||
+        !AssetArchive_Open(ASSET_ARCHIVE_PATH, archive))
+        printf("could not pack %s, loose files are used\n", ASSET_ARCHIVE_PATH);
+}
+// Everything that changes the generated mips, hashed into the cache key (no padding)
+struct TextureBakeParams {
+    uint32_t    mipgen_version;
+    uint32_t    filter;
+    uint32_t    wrap;
+    uint32_t    srgb;
+    uint32_t    bc_quality;
+};
+// Source DDS without mips -> cached DDS with its mip chain (the cache is safe to share between threads, temp files are per thread)
+// Returns false if the bake failed, out_path receives the cache entry otherwise
+static bool
+bake_texture_mips (AssetCache * cache, BYTE const * dds_data, size_t dds_size, UINT n_threads, char * out_path, size_t out_size) {
+    // -- tiling textures, so the filter wraps around the edges
+    MipGenSettings settings = {};
+    settings.filter = MIPGEN_FILTER_KAISER;
+    settings.wrap = true;
+    settings.srgb = false;
+    settings.n_threads = n_threads;
+    settings.bc_quality = BC_QUALITY_CLUSTER_FIT;  // baked once, worth the slower encode
+    TextureBakeParams params = {};
+    params.mipgen_version = MIPGEN_VERSION;
+    params.filter = settings.filter;
+    params.wrap = settings.wrap;
+    params.srgb = settings.srgb;
+    params.bc_quality = settings.bc_quality;
+    uint64_t key = AssetCache_MakeKey(dds_data, dds_size, &params, sizeof(params));
+
+    AssetCache_GetPath(cache, key, out_path, out_size);
+    if (AssetCache_Lookup(cache, key))
+        return true;
+    char tmp_path[ASSET_CACHE_MAX_PATH];
+    AssetCache_GetTempPath(cache, key, tmp_path, sizeof(tmp_path));
+    return
+        MipGen_BakeDDS(tmp_path, dds_data, dds_size, settings) &&
+        AssetCache_Commit(cache, key, tmp_path);
+}
+static void
+load_texture (
+    ID3D12Device * device,
+    ID3D12GraphicsCommandList * cmd_list,
+    AssetArchive const * archive,
+    AssetCache * cache,
+    wchar_t const * tex_path,
+    Texture * out_texture
+) {
+    // -- source bytes, from the archive if it's packed (the cache key is made from them)
+    BYTE * src = nullptr;
+    size_t src_size = 0;
+    int entry = AssetArchive_FindW(archive, tex_path);
+    bool read =
+        entry >= 0 ?
+        read_archived_asset(archive, entry, &src, &src_size) :
+        AssetStreamer_ReadFileRange(tex_path, 0, SIZE_MAX, &src, &src_size);
+    if (!read) {
+        printf("could not read %ls\n", tex_path);
+        return;
+    }
+
+    // -- a source without mips is loaded from its cached bake, like the streamed textures
+    BYTE const * dds_data = src;
+    size_t dds_size = src_size;
+    MappedFile baked = {};
+    if (MipGen_CanBake(src, src_size)) {
+        char baked_path[ASSET_CACHE_MAX_PATH];
+        if (bake_texture_mips(cache, src, src_size, 0, baked_path, sizeof(baked_path)) && MappedFile_Open(baked_path, &baked)) {
+            dds_data = baked.data;
+            dds_size = baked.size;
+        } else {
+            printf("could not generate mips for %ls, it's loaded without them\n", tex_path);
+        }
+    }
 
-    ::free(subresources);
-    ::free(ddsData);
+    D3D12_SUBRESOURCE_DATA subresources[DDS_MAX_SUBRESOURCES];
+    UINT n_subresources = 0;
+    DDS_HEADER const * header = nullptr;
+    uint8_t const * bit_data = nullptr;
+    size_t bit_size = 0;
+    if (SUCCEEDED(LoadTextureDataFromMemory(dds_data, dds_size, &header, &bit_data, &bit_size))) {
+        CreateTextureFromDDS(
+            device, header, bit_data, bit_size, 0, D3D12_RESOURCE_FLAG_NONE, DDS_LOADER_DEFAULT,
+            &out_texture->resource, subresources, &n_subresources, nullptr
+        );
+    }
+
+    // -- the texels are copied into the upload heap here, the source can go right after
+    create_texture_upload_heap(device, out_texture->resource, 0, n_subresources, &out_texture->upload_heap);
+    record_texture_upload(cmd_list, out_texture, 0, n_subresources, subresources);
+
+    MappedFile_Close(&baked);
+    ::free(src);
 }
 static void
 create_materials (Material out_materials []) {
@@ -320,96 +575,87 @@ create_shape_geometry (D3DRenderContext * render_ctx) {
     //  /   Floor      /
     // /--------------/
 
-    // required sizes
-    int nvtx = 20;
-    int nidx = 30;
-
-    Vertex *    vertices = (Vertex *)::malloc(sizeof(Vertex) * nvtx);
-    uint16_t *  indices = (uint16_t *)::malloc(sizeof(uint16_t) * nidx);
-    int i = 0;
-
-    // Floor: Observe we tile texture coordinates.
-    vertices[i++] = {.position = {-3.5f, 0.0f, -10.0f}, .normal = {0.0f, 1.0f, 0.0f}, .texc = {0.0f, 4.0f}}; // 0 
-    vertices[i++] = {.position = {-3.5f, 0.0f, 0.0f}, .normal = {0.0f, 1.0f, 0.0f }, .texc = { 0.0f, 0.0f}};
-    vertices[i++] = {.position = {7.5f, 0.0f, 0.0f}, .normal = {0.0f, 1.0f, 0.0f  }, .texc = { 4.0f, 0.0f}};
-    vertices[i++] = {.position = {7.5f, 0.0f, -10.0f}, .normal = {0.0f, 1.0f, 0.0f}, .texc = { 4.0f, 4.0f}};
-
-    // Wall: Observe we tile texture coordinates, and that we
-    // leave a gap in the middle for the mirror.
-    vertices[i++] = {.position = {-3.5f, 0.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.0f, 2.0f}}; // 4
-    vertices[i++] = {.position = {-3.5f, 4.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.0f, 0.0f}};
-    vertices[i++] = {.position = {-2.5f, 4.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.5f, 0.0f}};
-    vertices[i++] = {.position = {-2.5f, 0.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.5f, 2.0f}};
-
-    vertices[i++] = {.position = {2.5f, 0.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.0f, 2.0f}}; // 8 
-    vertices[i++] = {.position = {2.5f, 4.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.0f, 0.0f}};
-    vertices[i++] = {.position = {7.5f, 4.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 2.0f, 0.0f}};
-    vertices[i++] = {.position = {7.5f, 0.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 2.0f, 2.0f}};
-
-    vertices[i++] = {.position = {-3.5f, 4.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.0f, 1.0f}}; // 12
-    vertices[i++] = {.position = {-3.5f, 6.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.0f, 0.0f}};
-    vertices[i++] = {.position = {7.5f, 6.0f, 0.0f }, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 6.0f, 0.0f}};
-    vertices[i++] = {.position = {7.5f, 4.0f, 0.0f }, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 6.0f, 1.0f}};
-
-    // Mirror
-    vertices[i++] = {.position = {-2.5f, 0.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.0f, 1.0f}}; // 16
-    vertices[i++] = {.position = {-2.5f, 4.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.0f, 0.0f}};
-    vertices[i++] = {.position = {2.5f, 4.0f, 0.0f }, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 1.0f, 0.0f}};
-    vertices[i]   = {.position = {2.5f, 0.0f, 0.0f }, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 1.0f, 1.0f}};
-
-    i = 0;
-    // Floor
-    indices[i++] = 0; indices[i++] = 1; indices[i++] = 2;
-    indices[i++] = 0; indices[i++] = 2; indices[i++] = 3;
-
-    // Walls
-    indices[i++] = 4; indices[i++] = 5; indices[i++] = 6;
-    indices[i++] = 4; indices[i++] = 6; indices[i++] = 7;
-
-    indices[i++] = 8; indices[i++] = 9; indices[i++] = 10;
-    indices[i++] = 8; indices[i++] = 10; indices[i++] = 11;
-
-    indices[i++] = 12; indices[i++] = 13; indices[i++] = 14;
-    indices[i++] = 12; indices[i++] = 14; indices[i++] = 15;
-
-    // Mirror
-    indices[i++] = 16; indices[i++] = 17; indices[i++] = 18;
-    indices[i++] = 16; indices[i++] = 18; indices[i++] = 19;
+    // read-only table built at compile time, staged without any copy or repacking
+    static constexpr StaticGeometry<Vertex, 20, 30> room_geometry = {
+        .vertices = {
+            // Floor: Observe we tile texture coordinates.
+            // (u runs along +x on every room quad, so that is the tangent everywhere)
+            {.position = {-3.5f, 0.0f, -10.0f}, .normal = {0.0f, 1.0f, 0.0f}, .texc = {0.0f, 4.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}}, // 0
+            {.position = {-3.5f, 0.0f, 0.0f}, .normal = {0.0f, 1.0f, 0.0f }, .texc = { 0.0f, 0.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}},
+            {.position = {7.5f, 0.0f, 0.0f}, .normal = {0.0f, 1.0f, 0.0f  }, .texc = { 4.0f, 0.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}},
+            {.position = {7.5f, 0.0f, -10.0f}, .normal = {0.0f, 1.0f, 0.0f}, .texc = { 4.0f, 4.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}},
+
+            // Wall: Observe we tile texture coordinates, and that we
+            // leave a gap in the middle for the mirror.
+            {.position = {-3.5f, 0.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.0f, 2.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}}, // 4
+            {.position = {-3.5f, 4.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.0f, 0.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}},
+            {.position = {-2.5f, 4.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.5f, 0.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}},
+            {.position = {-2.5f, 0.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.5f, 2.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}},
+
+            {.position = {2.5f, 0.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.0f, 2.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}}, // 8
+            {.position = {2.5f, 4.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.0f, 0.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}},
+            {.position = {7.5f, 4.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 2.0f, 0.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}},
+            {.position = {7.5f, 0.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 2.0f, 2.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}},
+
+            {.position = {-3.5f, 4.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.0f, 1.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}}, // 12
+            {.position = {-3.5f, 6.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.0f, 0.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}},
+            {.position = {7.5f, 6.0f, 0.0f }, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 6.0f, 0.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}},
+            {.position = {7.5f, 4.0f, 0.0f }, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 6.0f, 1.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}},
+
+            // Mirror
+            {.position = {-2.5f, 0.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.0f, 1.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}}, // 16
+            {.position = {-2.5f, 4.0f, 0.0f}, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 0.0f, 0.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}},
+            {.position = {2.5f, 4.0f, 0.0f }, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 1.0f, 0.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}},
+            {.position = {2.5f, 0.0f, 0.0f }, .normal = { 0.0f, 0.0f, -1.0f}, .texc = { 1.0f, 1.0f}, .tangent_u = {1.0f, 0.0f, 0.0f}}
+        },
+        .indices = {
+            // Floor
+            0, 1, 2,
+            0, 2, 3,
+
+            // Walls
+            4, 5, 6,
+            4, 6, 7,
+
+            8, 9, 10,
+            8, 10, 11,
+
+            12, 13, 14,
+            12, 14, 15,
+
+            // Mirror
+            16, 17, 18,
+            16, 18, 19
+        }
+    };
+    UINT nvtx = ARRAY_COUNT(room_geometry.vertices);
+    UINT nidx = ARRAY_COUNT(room_geometry.indices);
+    Vertex const * vertices = room_geometry.vertices;
+    uint16_t const * indices = room_geometry.indices;
+
+    // -- Stage the room in the geometry pool (uploaded later with the rest of static meshes)
+    SubmeshGeometry room = GeometryPool_AddMesh(
+        render_ctx->geom_pool, vertices, nvtx, indices, nidx, DXGI_FORMAT_R16_UINT,
+        &render_ctx->geom[GEOM_ROOM].index_format
+    );
 
     SubmeshGeometry floor_submesh = {};
     floor_submesh.index_count = 6;
-    floor_submesh.start_index_location = 0;
-    floor_submesh.base_vertex_location = 0;
+    floor_submesh.start_index_location = room.start_index_location + 0;
+    floor_submesh.base_vertex_location = room.base_vertex_location;
+    floor_submesh.bounds = compute_vertex_bounds(&vertices[0], 4, sizeof(Vertex));
 
     SubmeshGeometry wall_submesh = {};
     wall_submesh.index_count = 18;
-    wall_submesh.start_index_location = 6;
-    wall_submesh.base_vertex_location = 0;
+    wall_submesh.start_index_location = room.start_index_location + 6;
+    wall_submesh.base_vertex_location = room.base_vertex_location;
+    wall_submesh.bounds = compute_vertex_bounds(&vertices[4], 12, sizeof(Vertex));
 
     SubmeshGeometry mirror_submesh = {};
     mirror_submesh.index_count = 6;
-    mirror_submesh.start_index_location = 24;
-    mirror_submesh.base_vertex_location = 0;
-
-    UINT vb_byte_size = nvtx * sizeof(Vertex);
-    UINT ib_byte_size = nidx * sizeof(uint16_t);
-
-    // -- Fill out geom
-    D3DCreateBlob(vb_byte_size, &render_ctx->geom[GEOM_ROOM].vb_cpu);
-    if (vertices)
-        CopyMemory(render_ctx->geom[GEOM_ROOM].vb_cpu->GetBufferPointer(), vertices, vb_byte_size);
-
-    D3DCreateBlob(ib_byte_size, &render_ctx->geom[GEOM_ROOM].ib_cpu);
-    if (indices)
-        CopyMemory(render_ctx->geom[GEOM_ROOM].ib_cpu->GetBufferPointer(), indices, ib_byte_size);
-
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size, &render_ctx->geom[GEOM_ROOM].vb_uploader, &render_ctx->geom[GEOM_ROOM].vb_gpu);
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size, &render_ctx->geom[GEOM_ROOM].ib_uploader, &render_ctx->geom[GEOM_ROOM].ib_gpu);
-
-    render_ctx->geom[GEOM_ROOM].vb_byte_stide = sizeof(Vertex);
-    render_ctx->geom[GEOM_ROOM].vb_byte_size = vb_byte_size;
-    render_ctx->geom[GEOM_ROOM].ib_byte_size = ib_byte_size;
-    render_ctx->geom[GEOM_ROOM].index_format = DXGI_FORMAT_R16_UINT;
+    mirror_submesh.start_index_location = room.start_index_location + 24;
+    mirror_submesh.base_vertex_location = room.base_vertex_location;
+    mirror_submesh.bounds = compute_vertex_bounds(&vertices[16], 4, sizeof(Vertex));
 
     render_ctx->geom[GEOM_ROOM].submesh_names[ROOM_SUBMESH_FLOOR] = "floor";
     render_ctx->geom[GEOM_ROOM].submesh_geoms[ROOM_SUBMESH_FLOOR] = floor_submesh;
@@ -419,137 +665,219 @@ create_shape_geometry (D3DRenderContext * render_ctx) {
 
     render_ctx->geom[GEOM_ROOM].submesh_names[ROOM_SUBMESH_MIRROR] = "mirror";
     render_ctx->geom[GEOM_ROOM].submesh_geoms[ROOM_SUBMESH_MIRROR] = mirror_submesh;
-
-    // -- cleanup
-    free(indices);
-    free(vertices);
 }
 static void
-create_skull_geometry (D3DRenderContext * render_ctx) {
-
-#pragma region Read_Data_File
-    FILE * f = nullptr;
-    errno_t err = fopen_s(&f, "./models/skull.txt", "r");
-    if (0 == f || err != 0) {
-        printf("could not open file\n");
-        return;
-    }
-    char linebuf[100];
-    int cnt = 0;
-    unsigned vcount = 0;
-    unsigned tcount = 0;
-    // -- read 1st line
-    if (fgets(linebuf, sizeof(linebuf), f))
-        cnt = sscanf_s(linebuf, "%*s %d", &vcount);
-    if (cnt != 1) {
-        printf("read error\n");
-        printf("read line: %s\n", linebuf);
-        return;
-    }
-    // -- read 2nd line
-    if (fgets(linebuf, sizeof(linebuf), f))
-        cnt = sscanf_s(linebuf, "%*s %d", &tcount);
-    if (cnt != 1) {
-        printf("read error\n");
-        printf("read line: %s\n", linebuf);
-        return;
+create_ball_geometry (D3DRenderContext * render_ctx) {
+    UINT nvtx = GeoSphere_VertexCount(BALL_GEOSPHERE_LEVEL);
+    UINT nidx = GeoSphere_IndexCount(BALL_GEOSPHERE_LEVEL);
+    GeomVertex * geom_vertices = (GeomVertex *)::malloc(sizeof(GeomVertex) * nvtx);
+    Vertex * vertices = (Vertex *)::malloc(sizeof(Vertex) * nvtx);
+    uint32_t * indices = (uint32_t *)::malloc(sizeof(uint32_t) * nidx);
+    create_geosphere(BALL_RADIUS, BALL_GEOSPHERE_LEVEL, geom_vertices, indices);
+    for (UINT i = 0; i < nvtx; ++i) {
+        vertices[i].position = geom_vertices[i].Position;
+        vertices[i].normal = geom_vertices[i].Normal;
+        vertices[i].texc = geom_vertices[i].TexC;
+        vertices[i].tangent_u = geom_vertices[i].TangentU;
     }
-    // -- skip two lines
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-    // -- read vertices
-    Vertex * vertices = (Vertex *)calloc(vcount, sizeof(Vertex));
-    for (unsigned i = 0; i < vcount; i++) {
-        fgets(linebuf, sizeof(linebuf), f);
-        cnt = sscanf_s(
-            linebuf, "%f %f %f %f %f %f",
-            &vertices[i].position.x, &vertices[i].position.y, &vertices[i].position.z,
-            &vertices[i].normal.x, &vertices[i].normal.y, &vertices[i].normal.z
-        );
-        if (cnt != 6) {
-            printf("read error\n");
-            printf("read line: %s\n", linebuf);
-            return;
-        }
-
-#pragma region skull texture coordinates calculations
-        XMVECTOR P = XMLoadFloat3(&vertices[i].position);
 
-        // Project point onto unit sphere and generate spherical texture coordinates.
-        XMFLOAT3 shpere_pos;
-        XMStoreFloat3(&shpere_pos, XMVector3Normalize(P));
-
-        float theta = atan2f(shpere_pos.z, shpere_pos.x);
-
-        // Put in [0, 2pi].
-        if (theta < 0.0f)
-            theta += XM_2PI;
-
-        float phi = acosf(shpere_pos.y);
+    // -- Stage the ball in the geometry pool (narrowed to 16-bit indices)
+    SubmeshGeometry submesh = GeometryPool_AddMesh(
+        render_ctx->geom_pool, vertices, nvtx, indices, nidx, DXGI_FORMAT_R32_UINT,
+        &render_ctx->geom[GEOM_BALL].index_format
+    );
+    submesh.bounds = compute_vertex_bounds(vertices, nvtx, sizeof(Vertex));
 
-        float u = theta / (2.0f * XM_PI);
-        float v = phi / XM_PI;
+    render_ctx->geom[GEOM_BALL].submesh_names[0] = "ball";
+    render_ctx->geom[GEOM_BALL].submesh_geoms[0] = submesh;
 
-        vertices[i].texc = {u, v};
-#pragma endregion
+    ::free(geom_vertices);
+    ::free(vertices);
+    ::free(indices);
+}
+// -- everything that changes the output of bake_text_model (hashed into the asset cache key, no padding)
+struct MeshBakeParams {
+    uint32_t    baked_version;
+    uint32_t    vertex_stride;
+    float       weld_position_tolerance;
+    float       weld_attribute_tolerance;
+    uint32_t    weld_drop_degenerates;
+};
+// -- text model -> baked mesh: parse, spherical texcoords, weld, tangents
+// -- (bump BAKED_MESH_VERSION when these steps change so that cached entries get rebaked)
+// -- (src is the text the cache key was made from, so the baked entry always matches its key)
+static bool
+bake_text_model (BYTE const * src, size_t src_size, char const * dst_path, MeshWeldSettings const & weld_settings) {
 
+#pragma region Read_Data_File
+    TextModel model = {};
+    if (!TextModel_OpenMemory(reinterpret_cast<char const *>(src), src_size, &model)) {
+        printf("malformed model\n");
+        return false;
     }
-    // -- skip three lines
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-    fgets(linebuf, sizeof(linebuf), f);
-    // -- read indices
+    unsigned vcount = model.nvtx;
+    unsigned tcount = model.ntri;
+    Vertex * vertices = (Vertex *)calloc(vcount, sizeof(Vertex));
     uint32_t * indices = (uint32_t *)calloc(tcount * 3, sizeof(uint32_t));
-    for (unsigned i = 0; i < tcount; i++) {
-        fgets(linebuf, sizeof(linebuf), f);
-        cnt = sscanf_s(
-            linebuf, "%d %d %d",
-            &indices[i * 3 + 0], &indices[i * 3 + 1], &indices[i * 3 + 2]
-        );
-        if (cnt != 3) {
-            printf("read error\n");
-            printf("read line: %s\n", linebuf);
-            return;
-        }
+
+    // -- parse positions, normals and indices in place
+    TextModelOutput model_output = {};
+    model_output.vertices = vertices;
+    model_output.stride = sizeof(Vertex);
+    model_output.position_offset = offsetof(Vertex, position);
+    model_output.normal_offset = offsetof(Vertex, normal);
+    model_output.indices = indices;
+    bool parsed = TextModel_Parse(&model, TextModel_ThreadCount(model.size, 0), model_output);
+    TextModel_Close(&model);
+    if (!parsed) {
+        printf("read error\n");
+        free(vertices);
+        free(indices);
+        return false;
     }
 
-    // -- remember to free heap-allocated memory
-    /*
-    free(vertices);
-    free(indices);
-    */
-    fclose(f);
+    // -- spherical texcoords around the model origin
+    TexcoordMeshDesc texc_mesh = {};
+    texc_mesh.vertices = vertices;
+    texc_mesh.nvtx = vcount;
+    texc_mesh.stride = sizeof(Vertex);
+    texc_mesh.position_offset = offsetof(Vertex, position);
+    texc_mesh.normal_offset = offsetof(Vertex, normal);
+    texc_mesh.texc_offset = offsetof(Vertex, texc);
+    TexcoordProjection projection = {};
+    projection.type = TEXCOORD_PROJECTION_SPHERICAL;
+    projection.scale = 1.0f;
+    Texcoords_Generate(texc_mesh, projection, Texcoords_ThreadCount(vcount, 0));
 #pragma endregion   Read_Data_File
 
-    UINT vb_byte_size = vcount * sizeof(Vertex);
-    UINT ib_byte_size = (tcount * 3) * sizeof(uint32_t);
-
-    // -- Fill out render_ctx geom[1] (skull)
-    D3DCreateBlob(vb_byte_size, &render_ctx->geom[1].vb_cpu);
-    CopyMemory(render_ctx->geom[1].vb_cpu->GetBufferPointer(), vertices, vb_byte_size);
-
-    D3DCreateBlob(ib_byte_size, &render_ctx->geom[1].ib_cpu);
-    CopyMemory(render_ctx->geom[1].ib_cpu->GetBufferPointer(), indices, ib_byte_size);
-
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, vertices, vb_byte_size, &render_ctx->geom[1].vb_uploader, &render_ctx->geom[1].vb_gpu);
-    create_default_buffer(render_ctx->device, render_ctx->direct_cmd_list, indices, ib_byte_size, &render_ctx->geom[1].ib_uploader, &render_ctx->geom[1].ib_gpu);
-
-    render_ctx->geom[GEOM_SKULL].vb_byte_stide = sizeof(Vertex);
-    render_ctx->geom[GEOM_SKULL].vb_byte_size = vb_byte_size;
-    render_ctx->geom[GEOM_SKULL].ib_byte_size = ib_byte_size;
-    render_ctx->geom[GEOM_SKULL].index_format = DXGI_FORMAT_R32_UINT;
-
-    SubmeshGeometry submesh = {};
-    submesh.index_count = tcount * 3;
-    submesh.start_index_location = 0;
-    submesh.base_vertex_location = 0;
+    // -- merge duplicated vertices
+    BYTE * weld_memory = (BYTE *)::malloc(MeshWeld_CalculateRequiredSize(vcount, sizeof(Vertex)));
+    UINT icount = 0;
+    vcount = MeshWeld_Weld(weld_memory, vertices, vcount, sizeof(Vertex), indices, tcount * 3, weld_settings, &icount);
+    ::free(weld_memory);
+
+    // -- tangent frames of the welded mesh (tangents are still zero while welding, so they don't split anything)
+    // -- the slot is the GeomVertex TangentU, the handedness sign is dropped (bitangent = cross(normal, tangent))
+    TangentMeshDesc tangent_mesh = {};
+    tangent_mesh.vertices = vertices;
+    tangent_mesh.nvtx = vcount;
+    tangent_mesh.stride = sizeof(Vertex);
+    tangent_mesh.position_offset = offsetof(Vertex, position);
+    tangent_mesh.normal_offset = offsetof(Vertex, normal);
+    tangent_mesh.texc_offset = offsetof(Vertex, texc);
+    tangent_mesh.indices = indices;
+    tangent_mesh.nidx = icount;
+    UINT tangent_threads = Tangents_ThreadCount(icount / 3, 0);
+    BYTE * tangent_memory = (BYTE *)::malloc(Tangents_CalculateRequiredSize(vcount, tangent_threads));
+    XMFLOAT4 * tangents = (XMFLOAT4 *)::malloc(sizeof(XMFLOAT4) * vcount);
+    Tangents_Generate(tangent_memory, tangent_mesh, tangent_threads, tangents);
+    for (UINT i = 0; i < vcount; ++i)
+        vertices[i].tangent_u = XMFLOAT3(tangents[i].x, tangents[i].y, tangents[i].z);
+    ::free(tangents);
+    ::free(tangent_memory);
+
+    // -- narrow indices in place when the welded mesh allows it
+    UINT index_size = sizeof(uint32_t);
+    if (vcount <= 0xffff) {
+        uint16_t * indices16 = reinterpret_cast<uint16_t *>(indices);
+        for (UINT i = 0; i < icount; ++i)
+            indices16[i] = (uint16_t)indices[i];
+        index_size = sizeof(uint16_t);
+    }
 
-    render_ctx->geom[GEOM_SKULL].submesh_names[0] = "skull";
-    render_ctx->geom[GEOM_SKULL].submesh_geoms[0] = submesh;
+    BakedSubmesh submesh = {};
+    submesh.index_count = icount;
+    DirectX::BoundingBox bounds = compute_vertex_bounds(vertices, vcount, sizeof(Vertex));
+    memcpy(submesh.center, &bounds.Center, sizeof(submesh.center));
+    memcpy(submesh.extents, &bounds.Extents, sizeof(submesh.extents));
+
+    BakedMeshDesc desc = {};
+    desc.vertices = vertices;
+    desc.vertex_count = vcount;
+    desc.vertex_stride = sizeof(Vertex);
+    desc.indices = indices;
+    desc.index_count = icount;
+    desc.index_size = index_size;
+    desc.submeshes = &submesh;
+    desc.submesh_count = 1;
+    bool ret = BakedMesh_Write(dst_path, desc);
 
     // -- cleanup
     free(vertices);
     free(indices);
+    return ret;
+}
+// -- text model (skull.txt layout) -> cached baked mesh, baked first on a miss
+// -- (safe on a worker thread: the cache is shared, temp files are per thread)
+static bool
+open_text_model (AssetCache * cache, BYTE const * src, size_t src_size, BakedMesh * out_mesh) {
+
+    // -- merge duplicated vertices (split normals are kept, they are hard edges)
+    MeshWeldSettings weld_settings = {};
+    weld_settings.position_tolerance = 1e-5f;
+    weld_settings.attribute_tolerance = 1e-3f;
+    weld_settings.drop_degenerates = true;
+
+    MeshBakeParams params = {};
+    params.baked_version = BAKED_MESH_VERSION;
+    params.vertex_stride = sizeof(Vertex);
+    params.weld_position_tolerance = weld_settings.position_tolerance;
+    params.weld_attribute_tolerance = weld_settings.attribute_tolerance;
+    params.weld_drop_degenerates = weld_settings.drop_degenerates;
+    uint64_t key = AssetCache_MakeKey(src, src_size, &params, sizeof(params));
+
+    // -- warm start: the cached baked mesh is used as is, otherwise bake it into the cache
+    char baked_path[ASSET_CACHE_MAX_PATH];
+    AssetCache_GetPath(cache, key, baked_path, sizeof(baked_path));
+    if (AssetCache_Lookup(cache, key) && BakedMesh_Open(baked_path, sizeof(Vertex), out_mesh))
+        return true;
+    char tmp_path[ASSET_CACHE_MAX_PATH];
+    AssetCache_GetTempPath(cache, key, tmp_path, sizeof(tmp_path));
+    return
+        bake_text_model(src, src_size, tmp_path, weld_settings) &&
+        AssetCache_Commit(cache, key, tmp_path) &&
+        BakedMesh_Open(baked_path, sizeof(Vertex), out_mesh);
+}
+// -- text model -> geometry pool, before the pool is uploaded
+static void
+create_text_model_geometry (D3DRenderContext * render_ctx, char const * src_path, MeshGeometry * geom, char const * name) {
+    // -- the key needs the source bytes (packed ones are read from the archive), a bake parses the same bytes
+    int entry = AssetArchive_Find(&render_ctx->archive, src_path);
+    BYTE * packed_src = nullptr;
+    size_t packed_size = 0;
+    MappedFile src_file = {};
+    BYTE const * src = nullptr;
+    size_t src_size = 0;
+    if (entry >= 0 && read_archived_asset(&render_ctx->archive, entry, &packed_src, &packed_size)) {
+        src = packed_src;
+        src_size = packed_size;
+    } else if (MappedFile_Open(src_path, &src_file)) {
+        src = src_file.data;
+        src_size = src_file.size;
+    } else {
+        printf("could not open %s\n", src_path);
+        return;
+    }
+    BakedMesh mesh = {};
+    bool loaded = open_text_model(&render_ctx->asset_cache, src, src_size, &mesh);
+    ::free(packed_src);
+    MappedFile_Close(&src_file);
+    if (!loaded) {
+        printf("could not load %s\n", src_path);
+        return;
+    }
+
+    // -- Stage the mesh in the geometry pool straight from the mapping
+    SubmeshGeometry submesh = GeometryPool_AddMesh(
+        render_ctx->geom_pool, mesh.vertices, mesh.header->vertex_count,
+        mesh.indices, mesh.header->index_count,
+        sizeof(uint16_t) == mesh.header->index_size ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT,
+        &geom->index_format
+    );
+    BakedMesh_Close(&mesh);
+
+    geom->submesh_names[0] = name;
+    geom->submesh_geoms[0] = submesh;
 }
 static void
 create_render_items (
@@ -561,7 +889,7 @@ create_render_items (
     RenderItemArray * reflected_ritems,
     RenderItemArray * shadows_ritems,
     RenderItemArray * reflected_shadow_ritems,
-    MeshGeometry * room_geom, MeshGeometry * skull_geom,
+    MeshGeometry * room_geom, MeshGeometry * skull_geom, MeshGeometry * ball_geom, MeshGeometry * car_geom,
     Material materials []
 ) {
     // floor
@@ -574,6 +902,7 @@ create_render_items (
     all_ritems->ritems[RITEM_FLOOR].index_count = room_geom->submesh_geoms[ROOM_SUBMESH_FLOOR].index_count;
     all_ritems->ritems[RITEM_FLOOR].start_index_loc = room_geom->submesh_geoms[ROOM_SUBMESH_FLOOR].start_index_location;
     all_ritems->ritems[RITEM_FLOOR].base_vertex_loc = room_geom->submesh_geoms[ROOM_SUBMESH_FLOOR].base_vertex_location;
+    all_ritems->ritems[RITEM_FLOOR].bounds = room_geom->submesh_geoms[ROOM_SUBMESH_FLOOR].bounds;
     all_ritems->ritems[RITEM_FLOOR].n_frames_dirty = NUM_QUEUING_FRAMES;
     all_ritems->ritems[RITEM_FLOOR].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
     all_ritems->ritems[RITEM_FLOOR].initialized = true;
@@ -591,6 +920,7 @@ create_render_items (
     all_ritems->ritems[RITEM_WALL].index_count = room_geom->submesh_geoms[ROOM_SUBMESH_WALL].index_count;
     all_ritems->ritems[RITEM_WALL].start_index_loc = room_geom->submesh_geoms[ROOM_SUBMESH_WALL].start_index_location;
     all_ritems->ritems[RITEM_WALL].base_vertex_loc = room_geom->submesh_geoms[ROOM_SUBMESH_WALL].base_vertex_location;
+    all_ritems->ritems[RITEM_WALL].bounds = room_geom->submesh_geoms[ROOM_SUBMESH_WALL].bounds;
     all_ritems->ritems[RITEM_WALL].n_frames_dirty = NUM_QUEUING_FRAMES;
     all_ritems->ritems[RITEM_WALL].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
     all_ritems->ritems[RITEM_WALL].initialized = true;
@@ -608,9 +938,11 @@ create_render_items (
     all_ritems->ritems[RITEM_SKULL].index_count = skull_geom->submesh_geoms[0].index_count;
     all_ritems->ritems[RITEM_SKULL].start_index_loc = skull_geom->submesh_geoms[0].start_index_location;
     all_ritems->ritems[RITEM_SKULL].base_vertex_loc = skull_geom->submesh_geoms[0].base_vertex_location;
+    all_ritems->ritems[RITEM_SKULL].bounds = skull_geom->submesh_geoms[0].bounds;
     all_ritems->ritems[RITEM_SKULL].n_frames_dirty = NUM_QUEUING_FRAMES;
     all_ritems->ritems[RITEM_SKULL].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
-    all_ritems->ritems[RITEM_SKULL].initialized = true;
+    // streamed: the skull (and its reflection and shadows, copied from it) show up once the mesh is uploaded
+    all_ritems->ritems[RITEM_SKULL].initialized = skull_geom->submesh_geoms[0].index_count > 0;
     all_ritems->size++;
     opaque_ritems->ritems[2] = all_ritems->ritems[RITEM_SKULL];
     opaque_ritems->size++;
@@ -635,6 +967,63 @@ create_render_items (
     reflected_ritems->ritems[1] = all_ritems->ritems[RITEM_REFLECTED_FLOOR];
     reflected_ritems->size++;
 
+    // ball resting on the floor in front of the right wall
+    all_ritems->ritems[RITEM_BALL].world = Identity4x4();
+    XMStoreFloat4x4(&all_ritems->ritems[RITEM_BALL].world, XMMatrixTranslation(4.5f, BALL_RADIUS, -2.5f));
+    all_ritems->ritems[RITEM_BALL].tex_transform = Identity4x4();
+    all_ritems->ritems[RITEM_BALL].obj_cbuffer_index = 8;
+    all_ritems->ritems[RITEM_BALL].mat = &materials[MAT_CHECKER_TILE];
+    all_ritems->ritems[RITEM_BALL].geometry = ball_geom;
+    all_ritems->ritems[RITEM_BALL].primitive_type = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    all_ritems->ritems[RITEM_BALL].index_count = ball_geom->submesh_geoms[0].index_count;
+    all_ritems->ritems[RITEM_BALL].start_index_loc = ball_geom->submesh_geoms[0].start_index_location;
+    all_ritems->ritems[RITEM_BALL].base_vertex_loc = ball_geom->submesh_geoms[0].base_vertex_location;
+    all_ritems->ritems[RITEM_BALL].bounds = ball_geom->submesh_geoms[0].bounds;
+    all_ritems->ritems[RITEM_BALL].n_frames_dirty = NUM_QUEUING_FRAMES;
+    all_ritems->ritems[RITEM_BALL].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
+    all_ritems->ritems[RITEM_BALL].initialized = true;
+    all_ritems->size++;
+    opaque_ritems->ritems[3] = all_ritems->ritems[RITEM_BALL];
+    opaque_ritems->size++;
+
+    // reflected ball
+    all_ritems->ritems[RITEM_REFLECTED_BALL] = all_ritems->ritems[RITEM_BALL];
+    all_ritems->ritems[RITEM_REFLECTED_BALL].obj_cbuffer_index = 9;
+    all_ritems->size++;
+    XMMATRIX ball_world = XMLoadFloat4x4(&all_ritems->ritems[RITEM_REFLECTED_BALL].world);
+    XMStoreFloat4x4(&all_ritems->ritems[RITEM_REFLECTED_BALL].world, ball_world * R);
+    reflected_ritems->ritems[2] = all_ritems->ritems[RITEM_REFLECTED_BALL];
+    reflected_ritems->size++;
+
+    // car turned sideways, wheels on the floor (lowest point from the baked bounds)
+    DirectX::BoundingBox const & car_bounds = car_geom->submesh_geoms[0].bounds;
+    float car_lift = -(car_bounds.Center.y - car_bounds.Extents.y) * CAR_SCALE;
+    XMMATRIX car_world = XMMatrixRotationY(0.5f * XM_PI) * XMMatrixScaling(CAR_SCALE, CAR_SCALE, CAR_SCALE) * XMMatrixTranslation(4.0f, car_lift, -7.5f);
+    XMStoreFloat4x4(&all_ritems->ritems[RITEM_CAR].world, car_world);
+    all_ritems->ritems[RITEM_CAR].tex_transform = Identity4x4();
+    all_ritems->ritems[RITEM_CAR].obj_cbuffer_index = 10;
+    all_ritems->ritems[RITEM_CAR].mat = &materials[MAT_SKULL];
+    all_ritems->ritems[RITEM_CAR].geometry = car_geom;
+    all_ritems->ritems[RITEM_CAR].primitive_type = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    all_ritems->ritems[RITEM_CAR].index_count = car_geom->submesh_geoms[0].index_count;
+    all_ritems->ritems[RITEM_CAR].start_index_loc = car_geom->submesh_geoms[0].start_index_location;
+    all_ritems->ritems[RITEM_CAR].base_vertex_loc = car_geom->submesh_geoms[0].base_vertex_location;
+    all_ritems->ritems[RITEM_CAR].bounds = car_bounds;
+    all_ritems->ritems[RITEM_CAR].n_frames_dirty = NUM_QUEUING_FRAMES;
+    all_ritems->ritems[RITEM_CAR].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
+    all_ritems->ritems[RITEM_CAR].initialized = true;
+    all_ritems->size++;
+    opaque_ritems->ritems[4] = all_ritems->ritems[RITEM_CAR];
+    opaque_ritems->size++;
+
+    // reflected car
+    all_ritems->ritems[RITEM_REFLECTED_CAR] = all_ritems->ritems[RITEM_CAR];
+    all_ritems->ritems[RITEM_REFLECTED_CAR].obj_cbuffer_index = 11;
+    all_ritems->size++;
+    XMStoreFloat4x4(&all_ritems->ritems[RITEM_REFLECTED_CAR].world, car_world * R);
+    reflected_ritems->ritems[3] = all_ritems->ritems[RITEM_REFLECTED_CAR];
+    reflected_ritems->size++;
+
     // shadowed skull will have different world matrix, so it needs to be its own render item.
     all_ritems->ritems[RITEM_SHADOWED_SKULL] = all_ritems->ritems[RITEM_SKULL];
     all_ritems->ritems[RITEM_SHADOWED_SKULL].obj_cbuffer_index = 5;
@@ -660,6 +1049,7 @@ create_render_items (
     all_ritems->ritems[RITEM_MIRROR].index_count = room_geom->submesh_geoms[ROOM_SUBMESH_MIRROR].index_count;
     all_ritems->ritems[RITEM_MIRROR].start_index_loc = room_geom->submesh_geoms[ROOM_SUBMESH_MIRROR].start_index_location;
     all_ritems->ritems[RITEM_MIRROR].base_vertex_loc = room_geom->submesh_geoms[ROOM_SUBMESH_MIRROR].base_vertex_location;
+    all_ritems->ritems[RITEM_MIRROR].bounds = room_geom->submesh_geoms[ROOM_SUBMESH_MIRROR].bounds;
     all_ritems->ritems[RITEM_MIRROR].n_frames_dirty = NUM_QUEUING_FRAMES;
     all_ritems->ritems[RITEM_MIRROR].mat->n_frames_dirty = NUM_QUEUING_FRAMES;
     all_ritems->ritems[RITEM_MIRROR].initialized = true;
@@ -677,93 +1067,85 @@ draw_render_items (
     UINT64 descriptor_increment_size,
     ID3D12DescriptorHeap * srv_heap,
     RenderItemArray * ritem_array,
+    CullingSet const * culling,
     UINT current_frame_index
 ) {
     UINT objcb_byte_size = (UINT64)sizeof(ObjectConstants);
     UINT matcb_byte_size = (UINT64)sizeof(MaterialConstants);
+
+    // -- compact the visible items before recording
+    RenderItem * visible_items[_COUNT_RENDERITEM];
+    UINT n_visible = 0;
     for (size_t i = 0; i < ritem_array->size; ++i) {
-        if (ritem_array->ritems[i].initialized) {
-            D3D12_VERTEX_BUFFER_VIEW vbv = Mesh_GetVertexBufferView(ritem_array->ritems[i].geometry);
-            D3D12_INDEX_BUFFER_VIEW ibv = Mesh_GetIndexBufferView(ritem_array->ritems[i].geometry);
+        RenderItem * ritem = &ritem_array->ritems[i];
+        if (ritem->initialized && culling->visible[ritem->obj_cbuffer_index])
+            visible_items[n_visible++] = ritem;
+    }
+
+    // -- static meshes share the geometry pool buffer, so only rebind IA state when it actually changes
+    D3D12_VERTEX_BUFFER_VIEW bound_vbv = {};
+    D3D12_INDEX_BUFFER_VIEW bound_ibv = {};
+    D3D12_PRIMITIVE_TOPOLOGY bound_topology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+    for (UINT i = 0; i < n_visible; ++i) {
+        RenderItem * ritem = visible_items[i];
+        D3D12_VERTEX_BUFFER_VIEW vbv = Mesh_GetVertexBufferView(ritem->geometry);
+        D3D12_INDEX_BUFFER_VIEW ibv = Mesh_GetIndexBufferView(ritem->geometry);
+        if (vbv.BufferLocation != bound_vbv.BufferLocation || vbv.SizeInBytes != bound_vbv.SizeInBytes || vbv.StrideInBytes != bound_vbv.StrideInBytes) {
             cmd_list->IASetVertexBuffers(0, 1, &vbv);
+            bound_vbv = vbv;
+        }
+        if (ibv.BufferLocation != bound_ibv.BufferLocation || ibv.SizeInBytes != bound_ibv.SizeInBytes || ibv.Format != bound_ibv.Format) {
             cmd_list->IASetIndexBuffer(&ibv);
-            cmd_list->IASetPrimitiveTopology(ritem_array->ritems[i].primitive_type);
+            bound_ibv = ibv;
+        }
+        if (ritem->primitive_type != bound_topology) {
+            cmd_list->IASetPrimitiveTopology(ritem->primitive_type);
+            bound_topology = ritem->primitive_type;
+        }
 
-            D3D12_GPU_DESCRIPTOR_HANDLE tex = srv_heap->GetGPUDescriptorHandleForHeapStart();
-            tex.ptr += descriptor_increment_size * ritem_array->ritems[i].mat->diffuse_srvheap_index;
+        D3D12_GPU_DESCRIPTOR_HANDLE tex = srv_heap->GetGPUDescriptorHandleForHeapStart();
+        tex.ptr += descriptor_increment_size * ritem->mat->diffuse_srvheap_index;
 
-            D3D12_GPU_VIRTUAL_ADDRESS objcb_address = object_cbuffer->GetGPUVirtualAddress();
-            objcb_address += (UINT64)ritem_array->ritems[i].obj_cbuffer_index * objcb_byte_size;
+        D3D12_GPU_VIRTUAL_ADDRESS objcb_address = object_cbuffer->GetGPUVirtualAddress();
+        objcb_address += (UINT64)ritem->obj_cbuffer_index * objcb_byte_size;
 
-            D3D12_GPU_VIRTUAL_ADDRESS matcb_address = mat_cbuffer->GetGPUVirtualAddress();
-            matcb_address += (UINT64)ritem_array->ritems[i].mat->mat_cbuffer_index * matcb_byte_size;
+        D3D12_GPU_VIRTUAL_ADDRESS matcb_address = mat_cbuffer->GetGPUVirtualAddress();
+        matcb_address += (UINT64)ritem->mat->mat_cbuffer_index * matcb_byte_size;
 
-            cmd_list->SetGraphicsRootDescriptorTable(0, tex);
-            cmd_list->SetGraphicsRootConstantBufferView(1, objcb_address);
-            cmd_list->SetGraphicsRootConstantBufferView(3, matcb_address);
-            cmd_list->DrawIndexedInstanced(ritem_array->ritems[i].index_count, 1, ritem_array->ritems[i].start_index_loc, ritem_array->ritems[i].base_vertex_loc, 0);
-        }
+        cmd_list->SetGraphicsRootDescriptorTable(0, tex);
+        cmd_list->SetGraphicsRootConstantBufferView(1, objcb_address);
+        cmd_list->SetGraphicsRootConstantBufferView(3, matcb_address);
+        cmd_list->DrawIndexedInstanced(ritem->index_count, 1, ritem->start_index_loc, ritem->base_vertex_loc, 0);
     }
 }
+// SRV of a texture, mips more detailed than min_lod are never sampled (they may not be loaded yet)
+static void
+create_texture_srv (D3DRenderContext * render_ctx, TEX_INDEX tex, UINT srv_index, float min_lod) {
+    ID3D12Resource * resource = render_ctx->textures[tex].resource;
+    D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
+    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srv_desc.Format = resource->GetDesc().Format;
+    srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    srv_desc.Texture2D.MostDetailedMip = 0;
+    srv_desc.Texture2D.MipLevels = resource->GetDesc().MipLevels;
+    srv_desc.Texture2D.ResourceMinLODClamp = min_lod;
+
+    D3D12_CPU_DESCRIPTOR_HANDLE descriptor_cpu_handle = render_ctx->srv_heap->GetCPUDescriptorHandleForHeapStart();
+    descriptor_cpu_handle.ptr += (SIZE_T)render_ctx->cbv_srv_uav_descriptor_size * srv_index;
+    render_ctx->device->CreateShaderResourceView(resource, &srv_desc, descriptor_cpu_handle);
+}
 static void
 create_descriptor_heaps (D3DRenderContext * render_ctx) {
 
     // Create Shader Resource View descriptor heap
     D3D12_DESCRIPTOR_HEAP_DESC srv_heap_desc = {};
-    srv_heap_desc.NumDescriptors = _COUNT_TEX + 1 /* imgui descriptor */;
+    srv_heap_desc.NumDescriptors = SRV_SECOND_VIEWS + _COUNT_TEX;
     srv_heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
     srv_heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
     render_ctx->device->CreateDescriptorHeap(&srv_heap_desc, IID_PPV_ARGS(&render_ctx->srv_heap));
 
-    // Fill out the heap with actual descriptors
-    D3D12_CPU_DESCRIPTOR_HANDLE descriptor_cpu_handle = render_ctx->srv_heap->GetCPUDescriptorHandleForHeapStart();
-    D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
-
-    // Brick texture
-    ID3D12Resource * brick_tex = render_ctx->textures[TEX_BRICK].resource;
-    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srv_desc.Format = brick_tex->GetDesc().Format;
-    srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srv_desc.Texture2D.MostDetailedMip = 0;
-    srv_desc.Texture2D.MipLevels = brick_tex->GetDesc().MipLevels;
-    srv_desc.Texture2D.ResourceMinLODClamp = 0.0f;
-    render_ctx->device->CreateShaderResourceView(brick_tex, &srv_desc, descriptor_cpu_handle);
-
-    // checkerboard texture
-    ID3D12Resource * checkerboard_tex = render_ctx->textures[TEX_CHECKERBOARD].resource;
-    memset(&srv_desc, 0, sizeof(srv_desc)); // reset desc
-    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srv_desc.Format = checkerboard_tex->GetDesc().Format;
-    srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srv_desc.Texture2D.MostDetailedMip = 0;
-    srv_desc.Texture2D.MipLevels = checkerboard_tex->GetDesc().MipLevels;
-    srv_desc.Texture2D.ResourceMinLODClamp = 0.0f;
-    descriptor_cpu_handle.ptr += render_ctx->cbv_srv_uav_descriptor_size;   // next descriptor
-    render_ctx->device->CreateShaderResourceView(checkerboard_tex, &srv_desc, descriptor_cpu_handle);
-
-    // Ice texture
-    ID3D12Resource * ice_tex = render_ctx->textures[TEX_ICE].resource;
-    memset(&srv_desc, 0, sizeof(srv_desc)); // reset desc
-    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srv_desc.Format = ice_tex->GetDesc().Format;
-    srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srv_desc.Texture2D.MostDetailedMip = 0;
-    srv_desc.Texture2D.MipLevels = ice_tex->GetDesc().MipLevels;
-    srv_desc.Texture2D.ResourceMinLODClamp = 0.0f;
-    descriptor_cpu_handle.ptr += render_ctx->cbv_srv_uav_descriptor_size;   // next descriptor
-    render_ctx->device->CreateShaderResourceView(ice_tex, &srv_desc, descriptor_cpu_handle);
-
-    // White texture
-    ID3D12Resource * white_tex = render_ctx->textures[TEX_WHITE1x1].resource;
-    memset(&srv_desc, 0, sizeof(srv_desc)); // reset desc
-    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srv_desc.Format = white_tex->GetDesc().Format;
-    srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srv_desc.Texture2D.MostDetailedMip = 0;
-    srv_desc.Texture2D.MipLevels = white_tex->GetDesc().MipLevels;
-    srv_desc.Texture2D.ResourceMinLODClamp = 0.0f;
-    descriptor_cpu_handle.ptr += render_ctx->cbv_srv_uav_descriptor_size;   // next descriptor
-    render_ctx->device->CreateShaderResourceView(white_tex, &srv_desc, descriptor_cpu_handle);
+    // Only the placeholder is ready now, streamed textures get their SRV once uploaded
+    create_texture_srv(render_ctx, TEX_WHITE1x1, TEX_WHITE1x1, 0.0f);
 
     // Create Render Target View Descriptor Heap
     D3D12_DESCRIPTOR_HEAP_DESC rtv_heap_desc = {};
@@ -935,7 +1317,7 @@ static void
 create_pso (D3DRenderContext * render_ctx, IDxcBlob * vertex_shader_code, IDxcBlob * pixel_shader_code_opaque, IDxcBlob * pixel_shader_code_alphatested) {
     // -- Create vertex-input-layout Elements
 
-    D3D12_INPUT_ELEMENT_DESC input_desc[3];
+    D3D12_INPUT_ELEMENT_DESC input_desc[4];
     input_desc[0] = {};
     input_desc[0].SemanticName = "POSITION";
     input_desc[0].SemanticIndex = 0;
@@ -960,6 +1342,14 @@ create_pso (D3DRenderContext * render_ctx, IDxcBlob * vertex_shader_code, IDxcBl
     input_desc[2].AlignedByteOffset = 24; // bc of the position and normal
     input_desc[2].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
 
+    input_desc[3] = {};
+    input_desc[3].SemanticName = "TANGENT";
+    input_desc[3].SemanticIndex = 0;
+    input_desc[3].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+    input_desc[3].InputSlot = 0;
+    input_desc[3].AlignedByteOffset = 32; // bc of the position, normal and texc
+    input_desc[3].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+
     //
     // -- Create PSO for Opaque objs
     //
@@ -1264,10 +1654,134 @@ update_obj_cbuffers (D3DRenderContext * render_ctx) {
             uint8_t * obj_ptr = render_ctx->frame_resources[frame_index].obj_cb_data_ptr + ((UINT64)obj_index * cbuffer_size);
             memcpy(obj_ptr, &obj_cbuffer, cbuffer_size);
 
+            // world has changed, so does the world-space box
+            CullingSet_SetItem(render_ctx->culling, obj_index, render_ctx->all_ritems.ritems[i].bounds, render_ctx->all_ritems.ritems[i].world);
+            Bvh_SetItem(render_ctx->bvh, obj_index, render_ctx->all_ritems.ritems[i].bounds, render_ctx->all_ritems.ritems[i].world);
+
             // Next FrameResource need to be updated too.
             render_ctx->all_ritems.ritems[i].n_frames_dirty--;
         }
     }
+    // moved items only grow/shrink their boxes, the tree topology is kept
+    Bvh_Refit(render_ctx->bvh);
+}
+static void
+cull_render_items (CullingSet * culling, SceneContext * scene_ctx) {
+    // -- world space view frustum
+    XMMATRIX view = XMLoadFloat4x4(&scene_ctx->view);
+    XMMATRIX proj = XMLoadFloat4x4(&scene_ctx->proj);
+    XMVECTOR view_det = XMMatrixDeterminant(view);
+    XMMATRIX inv_view = XMMatrixInverse(&view_det, view);
+
+    BoundingFrustum frustum;
+    BoundingFrustum::CreateFromMatrix(frustum, proj);
+    frustum.Transform(frustum, inv_view);
+
+    CullingSet_Cull(culling, frustum);
+}
+// Texture repeats across a render item: largest side of the uv box of its vertices, after tex_transform
+static float
+compute_uv_extent (RenderItem const * ritem, GeometryPool const * pool) {
+    // staged copies of the meshes are still in the pool memory
+    BYTE const * vertices = pool->vertices + (size_t)ritem->base_vertex_loc * pool->vtx_stride + offsetof(Vertex, texc);
+    bool indices16 = (DXGI_FORMAT_R16_UINT == ritem->geometry->index_format);
+    XMVECTOR uv_min = XMVectorReplicate(FLT_MAX);
+    XMVECTOR uv_max = XMVectorReplicate(-FLT_MAX);
+    for (UINT i = 0; i < ritem->index_count; ++i) {
+        UINT idx = indices16 ? pool->indices16[ritem->start_index_loc + i] : pool->indices32[ritem->start_index_loc + i];
+        XMVECTOR uv = XMLoadFloat2(reinterpret_cast<XMFLOAT2 const *>(vertices + (size_t)idx * pool->vtx_stride));
+        uv_min = XMVectorMin(uv_min, uv);
+        uv_max = XMVectorMax(uv_max, uv);
+    }
+    if (0 == ritem->index_count)
+        return 0.0f;
+    XMMATRIX tex_transform = XMLoadFloat4x4(&ritem->tex_transform);
+    XMVECTOR extent = XMVectorAbs(XMVector2TransformNormal(XMVectorSubtract(uv_max, uv_min), tex_transform));
+    return XMVectorGetX(extent) > XMVectorGetY(extent) ? XMVectorGetX(extent) : XMVectorGetY(extent);
+}
+struct PickContext {
+    RenderItem const *      ritems[_COUNT_RENDERITEM];     // by obj_cbuffer_index, nullptr if not pickable
+    GeometryPool const *    geom_pool;
+};
+// Narrow phase of picking: ray-triangle tests in the local space of the item
+static bool
+pick_triangles (void * user_data, UINT item, XMFLOAT3 const & origin, XMFLOAT3 const & dir, float * inout_t) {
+    PickContext const * pick = reinterpret_cast<PickContext const *>(user_data);
+    RenderItem const * ritem = pick->ritems[item];
+    if (nullptr == ritem)
+        return false;
+
+    XMMATRIX world = XMLoadFloat4x4(&ritem->world);
+    XMVECTOR world_det = XMMatrixDeterminant(world);
+    XMMATRIX inv_world = XMMatrixInverse(&world_det, world);
+    XMVECTOR local_origin = XMVector3TransformCoord(XMLoadFloat3(&origin), inv_world);
+    XMVECTOR local_dir = XMVector3TransformNormal(XMLoadFloat3(&dir), inv_world);
+
+    // local distances are scaled by the world matrix, convert them back to the ray parameter
+    float local_scale = XMVectorGetX(XMVector3Length(local_dir));
+    local_dir = XMVector3Normalize(local_dir);
+
+    // staged copies of the meshes are still in the pool memory
+    GeometryPool const * pool = pick->geom_pool;
+    BYTE const * vertices = pool->vertices + (size_t)ritem->base_vertex_loc * pool->vtx_stride;
+    bool indices16 = (DXGI_FORMAT_R16_UINT == ritem->geometry->index_format);
+    float best_t = *inout_t;
+    bool hit = false;
+    for (UINT i = 0; i + 2 < ritem->index_count; i += 3) {
+        UINT idx[3];
+        for (int k = 0; k < 3; ++k)
+            idx[k] = indices16 ? pool->indices16[ritem->start_index_loc + i + k] : pool->indices32[ritem->start_index_loc + i + k];
+        XMVECTOR v0 = XMLoadFloat3(reinterpret_cast<XMFLOAT3 const *>(vertices + (size_t)idx[0] * pool->vtx_stride));
+        XMVECTOR v1 = XMLoadFloat3(reinterpret_cast<XMFLOAT3 const *>(vertices + (size_t)idx[1] * pool->vtx_stride));
+        XMVECTOR v2 = XMLoadFloat3(reinterpret_cast<XMFLOAT3 const *>(vertices + (size_t)idx[2] * pool->vtx_stride));
+        float dist = 0.0f;
+        if (TriangleTests::Intersects(local_origin, local_dir, v0, v1, v2, dist)) {
+            float t = dist / local_scale;
+            if (t < best_t) {
+                best_t = t;
+                hit = true;
+            }
+        }
+    }
+    if (hit)
+        *inout_t = best_t;
+    return hit;
+}
+static void
+pick_render_item (D3DRenderContext * render_ctx, SceneContext * scene_ctx, int x, int y) {
+    // -- screen point to view-space ray through the near plane
+    float vx = (+2.0f * x / scene_ctx->width - 1.0f) / scene_ctx->proj._11;
+    float vy = (-2.0f * y / scene_ctx->height + 1.0f) / scene_ctx->proj._22;
+
+    XMMATRIX view = XMLoadFloat4x4(&scene_ctx->view);
+    XMVECTOR view_det = XMMatrixDeterminant(view);
+    XMMATRIX inv_view = XMMatrixInverse(&view_det, view);
+
+    XMFLOAT3 origin;
+    XMFLOAT3 dir;
+    XMStoreFloat3(&origin, XMVector3TransformCoord(XMVectorZero(), inv_view));
+    XMStoreFloat3(&dir, XMVector3Normalize(XMVector3TransformNormal(XMVectorSet(vx, vy, 1.0f, 0.0f), inv_view)));
+
+    // -- only the actual objects are pickable (not their reflections and shadows)
+    PickContext pick = {};
+    pick.geom_pool = render_ctx->geom_pool;
+    int const pickables [] = {RITEM_FLOOR, RITEM_WALL, RITEM_MIRROR, RITEM_SKULL, RITEM_BALL, RITEM_CAR};
+    for (unsigned i = 0; i < ARRAY_COUNT(pickables); ++i) {
+        RenderItem const * ritem = &render_ctx->all_ritems.ritems[pickables[i]];
+        pick.ritems[ritem->obj_cbuffer_index] = ritem;
+    }
+
+    UINT slot = 0;
+    float t = 0.0f;
+    render_ctx->picked_ritem = -1;
+    if (Bvh_RayCast(render_ctx->bvh, origin, dir, FLT_MAX, pick_triangles, &pick, &slot, &t)) {
+        for (unsigned i = 0; i < ARRAY_COUNT(pickables); ++i) {
+            if (render_ctx->all_ritems.ritems[pickables[i]].obj_cbuffer_index == slot) {
+                render_ctx->picked_ritem = pickables[i];
+                render_ctx->picked_dist = t;
+            }
+        }
+    }
 }
 static void
 update_mat_cbuffers (D3DRenderContext * render_ctx) {
@@ -1353,6 +1867,33 @@ update_reflected_pass_cbuffers (D3DRenderContext * render_ctx, GameTimer * timer
     uint8_t * pass_ptr = render_ctx->frame_resources[render_ctx->frame_index].pass_cb_data_ptr + (1 * sizeof(PassConstants));
     memcpy(pass_ptr, &render_ctx->reflected_pass_constants, sizeof(PassConstants));
 }
+// Upload heaps of streamed textures (and the streamed mesh uploader) whose copies the GPU has executed
+static void
+release_streaming_upload_heaps (D3DRenderContext * render_ctx) {
+    UINT64 completed = render_ctx->streaming_fence->GetCompletedValue();
+    for (unsigned i = 0; i < _countof(render_ctx->streamed_textures); i++) {
+        StreamedTexture * st = &render_ctx->streamed_textures[i];
+        Texture * texture = &render_ctx->textures[st->tex];
+        if (st->tail_upload_fence > 0 && st->tail_upload_fence <= completed) {
+            texture->upload_heap->Release();
+            texture->upload_heap = nullptr;
+            st->tail_upload_fence = 0;
+        }
+        for (unsigned j = 0; j < MIP_STREAMING_MAX_MIPS; j++) {
+            if (st->mip_upload_fences[j] > 0 && st->mip_upload_fences[j] <= completed) {
+                st->mip_upload_heaps[j]->Release();
+                st->mip_upload_heaps[j] = nullptr;
+                st->mip_upload_fences[j] = 0;
+            }
+        }
+    }
+    StreamedMesh * sm = &render_ctx->streamed_skull;
+    if (sm->upload_fence > 0 && sm->upload_fence <= completed) {
+        sm->uploader->Release();
+        sm->uploader = nullptr;
+        sm->upload_fence = 0;
+    }
+}
 static UINT64
 move_to_next_frame (D3DRenderContext * render_ctx, UINT * out_frame_index, UINT * out_backbuffer_index) {
     UINT frame_index = *out_frame_index;
@@ -1361,6 +1902,7 @@ move_to_next_frame (D3DRenderContext * render_ctx, UINT * out_frame_index, UINT
     // i.e., notify the fence when the GPU completes commands up to this fence point.
     UINT64 current_fence_value = render_ctx->frame_resources[frame_index].fence;
     render_ctx->cmd_queue->Signal(render_ctx->fence, current_fence_value);
+    render_ctx->cmd_queue->Signal(render_ctx->streaming_fence, ++render_ctx->streaming_fence_value);
 
     // -- 2. update frame index
     //*out_backbuffer_index = render_ctx->swapchain3->GetCurrentBackBufferIndex();
@@ -1372,6 +1914,7 @@ move_to_next_frame (D3DRenderContext * render_ctx, UINT * out_frame_index, UINT
         render_ctx->fence->SetEventOnCompletion(render_ctx->frame_resources[frame_index].fence, render_ctx->fence_event);
         WaitForSingleObjectEx(render_ctx->fence_event, INFINITE /*return only when the object is signaled*/, false);
     }
+    release_streaming_upload_heaps(render_ctx);
 
     // -- 4. set the fence value for the next frame
     // i.e., advance the fence value to mark commands up to this fence point.
@@ -1414,6 +1957,360 @@ create_barrier (ID3D12Resource * resource, D3D12_RESOURCE_STATES before, D3D12_R
     barrier.Transition.StateAfter = after;
     return barrier;
 }
+// Decode worker: create the texture (first request) and the upload heap of what was read (device is free-threaded)
+static bool
+decode_streamed_texture (void * user_data, BYTE const * file_data, size_t file_size) {
+    StreamedTexture * st = (StreamedTexture *)user_data;
+    ID3D12Device * device = st->render_ctx->device;
+    Texture * texture = &st->render_ctx->textures[st->tex];
+    MipStreamingLayout const * layout = &st->layout;
+
+    // -- not streamable: parse the DDS in place, subresources point into file_data (alive until the completion returns)
+    if (st->whole_file) {
+        DDS_HEADER const * header = nullptr;
+        uint8_t const * bit_data = nullptr;
+        size_t bit_size = 0;
+        if (FAILED(LoadTextureDataFromMemory(file_data, file_size, &header, &bit_data, &bit_size)))
+            return false;
+        if (FAILED(CreateTextureFromDDS(
+            device, header, bit_data, bit_size, 0, D3D12_RESOURCE_FLAG_NONE, DDS_LOADER_DEFAULT,
+            &texture->resource, st->subresources, &st->n_subresources, nullptr
+        )))
+            return false;
+        st->first_subresource = 0;
+        return SUCCEEDED(create_texture_upload_heap(device, texture->resource, 0, st->n_subresources, &texture->upload_heap));
+    }
+
+    // -- file_data holds mips [first, mip_count) back to back
+    UINT first = st->tail_loaded ? st->loading_mip : layout->tail_mip;
+    UINT n = st->tail_loaded ? 1 : layout->mip_count - first;
+    if (!st->tail_loaded && FAILED(CreateTextureResource(
+        device, D3D12_RESOURCE_DIMENSION_TEXTURE2D, layout->width, layout->height, 1, layout->mip_count, 1,
+        layout->format, D3D12_RESOURCE_FLAG_NONE, DDS_LOADER_DEFAULT, &texture->resource
+    )))
+        return false;
+    for (UINT i = 0; i < n; ++i) {
+        MipStreamingMip const & mip = layout->mips[first + i];
+        st->subresources[i].pData = file_data + (mip.offset - layout->mips[first].offset);
+        st->subresources[i].RowPitch = (LONG_PTR)mip.row_bytes;
+        st->subresources[i].SlicePitch = (LONG_PTR)mip.size;
+    }
+    st->first_subresource = first;
+    st->n_subresources = n;
+    ID3D12Resource ** upload_heap = st->tail_loaded ? &st->mip_upload_heaps[first] : &texture->upload_heap;
+    return SUCCEEDED(create_texture_upload_heap(device, texture->resource, first, n, upload_heap));
+}
+// Copies one more mip into a texture that is already sampled (its view is still clamped above it)
+static void
+record_mip_upload (ID3D12GraphicsCommandList * cmd_list, ID3D12Resource * texture, ID3D12Resource * upload_heap, UINT mip, D3D12_SUBRESOURCE_DATA * subresource) {
+    D3D12_RESOURCE_BARRIER barrier = create_barrier(texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+    barrier.Transition.Subresource = mip;
+    cmd_list->ResourceBarrier(1, &barrier);
+    update_subresources(cmd_list, texture, upload_heap, 0, mip, 1, subresource);
+    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    cmd_list->ResourceBarrier(1, &barrier);
+}
+// Main thread (draw_main, command list open): upload, then swap the placeholder for the real texture or lower the clamp
+static void
+complete_streamed_texture (void * user_data, BYTE const * file_data, size_t file_size, bool ok) {
+    StreamedTexture * st = (StreamedTexture *)user_data;
+    D3DRenderContext * render_ctx = st->render_ctx;
+    Texture * texture = &render_ctx->textures[st->tex];
+    Material * mat = &render_ctx->materials[st->mat];
+    // -- the copies go in this frame's command list, signaled at the end of the frame
+    UINT64 upload_fence = render_ctx->streaming_fence_value + 1;
+    if (ok && !st->tail_loaded) {
+        record_texture_upload(render_ctx->direct_cmd_list, texture, st->first_subresource, st->n_subresources, st->subresources);
+        st->tail_loaded = true;
+        st->resident_mip = st->first_subresource;
+        st->srv_index = st->tex;
+        st->tail_upload_fence = upload_fence;
+    } else if (ok) {
+        record_mip_upload(render_ctx->direct_cmd_list, texture->resource, st->mip_upload_heaps[st->loading_mip], st->loading_mip, st->subresources);
+        st->resident_mip = st->loading_mip;
+        // -- frames in flight still sample through the current view, the new clamp goes to the other one
+        st->srv_index = st->srv_index == st->tex ? SRV_SECOND_VIEWS + st->tex : st->tex;
+        st->mip_upload_fences[st->loading_mip] = upload_fence;
+    } else if (!st->tail_loaded) {
+        printf("could not stream texture %ls, keeping the placeholder\n", texture->filename);
+        st->failed = true;
+    } else {
+        printf("could not stream mip %u of %ls, keeping mip %u\n", st->loading_mip, texture->filename, st->resident_mip);
+        st->failed = true;
+    }
+    if (ok) {
+        create_texture_srv(render_ctx, st->tex, st->srv_index, (float)st->resident_mip);
+        mat->diffuse_srvheap_index = st->srv_index;
+    }
+    st->in_flight = false;
+}
+// Up to size bytes of the texture file at offset, from the archive mapping if it's packed
+static bool
+read_texture_range (StreamedTexture const * st, uint64_t offset, size_t size, BYTE ** out_data, size_t * out_size) {
+    if (st->archive_entry < 0)
+        return AssetStreamer_ReadFileRange(st->render_ctx->textures[st->tex].filename, offset, size, out_data, out_size);
+
+    AssetArchive const * archive = &st->render_ctx->archive;
+    AssetArchiveEntry const & entry = archive->entries[st->archive_entry];
+    if (offset >= entry.size)
+        return false;
+    size_t n = entry.size - offset < size ? (size_t)(entry.size - offset) : size;
+    BYTE * data = (BYTE *)::malloc(n);
+    if (nullptr == data)
+        return false;
+    if (ASSET_ARCHIVE_COMPRESSION_NONE == entry.compression) {
+        memcpy(data, AssetArchive_GetStoredData(archive, st->archive_entry) + offset, n);
+    } else {
+        // -- compressed entries can only be extracted whole
+        BYTE * whole = nullptr;
+        size_t whole_size = 0;
+        if (!read_archived_asset(archive, st->archive_entry, &whole, &whole_size)) {
+            ::free(data);
+            return false;
+        }
+        memcpy(data, whole + offset, n);
+        ::free(whole);
+    }
+    *out_data = data;
+    *out_size = n;
+    return true;
+}
+// I/O thread: the header and the mip tail first (or the whole file if it can't be streamed), then one mip per request
+static bool
+read_streamed_texture (void * user_data, BYTE ** out_data, size_t * out_size) {
+    StreamedTexture * st = (StreamedTexture *)user_data;
+    MipStreamingLayout * layout = &st->layout;
+    UINT first = st->loading_mip;
+    if (!st->tail_loaded) {
+        BYTE * header = nullptr;
+        size_t header_size = 0;
+        if (!read_texture_range(st, 0, MIP_STREAMING_HEADER_SIZE, &header, &header_size))
+            return false;
+        st->whole_file = !MipStreaming_ParseLayout(header, header_size, layout);
+        ::free(header);
+        if (st->whole_file)
+            return read_texture_range(st, 0, SIZE_MAX, out_data, out_size);
+        first = layout->tail_mip;
+    }
+    MipStreamingMip const & last = st->tail_loaded ? layout->mips[first] : layout->mips[layout->mip_count - 1];
+    size_t size = (size_t)(last.offset + last.size - layout->mips[first].offset);
+    // -- a truncated file is an error (the streamer frees what was read)
+    return read_texture_range(st, layout->mips[first].offset, size, out_data, out_size) && size == *out_size;
+}
+// I/O thread: the whole source file, to bake its mips
+static bool
+read_texture_source (void * user_data, BYTE ** out_data, size_t * out_size) {
+    return read_texture_range((StreamedTexture const *)user_data, 0, SIZE_MAX, out_data, out_size);
+}
+// Decode worker: the cached bake or a new one
+static bool
+bake_streamed_texture (void * user_data, BYTE const * file_data, size_t file_size) {
+    StreamedTexture * st = (StreamedTexture *)user_data;
+    AssetCache * cache = &st->render_ctx->asset_cache;
+    st->baked_path[0] = '\0';
+    if (!MipGen_CanBake(file_data, file_size))
+        return true;    // has mips or isn't supported, streamed as is
+
+    // -- one thread, the other decode workers bake (or decode) the other textures meanwhile
+    char baked_path[ASSET_CACHE_MAX_PATH];
+    bool baked = bake_texture_mips(cache, file_data, file_size, 1, baked_path, sizeof(baked_path));
+    if (baked)
+        strcpy_s(st->baked_path, sizeof(st->baked_path), baked_path);
+    else
+        printf("could not generate mips for %s, it's streamed without them\n", st->render_ctx->textures[st->tex].name);
+    return true;
+}
+static bool
+submit_streamed_texture (D3DRenderContext * render_ctx, StreamedTexture * st, int priority);
+// Main thread: stream the baked DDS (or the source if there was nothing to bake), the placeholder stays until then
+static void
+complete_baked_texture (void * user_data, BYTE const *, size_t, bool) {
+    StreamedTexture * st = (StreamedTexture *)user_data;
+    D3DRenderContext * render_ctx = st->render_ctx;
+    Texture * texture = &render_ctx->textures[st->tex];
+    st->bake_mips = false;
+    st->in_flight = false;
+    if (st->baked_path[0]) {
+        // -- cache paths are ASCII
+        UINT i = 0;
+        for (; st->baked_path[i] && i + 1 < _countof(texture->filename); ++i)
+            texture->filename[i] = (wchar_t)st->baked_path[i];
+        texture->filename[i] = L'\0';
+        st->archive_entry = -1;
+    }
+    if (!submit_streamed_texture(render_ctx, st, st->priority))
+        printf("streamer is full, %ls is not loaded\n", texture->filename);
+}
+static bool
+submit_streamed_texture (D3DRenderContext * render_ctx, StreamedTexture * st, int priority) {
+    AssetRequest request = {};
+    request.path = render_ctx->textures[st->tex].filename;
+    request.priority = priority;
+    request.read = st->bake_mips ? read_texture_source : read_streamed_texture;
+    request.decode = st->bake_mips ? bake_streamed_texture : decode_streamed_texture;
+    request.complete = st->bake_mips ? complete_baked_texture : complete_streamed_texture;
+    request.user_data = st;
+    st->in_flight = AssetStreamer_Submit(render_ctx->streamer, request);
+    return st->in_flight;
+}
+static void
+stream_texture (D3DRenderContext * render_ctx, StreamedTexture * st, TEX_INDEX tex, MAT_INDEX mat, int priority, bool bake_mips) {
+    st->render_ctx = render_ctx;
+    st->tex = tex;
+    st->mat = mat;
+    st->priority = priority;
+    st->bake_mips = bake_mips;
+    st->baked_path[0] = '\0';
+    st->archive_entry = AssetArchive_FindW(&render_ctx->archive, render_ctx->textures[tex].filename);
+    st->n_subresources = 0;
+    st->first_subresource = 0;
+    st->whole_file = false;
+    st->tail_loaded = false;
+    st->in_flight = false;
+    st->failed = false;
+    st->loading_mip = 0;
+    st->resident_mip = MIP_STREAMING_MAX_MIPS;
+    st->srv_index = tex;
+    st->desired_mip = MIP_STREAMING_MAX_MIPS;
+    st->tail_upload_fence = 0;
+    for (UINT i = 0; i < MIP_STREAMING_MAX_MIPS; ++i) {
+        st->mip_upload_heaps[i] = nullptr;
+        st->mip_upload_fences[i] = 0;
+    }
+
+    if (!submit_streamed_texture(render_ctx, st, priority))
+        printf("streamer is full, %ls is not loaded\n", render_ctx->textures[tex].filename);
+}
+// I/O thread: the packed source (the streamer reads loose files by path itself)
+static bool
+read_mesh_source (void * user_data, BYTE ** out_data, size_t * out_size) {
+    StreamedMesh const * sm = (StreamedMesh const *)user_data;
+    return read_archived_asset(&sm->render_ctx->archive, sm->archive_entry, out_data, out_size);
+}
+// Decode worker: the cached bake or a new one
+static bool
+decode_streamed_mesh (void * user_data, BYTE const * file_data, size_t file_size) {
+    StreamedMesh * sm = (StreamedMesh *)user_data;
+    return open_text_model(&sm->render_ctx->asset_cache, file_data, file_size, &sm->mesh);
+}
+// Points every render item drawing geom (in all the layers) to its first submesh and shows it
+static void
+show_streamed_geometry (D3DRenderContext * render_ctx, MeshGeometry const * geom) {
+    SubmeshGeometry const & submesh = geom->submesh_geoms[0];
+    RenderItemArray * arrays [] = {
+        &render_ctx->all_ritems, &render_ctx->opaque_ritems, &render_ctx->transparent_ritems, &render_ctx->alphatested_ritems,
+        &render_ctx->mirrors_ritems, &render_ctx->reflected_ritems, &render_ctx->shadow_ritems, &render_ctx->reflected_shadow_ritems
+    };
+    for (unsigned i = 0; i < _countof(arrays); i++) {
+        for (unsigned j = 0; j < arrays[i]->size; j++) {
+            RenderItem * ritem = &arrays[i]->ritems[j];
+            if (ritem->geometry != geom)
+                continue;
+            ritem->index_count = submesh.index_count;
+            ritem->start_index_loc = submesh.start_index_location;
+            ritem->base_vertex_loc = submesh.base_vertex_location;
+            ritem->bounds = submesh.bounds;
+            ritem->uv_extent = compute_uv_extent(ritem, render_ctx->geom_pool);
+            ritem->n_frames_dirty = NUM_QUEUING_FRAMES;     // new bounds for culling and the hierarchy
+            ritem->initialized = true;
+        }
+    }
+}
+// Main thread (draw_main, command list open): copy into the geometry pool, the skull is drawn from this frame on
+static void
+complete_streamed_mesh (void * user_data, BYTE const *, size_t, bool ok) {
+    StreamedMesh * sm = (StreamedMesh *)user_data;
+    D3DRenderContext * render_ctx = sm->render_ctx;
+    if (!ok) {
+        printf("could not load %s\n", sm->src_path);
+        return;
+    }
+    MeshGeometry * geom = &render_ctx->geom[sm->geom];
+    BakedMesh * mesh = &sm->mesh;
+    SubmeshGeometry submesh = GeometryPool_UploadMesh(
+        render_ctx->geom_pool, render_ctx->device, render_ctx->direct_cmd_list,
+        mesh->vertices, mesh->header->vertex_count,
+        mesh->indices, mesh->header->index_count,
+        sizeof(uint16_t) == mesh->header->index_size ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT,
+        &geom->index_format, &sm->uploader
+    );
+    sm->upload_fence = render_ctx->streaming_fence_value + 1;
+    BakedMesh_Close(mesh);
+
+    // -- the index format is only known now, so is the pool region the views point to
+    GeometryPool_FillMeshGeometry(render_ctx->geom_pool, geom);
+    geom->submesh_names[0] = sm->name;
+    geom->submesh_geoms[0] = submesh;
+    show_streamed_geometry(render_ctx, geom);
+}
+static void
+stream_mesh (D3DRenderContext * render_ctx, StreamedMesh * sm, char const * src_path, GEOM_INDEX geom, char const * name, int priority) {
+    sm->render_ctx = render_ctx;
+    sm->src_path = src_path;
+    UINT i = 0;
+    for (; src_path[i] && i + 1 < _countof(sm->filename); ++i)
+        sm->filename[i] = (wchar_t)src_path[i];
+    sm->filename[i] = L'\0';
+    sm->archive_entry = AssetArchive_Find(&render_ctx->archive, src_path);
+    sm->geom = geom;
+    sm->name = name;
+    sm->mesh = {};
+    sm->uploader = nullptr;
+    sm->upload_fence = 0;
+
+    AssetRequest request = {};
+    request.path = sm->filename;
+    request.priority = priority;
+    request.read = sm->archive_entry >= 0 ? read_mesh_source : nullptr;
+    request.decode = decode_streamed_mesh;
+    request.complete = complete_streamed_mesh;
+    request.user_data = sm;
+    if (!AssetStreamer_Submit(render_ctx->streamer, request))
+        printf("streamer is full, %s is not loaded\n", src_path);
+}
+// Asks for the next mip of every streamed texture that is less detailed than what the visible items need
+static void
+update_texture_streaming (D3DRenderContext * render_ctx, SceneContext * scene_ctx) {
+    StreamedTexture * textures = render_ctx->streamed_textures;
+    UINT n_textures = _countof(render_ctx->streamed_textures);
+    for (UINT i = 0; i < n_textures; ++i)
+        textures[i].desired_mip = MIP_STREAMING_MAX_MIPS;
+
+    // -- desired mip from screen-space usage (bounding sphere of the world-space box)
+    CullingSet const * culling = render_ctx->culling;
+    for (UINT i = 0; i < render_ctx->all_ritems.size; ++i) {
+        RenderItem const * ritem = &render_ctx->all_ritems.ritems[i];
+        UINT slot = ritem->obj_cbuffer_index;
+        if (!ritem->initialized || !culling->visible[slot])
+            continue;
+        for (UINT j = 0; j < n_textures; ++j) {
+            StreamedTexture * st = &textures[j];
+            if (ritem->mat != &render_ctx->materials[st->mat] || !st->tail_loaded || st->whole_file)
+                continue;
+            XMFLOAT3 center = XMFLOAT3(culling->center_x[slot], culling->center_y[slot], culling->center_z[slot]);
+            XMFLOAT3 extent = XMFLOAT3(culling->extent_x[slot], culling->extent_y[slot], culling->extent_z[slot]);
+            float radius = XMVectorGetX(XMVector3Length(XMLoadFloat3(&extent)));
+            float screen_extent = MipStreaming_ScreenExtent(center, radius, scene_ctx->eye_pos, scene_ctx->proj._22, (float)scene_ctx->height);
+            UINT mip = MipStreaming_DesiredMip(&st->layout, ritem->uv_extent, screen_extent);
+            if (mip < st->desired_mip)
+                st->desired_mip = mip;
+        }
+    }
+
+    // -- one mip at a time, coarse to fine, the further from the desired mip the more urgent.
+    // The next mip rewrites the view the material used before the last one, so it waits until
+    // the frame that switched views has executed (its upload heap is released then).
+    for (UINT i = 0; i < n_textures; ++i) {
+        StreamedTexture * st = &textures[i];
+        if (!st->tail_loaded || st->whole_file || st->in_flight || st->failed || st->desired_mip >= st->resident_mip)
+            continue;
+        if (st->tail_upload_fence > 0 || st->mip_upload_fences[st->resident_mip] > 0)
+            continue;
+        st->loading_mip = st->resident_mip - 1;
+        submit_streamed_texture(render_ctx, st, (int)(st->resident_mip - st->desired_mip));  // retried next frame if the streamer is full
+    }
+}
 static void
 draw_main (D3DRenderContext * render_ctx) {
     UINT frame_index = render_ctx->frame_index;
@@ -1428,6 +2325,9 @@ draw_main (D3DRenderContext * render_ctx) {
         render_ctx->psos[LAYER_OPAQUE]
     );
 
+    // -- record uploads of streamed assets that finished loading (they are used from this frame on)
+    AssetStreamer_Poll(render_ctx->streamer, STREAMER_UPLOADS_PER_FRAME);
+
     // -- set viewport and scissor
     render_ctx->direct_cmd_list->RSSetViewports(1, &render_ctx->viewport);
     render_ctx->direct_cmd_list->RSSetScissorRects(1, &render_ctx->scissor_rect);
@@ -1461,7 +2361,7 @@ draw_main (D3DRenderContext * render_ctx) {
         render_ctx->frame_resources[frame_index].mat_cb,
         render_ctx->cbv_srv_uav_descriptor_size,
         render_ctx->srv_heap,
-        &render_ctx->opaque_ritems, frame_index
+        &render_ctx->opaque_ritems, render_ctx->culling, frame_index
     );
     // 2. draw mirrors only to stencil buffer, i.e., mark visible mirror pixels in stencil buffer with value 1
     render_ctx->direct_cmd_list->OMSetStencilRef(1);
@@ -1472,7 +2372,7 @@ draw_main (D3DRenderContext * render_ctx) {
         render_ctx->frame_resources[frame_index].mat_cb,
         render_ctx->cbv_srv_uav_descriptor_size,
         render_ctx->srv_heap,
-        &render_ctx->mirrors_ritems, frame_index
+        &render_ctx->mirrors_ritems, render_ctx->culling, frame_index
     );
     // 3. draw reflections, only into the mirror (only for pixels where stencil buffer is 1)
     // Use a different pass_cb for light reflection!
@@ -1484,7 +2384,7 @@ draw_main (D3DRenderContext * render_ctx) {
         render_ctx->frame_resources[frame_index].mat_cb,
         render_ctx->cbv_srv_uav_descriptor_size,
         render_ctx->srv_heap,
-        &render_ctx->reflected_ritems, frame_index
+        &render_ctx->reflected_ritems, render_ctx->culling, frame_index
     );
     // 3.1 draw skull shadow reflection
     render_ctx->direct_cmd_list->SetPipelineState(render_ctx->psos[LAYER_SHADOW]);
@@ -1494,7 +2394,7 @@ draw_main (D3DRenderContext * render_ctx) {
         render_ctx->frame_resources[frame_index].mat_cb,
         render_ctx->cbv_srv_uav_descriptor_size,
         render_ctx->srv_heap,
-        &render_ctx->reflected_shadow_ritems, frame_index
+        &render_ctx->reflected_shadow_ritems, render_ctx->culling, frame_index
     );
 
     // 4. draw mirrors, this time into backbuffer (with transparency blending)
@@ -1508,7 +2408,7 @@ draw_main (D3DRenderContext * render_ctx) {
         render_ctx->frame_resources[frame_index].mat_cb,
         render_ctx->cbv_srv_uav_descriptor_size,
         render_ctx->srv_heap,
-        &render_ctx->transparent_ritems, frame_index
+        &render_ctx->transparent_ritems, render_ctx->culling, frame_index
     );
 
     // 5. draw skull shadows
@@ -1519,7 +2419,7 @@ draw_main (D3DRenderContext * render_ctx) {
         render_ctx->frame_resources[frame_index].mat_cb,
         render_ctx->cbv_srv_uav_descriptor_size,
         render_ctx->srv_heap,
-        &render_ctx->shadow_ritems, frame_index
+        &render_ctx->shadow_ritems, render_ctx->culling, frame_index
     );
 
     // Imgui draw call
@@ -1573,6 +2473,8 @@ RenderContext_Init (D3DRenderContext * render_ctx) {
     render_ctx->scissor_rect.right = global_scene_ctx.width;
     render_ctx->scissor_rect.bottom = global_scene_ctx.height;
 
+    render_ctx->picked_ritem = -1;
+
     // -- initialize fog data
     render_ctx->main_pass_constants.fog_color = {0.7f, 0.7f, 0.7f, 1.0f};
     render_ctx->main_pass_constants.fog_start = 5.0f;
@@ -1759,6 +2661,9 @@ main_win_cb (HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
         global_scene_ctx.mouse.x = GET_X_LPARAM(lParam);
         global_scene_ctx.mouse.y = GET_Y_LPARAM(lParam);
         SetCapture(hwnd);
+        // left/right drags move the camera, middle click picks
+        if (WM_MBUTTONDOWN == uMsg && global_mouse_active && _render_ctx && _render_ctx->bvh)
+            pick_render_item(_render_ctx, &global_scene_ctx, global_scene_ctx.mouse.x, global_scene_ctx.mouse.y);
     } break;
     case WM_LBUTTONUP:
     case WM_MBUTTONUP:
@@ -1946,34 +2851,33 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
 
 // ========================================================================================================
 #pragma region Load Textures
-    // Brick
-    strcpy_s(render_ctx->textures[TEX_BRICK].name, "brickstex");
-    wcscpy_s(render_ctx->textures[TEX_BRICK].filename, L"../Textures/bricks3.dds");
+    open_asset_archive(&render_ctx->archive);
+    if (!AssetCache_Init(&render_ctx->asset_cache, "./cache", ASSET_CACHE_MAX_BYTES))
+        printf("could not create the asset cache directory\n");
+
+    // White1x1 (placeholder, loaded right away)
+    strcpy_s(render_ctx->textures[TEX_WHITE1x1].name, "white1x1tex");
+    wcscpy_s(render_ctx->textures[TEX_WHITE1x1].filename, L"../Textures/white1x1.dds");
     load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_BRICK].filename, &render_ctx->textures[TEX_BRICK]
+        render_ctx->device, render_ctx->direct_cmd_list, &render_ctx->archive, &render_ctx->asset_cache,
+        render_ctx->textures[TEX_WHITE1x1].filename, &render_ctx->textures[TEX_WHITE1x1]
     );
-    // Checkerboard
+
+    // The rest is streamed, the floor covers most of the screen so it goes first
+    BYTE * streamer_memory = (BYTE *)::malloc(AssetStreamer_CalculateRequiredSize(STREAMER_MAX_JOBS));
+    render_ctx->streamer = AssetStreamer_Init(streamer_memory, STREAMER_MAX_JOBS, 2, 0);
+
+    strcpy_s(render_ctx->textures[TEX_BRICK].name, "brickstex");
+    wcscpy_s(render_ctx->textures[TEX_BRICK].filename, L"../Textures/bricks3.dds");
     strcpy_s(render_ctx->textures[TEX_CHECKERBOARD].name, "checkerboardtex");
     wcscpy_s(render_ctx->textures[TEX_CHECKERBOARD].filename, L"../Textures/checkboard.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_CHECKERBOARD].filename, &render_ctx->textures[TEX_CHECKERBOARD]
-    );
-    // Ice
     strcpy_s(render_ctx->textures[TEX_ICE].name, "icetex");
     wcscpy_s(render_ctx->textures[TEX_ICE].filename, L"../Textures/ice.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_ICE].filename, &render_ctx->textures[TEX_ICE]
-    );
-    // White1x1
-    strcpy_s(render_ctx->textures[TEX_WHITE1x1].name, "white1x1tex");
-    wcscpy_s(render_ctx->textures[TEX_WHITE1x1].filename, L"../Textures/white1x1.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_WHITE1x1].filename, &render_ctx->textures[TEX_WHITE1x1]
-    );
+
+    // -- sources without mips get them baked by the streamer first (cache hits only cost the source read)
+    stream_texture(render_ctx, &render_ctx->streamed_textures[0], TEX_CHECKERBOARD, MAT_CHECKER_TILE, 3, true);
+    stream_texture(render_ctx, &render_ctx->streamed_textures[1], TEX_BRICK, MAT_BRICKS, 2, true);
+    stream_texture(render_ctx, &render_ctx->streamed_textures[2], TEX_ICE, MAT_ICE_MIRROR, 1, true);
 #pragma endregion
 
     create_descriptor_heaps(render_ctx);
@@ -2142,10 +3046,30 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
 #pragma endregion PSO_Creation
 
 #pragma region Shapes_And_Renderitem_Creation
-    create_skull_geometry(render_ctx);
+    BYTE * geom_pool_memory = (BYTE *)::malloc(GeometryPool_CalculateRequiredSize(sizeof(Vertex), GEOMPOOL_MAX_VERTICES, GEOMPOOL_MAX_INDICES16, GEOMPOOL_MAX_INDICES32));
+    render_ctx->geom_pool = GeometryPool_Init(geom_pool_memory, sizeof(Vertex), GEOMPOOL_MAX_VERTICES, GEOMPOOL_MAX_INDICES16, GEOMPOOL_MAX_INDICES32);
+
+    BYTE * culling_memory = (BYTE *)::malloc(CullingSet_CalculateRequiredSize(_COUNT_RENDERITEM));
+    render_ctx->culling = CullingSet_Init(culling_memory, _COUNT_RENDERITEM);
+
+    BYTE * bvh_memory = (BYTE *)::malloc(Bvh_CalculateRequiredSize(_COUNT_RENDERITEM));
+    render_ctx->bvh = Bvh_Init(bvh_memory, _COUNT_RENDERITEM);
+
+    create_text_model_geometry(render_ctx, "./models/car.txt", &render_ctx->geom[GEOM_CAR], "car");
     create_shape_geometry(render_ctx);
+    create_ball_geometry(render_ctx);
+
+    // -- one upload for all static meshes
+    GeometryPool_Upload(render_ctx->geom_pool, render_ctx->device, render_ctx->direct_cmd_list);
+    for (unsigned i = 0; i < _COUNT_GEOM; i++)
+        GeometryPool_FillMeshGeometry(render_ctx->geom_pool, &render_ctx->geom[i]);
+    // -- the skull is drawn once it's loaded (ahead of the texture mips)
+    stream_mesh(render_ctx, &render_ctx->streamed_skull, "./models/skull.txt", GEOM_SKULL, "skull", 4);
 
     create_materials(render_ctx->materials);
+    // -- the placeholder until the mip tail lands
+    for (unsigned i = 0; i < _countof(render_ctx->streamed_textures); i++)
+        render_ctx->materials[render_ctx->streamed_textures[i].mat].diffuse_srvheap_index = TEX_WHITE1x1;
     create_render_items(
         &render_ctx->all_ritems,
         &render_ctx->opaque_ritems,
@@ -2157,8 +3081,19 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
         &render_ctx->reflected_shadow_ritems,
         &render_ctx->geom[GEOM_ROOM],
         &render_ctx->geom[GEOM_SKULL],
+        &render_ctx->geom[GEOM_BALL],
+        &render_ctx->geom[GEOM_CAR],
         render_ctx->materials
     );
+    for (unsigned i = 0; i < render_ctx->all_ritems.size; i++)
+        render_ctx->all_ritems.ritems[i].uv_extent = compute_uv_extent(&render_ctx->all_ritems.ritems[i], render_ctx->geom_pool);
+
+    // -- build the hierarchy once, later frames only refit it
+    for (unsigned i = 0; i < render_ctx->all_ritems.size; i++) {
+        RenderItem * ritem = &render_ctx->all_ritems.ritems[i];
+        Bvh_SetItem(render_ctx->bvh, ritem->obj_cbuffer_index, ritem->bounds, ritem->world);
+    }
+    Bvh_Build(render_ctx->bvh);
 
 #pragma endregion Shapes_And_Renderitem_Creation
 
@@ -2179,6 +3114,8 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     CHECK_AND_FAIL(render_ctx->device->CreateFence(render_ctx->frame_resources[frame_index].fence, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&render_ctx->fence)));
 
     ++render_ctx->frame_resources[frame_index].fence;
+    render_ctx->streaming_fence_value = 0;
+    CHECK_AND_FAIL(render_ctx->device->CreateFence(render_ctx->streaming_fence_value, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&render_ctx->streaming_fence)));
 
     // Create an event handle to use for frame synchronization.
     render_ctx->fence_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
@@ -2193,6 +3130,9 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     flush_command_queue(render_ctx);
     //wait_for_gpu(render_ctx);
 
+    // geometry is on the GPU now
+    GeometryPool_ReleaseUploader(render_ctx->geom_pool);
+
 #pragma endregion
 
 #pragma region Imgui Setup
@@ -2255,12 +3195,31 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
 
         ImGui::TextColored(
             ImVec4(0.8f, 0.7f, 0.0f, 1.0f),
-            "Use 'A', 'W', 'S', 'D', 'Q', 'E' to move skull\n\n"
+            "Use 'A', 'W', 'S', 'D', 'Q', 'E' to move skull\n"
+            "Middle click to pick an object\n\n"
         );
 
         ImGui::ColorEdit3("BG Color", (float*)&render_ctx->main_pass_constants.fog_color);
         coloredit = ImGui::IsItemActive();
 
+        ImGui::Text("Visible render items: %u / %u", render_ctx->culling->n_visible, render_ctx->culling->n_items);
+        if (render_ctx->picked_ritem >= 0)
+            ImGui::Text("Picked: %s (distance %.2f)", ritem_names[render_ctx->picked_ritem], render_ctx->picked_dist);
+        else
+            ImGui::Text("Picked: none");
+
+        static double skull_legacy_ms = 0.0;
+        static double skull_mapped_ms = 0.0;
+        if (ImGui::Button("Benchmark Skull Loading"))   // fgets/sscanf_s vs mapped parser, 10 runs each
+            TextModel_BenchmarkLoad("./models/skull.txt", 10, &skull_legacy_ms, &skull_mapped_ms);
+        ImGui::Text("skull.txt: %.2f ms (fgets/sscanf_s), %.2f ms (mapped)", skull_legacy_ms, skull_mapped_ms);
+        ImGui::Text("Streaming assets: %u pending", AssetStreamer_PendingCount(render_ctx->streamer));
+        for (unsigned i = 0; i < _countof(render_ctx->streamed_textures); i++) {
+            StreamedTexture const * st = &render_ctx->streamed_textures[i];
+            if (st->tail_loaded)
+                ImGui::Text("  %s: mip %u resident, mip %u desired", render_ctx->textures[st->tex].name, st->resident_mip, st->desired_mip);
+        }
+
         ImGui::Text("\n\n");
         ImGui::Separator();
         ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
@@ -2281,6 +3240,8 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
         update_camera(&global_scene_ctx);
 
         update_obj_cbuffers(render_ctx);
+        cull_render_items(render_ctx->culling, &global_scene_ctx);
+        update_texture_streaming(render_ctx, &global_scene_ctx);
         update_mat_cbuffers(render_ctx);
         update_main_pass_cbuffers(render_ctx, &global_timer);
         update_reflected_pass_cbuffers(render_ctx, &global_timer);
@@ -2301,6 +3262,19 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     flush_command_queue(render_ctx);
     //wait_for_gpu(render_ctx);
 
+    // -- stop loading before the device goes away (decoded but never uploaded textures are released below)
+    AssetStreamer_Deinit(render_ctx->streamer);
+    ::free(streamer_memory);
+    if (render_ctx->streamed_skull.uploader)
+        render_ctx->streamed_skull.uploader->Release();
+    BakedMesh_Close(&render_ctx->streamed_skull.mesh);     // decoded but never completed
+    for (unsigned i = 0; i < _countof(render_ctx->streamed_textures); i++) {
+        for (unsigned j = 0; j < MIP_STREAMING_MAX_MIPS; j++)
+            if (render_ctx->streamed_textures[i].mip_upload_heaps[j])
+                render_ctx->streamed_textures[i].mip_upload_heaps[j]->Release();
+    }
+    AssetArchive_Close(&render_ctx->archive);
+
     // Cleanup Imgui
     ImGui_ImplDX12_Shutdown();
     ImGui_ImplWin32_Shutdown();
@@ -2309,6 +3283,7 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     CloseHandle(render_ctx->fence_event);
 
     render_ctx->fence->Release();
+    render_ctx->streaming_fence->Release();
 
     // release queuing frame resources
     for (size_t i = 0; i < NUM_QUEUING_FRAMES; i++) {
@@ -2321,12 +3296,10 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
 
         render_ctx->frame_resources[i].cmd_list_alloc->Release();
     }
-    for (unsigned i = 0; i < _COUNT_GEOM; i++) {
-        render_ctx->geom[i].ib_uploader->Release();
-        render_ctx->geom[i].vb_uploader->Release();
-        render_ctx->geom[i].vb_gpu->Release();
-        render_ctx->geom[i].ib_gpu->Release();
-    }   // is this a bug in d3d12sdklayers.dll ?
+    GeometryPool_Deinit(render_ctx->geom_pool);
+    ::free(geom_pool_memory);
+    ::free(culling_memory);
+    ::free(bvh_memory);
 
     for (int i = 0; i < _COUNT_RENDER_LAYER; ++i) {
         render_ctx->psos[i]->Release();
@@ -2349,9 +3322,12 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
 
     render_ctx->depth_stencil_buffer->Release();
 
+    // textures that failed (or never finished) streaming have no resources
     for (unsigned i = 0; i < _COUNT_TEX; i++) {
-        render_ctx->textures[i].upload_heap->Release();
-        render_ctx->textures[i].resource->Release();
+        if (render_ctx->textures[i].upload_heap)
+            render_ctx->textures[i].upload_heap->Release();
+        if (render_ctx->textures[i].resource)
+            render_ctx->textures[i].resource->Release();
     }
 
     //render_ctx->swapchain3->Release();
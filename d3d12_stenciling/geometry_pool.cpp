@@ -0,0 +1,262 @@
+#include "geometry_pool.h"
+#include "culling.h"
+
+#define GEOMPOOL_MAX_INDEX16    0xffff
+
+static UINT64
+align_up (UINT64 val, UINT64 alignment) {
+    return (val + alignment - 1) & ~(alignment - 1);
+}
+size_t
+GeometryPool_CalculateRequiredSize (UINT vtx_stride, UINT max_vertices, UINT max_indices16, UINT max_indices32) {
+    _ASSERT_EXPR(vtx_stride > 0 && max_vertices > 0, "Invalid geometry pool dimensions");
+    return
+        sizeof(GeometryPool) +
+        (size_t)vtx_stride * max_vertices +
+        sizeof(uint32_t) * (size_t)max_indices32 +
+        sizeof(uint16_t) * (size_t)max_indices16;
+}
+GeometryPool *
+GeometryPool_Init (BYTE * memory, UINT vtx_stride, UINT max_vertices, UINT max_indices16, UINT max_indices32) {
+    GeometryPool * ret = reinterpret_cast<GeometryPool *>(memory);
+    *ret = {};
+    ret->vtx_stride = vtx_stride;
+    ret->max_vertices = max_vertices;
+    ret->max_indices16 = max_indices16;
+    ret->max_indices32 = max_indices32;
+
+    // Setup pointers (32-bit indices before 16-bit ones to keep them 4-byte aligned)
+    BYTE * ptr = memory + sizeof(GeometryPool);
+    ret->vertices = ptr;
+    ptr += (size_t)vtx_stride * max_vertices;
+    ret->indices32 = reinterpret_cast<uint32_t *>(ptr);
+    ptr += sizeof(uint32_t) * (size_t)max_indices32;
+    ret->indices16 = reinterpret_cast<uint16_t *>(ptr);
+
+    return ret;
+}
+static SubmeshGeometry
+stage_mesh (
+    GeometryPool * pool,
+    void const * vertices, UINT nvtx,
+    void const * indices, UINT nidx, DXGI_FORMAT src_index_format,
+    DXGI_FORMAT * out_index_format
+) {
+    _ASSERT_EXPR(pool->n_vertices + nvtx <= pool->max_vertices, "Geometry pool out of vertex space");
+    _ASSERT_EXPR(DXGI_FORMAT_R16_UINT == src_index_format || DXGI_FORMAT_R32_UINT == src_index_format, "Invalid index format");
+
+    SubmeshGeometry ret = {};
+    ret.index_count = nidx;
+    ret.base_vertex_location = (INT)pool->n_vertices;
+    ret.bounds = compute_vertex_bounds(vertices, nvtx, pool->vtx_stride);
+
+    memcpy(pool->vertices + (size_t)pool->n_vertices * pool->vtx_stride, vertices, (size_t)nvtx * pool->vtx_stride);
+    pool->n_vertices += nvtx;
+
+    // -- pick the narrowest index format that can address the mesh
+    if (nvtx <= GEOMPOOL_MAX_INDEX16) {
+        _ASSERT_EXPR(pool->n_indices16 + nidx <= pool->max_indices16, "Geometry pool out of 16-bit index space");
+        uint16_t * dst = pool->indices16 + pool->n_indices16;
+        if (DXGI_FORMAT_R16_UINT == src_index_format) {
+            memcpy(dst, indices, sizeof(uint16_t) * (size_t)nidx);
+        } else {
+            uint32_t const * src = reinterpret_cast<uint32_t const *>(indices);
+            for (UINT i = 0; i < nidx; ++i)
+                dst[i] = (uint16_t)src[i];
+        }
+        ret.start_index_location = pool->n_indices16;
+        pool->n_indices16 += nidx;
+        *out_index_format = DXGI_FORMAT_R16_UINT;
+    } else {
+        _ASSERT_EXPR(DXGI_FORMAT_R32_UINT == src_index_format, "16-bit indices cannot address this mesh");
+        _ASSERT_EXPR(pool->n_indices32 + nidx <= pool->max_indices32, "Geometry pool out of 32-bit index space");
+        memcpy(pool->indices32 + pool->n_indices32, indices, sizeof(uint32_t) * (size_t)nidx);
+        ret.start_index_location = pool->n_indices32;
+        pool->n_indices32 += nidx;
+        *out_index_format = DXGI_FORMAT_R32_UINT;
+    }
+    return ret;
+}
+SubmeshGeometry
+GeometryPool_AddMesh (
+    GeometryPool * pool,
+    void const * vertices, UINT nvtx,
+    void const * indices, UINT nidx, DXGI_FORMAT src_index_format,
+    DXGI_FORMAT * out_index_format
+) {
+    _ASSERT_EXPR(nullptr == pool->buffer, "Geometry pool is already uploaded");
+    return stage_mesh(pool, vertices, nvtx, indices, nidx, src_index_format, out_index_format);
+}
+void
+GeometryPool_Upload (GeometryPool * pool, ID3D12Device * device, ID3D12GraphicsCommandList * cmd_list) {
+    _ASSERT_EXPR(nullptr == pool->buffer, "Geometry pool is already uploaded");
+
+    // -- regions are laid out for the whole capacity, so meshes uploaded later never move the others
+    UINT64 vb_byte_size = (UINT64)pool->n_vertices * pool->vtx_stride;
+    pool->ib16_offset = align_up((UINT64)pool->max_vertices * pool->vtx_stride, 4);
+    pool->ib32_offset = align_up(pool->ib16_offset + sizeof(uint16_t) * (UINT64)pool->max_indices16, 4);
+    pool->total_byte_size = pool->ib32_offset + sizeof(uint32_t) * (UINT64)pool->max_indices32;
+
+    D3D12_HEAP_PROPERTIES def_heap = {};
+    def_heap.Type = D3D12_HEAP_TYPE_DEFAULT;
+    def_heap.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    def_heap.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    def_heap.CreationNodeMask = 1;
+    def_heap.VisibleNodeMask = 1;
+
+    D3D12_HEAP_PROPERTIES upload_heap = def_heap;
+    upload_heap.Type = D3D12_HEAP_TYPE_UPLOAD;
+
+    D3D12_RESOURCE_DESC buf_desc = {};
+    buf_desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    buf_desc.Alignment = 0;
+    buf_desc.Width = pool->total_byte_size;
+    buf_desc.Height = 1;
+    buf_desc.DepthOrArraySize = 1;
+    buf_desc.MipLevels = 1;
+    buf_desc.Format = DXGI_FORMAT_UNKNOWN;
+    buf_desc.SampleDesc = {.Count = 1, .Quality = 0};
+    buf_desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    buf_desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    CHECK_AND_FAIL(device->CreateCommittedResource(
+        &def_heap, D3D12_HEAP_FLAG_NONE, &buf_desc,
+        D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&pool->buffer)));
+    CHECK_AND_FAIL(device->CreateCommittedResource(
+        &upload_heap, D3D12_HEAP_FLAG_NONE, &buf_desc,
+        D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&pool->uploader)));
+
+    // -- pack all regions into the upload buffer
+    BYTE * mapped = nullptr;
+    D3D12_RANGE read_range = {};
+    CHECK_AND_FAIL(pool->uploader->Map(0, &read_range, reinterpret_cast<void **>(&mapped)));
+    memcpy(mapped, pool->vertices, vb_byte_size);
+    memcpy(mapped + pool->ib16_offset, pool->indices16, sizeof(uint16_t) * (size_t)pool->n_indices16);
+    memcpy(mapped + pool->ib32_offset, pool->indices32, sizeof(uint32_t) * (size_t)pool->n_indices32);
+    pool->uploader->Unmap(0, nullptr);
+
+    // -- one copy for all static geometry
+    cmd_list->CopyBufferRegion(pool->buffer, 0, pool->uploader, 0, pool->total_byte_size);
+
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    barrier.Transition.pResource = pool->buffer;
+    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER | D3D12_RESOURCE_STATE_INDEX_BUFFER;
+    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    cmd_list->ResourceBarrier(1, &barrier);
+}
+static void
+transition_buffer (ID3D12GraphicsCommandList * cmd_list, ID3D12Resource * buffer, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after) {
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    barrier.Transition.pResource = buffer;
+    barrier.Transition.StateBefore = before;
+    barrier.Transition.StateAfter = after;
+    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    cmd_list->ResourceBarrier(1, &barrier);
+}
+SubmeshGeometry
+GeometryPool_UploadMesh (
+    GeometryPool * pool,
+    ID3D12Device * device, ID3D12GraphicsCommandList * cmd_list,
+    void const * vertices, UINT nvtx,
+    void const * indices, UINT nidx, DXGI_FORMAT src_index_format,
+    DXGI_FORMAT * out_index_format,
+    ID3D12Resource ** out_uploader
+) {
+    _ASSERT_EXPR(pool->buffer, "Geometry pool is not uploaded yet");
+
+    SubmeshGeometry ret = stage_mesh(pool, vertices, nvtx, indices, nidx, src_index_format, out_index_format);
+
+    // -- the staged ranges (indices may have been narrowed), vertices first
+    UINT index_size = DXGI_FORMAT_R16_UINT == *out_index_format ? sizeof(uint16_t) : sizeof(uint32_t);
+    UINT64 vb_offset = (UINT64)ret.base_vertex_location * pool->vtx_stride;
+    UINT64 vb_byte_size = (UINT64)nvtx * pool->vtx_stride;
+    UINT64 ib_offset = (DXGI_FORMAT_R16_UINT == *out_index_format ? pool->ib16_offset : pool->ib32_offset) + (UINT64)ret.start_index_location * index_size;
+    UINT64 ib_byte_size = (UINT64)nidx * index_size;
+    UINT64 ib_upload_offset = align_up(vb_byte_size, 4);
+    BYTE const * staged_indices =
+        DXGI_FORMAT_R16_UINT == *out_index_format ?
+        reinterpret_cast<BYTE const *>(pool->indices16 + ret.start_index_location) :
+        reinterpret_cast<BYTE const *>(pool->indices32 + ret.start_index_location);
+
+    D3D12_HEAP_PROPERTIES upload_heap = {};
+    upload_heap.Type = D3D12_HEAP_TYPE_UPLOAD;
+    upload_heap.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    upload_heap.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    upload_heap.CreationNodeMask = 1;
+    upload_heap.VisibleNodeMask = 1;
+
+    D3D12_RESOURCE_DESC buf_desc = {};
+    buf_desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    buf_desc.Alignment = 0;
+    buf_desc.Width = ib_upload_offset + ib_byte_size;
+    buf_desc.Height = 1;
+    buf_desc.DepthOrArraySize = 1;
+    buf_desc.MipLevels = 1;
+    buf_desc.Format = DXGI_FORMAT_UNKNOWN;
+    buf_desc.SampleDesc = {.Count = 1, .Quality = 0};
+    buf_desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    buf_desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    CHECK_AND_FAIL(device->CreateCommittedResource(
+        &upload_heap, D3D12_HEAP_FLAG_NONE, &buf_desc,
+        D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(out_uploader)));
+
+    BYTE * mapped = nullptr;
+    D3D12_RANGE read_range = {};
+    CHECK_AND_FAIL((*out_uploader)->Map(0, &read_range, reinterpret_cast<void **>(&mapped)));
+    memcpy(mapped, pool->vertices + vb_offset, vb_byte_size);
+    memcpy(mapped + ib_upload_offset, staged_indices, ib_byte_size);
+    (*out_uploader)->Unmap(0, nullptr);
+
+    // -- only the new ranges are written, draws already recorded read the other ones
+    D3D12_RESOURCE_STATES const geometry_state = D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER | D3D12_RESOURCE_STATE_INDEX_BUFFER;
+    transition_buffer(cmd_list, pool->buffer, geometry_state, D3D12_RESOURCE_STATE_COPY_DEST);
+    cmd_list->CopyBufferRegion(pool->buffer, vb_offset, *out_uploader, 0, vb_byte_size);
+    cmd_list->CopyBufferRegion(pool->buffer, ib_offset, *out_uploader, ib_upload_offset, ib_byte_size);
+    transition_buffer(cmd_list, pool->buffer, D3D12_RESOURCE_STATE_COPY_DEST, geometry_state);
+
+    return ret;
+}
+void
+GeometryPool_FillMeshGeometry (GeometryPool * pool, MeshGeometry * mesh) {
+    _ASSERT_EXPR(pool->buffer, "Geometry pool is not uploaded yet");
+
+    mesh->vb_gpu = pool->buffer;
+    mesh->ib_gpu = pool->buffer;
+    mesh->vb_cpu = nullptr;
+    mesh->ib_cpu = nullptr;
+    mesh->vb_uploader = nullptr;
+    mesh->ib_uploader = nullptr;
+
+    // -- views span the whole regions, so they stay valid when meshes are uploaded later
+    mesh->vb_byte_stide = pool->vtx_stride;
+    mesh->vb_byte_offset = 0;
+    mesh->vb_byte_size = pool->max_vertices * pool->vtx_stride;
+    if (DXGI_FORMAT_R16_UINT == mesh->index_format) {
+        mesh->ib_byte_offset = pool->ib16_offset;
+        mesh->ib_byte_size = pool->max_indices16 * sizeof(uint16_t);
+    } else {
+        mesh->ib_byte_offset = pool->ib32_offset;
+        mesh->ib_byte_size = pool->max_indices32 * sizeof(uint32_t);
+    }
+}
+void
+GeometryPool_ReleaseUploader (GeometryPool * pool) {
+    if (pool->uploader) {
+        pool->uploader->Release();
+        pool->uploader = nullptr;
+    }
+}
+void
+GeometryPool_Deinit (GeometryPool * pool) {
+    GeometryPool_ReleaseUploader(pool);
+    if (pool->buffer) {
+        pool->buffer->Release();
+        pool->buffer = nullptr;
+    }
+}
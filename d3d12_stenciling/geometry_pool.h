@@ -0,0 +1,91 @@
+#pragma once
+
+#include "headers/common.h"
+#include "headers/mesh_geometry.h"
+
+// NOTE(omid): A geometry pool suballocates all static meshes into one GPU buffer:
+//   [ vertices | 16-bit indices | 32-bit indices ]
+// Meshes are staged in system memory by GeometryPool_AddMesh and uploaded with a single copy.
+// The buffer is sized for the whole capacity, meshes that arrive later (streamed) are staged and
+// copied into the free space by GeometryPool_UploadMesh.
+// Indices stay local to each mesh (base_vertex_location carries the vertex offset),
+// so any mesh with at most 0xffff vertices gets 16-bit indices regardless of its source format.
+struct GeometryPool {
+    UINT vtx_stride;
+
+    UINT max_vertices;
+    UINT max_indices16;
+    UINT max_indices32;
+
+    UINT n_vertices;
+    UINT n_indices16;
+    UINT n_indices32;
+
+    // system memory staging (points into the pool memory block)
+    BYTE *      vertices;
+    uint16_t *  indices16;
+    uint32_t *  indices32;
+
+    // byte offsets of each region inside the shared buffer
+    UINT64 ib16_offset;
+    UINT64 ib32_offset;
+    UINT64 total_byte_size;
+
+    ID3D12Resource * buffer;
+    ID3D12Resource * uploader;
+};
+
+size_t
+GeometryPool_CalculateRequiredSize (UINT vtx_stride, UINT max_vertices, UINT max_indices16, UINT max_indices32);
+
+GeometryPool *
+GeometryPool_Init (BYTE * memory, UINT vtx_stride, UINT max_vertices, UINT max_indices16, UINT max_indices32);
+
+/*
+    Copies the mesh into the staging area and returns its submesh (offsets relative to the shared buffer,
+    bounds computed from the vertex positions which are expected at the beginning of each vertex).
+    src_index_format is either DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT,
+    out_index_format receives the format the mesh ended up with.
+*/
+SubmeshGeometry
+GeometryPool_AddMesh (
+    GeometryPool * pool,
+    void const * vertices, UINT nvtx,
+    void const * indices, UINT nidx, DXGI_FORMAT src_index_format,
+    DXGI_FORMAT * out_index_format
+);
+
+/*
+    Creates the shared default buffer and records one copy for all the staged meshes.
+    The uploader must be kept alive until the copy has executed.
+*/
+void
+GeometryPool_Upload (GeometryPool * pool, ID3D12Device * device, ID3D12GraphicsCommandList * cmd_list);
+
+/*
+    Same as GeometryPool_AddMesh once the pool is uploaded: stages the mesh and records the copy of its ranges.
+    The pool buffer must be in the vertex/index buffer state (as left by GeometryPool_Upload),
+    out_uploader must be kept alive until the copy has executed.
+*/
+SubmeshGeometry
+GeometryPool_UploadMesh (
+    GeometryPool * pool,
+    ID3D12Device * device, ID3D12GraphicsCommandList * cmd_list,
+    void const * vertices, UINT nvtx,
+    void const * indices, UINT nidx, DXGI_FORMAT src_index_format,
+    DXGI_FORMAT * out_index_format,
+    ID3D12Resource ** out_uploader
+);
+
+/*
+    Points a MeshGeometry to the shared buffer, using the region that matches mesh->index_format.
+    Submeshes are not touched.
+*/
+void
+GeometryPool_FillMeshGeometry (GeometryPool * pool, MeshGeometry * mesh);
+
+void
+GeometryPool_ReleaseUploader (GeometryPool * pool);
+
+void
+GeometryPool_Deinit (GeometryPool * pool);
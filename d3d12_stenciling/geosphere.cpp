@@ -0,0 +1,243 @@
+#include "geosphere.h"
+
+#include <mutex>
+
+#define EDGE_EMPTY_KEY      0xffffffffffffffffull
+#define NO_COPY             0xffffffffu
+
+// Process-wide, levels are never freed
+// closed levels share every vertex (subdivision input), textured levels have the seam and poles split
+struct GeoSphereCache {
+    GeoSphereMesh   levels[GEOSPHERE_MAX_LEVEL + 1];
+    GeoSphereMesh   textured[GEOSPHERE_MAX_LEVEL + 1];
+    std::once_flag  built[GEOSPHERE_MAX_LEVEL + 1];
+    std::once_flag  built_textured[GEOSPHERE_MAX_LEVEL + 1];
+};
+static GeoSphereCache global_geosphere_cache;
+
+static UINT
+closed_vertex_count (int level) {
+    return 10u * (1u << (2 * level)) + 2u;
+}
+UINT
+GeoSphere_VertexCount (int level) {
+    return GeoSphere_GetUnitMesh(level)->nvtx;
+}
+UINT
+GeoSphere_IndexCount (int level) {
+    return 60u * (1u << (2 * level));
+}
+static void
+set_unit_vertex (GeomVertex * v, XMVECTOR dir) {
+    XMVECTOR n = XMVector3Normalize(dir);
+    XMStoreFloat3(&v->Position, n);
+    XMStoreFloat3(&v->Normal, n);
+
+    // -- spherical texture coordinates, tangent is dP/dtheta
+    float theta = atan2f(v->Position.z, v->Position.x);
+    if (theta < 0.0f)
+        theta += XM_2PI;
+    float phi = acosf(CLAMP_VALUE(v->Position.y, -1.0f, 1.0f));
+    v->TexC.x = theta / XM_2PI;
+    v->TexC.y = phi / XM_PI;
+    v->TangentU = XMFLOAT3(-sinf(phi) * sinf(theta), 0.0f, +sinf(phi) * cosf(theta));
+    XMStoreFloat3(&v->TangentU, XMVector3Normalize(XMLoadFloat3(&v->TangentU)));
+}
+static void
+build_icosahedron (GeoSphereMesh * mesh) {
+    float const X = 0.525731f;
+    float const Z = 0.850651f;
+    XMFLOAT3 const pos[12] = {
+        XMFLOAT3(-X, 0.0f, Z),  XMFLOAT3(X, 0.0f, Z),
+        XMFLOAT3(-X, 0.0f, -Z), XMFLOAT3(X, 0.0f, -Z),
+        XMFLOAT3(0.0f, Z, X),   XMFLOAT3(0.0f, Z, -X),
+        XMFLOAT3(0.0f, -Z, X),  XMFLOAT3(0.0f, -Z, -X),
+        XMFLOAT3(Z, X, 0.0f),   XMFLOAT3(-Z, X, 0.0f),
+        XMFLOAT3(Z, -X, 0.0f),  XMFLOAT3(-Z, -X, 0.0f)
+    };
+    uint32_t const idx[60] = {
+        1,4,0,  4,9,0,  4,5,9,  8,5,4,  1,8,4,
+        1,10,8, 10,3,8, 8,3,5,  3,2,5,  3,7,2,
+        3,10,7, 10,6,7, 6,11,7, 6,0,11, 6,1,0,
+        10,1,6, 11,0,9, 2,11,9, 5,2,9,  11,2,7
+    };
+    mesh->nvtx = closed_vertex_count(0);
+    mesh->nidx = GeoSphere_IndexCount(0);
+    mesh->vertices = (GeomVertex *)::malloc(sizeof(GeomVertex) * mesh->nvtx);
+    mesh->indices = (uint32_t *)::malloc(sizeof(uint32_t) * mesh->nidx);
+    for (UINT i = 0; i < mesh->nvtx; ++i)
+        set_unit_vertex(&mesh->vertices[i], XMLoadFloat3(&pos[i]));
+    memcpy(mesh->indices, idx, sizeof(idx));
+}
+// Returns the vertex at the middle of edge (a, b), adding it on the first visit
+static uint32_t
+get_midpoint (
+    uint64_t * keys, uint32_t * values, UINT mask,
+    GeoSphereMesh * mesh, uint32_t a, uint32_t b
+) {
+    uint64_t key = a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+    UINT slot = (UINT)((key * 0x9e3779b97f4a7c15ull) >> 40) & mask;
+    while (EDGE_EMPTY_KEY != keys[slot]) {
+        if (key == keys[slot])
+            return values[slot];
+        slot = (slot + 1) & mask;
+    }
+    uint32_t ret = mesh->nvtx++;
+    XMVECTOR pa = XMLoadFloat3(&mesh->vertices[a].Position);
+    XMVECTOR pb = XMLoadFloat3(&mesh->vertices[b].Position);
+    set_unit_vertex(&mesh->vertices[ret], XMVectorAdd(pa, pb));
+    keys[slot] = key;
+    values[slot] = ret;
+    return ret;
+}
+static void
+subdivide (GeoSphereMesh const * src, GeoSphereMesh * dst, int level) {
+    dst->nvtx = src->nvtx;
+    dst->nidx = 0;
+    dst->vertices = (GeomVertex *)::malloc(sizeof(GeomVertex) * closed_vertex_count(level));
+    dst->indices = (uint32_t *)::malloc(sizeof(uint32_t) * GeoSphere_IndexCount(level));
+    memcpy(dst->vertices, src->vertices, sizeof(GeomVertex) * src->nvtx);
+
+    // -- edge -> midpoint table, every edge is shared by two triangles
+    UINT n_edges = src->nidx / 2;
+    UINT cap = 16;
+    while (cap < 2 * n_edges)
+        cap <<= 1;
+    uint64_t * keys = (uint64_t *)::malloc(sizeof(uint64_t) * cap);
+    uint32_t * values = (uint32_t *)::malloc(sizeof(uint32_t) * cap);
+    memset(keys, 0xff, sizeof(uint64_t) * cap);
+
+    // every triangle is split in 4 (corners + center):
+    // (v0, m0, m2), (m0, m1, m2), (m2, m1, v2), (m0, v1, m1)
+    // with m0 = mid(v0, v1), m1 = mid(v1, v2), m2 = mid(v0, v2)
+    for (UINT i = 0; i < src->nidx; i += 3) {
+        uint32_t v0 = src->indices[i + 0];
+        uint32_t v1 = src->indices[i + 1];
+        uint32_t v2 = src->indices[i + 2];
+        uint32_t m0 = get_midpoint(keys, values, cap - 1, dst, v0, v1);
+        uint32_t m1 = get_midpoint(keys, values, cap - 1, dst, v1, v2);
+        uint32_t m2 = get_midpoint(keys, values, cap - 1, dst, v0, v2);
+
+        uint32_t * out = dst->indices + dst->nidx;
+        out[0] = v0; out[1] = m0; out[2] = m2;
+        out[3] = m0; out[4] = m1; out[5] = m2;
+        out[6] = m2; out[7] = m1; out[8] = v2;
+        out[9] = m0; out[10] = v1; out[11] = m1;
+        dst->nidx += 12;
+    }
+    _ASSERT_EXPR(dst->nvtx == closed_vertex_count(level), "Unexpected geosphere vertex count");
+
+    ::free(values);
+    ::free(keys);
+}
+static bool
+is_pole (GeomVertex const * v) {
+    return fabsf(v->Position.y) > 0.99999f;
+}
+// Copies the closed mesh and splits the vertices the spherical mapping can't share:
+// triangles crossing the u = 0/1 seam use copies of their low-u corners with u + 1
+// (one copy per seam vertex, shared by the triangles on that side),
+// and every triangle touching a pole gets its own pole vertex, with u centered between the other corners
+static void
+split_seam (GeoSphereMesh const * src, GeoSphereMesh * dst) {
+    dst->nvtx = src->nvtx;
+    dst->nidx = src->nidx;
+    // at most one new vertex per corner, trimmed at the end
+    dst->vertices = (GeomVertex *)::malloc(sizeof(GeomVertex) * (src->nvtx + src->nidx));
+    dst->indices = (uint32_t *)::malloc(sizeof(uint32_t) * src->nidx);
+    memcpy(dst->vertices, src->vertices, sizeof(GeomVertex) * src->nvtx);
+    memcpy(dst->indices, src->indices, sizeof(uint32_t) * src->nidx);
+
+    // -- closed vertex -> its seam copy (poles: marks the original as taken by a triangle)
+    uint32_t * copies = (uint32_t *)::malloc(sizeof(uint32_t) * src->nvtx);
+    memset(copies, 0xff, sizeof(uint32_t) * src->nvtx);
+
+    for (UINT i = 0; i < dst->nidx; i += 3) {
+        uint32_t * tri = dst->indices + i;
+        // -- the triangle crosses the seam if it has corners on both halves
+        // and moving the low ones to u + 1 makes it narrower
+        float u_min = 1.0f, u_max = 0.0f;
+        float wrapped_min = 2.0f, wrapped_max = 0.0f;
+        for (UINT k = 0; k < 3; ++k) {
+            GeomVertex const * v = &src->vertices[tri[k]];
+            if (!is_pole(v)) {
+                float u = v->TexC.x;
+                float wrapped_u = u < 0.5f ? u + 1.0f : u;
+                u_min = fminf(u_min, u);
+                u_max = fmaxf(u_max, u);
+                wrapped_min = fminf(wrapped_min, wrapped_u);
+                wrapped_max = fmaxf(wrapped_max, wrapped_u);
+            }
+        }
+        if (u_min < 0.5f && u_max >= 0.5f && wrapped_max - wrapped_min < u_max - u_min) {
+            for (UINT k = 0; k < 3; ++k) {
+                uint32_t v = tri[k];
+                if (is_pole(&src->vertices[v]) || src->vertices[v].TexC.x >= 0.5f)
+                    continue;
+                if (NO_COPY == copies[v]) {
+                    copies[v] = dst->nvtx++;
+                    dst->vertices[copies[v]] = src->vertices[v];
+                    dst->vertices[copies[v]].TexC.x += 1.0f;
+                }
+                tri[k] = copies[v];
+            }
+        }
+        for (UINT k = 0; k < 3; ++k) {
+            uint32_t v = tri[k];
+            if (!is_pole(&dst->vertices[v]))
+                continue;
+            // -- the first triangle keeps the original pole vertex
+            uint32_t pole = v;
+            if (NO_COPY == copies[v]) {
+                copies[v] = v;
+            } else {
+                pole = dst->nvtx++;
+                dst->vertices[pole] = src->vertices[v];
+            }
+            float u = 0.5f * (dst->vertices[tri[(k + 1) % 3]].TexC.x + dst->vertices[tri[(k + 2) % 3]].TexC.x);
+            float theta = u * XM_2PI;
+            dst->vertices[pole].TexC.x = u;
+            // dP/dtheta vanishes at the pole, take its limit along the triangle's meridian
+            dst->vertices[pole].TangentU = XMFLOAT3(-sinf(theta), 0.0f, cosf(theta));
+            tri[k] = pole;
+        }
+    }
+    dst->vertices = (GeomVertex *)::realloc(dst->vertices, sizeof(GeomVertex) * dst->nvtx);
+
+    ::free(copies);
+}
+static GeoSphereMesh const *
+get_closed_mesh (int level) {
+    GeoSphereCache * cache = &global_geosphere_cache;
+    std::call_once(cache->built[level], [cache, level]() {
+        if (0 == level)
+            build_icosahedron(&cache->levels[0]);
+        else
+            subdivide(get_closed_mesh(level - 1), &cache->levels[level], level);
+    });
+    return &cache->levels[level];
+}
+GeoSphereMesh const *
+GeoSphere_GetUnitMesh (int level) {
+    _ASSERT_EXPR(level >= 0 && level <= GEOSPHERE_MAX_LEVEL, "Geosphere level out of range");
+    GeoSphereCache * cache = &global_geosphere_cache;
+    std::call_once(cache->built_textured[level], [cache, level]() {
+        split_seam(get_closed_mesh(level), &cache->textured[level]);
+    });
+    return &cache->textured[level];
+}
+void
+create_geosphere (float radius, int level, GeomVertex out_vtx [], uint32_t out_idx []) {
+    GeoSphereMesh const * unit = GeoSphere_GetUnitMesh(level);
+
+    // -- unit normals, tangents and texcoords carry over, only positions scale
+    XMVECTOR scale = XMVectorReplicate(radius);
+    for (UINT i = 0; i < unit->nvtx; ++i) {
+        GeomVertex const * src = &unit->vertices[i];
+        XMStoreFloat3(&out_vtx[i].Position, XMVectorMultiply(XMLoadFloat3(&src->Position), scale));
+        out_vtx[i].Normal = src->Normal;
+        out_vtx[i].TangentU = src->TangentU;
+        out_vtx[i].TexC = src->TexC;
+    }
+    memcpy(out_idx, unit->indices, sizeof(uint32_t) * unit->nidx);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "headers/utils.h"
+
+// NOTE(omid): Geosphere: an icosahedron whose triangles are split in 4 per subdivision level,
+// with the new vertices projected onto the sphere. Unlike the UV sphere (create_sphere), triangles
+// are spread uniformly, so detail scales with a single level parameter.
+// The unit-sphere mesh of every level is built once (from the previous level, sharing edge midpoints
+// through a hash table) and kept for the lifetime of the process. Spheres of a given radius are
+// then a copy of the cached level with the positions scaled.
+// The spherical texcoords need split vertices: the u = 0/1 seam is duplicated with u + 1 and
+// pole vertices are split per triangle (create_sphere duplicates its first slice the same way),
+// subdivision itself runs on the closed mesh.
+
+#define GEOSPHERE_MAX_LEVEL     7
+
+struct GeoSphereMesh {
+    GeomVertex *    vertices;
+    uint32_t *      indices;
+    UINT            nvtx;
+    UINT            nidx;
+};
+
+// 10 * 4^level + 2 closed vertices plus the seam and pole copies (builds the level), 60 * 4^level indices
+UINT
+GeoSphere_VertexCount (int level);
+
+UINT
+GeoSphere_IndexCount (int level);
+
+/*
+    Unit-sphere mesh of the given level (built on first use, thread-safe).
+    The returned mesh is owned by the cache (kept until the process exits).
+*/
+GeoSphereMesh const *
+GeoSphere_GetUnitMesh (int level);
+
+/*
+    out_vtx [GeoSphere_VertexCount(level)], out_idx [GeoSphere_IndexCount(level)]
+    Levels up to 6 fit 16-bit indices (GeometryPool_AddMesh narrows them).
+*/
+void
+create_geosphere (float radius, int level, GeomVertex out_vtx [], uint32_t out_idx []);
@@ -21,8 +21,8 @@ struct SubmeshGeometry {
     UINT start_index_location;
     INT base_vertex_location;
 
-    // Bounding box of the geometry defined by this submesh. 
-    // Not used for now
+    // Local-space bounding box of the geometry defined by this submesh.
+    // Filled at geometry creation, used for frustum culling.
     DirectX::BoundingBox bounds;
 };
 struct MeshGeometry {
@@ -33,6 +33,10 @@ struct MeshGeometry {
     UINT vb_byte_size;
     UINT ib_byte_size;
 
+    // Byte offsets into vb_gpu/ib_gpu (non-zero when buffers are shared, e.g., by a GeometryPool)
+    UINT64 vb_byte_offset;
+    UINT64 ib_byte_offset;
+
     // System memory copies.  Use Blobs because the vertex/index format can be generic.
     // It is up to the client to cast appropriately.  
     ID3DBlob * vb_cpu;
@@ -53,20 +57,20 @@ struct MeshGeometry {
     SubmeshGeometry submesh_geoms [MAX_SUBMESH_COUNT];
 };
 
-D3D12_VERTEX_BUFFER_VIEW
+inline D3D12_VERTEX_BUFFER_VIEW
 Mesh_GetVertexBufferView (MeshGeometry * mesh) {
     D3D12_VERTEX_BUFFER_VIEW vbv;
-    vbv.BufferLocation = mesh->vb_gpu->GetGPUVirtualAddress();
+    vbv.BufferLocation = mesh->vb_gpu->GetGPUVirtualAddress() + mesh->vb_byte_offset;
     vbv.StrideInBytes = mesh->vb_byte_stide;
     vbv.SizeInBytes = mesh->vb_byte_size;
 
     return vbv;
 }
 
-D3D12_INDEX_BUFFER_VIEW
+inline D3D12_INDEX_BUFFER_VIEW
 Mesh_GetIndexBufferView (MeshGeometry * mesh) {
     D3D12_INDEX_BUFFER_VIEW ibv;
-    ibv.BufferLocation = mesh->ib_gpu->GetGPUVirtualAddress();
+    ibv.BufferLocation = mesh->ib_gpu->GetGPUVirtualAddress() + mesh->ib_byte_offset;
     ibv.Format = mesh->index_format;
     ibv.SizeInBytes = mesh->ib_byte_size;
 
@@ -74,7 +78,7 @@ Mesh_GetIndexBufferView (MeshGeometry * mesh) {
 }
 
 // We can free this memory after we finish upload to the GPU.
-void
+inline void
 Mesh_Dispose (MeshGeometry * mesh) {
     mesh->vb_cpu->Release();
     mesh->ib_cpu->Release();
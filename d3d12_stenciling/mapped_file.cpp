@@ -0,0 +1,45 @@
+#include "mapped_file.h"
+
+bool
+MappedFile_Open (char const * path, MappedFile * out) {
+    *out = {};
+
+    // -- sequential scan hint lets the cache manager read ahead aggressively
+    HANDLE file = ::CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (INVALID_HANDLE_VALUE == file)
+        return false;
+
+    // -- empty files can't be mapped
+    LARGE_INTEGER file_size = {};
+    if (!::GetFileSizeEx(file, &file_size) || 0 == file_size.QuadPart) {
+        ::CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (nullptr == mapping) {
+        ::CloseHandle(file);
+        return false;
+    }
+    void * view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (nullptr == view) {
+        ::CloseHandle(mapping);
+        ::CloseHandle(file);
+        return false;
+    }
+
+    out->data = reinterpret_cast<BYTE const *>(view);
+    out->size = (size_t)file_size.QuadPart;
+    out->file = file;
+    out->mapping = mapping;
+    return true;
+}
+void
+MappedFile_Close (MappedFile * mapped) {
+    if (mapped->data)
+        ::UnmapViewOfFile(mapped->data);
+    if (mapped->mapping)
+        ::CloseHandle(mapped->mapping);
+    if (mapped->file)
+        ::CloseHandle(mapped->file);
+    *mapped = {};
+}
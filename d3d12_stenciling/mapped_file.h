@@ -0,0 +1,23 @@
+#pragma once
+
+#include "headers/common.h"
+
+// NOTE(omid): Read-only memory mapping of a whole file.
+// The contents are paged in by the OS on first touch, no staging buffer or read copy is involved.
+// The view is not null-terminated, always parse against data + size.
+struct MappedFile {
+    BYTE const *    data;
+    size_t          size;
+
+    HANDLE          file;
+    HANDLE          mapping;
+};
+
+/*
+    Returns false (out left zeroed) if the file can't be opened or is empty.
+*/
+bool
+MappedFile_Open (char const * path, MappedFile * out);
+
+void
+MappedFile_Close (MappedFile * mapped);
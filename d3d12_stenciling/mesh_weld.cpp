@@ -0,0 +1,156 @@
+#include "mesh_weld.h"
+
+#include <math.h>
+
+#define WELD_EMPTY_SLOT     0xffffffffu
+// quantized cells are clamped to +-2^30 so the int32 cast (and the +-1 neighbour) never overflows
+#define WELD_MAX_CELL       1073741824.0f
+
+static UINT
+table_capacity (UINT nvtx) {
+    // power of two, at most half full
+    UINT cap = 16;
+    while (cap < 2 * (size_t)nvtx)
+        cap <<= 1;
+    return cap;
+}
+static uint32_t
+hash_cell (int32_t const cell [3]) {
+    // multiplicative mixing per component, murmur3 finalizer at the end
+    uint32_t h = 0x811c9dc5u;
+    for (UINT k = 0; k < 3; ++k)
+        h = (h ^ (uint32_t)cell[k]) * 0x9e3779b1u;
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+static int32_t
+quantize (float c) {
+    // NaN fails both compares and lands in the lowest cell, it never passes the distance test anyway
+    if (!(c >= -WELD_MAX_CELL))
+        c = -WELD_MAX_CELL;
+    if (c > WELD_MAX_CELL)
+        c = WELD_MAX_CELL;
+    return (int32_t)floorf(c);
+}
+static bool
+within (float const * a, float const * b, UINT begin, UINT end, float tolerance) {
+    for (UINT k = begin; k < end; ++k) {
+        if (tolerance > 0.0f) {
+            if (!(fabsf(a[k] - b[k]) <= tolerance))
+                return false;
+        } else if (a[k] != b[k]) {  // -0 == +0
+            return false;
+        }
+    }
+    return true;
+}
+size_t
+MeshWeld_CalculateRequiredSize (UINT nvtx, UINT stride) {
+    (void)stride;   // candidates are compared against the compacted copies, no keys are kept
+    return
+        2 * sizeof(uint32_t) * (size_t)table_capacity(nvtx) +   // table (vertex, hash)
+        sizeof(uint32_t) * (size_t)nvtx;                    // remap
+}
+UINT
+MeshWeld_Weld (
+    BYTE * memory,
+    void * vertices, UINT nvtx, UINT stride,
+    uint32_t indices [], UINT nidx,
+    MeshWeldSettings const & settings,
+    UINT * out_nidx
+) {
+    _ASSERT_EXPR(stride >= 3 * sizeof(float) && 0 == stride % sizeof(float), "Vertex stride must be a multiple of 4 and hold a position");
+
+    UINT nfloat = stride / sizeof(float);
+    UINT cap = table_capacity(nvtx);
+    UINT mask = cap - 1;
+
+    // Setup pointers (arrays)
+    // table slots hold the vertex next to its hash, so most probes touch a single cache line
+    uint32_t * table = reinterpret_cast<uint32_t *>(memory);
+    uint32_t * remap = table + 2 * (size_t)cap;
+    memset(table, 0xff, 2 * sizeof(uint32_t) * (size_t)cap);
+
+    // -- cells are twice the tolerance wide: a vertex within tolerance is either in the same cell
+    // or in the neighbour on the side of the nearer cell boundary, so 2 cells per axis (8 in total) cover it.
+    // 0 tolerance hashes the bit pattern and probes a single cell.
+    float pos_tolerance = settings.position_tolerance;
+    float scale = pos_tolerance > 0.0f ? 0.5f / pos_tolerance : 0.0f;
+    UINT n_cells = scale > 0.0f ? 8 : 1;
+
+    BYTE * vtx = reinterpret_cast<BYTE *>(vertices);
+    UINT n_unique = 0;
+    for (UINT i = 0; i < nvtx; ++i) {
+        float const * src = reinterpret_cast<float const *>(vtx + (size_t)i * stride);
+        int32_t cell [3];
+        int32_t side [3];
+        for (UINT k = 0; k < 3; ++k) {
+            if (scale > 0.0f) {
+                float c = src[k] * scale;
+                cell[k] = quantize(c);
+                side[k] = (c - (float)cell[k]) < 0.5f ? -1 : 1;
+            } else {
+                float v = src[k] + 0.0f;    // -0 becomes +0
+                memcpy(&cell[k], &v, sizeof(float));
+                side[k] = 0;
+            }
+        }
+        uint32_t own_hash = hash_cell(cell);
+
+        // -- probe the own cell and its neighbours, the earliest vertex in tolerance wins
+        uint32_t match = WELD_EMPTY_SLOT;
+        for (UINT n = 0; n < n_cells; ++n) {
+            int32_t probe [3] = {
+                cell[0] + ((n & 1) ? side[0] : 0),
+                cell[1] + ((n & 2) ? side[1] : 0),
+                cell[2] + ((n & 4) ? side[2] : 0),
+            };
+            uint32_t h = 0 == n ? own_hash : hash_cell(probe);
+            // linear probing, a cell can hold several vertices (same position, different attributes)
+            for (UINT slot = h & mask; WELD_EMPTY_SLOT != table[2 * slot]; slot = (slot + 1) & mask) {
+                uint32_t rep = table[2 * slot];
+                if (table[2 * slot + 1] != h || rep >= match)
+                    continue;
+                float const * other = reinterpret_cast<float const *>(vtx + (size_t)remap[rep] * stride);
+                if (within(src, other, 0, 3, pos_tolerance) && within(src, other, 3, nfloat, settings.attribute_tolerance))
+                    match = rep;
+            }
+        }
+        if (WELD_EMPTY_SLOT != match) {
+            remap[i] = remap[match];
+            continue;
+        }
+
+        UINT slot = own_hash & mask;
+        while (WELD_EMPTY_SLOT != table[2 * slot])
+            slot = (slot + 1) & mask;
+        table[2 * slot] = i;
+        table[2 * slot + 1] = own_hash;
+        remap[i] = n_unique;
+        // compaction never overtakes the reader (n_unique <= i), survivors are compared in their new place
+        if (n_unique != i)
+            memcpy(vtx + (size_t)n_unique * stride, src, stride);
+        n_unique++;
+    }
+
+    // -- rewrite indices, optionally dropping collapsed triangles
+    UINT n_out = 0;
+    for (UINT t = 0; t + 2 < nidx; t += 3) {
+        uint32_t a = remap[indices[t + 0]];
+        uint32_t b = remap[indices[t + 1]];
+        uint32_t c = remap[indices[t + 2]];
+        if (settings.drop_degenerates && (a == b || b == c || c == a))
+            continue;
+        indices[n_out + 0] = a;
+        indices[n_out + 1] = b;
+        indices[n_out + 2] = c;
+        n_out += 3;
+    }
+    if (out_nidx)
+        *out_nidx = n_out;
+    return n_unique;
+}
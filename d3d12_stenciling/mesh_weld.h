@@ -0,0 +1,34 @@
+#pragma once
+
+#include "headers/common.h"
+
+// NOTE(omid): Vertex welding for imported/generated meshes.
+// Every vertex is read as stride / 4 floats: position (first 3 floats) and attributes (the rest).
+// Positions are snapped to a grid of cells twice the tolerance wide and the cell is hashed into an
+// open-addressing table (linear probing). A vertex probes its own cell and the 7 neighbours towards the
+// nearer cell boundaries, so pairs straddling a boundary are still found; the pass stays O(n).
+// A vertex merges into the earliest survivor whose position and attributes are all within tolerance
+// (per component), indices are remapped to the survivors.
+
+struct MeshWeldSettings {
+    float position_tolerance;       // 0 means exact match
+    float attribute_tolerance;      // normals, texcoords, ... (0 means exact match)
+    bool drop_degenerates;          // remove triangles that end up with repeated indices
+};
+
+size_t
+MeshWeld_CalculateRequiredSize (UINT nvtx, UINT stride);
+
+/*
+    Welds in place: unique vertices are compacted to the front of the vertex array and
+    indices (triangle list) are rewritten. memory is scratch space of MeshWeld_CalculateRequiredSize bytes.
+    Returns the new vertex count, out_nidx receives the new index count.
+*/
+UINT
+MeshWeld_Weld (
+    BYTE * memory,
+    void * vertices, UINT nvtx, UINT stride,
+    uint32_t indices [], UINT nidx,
+    MeshWeldSettings const & settings,
+    UINT * out_nidx
+);
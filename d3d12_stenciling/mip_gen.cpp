@@ -0,0 +1,607 @@
+#include "mip_gen.h"
+#include "headers/dds_loader.h"
+
+#include <DirectXPackedVector.h>
+#include <thread>
+
+using namespace DirectX;
+
+// -- pixel formats
+
+enum CHANNEL_TYPE {
+    CHANNEL_UNORM = 0,
+    CHANNEL_SNORM = 1,
+    CHANNEL_FLOAT = 2
+};
+enum PIXEL_PACKING {
+    PACKING_CHANNELS = 0,       // n_channels of channel_bytes each
+    PACKING_R10G10B10A2 = 1,
+    PACKING_B5G6R5 = 2,
+    PACKING_B5G5R5A1 = 3,
+    PACKING_B4G4R4A4 = 4
+};
+struct PixelFormat {
+    DXGI_FORMAT     format;
+    PIXEL_PACKING   packing;
+    UINT            n_channels;
+    UINT            channel_bytes;
+    CHANNEL_TYPE    type;
+    bool            bgra;       // channels stored as B, G, R, A
+    bool            srgb;
+    bool            alpha_only;
+};
+static PixelFormat const pixel_formats [] = {
+    {DXGI_FORMAT_R8G8B8A8_UNORM,        PACKING_CHANNELS, 4, 1, CHANNEL_UNORM, false, false, false},
+    {DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,   PACKING_CHANNELS, 4, 1, CHANNEL_UNORM, false, true, false},
+    {DXGI_FORMAT_R8G8B8A8_SNORM,        PACKING_CHANNELS, 4, 1, CHANNEL_SNORM, false, false, false},
+    {DXGI_FORMAT_B8G8R8A8_UNORM,        PACKING_CHANNELS, 4, 1, CHANNEL_UNORM, true, false, false},
+    {DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,   PACKING_CHANNELS, 4, 1, CHANNEL_UNORM, true, true, false},
+    {DXGI_FORMAT_B8G8R8X8_UNORM,        PACKING_CHANNELS, 4, 1, CHANNEL_UNORM, true, false, false},
+    {DXGI_FORMAT_B8G8R8X8_UNORM_SRGB,   PACKING_CHANNELS, 4, 1, CHANNEL_UNORM, true, true, false},
+    {DXGI_FORMAT_R8G8_UNORM,            PACKING_CHANNELS, 2, 1, CHANNEL_UNORM, false, false, false},
+    {DXGI_FORMAT_R8G8_SNORM,            PACKING_CHANNELS, 2, 1, CHANNEL_SNORM, false, false, false},
+    {DXGI_FORMAT_R8_UNORM,              PACKING_CHANNELS, 1, 1, CHANNEL_UNORM, false, false, false},
+    {DXGI_FORMAT_A8_UNORM,              PACKING_CHANNELS, 1, 1, CHANNEL_UNORM, false, false, true},
+    {DXGI_FORMAT_R16_UNORM,             PACKING_CHANNELS, 1, 2, CHANNEL_UNORM, false, false, false},
+    {DXGI_FORMAT_R16G16_UNORM,          PACKING_CHANNELS, 2, 2, CHANNEL_UNORM, false, false, false},
+    {DXGI_FORMAT_R16G16_SNORM,          PACKING_CHANNELS, 2, 2, CHANNEL_SNORM, false, false, false},
+    {DXGI_FORMAT_R16G16B16A16_UNORM,    PACKING_CHANNELS, 4, 2, CHANNEL_UNORM, false, false, false},
+    {DXGI_FORMAT_R16G16B16A16_SNORM,    PACKING_CHANNELS, 4, 2, CHANNEL_SNORM, false, false, false},
+    {DXGI_FORMAT_R16_FLOAT,             PACKING_CHANNELS, 1, 2, CHANNEL_FLOAT, false, false, false},
+    {DXGI_FORMAT_R16G16_FLOAT,          PACKING_CHANNELS, 2, 2, CHANNEL_FLOAT, false, false, false},
+    {DXGI_FORMAT_R16G16B16A16_FLOAT,    PACKING_CHANNELS, 4, 2, CHANNEL_FLOAT, false, false, false},
+    {DXGI_FORMAT_R32_FLOAT,             PACKING_CHANNELS, 1, 4, CHANNEL_FLOAT, false, false, false},
+    {DXGI_FORMAT_R32G32_FLOAT,          PACKING_CHANNELS, 2, 4, CHANNEL_FLOAT, false, false, false},
+    {DXGI_FORMAT_R32G32B32A32_FLOAT,    PACKING_CHANNELS, 4, 4, CHANNEL_FLOAT, false, false, false},
+    {DXGI_FORMAT_R10G10B10A2_UNORM,     PACKING_R10G10B10A2, 4, 0, CHANNEL_UNORM, false, false, false},
+    {DXGI_FORMAT_B5G6R5_UNORM,          PACKING_B5G6R5, 3, 0, CHANNEL_UNORM, true, false, false},
+    {DXGI_FORMAT_B5G5R5A1_UNORM,        PACKING_B5G5R5A1, 4, 0, CHANNEL_UNORM, true, false, false},
+    {DXGI_FORMAT_B4G4R4A4_UNORM,        PACKING_B4G4R4A4, 4, 0, CHANNEL_UNORM, true, false, false},
+};
+static PixelFormat const *
+find_pixel_format (DXGI_FORMAT format) {
+    for (UINT i = 0; i < _countof(pixel_formats); ++i)
+        if (pixel_formats[i].format == format)
+            return &pixel_formats[i];
+    return nullptr;
+}
+static UINT
+pixel_bytes (PixelFormat const * pf) {
+    switch (pf->packing) {
+    case PACKING_CHANNELS:      return pf->n_channels * pf->channel_bytes;
+    case PACKING_R10G10B10A2:   return 4;
+    default:                    return 2;
+    }
+}
+// Slot (0 = r ... 3 = a) of the i-th stored channel
+static UINT
+channel_slot (PixelFormat const * pf, UINT i) {
+    if (pf->alpha_only)
+        return 3;
+    return (pf->bgra && i < 3) ? 2 - i : i;
+}
+
+// Exact sRGB decode of the 256 8-bit values (magic static, built once)
+struct SrgbTable {
+    float to_linear[256];
+    SrgbTable () {
+        for (int i = 0; i < 256; ++i) {
+            float c = (float)i / 255.0f;
+            to_linear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+        }
+    }
+};
+static float const *
+srgb_to_linear_table () {
+    static SrgbTable const table;
+    return table.to_linear;
+}
+
+static float
+unpack_channel (BYTE const * src, CHANNEL_TYPE type, UINT channel_bytes) {
+    switch (channel_bytes) {
+    case 1:
+        return CHANNEL_SNORM == type ? fmaxf((float)(int8_t)src[0] / 127.0f, -1.0f) : (float)src[0] / 255.0f;
+    case 2: {
+        uint16_t v;
+        memcpy(&v, src, sizeof(v));
+        if (CHANNEL_FLOAT == type)
+            return PackedVector::XMConvertHalfToFloat(v);
+        return CHANNEL_SNORM == type ? fmaxf((float)(int16_t)v / 32767.0f, -1.0f) : (float)v / 65535.0f;
+    }
+    default: {
+        float v;
+        memcpy(&v, src, sizeof(v));
+        return v;
+    }
+    }
+}
+static void
+pack_channel (float v, CHANNEL_TYPE type, UINT channel_bytes, BYTE * dst) {
+    if (CHANNEL_UNORM == type)
+        v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+    else if (CHANNEL_SNORM == type)
+        v = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+    switch (channel_bytes) {
+    case 1:
+        if (CHANNEL_SNORM == type)
+            dst[0] = (BYTE)(int8_t)lrintf(v * 127.0f);
+        else
+            dst[0] = (BYTE)(v * 255.0f + 0.5f);
+        break;
+    case 2: {
+        uint16_t u;
+        if (CHANNEL_FLOAT == type)
+            u = PackedVector::XMConvertFloatToHalf(v);
+        else if (CHANNEL_SNORM == type)
+            u = (uint16_t)(int16_t)lrintf(v * 32767.0f);
+        else
+            u = (uint16_t)(v * 65535.0f + 0.5f);
+        memcpy(dst, &u, sizeof(u));
+    } break;
+    default:
+        memcpy(dst, &v, sizeof(v));
+        break;
+    }
+}
+static uint32_t
+quantize (float v, uint32_t max_value) {
+    v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+    return (uint32_t)(v * (float)max_value + 0.5f);
+}
+static void
+unpack_row (PixelFormat const * pf, bool srgb, BYTE const * src, UINT width, XMFLOAT4A * dst) {
+    float const * to_linear = srgb_to_linear_table();
+    UINT stride = pixel_bytes(pf);
+    for (UINT x = 0; x < width; ++x, src += stride) {
+        float c[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        if (PACKING_CHANNELS == pf->packing) {
+            for (UINT i = 0; i < pf->n_channels; ++i) {
+                UINT slot = channel_slot(pf, i);
+                if (srgb && slot < 3)
+                    c[slot] = to_linear[src[i]];
+                else
+                    c[slot] = unpack_channel(src + (size_t)i * pf->channel_bytes, pf->type, pf->channel_bytes);
+            }
+        } else if (PACKING_R10G10B10A2 == pf->packing) {
+            uint32_t v;
+            memcpy(&v, src, sizeof(v));
+            c[0] = (float)(v & 0x3ff) / 1023.0f;
+            c[1] = (float)((v >> 10) & 0x3ff) / 1023.0f;
+            c[2] = (float)((v >> 20) & 0x3ff) / 1023.0f;
+            c[3] = (float)(v >> 30) / 3.0f;
+        } else {
+            uint16_t v;
+            memcpy(&v, src, sizeof(v));
+            if (PACKING_B5G6R5 == pf->packing) {
+                c[2] = (float)(v & 0x1f) / 31.0f;
+                c[1] = (float)((v >> 5) & 0x3f) / 63.0f;
+                c[0] = (float)(v >> 11) / 31.0f;
+            } else if (PACKING_B5G5R5A1 == pf->packing) {
+                c[2] = (float)(v & 0x1f) / 31.0f;
+                c[1] = (float)((v >> 5) & 0x1f) / 31.0f;
+                c[0] = (float)((v >> 10) & 0x1f) / 31.0f;
+                c[3] = (float)(v >> 15);
+            } else {
+                c[2] = (float)(v & 0xf) / 15.0f;
+                c[1] = (float)((v >> 4) & 0xf) / 15.0f;
+                c[0] = (float)((v >> 8) & 0xf) / 15.0f;
+                c[3] = (float)(v >> 12) / 15.0f;
+            }
+        }
+        dst[x] = XMFLOAT4A(c[0], c[1], c[2], c[3]);
+    }
+}
+static void
+pack_row (PixelFormat const * pf, bool srgb, XMFLOAT4A const * src, UINT width, BYTE * dst) {
+    UINT stride = pixel_bytes(pf);
+    for (UINT x = 0; x < width; ++x, dst += stride) {
+        XMFLOAT4A c = src[x];
+        if (srgb)
+            XMStoreFloat4A(&c, XMColorRGBToSRGB(XMVectorSaturate(XMLoadFloat4A(&src[x]))));
+        float const * v = &c.x;
+        if (PACKING_CHANNELS == pf->packing) {
+            for (UINT i = 0; i < pf->n_channels; ++i)
+                pack_channel(v[channel_slot(pf, i)], pf->type, pf->channel_bytes, dst + (size_t)i * pf->channel_bytes);
+        } else if (PACKING_R10G10B10A2 == pf->packing) {
+            uint32_t p = quantize(v[0], 1023) | (quantize(v[1], 1023) << 10) | (quantize(v[2], 1023) << 20) | (quantize(v[3], 3) << 30);
+            memcpy(dst, &p, sizeof(p));
+        } else {
+            uint32_t p;
+            if (PACKING_B5G6R5 == pf->packing)
+                p = quantize(v[2], 31) | (quantize(v[1], 63) << 5) | (quantize(v[0], 31) << 11);
+            else if (PACKING_B5G5R5A1 == pf->packing)
+                p = quantize(v[2], 31) | (quantize(v[1], 31) << 5) | (quantize(v[0], 31) << 10) | (quantize(v[3], 1) << 15);
+            else
+                p = quantize(v[2], 15) | (quantize(v[1], 15) << 4) | (quantize(v[0], 15) << 8) | (quantize(v[3], 15) << 12);
+            uint16_t p16 = (uint16_t)p;
+            memcpy(dst, &p16, sizeof(p16));
+        }
+    }
+}
+
+// -- resampling
+
+// Taps of one axis: destination texel i reads indices[i * n_taps + k] with weights[i * n_taps + k]
+struct FilterTaps {
+    UINT        n_taps;
+    UINT *      indices;
+    float *     weights;
+};
+static float
+bessel_i0 (float x) {
+    // power series, converges quickly for the alphas used here
+    float sum = 1.0f;
+    float term = 1.0f;
+    float half_x2 = 0.25f * x * x;
+    for (int k = 1; k < 32 && term > 1e-8f * sum; ++k) {
+        term *= half_x2 / (float)(k * k);
+        sum += term;
+    }
+    return sum;
+}
+static float
+kaiser_sinc (float t) {
+    // t in destination texels
+    float u = t / MIPGEN_KAISER_RADIUS;
+    if (u <= -1.0f || u >= 1.0f)
+        return 0.0f;
+    float sinc = fabsf(t) < 1e-6f ? 1.0f : sinf(XM_PI * t) / (XM_PI * t);
+    return sinc * bessel_i0(MIPGEN_KAISER_ALPHA * sqrtf(1.0f - u * u)) / bessel_i0(MIPGEN_KAISER_ALPHA);
+}
+static UINT
+max_taps (MIPGEN_FILTER filter, UINT src_size, UINT dst_size) {
+    float scale = (float)src_size / (float)dst_size;
+    float radius = (MIPGEN_FILTER_BOX == filter ? 0.5f : MIPGEN_KAISER_RADIUS) * scale;
+    return (UINT)ceilf(2.0f * radius) + 2;
+}
+static void
+compute_taps (MIPGEN_FILTER filter, bool wrap, UINT src_size, UINT dst_size, FilterTaps * taps) {
+    float scale = (float)src_size / (float)dst_size;
+    float radius = (MIPGEN_FILTER_BOX == filter ? 0.5f : MIPGEN_KAISER_RADIUS) * scale;
+    for (UINT i = 0; i < dst_size; ++i) {
+        UINT * indices = taps->indices + (size_t)i * taps->n_taps;
+        float * weights = taps->weights + (size_t)i * taps->n_taps;
+        float center = ((float)i + 0.5f) * scale;
+        int first = (int)floorf(center - radius);
+        float sum = 0.0f;
+        for (UINT k = 0; k < taps->n_taps; ++k) {
+            int s = first + (int)k;
+            float w;
+            if (MIPGEN_FILTER_BOX == filter) {
+                // -- overlap of the source texel [s, s + 1] with the box
+                float lo = fmaxf((float)s, center - radius);
+                float hi = fminf((float)s + 1.0f, center + radius);
+                w = hi > lo ? hi - lo : 0.0f;
+            } else {
+                w = kaiser_sinc(((float)s + 0.5f - center) / scale);
+            }
+            if (wrap)
+                s = ((s % (int)src_size) + (int)src_size) % (int)src_size;
+            else
+                s = s < 0 ? 0 : (s >= (int)src_size ? (int)src_size - 1 : s);
+            indices[k] = (UINT)s;
+            weights[k] = w;
+            sum += w;
+        }
+        for (UINT k = 0; k < taps->n_taps; ++k)
+            weights[k] /= sum;
+    }
+}
+
+// One level: src (src_w x src_h) -> tmp (dst_w x src_h) -> dst (dst_w x dst_h) -> packed
+struct LevelJob {
+    PixelFormat const *     pf;
+    bool                    srgb;
+
+    BYTE const *            packed_src;     // top level only
+    size_t                  packed_src_pitch;
+    XMFLOAT4A *             src;
+    UINT                    src_w;
+    XMFLOAT4A *             tmp;
+    XMFLOAT4A *             dst;
+    UINT                    dst_w;
+    FilterTaps              taps_x;
+    FilterTaps              taps_y;
+    BYTE *                  packed_dst;
+    size_t                  packed_dst_pitch;
+};
+static void
+unpack_rows (LevelJob const * job, UINT first_row, UINT last_row) {
+    for (UINT y = first_row; y < last_row; ++y)
+        unpack_row(job->pf, job->srgb, job->packed_src + job->packed_src_pitch * y, job->src_w, job->src + (size_t)job->src_w * y);
+}
+static void
+filter_rows_x (LevelJob const * job, UINT first_row, UINT last_row) {
+    UINT n_taps = job->taps_x.n_taps;
+    for (UINT y = first_row; y < last_row; ++y) {
+        XMFLOAT4A const * src = job->src + (size_t)job->src_w * y;
+        XMFLOAT4A * dst = job->tmp + (size_t)job->dst_w * y;
+        for (UINT x = 0; x < job->dst_w; ++x) {
+            UINT const * indices = job->taps_x.indices + (size_t)x * n_taps;
+            float const * weights = job->taps_x.weights + (size_t)x * n_taps;
+            XMVECTOR acc = XMVectorZero();
+            for (UINT k = 0; k < n_taps; ++k)
+                acc = XMVectorMultiplyAdd(XMLoadFloat4A(&src[indices[k]]), XMVectorReplicate(weights[k]), acc);
+            XMStoreFloat4A(&dst[x], acc);
+        }
+    }
+}
+static void
+filter_rows_y (LevelJob const * job, UINT first_row, UINT last_row) {
+    UINT n_taps = job->taps_y.n_taps;
+    for (UINT y = first_row; y < last_row; ++y) {
+        UINT const * indices = job->taps_y.indices + (size_t)y * n_taps;
+        float const * weights = job->taps_y.weights + (size_t)y * n_taps;
+        XMFLOAT4A * dst = job->dst + (size_t)job->dst_w * y;
+        // -- whole rows at a time, the source rows are read front to back
+        for (UINT x = 0; x < job->dst_w; ++x)
+            XMStoreFloat4A(&dst[x], XMVectorZero());
+        for (UINT k = 0; k < n_taps; ++k) {
+            XMFLOAT4A const * src = job->tmp + (size_t)job->dst_w * indices[k];
+            XMVECTOR w = XMVectorReplicate(weights[k]);
+            for (UINT x = 0; x < job->dst_w; ++x)
+                XMStoreFloat4A(&dst[x], XMVectorMultiplyAdd(XMLoadFloat4A(&src[x]), w, XMLoadFloat4A(&dst[x])));
+        }
+        pack_row(job->pf, job->srgb, dst, job->dst_w, job->packed_dst + job->packed_dst_pitch * y);
+    }
+}
+static UINT
+thread_count (UINT n_rows, UINT row_texels, UINT max_threads) {
+    UINT n = (UINT)(((uint64_t)n_rows * row_texels) / MIPGEN_MIN_TEXELS_PER_THREAD);
+    if (n > n_rows)
+        n = n_rows;
+    return n < 1 ? 1 : (n > max_threads ? max_threads : n);
+}
+// Contiguous row ranges, thread 0 is the caller
+static void
+run_rows (void (*fn)(LevelJob const *, UINT, UINT), LevelJob const * job, UINT n_rows, UINT n_threads) {
+    std::thread threads[MIPGEN_MAX_THREADS];
+    for (UINT i = 1; i < n_threads; ++i)
+        threads[i] = std::thread(fn, job, (UINT)((uint64_t)n_rows * i / n_threads), (UINT)((uint64_t)n_rows * (i + 1) / n_threads));
+    fn(job, 0, (UINT)((uint64_t)n_rows / n_threads));
+    for (UINT i = 1; i < n_threads; ++i)
+        threads[i].join();
+}
+
+bool
+MipGen_IsSupported (DXGI_FORMAT format) {
+    return nullptr != find_pixel_format(format);
+}
+size_t
+MipGen_CalculateOutputSize (DXGI_FORMAT format, UINT width, UINT height, UINT mip_count) {
+    PixelFormat const * pf = find_pixel_format(format);
+    if (nullptr == pf)
+        return 0;
+    size_t ret = 0;
+    for (UINT i = 1; i < mip_count; ++i) {
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        ret += (size_t)width * height * pixel_bytes(pf);
+    }
+    return ret;
+}
+bool
+MipGen_Generate (
+    DXGI_FORMAT format, UINT width, UINT height,
+    BYTE const * mip0, size_t mip0_row_pitch,
+    UINT mip_count, MipGenSettings const & settings,
+    BYTE * out_mips
+) {
+    _ASSERT_EXPR(mip_count >= 1 && mip_count <= CountMips(width, height), "Invalid mip count");
+    PixelFormat const * pf = find_pixel_format(format);
+    if (nullptr == pf)
+        return false;
+    if (mip_count < 2)
+        return true;
+
+    UINT max_threads = settings.n_threads > 0 ? settings.n_threads : std::thread::hardware_concurrency();
+    if (max_threads < 1)
+        max_threads = 1;
+    if (max_threads > MIPGEN_MAX_THREADS)
+        max_threads = MIPGEN_MAX_THREADS;
+
+    // -- float levels ping-pong between a (big enough for the top) and b (for the first mip), tmp holds the horizontal pass
+    UINT w1 = width > 1 ? width / 2 : 1;
+    UINT h1 = height > 1 ? height / 2 : 1;
+    UINT taps_max = max_taps(settings.filter, 3, 1);    // 3 -> 1 is the largest ratio of any level
+    size_t level_a_size = sizeof(XMFLOAT4A) * width * height;
+    size_t level_b_size = sizeof(XMFLOAT4A) * w1 * h1;
+    size_t tmp_size = sizeof(XMFLOAT4A) * w1 * height;
+    size_t taps_size = (sizeof(UINT) + sizeof(float)) * taps_max * ((size_t)w1 + h1);
+    BYTE * memory = (BYTE *)::malloc(level_a_size + level_b_size + tmp_size + taps_size);
+    if (nullptr == memory)
+        return false;
+    XMFLOAT4A * level_a = reinterpret_cast<XMFLOAT4A *>(memory);
+    XMFLOAT4A * level_b = reinterpret_cast<XMFLOAT4A *>(memory + level_a_size);
+    XMFLOAT4A * tmp = reinterpret_cast<XMFLOAT4A *>(memory + level_a_size + level_b_size);
+    float * tap_weights = reinterpret_cast<float *>(memory + level_a_size + level_b_size + tmp_size);
+    UINT * tap_indices = reinterpret_cast<UINT *>(tap_weights + (size_t)taps_max * (w1 + h1));
+
+    LevelJob job = {};
+    job.pf = pf;
+    job.srgb = pf->srgb || (settings.srgb && CHANNEL_UNORM == pf->type && 1 == pf->channel_bytes && pf->n_channels >= 3);
+    job.packed_src = mip0;
+    job.packed_src_pitch = mip0_row_pitch;
+    job.src = level_a;
+    job.src_w = width;
+    run_rows(unpack_rows, &job, height, thread_count(height, width, max_threads));
+
+    UINT src_h = height;
+    BYTE * packed = out_mips;
+    for (UINT mip = 1; mip < mip_count; ++mip) {
+        UINT dst_w = job.src_w > 1 ? job.src_w / 2 : 1;
+        UINT dst_h = src_h > 1 ? src_h / 2 : 1;
+        job.tmp = tmp;
+        job.dst = (job.src == level_a) ? level_b : level_a;
+        job.dst_w = dst_w;
+        job.taps_x.n_taps = max_taps(settings.filter, job.src_w, dst_w);
+        job.taps_x.weights = tap_weights;
+        job.taps_x.indices = tap_indices;
+        job.taps_y.n_taps = max_taps(settings.filter, src_h, dst_h);
+        job.taps_y.weights = tap_weights + (size_t)job.taps_x.n_taps * dst_w;
+        job.taps_y.indices = tap_indices + (size_t)job.taps_x.n_taps * dst_w;
+        compute_taps(settings.filter, settings.wrap, job.src_w, dst_w, &job.taps_x);
+        compute_taps(settings.filter, settings.wrap, src_h, dst_h, &job.taps_y);
+        job.packed_dst = packed;
+        job.packed_dst_pitch = (size_t)dst_w * pixel_bytes(pf);
+
+        run_rows(filter_rows_x, &job, src_h, thread_count(src_h, dst_w, max_threads));
+        run_rows(filter_rows_y, &job, dst_h, thread_count(dst_h, dst_w, max_threads));
+
+        packed += job.packed_dst_pitch * dst_h;
+        job.src = job.dst;
+        job.src_w = dst_w;
+        src_h = dst_h;
+    }
+    ::free(memory);
+    return true;
+}
+
+// -- DDS baking
+
+// Top mip of a DDS the generator can extend, false if there's nothing to do or it's not supported
+static bool
+parse_bakeable_dds (
+    BYTE const * dds_data, size_t dds_size,
+    DXGI_FORMAT * out_format, DDS_HEADER const ** out_header, uint8_t const ** out_bits, size_t * out_row_bytes
+) {
+    DDS_HEADER const * header = nullptr;
+    uint8_t const * bit_data = nullptr;
+    size_t bit_size = 0;
+    if (FAILED(LoadTextureDataFromMemory(dds_data, dds_size, &header, &bit_data, &bit_size)))
+        return false;
+    if (header->mipMapCount > 1 || 0 == header->width || 0 == header->height ||
+        header->width > D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION || header->height > D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION)
+        return false;
+
+    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    if ((header->ddspf.flags & DDS_FOURCC) && (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC)) {
+        DDS_HEADER_DXT10 const * d3d10ext = reinterpret_cast<DDS_HEADER_DXT10 const *>(header + 1);
+        if (1 != d3d10ext->arraySize || D3D12_RESOURCE_DIMENSION_TEXTURE2D != d3d10ext->resourceDimension ||
+            (d3d10ext->miscFlag & 0x4 /* RESOURCE_MISC_TEXTURECUBE */))
+            return false;
+        format = d3d10ext->dxgiFormat;
+    } else {
+        if ((header->flags & DDS_HEADER_FLAGS_VOLUME) || (header->caps2 & DDS_CUBEMAP))
+            return false;
+        format = GetDXGIFormat(header->ddspf);
+    }
+    if (!MipGen_IsSupported(format) && !BCCodec_IsSupported(format))
+        return false;
+
+    size_t n_bytes = 0;
+    size_t row_bytes = 0;
+    size_t n_rows = 0;
+    if (FAILED(GetSurfaceInfo(header->width, header->height, format, &n_bytes, &row_bytes, &n_rows)) || bit_size < n_bytes)
+        return false;
+    *out_format = format;
+    *out_header = header;
+    *out_bits = bit_data;
+    *out_row_bytes = row_bytes;
+    return true;
+}
+// Bytes of mips [1, mip_count) of a block compressed texture
+static size_t
+compressed_mips_size (DXGI_FORMAT format, UINT width, UINT height, UINT mip_count) {
+    size_t ret = 0;
+    for (UINT i = 1; i < mip_count; ++i) {
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        ret += BCCodec_CalculateSize(format, width, height);
+    }
+    return ret;
+}
+// Decodes the top mip, generates the chain uncompressed and encodes mips [1, mip_count)
+static bool
+generate_compressed_mips (
+    DXGI_FORMAT format, UINT width, UINT height,
+    BYTE const * mip0_blocks, UINT mip_count, MipGenSettings const & settings,
+    BYTE * out_mips
+) {
+    DXGI_FORMAT image_format = BCCodec_GetImageFormat(format);
+    size_t image_size = (size_t)width * height * 4;
+    size_t mips_size = MipGen_CalculateOutputSize(image_format, width, height, mip_count);
+    BYTE * memory = (BYTE *)::malloc(image_size + mips_size);
+    if (nullptr == memory)
+        return false;
+    BYTE * image = memory;
+    BYTE * mips = memory + image_size;
+
+    // -- BC4/BC5 are data, not colors
+    MipGenSettings image_settings = settings;
+    if (DXGI_FORMAT_R8G8B8A8_UNORM_SRGB != image_format &&
+        DXGI_FORMAT_BC1_UNORM != format && DXGI_FORMAT_BC3_UNORM != format)
+        image_settings.srgb = false;
+    BCSettings bc_settings = {};
+    bc_settings.quality = settings.bc_quality;
+    bc_settings.n_threads = settings.n_threads;
+
+    bool ret =
+        BCCodec_Decode(format, width, height, mip0_blocks, image, (size_t)width * 4, settings.n_threads) &&
+        MipGen_Generate(image_format, width, height, image, (size_t)width * 4, mip_count, image_settings, mips);
+    for (UINT i = 1; ret && i < mip_count; ++i) {
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        ret = BCCodec_Encode(format, width, height, mips, (size_t)width * 4, bc_settings, out_mips);
+        mips += (size_t)width * height * 4;
+        out_mips += BCCodec_CalculateSize(format, width, height);
+    }
+    ::free(memory);
+    return ret;
+}
+bool
+MipGen_CanBake (BYTE const * dds_data, size_t dds_size) {
+    DXGI_FORMAT format;
+    DDS_HEADER const * header;
+    uint8_t const * bits;
+    size_t row_bytes;
+    return parse_bakeable_dds(dds_data, dds_size, &format, &header, &bits, &row_bytes);
+}
+bool
+MipGen_BakeDDS (char const * path, BYTE const * dds_data, size_t dds_size, MipGenSettings const & settings) {
+    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    DDS_HEADER const * src_header = nullptr;
+    uint8_t const * bits = nullptr;
+    size_t row_bytes = 0;
+    if (!parse_bakeable_dds(dds_data, dds_size, &format, &src_header, &bits, &row_bytes))
+        return false;
+
+    UINT width = src_header->width;
+    UINT height = src_header->height;
+    UINT mip_count = CountMips(width, height);
+    bool compressed = BCCodec_IsSupported(format);
+    size_t headers_size = (size_t)(bits - dds_data);
+    size_t mip0_size = compressed ? BCCodec_CalculateSize(format, width, height) : row_bytes * height;
+    size_t mips_size = compressed ?
+        compressed_mips_size(format, width, height, mip_count) :
+        MipGen_CalculateOutputSize(format, width, height, mip_count);
+    BYTE * out = (BYTE *)::malloc(headers_size + mip0_size + mips_size);
+    if (nullptr == out)
+        return false;
+
+    // -- same headers, now advertising the chain
+    memcpy(out, dds_data, headers_size + mip0_size);
+    DDS_HEADER * header = reinterpret_cast<DDS_HEADER *>(out + sizeof(uint32_t));
+    header->mipMapCount = mip_count;
+    header->flags |= 0x20000;           // DDSD_MIPMAPCOUNT
+    header->caps |= 0x8 | 0x400000;     // DDSCAPS_COMPLEX | DDSCAPS_MIPMAP
+
+    bool ret = compressed ?
+        generate_compressed_mips(format, width, height, bits, mip_count, settings, out + headers_size + mip0_size) :
+        MipGen_Generate(format, width, height, bits, row_bytes, mip_count, settings, out + headers_size + mip0_size);
+    FILE * f = nullptr;
+    if (ret && (0 != fopen_s(&f, path, "wb") || nullptr == f))
+        ret = false;
+    if (f) {
+        size_t size = headers_size + mip0_size + mips_size;
+        if (fwrite(out, 1, size, f) != size)
+            ret = false;
+        if (0 != fclose(f))
+            ret = false;
+        if (!ret)
+            remove(path);   // never leave a truncated file behind
+    }
+    ::free(out);
+    return ret;
+}
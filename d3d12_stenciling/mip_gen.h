@@ -0,0 +1,72 @@
+#pragma once
+
+#include "headers/common.h"
+#include "bc_codec.h"
+
+// NOTE(omid): CPU mip chain generation for uncompressed textures authored without mips.
+// Each level is made from the previous one (kept in float, so quantization doesn't accumulate):
+//  1. the source rows are unpacked to linear RGBA floats (8-bit sRGB colors go through a LUT)
+//  2. a separable resampler runs horizontally then vertically, one XMVECTOR per texel; taps and weights
+//     are computed once per level and axis, so odd sizes (e.g., 5 -> 2) are filtered correctly too
+//  3. the result is converted back (to sRGB where needed) and packed into the format
+// Every pass is split into contiguous row ranges over threads (thread 0 is the caller).
+//
+// Filters:
+//  - box:      average of the source texels under the destination texel (2x2 for even sizes)
+//  - kaiser:   sinc windowed by a Kaiser window (MIPGEN_KAISER_RADIUS destination texels, alpha MIPGEN_KAISER_ALPHA),
+//              sharper than the box, negative lobes are clamped for normalized formats
+// Alpha is filtered as is (not premultiplied).
+//
+// Block compressed textures (the formats bc_codec supports) are baked by decoding the top mip,
+// generating the chain on the decoded R8G8B8A8 image and encoding every new mip; the top mip
+// is copied as is. BC4/BC5 are data, so they're never treated as sRGB.
+
+#define MIPGEN_VERSION                  2u      // bump when the output changes, baked textures are regenerated
+#define MIPGEN_MAX_THREADS              16
+#define MIPGEN_MIN_TEXELS_PER_THREAD    (64 * 1024)
+#define MIPGEN_KAISER_RADIUS            3.0f
+#define MIPGEN_KAISER_ALPHA             4.0f
+
+enum MIPGEN_FILTER : uint32_t {
+    MIPGEN_FILTER_BOX = 0,
+    MIPGEN_FILTER_KAISER = 1
+};
+
+struct MipGenSettings {
+    MIPGEN_FILTER   filter;
+    bool            wrap;       // tiling texture: taps wrap around the edges (clamped otherwise)
+    bool            srgb;       // 8-bit UNORM colors are sRGB even if the format isn't *_SRGB
+    UINT            n_threads;  // 0 means hardware concurrency
+    BC_QUALITY      bc_quality; // encoder quality of the generated mips of block compressed textures
+};
+
+// 8/16/32-bit UNORM, SNORM and FLOAT formats, R10G10B10A2 and the 16-bit packed ones
+bool
+MipGen_IsSupported (DXGI_FORMAT format);
+
+// Bytes of mips [1, mip_count) with tightly packed rows, back to back (what MipGen_Generate writes)
+size_t
+MipGen_CalculateOutputSize (DXGI_FORMAT format, UINT width, UINT height, UINT mip_count);
+
+/*
+    Generates mips [1, mip_count) of a texture from its top mip (mip0_row_pitch bytes between rows).
+    mip_count is at most the full chain of width x height. Returns false if the format isn't supported.
+*/
+bool
+MipGen_Generate (
+    DXGI_FORMAT format, UINT width, UINT height,
+    BYTE const * mip0, size_t mip0_row_pitch,
+    UINT mip_count, MipGenSettings const & settings,
+    BYTE * out_mips
+);
+
+// True if the DDS file is a single 2D texture of a supported (or BC codec supported) format with only its top mip
+bool
+MipGen_CanBake (BYTE const * dds_data, size_t dds_size);
+
+/*
+    Writes the DDS file to path with a full mip chain generated from its top mip.
+    Returns false (and leaves no file behind) if it can't be baked or written.
+*/
+bool
+MipGen_BakeDDS (char const * path, BYTE const * dds_data, size_t dds_size, MipGenSettings const & settings);
@@ -0,0 +1,135 @@
+// NOTE(omid): CPU test of the mip chain generator (MipGen_Generate), no device needed.
+// Gradients go through the box and Kaiser filters: every level keeps the average of the top mip and stays a gradient.
+// sRGB colors are filtered in linear space, and a constant image comes back unchanged from every level.
+// It's the mip_gen_test project of misc_d3d12.sln (console app), or from a developer command prompt in this folder:
+//      cl /nologo /std:c++latest /EHsc mip_gen_test.cpp mip_gen.cpp bc_codec.cpp && mip_gen_test.exe
+// It returns nonzero if a check fails.
+
+#include "mip_gen.h"
+
+static int n_fails = 0;
+#define CHECK(exp) do { if (!(exp)) { ::printf("[FAIL] %s at line %d. \n", #exp, __LINE__); ++n_fails; } } while (0)
+
+static UINT
+full_chain (UINT width, UINT height) {
+    UINT n = 1;
+    for (; width > 1 || height > 1; ++n) {
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return n;
+}
+static float
+channel_average (BYTE const * texels, UINT width, UINT height, UINT channel) {
+    double sum = 0.0;
+    for (UINT i = 0; i < width * height; ++i)
+        sum += texels[i * 4 + channel];
+    return (float)(sum / ((double)width * height));
+}
+// Red ramps along x, green along y, blue along the diagonal, alpha is opaque
+static void
+fill_gradient (BYTE * texels, UINT width, UINT height) {
+    for (UINT y = 0; y < height; ++y) {
+        for (UINT x = 0; x < width; ++x) {
+            BYTE * texel = &texels[(y * width + x) * 4];
+            texel[0] = (BYTE)(x * 255 / (width - 1));
+            texel[1] = (BYTE)(y * 255 / (height - 1));
+            texel[2] = (BYTE)((x + y) * 255 / (width + height - 2));
+            texel[3] = 255;
+        }
+    }
+}
+
+static void
+test_gradient (MIPGEN_FILTER filter, float max_average_error) {
+    UINT const width = 64, height = 32;
+    UINT mip_count = full_chain(width, height);
+    BYTE * mip0 = (BYTE *)::malloc(width * height * 4);
+    BYTE * mips = (BYTE *)::malloc(MipGen_CalculateOutputSize(DXGI_FORMAT_R8G8B8A8_UNORM, width, height, mip_count));
+    fill_gradient(mip0, width, height);
+
+    MipGenSettings settings = {};
+    settings.filter = filter;
+    settings.n_threads = 1;
+    CHECK(MipGen_Generate(DXGI_FORMAT_R8G8B8A8_UNORM, width, height, mip0, width * 4, mip_count, settings, mips));
+
+    BYTE const * level = mips;
+    UINT w = width, h = height;
+    for (UINT mip = 1; mip < mip_count; ++mip) {
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+        // -- every level averages out to the top mip (the ramps are symmetric about the center)
+        for (UINT c = 0; c < 4; ++c) {
+            float error = channel_average(level, w, h, c) - channel_average(mip0, width, height, c);
+            CHECK(error > -max_average_error && error < max_average_error);
+        }
+        // -- and is still a ramp along each axis
+        for (UINT y = 0; y < h; ++y)
+            for (UINT x = 1; x < w; ++x)
+                CHECK(level[(y * w + x) * 4] > level[(y * w + x - 1) * 4]);
+        for (UINT y = 1; y < h; ++y)
+            CHECK(level[y * w * 4 + 1] > level[(y - 1) * w * 4 + 1]);
+        level += (size_t)w * h * 4;
+    }
+    // -- a box level is the plain 2x2 average of the previous one
+    if (MIPGEN_FILTER_BOX == filter) {
+        for (UINT y = 0; y < height / 2; ++y) {
+            for (UINT x = 0; x < width / 2; ++x) {
+                for (UINT c = 0; c < 4; ++c) {
+                    UINT sum = 0;
+                    for (UINT i = 0; i < 4; ++i)
+                        sum += mip0[((2 * y + i / 2) * width + 2 * x + i % 2) * 4 + c];
+                    int diff = (int)mips[(y * (width / 2) + x) * 4 + c] - (int)((sum + 2) / 4);
+                    CHECK(diff >= -1 && diff <= 1);
+                }
+            }
+        }
+    }
+    ::free(mips);
+    ::free(mip0);
+}
+static void
+test_srgb_round_trip (MIPGEN_FILTER filter) {
+    UINT const width = 8, height = 4;
+    UINT mip_count = full_chain(width, height);
+    BYTE mip0 [width * height * 4];
+    BYTE mips [(4 * 2 + 2 * 1 + 1 * 1) * 4];
+    CHECK(sizeof(mips) == MipGen_CalculateOutputSize(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, width, height, mip_count));
+
+    MipGenSettings settings = {};
+    settings.filter = filter;
+    settings.n_threads = 1;
+    // -- every sRGB value goes to linear and back to itself
+    bool round_trip = true;
+    for (UINT v = 0; v < 256; ++v) {
+        ::memset(mip0, (int)v, sizeof(mip0));
+        CHECK(MipGen_Generate(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, width, height, mip0, width * 4, mip_count, settings, mips));
+        for (UINT i = 0; i < sizeof(mips); ++i)
+            round_trip = round_trip && v == mips[i];
+    }
+    CHECK(round_trip);
+
+    // -- black and white average to linear 0.5 (sRGB 188) in the color channels, alpha isn't sRGB
+    for (UINT i = 0; i < width * height; ++i)
+        ::memset(&mip0[i * 4], ((i % width + i / width) & 1) ? 255 : 0, 4);
+    CHECK(MipGen_Generate(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, width, height, mip0, width * 4, mip_count, settings, mips));
+    BYTE const * last = &mips[sizeof(mips) - 4];
+    CHECK(abs((int)last[0] - 188) <= 1 && abs((int)last[1] - 188) <= 1 && abs((int)last[2] - 188) <= 1);
+    CHECK(abs((int)last[3] - 128) <= 1);
+    // -- same image as plain UNORM: averaged as is
+    CHECK(MipGen_Generate(DXGI_FORMAT_R8G8B8A8_UNORM, width, height, mip0, width * 4, mip_count, settings, mips));
+    CHECK(abs((int)last[0] - 128) <= 1);
+}
+
+int
+main () {
+    test_gradient(MIPGEN_FILTER_BOX, 0.5f);
+    test_gradient(MIPGEN_FILTER_KAISER, 1.0f);
+    test_srgb_round_trip(MIPGEN_FILTER_BOX);
+    test_srgb_round_trip(MIPGEN_FILTER_KAISER);
+    if (n_fails)
+        ::printf("mip gen: %d checks failed \n", n_fails);
+    else
+        ::printf("mip gen: all checks passed \n");
+    return n_fails ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+#include "mip_streaming.h"
+#include "headers/dds_loader.h"
+
+#include <float.h>
+
+using namespace DirectX;
+
+bool
+MipStreaming_ParseLayout (BYTE const * header_data, size_t header_size, MipStreamingLayout * out) {
+    DDS_HEADER const * header = nullptr;
+    uint8_t const * bit_data = nullptr;
+    size_t bit_size = 0;
+    if (FAILED(LoadTextureDataFromMemory(header_data, header_size, &header, &bit_data, &bit_size)))
+        return false;
+
+    // -- same format/dimension rules as CreateTextureFromDDS, restricted to a single 2D texture
+    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    if ((header->ddspf.flags & DDS_FOURCC) && (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC)) {
+        DDS_HEADER_DXT10 const * d3d10ext = reinterpret_cast<DDS_HEADER_DXT10 const *>(header + 1);
+        if (1 != d3d10ext->arraySize || D3D12_RESOURCE_DIMENSION_TEXTURE2D != d3d10ext->resourceDimension ||
+            (d3d10ext->miscFlag & 0x4 /* RESOURCE_MISC_TEXTURECUBE */))
+            return false;
+        switch (d3d10ext->dxgiFormat) {
+        case DXGI_FORMAT_AI44:
+        case DXGI_FORMAT_IA44:
+        case DXGI_FORMAT_P8:
+        case DXGI_FORMAT_A8P8:
+            return false;
+        default:
+            break;
+        }
+        format = d3d10ext->dxgiFormat;
+    } else {
+        if ((header->flags & DDS_HEADER_FLAGS_VOLUME) || (header->caps2 & DDS_CUBEMAP))
+            return false;
+        format = GetDXGIFormat(header->ddspf);
+    }
+    // -- video and other multi-plane formats have more than one subresource per mip
+    DDS_FORMAT_TRAITS const & traits = GetFormatTraits(format);
+    if (0 == traits.bitsPerPixel || traits.planeCount > 1 || traits.depthStencil)
+        return false;
+
+    UINT mip_count = header->mipMapCount > 0 ? header->mipMapCount : 1;
+    if (mip_count > MIP_STREAMING_MAX_MIPS || 0 == header->width || 0 == header->height ||
+        header->width > D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION || header->height > D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION ||
+        mip_count > CountMips(header->width, header->height))
+        return false;
+
+    out->format = format;
+    out->width = header->width;
+    out->height = header->height;
+    out->mip_count = mip_count;
+    out->tail_mip = mip_count - 1;
+
+    // -- mips follow the headers back to back
+    uint64_t offset = (uint64_t)(bit_data - header_data);
+    UINT w = header->width;
+    UINT h = header->height;
+    for (UINT i = 0; i < mip_count; ++i) {
+        MipStreamingMip * mip = &out->mips[i];
+        size_t n_bytes = 0;
+        if (FAILED(GetSurfaceInfo(w, h, format, &n_bytes, &mip->row_bytes, &mip->n_rows)))
+            return false;
+        mip->offset = offset;
+        mip->size = n_bytes;
+        mip->width = w;
+        mip->height = h;
+        offset += n_bytes;
+
+        if (out->tail_mip == mip_count - 1 && (w > h ? w : h) <= MIP_STREAMING_TAIL_DIM)
+            out->tail_mip = i;
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+    }
+    return true;
+}
+UINT
+MipStreaming_DesiredMip (MipStreamingLayout const * layout, float uv_extent, float screen_extent) {
+    // -- one texel per pixel: every halving of texels over pixels is one mip further
+    float texels = (float)(layout->width > layout->height ? layout->width : layout->height) * uv_extent;
+    float ratio = screen_extent > 0.0f ? texels / screen_extent : FLT_MAX;
+    if (!(ratio > 1.0f))
+        return 0;
+    float mip = floorf(log2f(ratio));
+    return mip < (float)(layout->mip_count - 1) ? (UINT)mip : layout->mip_count - 1;
+}
+float
+MipStreaming_ScreenExtent (
+    XMFLOAT3 const & center, float radius,
+    XMFLOAT3 const & eye_pos, float proj_22, float viewport_height
+) {
+    float dist = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&center), XMLoadFloat3(&eye_pos))));
+    if (dist <= radius)
+        return FLT_MAX;
+    // -- NDC spans 2 units over the viewport height
+    return radius * proj_22 * viewport_height / dist;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "headers/common.h"
+
+// NOTE(omid): Progressive (mip tail first) loading of 2D DDS textures.
+// Mips are stored from the most detailed to the least detailed one, so the small mips at the end of
+// the file (the "tail", everything up to MIP_STREAMING_TAIL_DIM texels) can be read with one ranged read
+// and uploaded into a resource created with the full mip chain. Higher mips are then read one at a time,
+// coarse to fine, as far as the desired mip of the texture asks for. Until a mip lands, sampling is
+// clamped (ResourceMinLODClamp) to the most detailed resident mip so the empty mips are never read.
+// The desired mip comes from screen-space usage: texels the item spans vs. pixels it covers.
+//
+// The resource is a committed one, so memory for every mip is allocated up front; only the I/O, decode
+// and upload work is deferred. Arrays, cube maps, volumes and planar formats aren't streamed (the layout
+// parse fails and the caller loads the whole file instead).
+
+#define MIP_STREAMING_TAIL_DIM      64      // mips up to this size (largest side, in texels) come first
+#define MIP_STREAMING_MAX_MIPS      15      // D3D12_REQ_MIP_LEVELS
+#define MIP_STREAMING_HEADER_SIZE   148     // magic + DDS_HEADER + DDS_HEADER_DXT10, enough to parse any layout
+
+// Location of one mip in the DDS file (offset from the beginning of the file)
+struct MipStreamingMip {
+    uint64_t    offset;
+    size_t      size;
+    UINT        width;
+    UINT        height;
+    size_t      row_bytes;
+    size_t      n_rows;
+};
+
+struct MipStreamingLayout {
+    DXGI_FORMAT     format;
+    UINT            width;
+    UINT            height;
+    UINT            mip_count;
+    UINT            tail_mip;       // first mip of the tail (mip_count - 1 if even the last mip is bigger)
+    MipStreamingMip mips[MIP_STREAMING_MAX_MIPS];
+};
+
+/*
+    Parses the mip layout from the beginning of a DDS file (at least MIP_STREAMING_HEADER_SIZE bytes,
+    or the whole file if it's shorter). Returns false if the texture can't be streamed.
+*/
+bool
+MipStreaming_ParseLayout (BYTE const * header_data, size_t header_size, MipStreamingLayout * out);
+
+/*
+    Most detailed mip worth having for an item that spans uv_extent texture repeats (largest side)
+    and covers screen_extent pixels (largest side). Clamped to [0, mip_count - 1].
+*/
+UINT
+MipStreaming_DesiredMip (MipStreamingLayout const * layout, float uv_extent, float screen_extent);
+
+/*
+    Projected diameter (pixels) of a bounding sphere, proj_22 is the y scale of the projection matrix.
+    Returns FLT_MAX if the eye is inside the sphere.
+*/
+float
+MipStreaming_ScreenExtent (
+    DirectX::XMFLOAT3 const & center, float radius,
+    DirectX::XMFLOAT3 const & eye_pos, float proj_22, float viewport_height
+);
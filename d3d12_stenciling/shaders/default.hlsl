@@ -63,6 +63,7 @@ struct VertexShaderInput {
     float3 pos_local : POSITION;
     float3 normal_local : NORMAL;
     float2 texc : TEXCOORD;
+    float3 tangent_local : TANGENT;
 };
 struct VertexShaderOutput {
     float4 pos_homogenous_clip_space : SV_Position;
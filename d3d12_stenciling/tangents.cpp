@@ -0,0 +1,154 @@
+#include "tangents.h"
+
+#include <thread>
+
+using namespace DirectX;
+
+// per-vertex accumulator: tangent (xyz) and bitangent (xyz)
+#define ACCUM_FLOATS    6
+
+static XMVECTOR
+load_attribute (TangentMeshDesc const & mesh, uint32_t vtx, UINT offset) {
+    BYTE const * ptr = reinterpret_cast<BYTE const *>(mesh.vertices) + (size_t)vtx * mesh.stride + offset;
+    return XMLoadFloat3(reinterpret_cast<XMFLOAT3 const *>(ptr));
+}
+static XMVECTOR
+load_texc (TangentMeshDesc const & mesh, uint32_t vtx) {
+    BYTE const * ptr = reinterpret_cast<BYTE const *>(mesh.vertices) + (size_t)vtx * mesh.stride + mesh.texc_offset;
+    return XMLoadFloat2(reinterpret_cast<XMFLOAT2 const *>(ptr));
+}
+// projection of v onto the plane orthogonal to the unit vector n
+static XMVECTOR
+project_to_plane (FXMVECTOR v, FXMVECTOR n) {
+    return XMVectorSubtract(v, XMVectorMultiply(n, XMVector3Dot(n, v)));
+}
+static void
+accumulate_triangles (TangentMeshDesc const & mesh, UINT first_tri, UINT last_tri, float * accum) {
+    for (UINT t = first_tri; t < last_tri; ++t) {
+        uint32_t idx[3] = {mesh.indices[3 * t + 0], mesh.indices[3 * t + 1], mesh.indices[3 * t + 2]};
+        XMVECTOR p[3];
+        XMFLOAT2 uv[3];
+        for (int k = 0; k < 3; ++k) {
+            p[k] = load_attribute(mesh, idx[k], mesh.position_offset);
+            XMStoreFloat2(&uv[k], load_texc(mesh, idx[k]));
+        }
+
+        // -- tangent/bitangent of the triangle from texcoord derivatives (unnormalized, sign kept)
+        XMVECTOR e1 = XMVectorSubtract(p[1], p[0]);
+        XMVECTOR e2 = XMVectorSubtract(p[2], p[0]);
+        float du1 = uv[1].x - uv[0].x;
+        float dv1 = uv[1].y - uv[0].y;
+        float du2 = uv[2].x - uv[0].x;
+        float dv2 = uv[2].y - uv[0].y;
+        float det = du1 * dv2 - du2 * dv1;
+        if (fabsf(det) < 1e-12f)
+            continue;   // degenerate texture mapping, the triangle doesn't define a frame
+        float sign = det > 0.0f ? 1.0f : -1.0f;
+        // scaling by |det| instead of dividing keeps the direction and avoids blowing up tiny uv areas
+        XMVECTOR tri_t = XMVectorScale(XMVectorSubtract(XMVectorScale(e1, dv2), XMVectorScale(e2, dv1)), sign);
+        XMVECTOR tri_b = XMVectorScale(XMVectorSubtract(XMVectorScale(e2, du1), XMVectorScale(e1, du2)), sign);
+
+        for (int k = 0; k < 3; ++k) {
+            // -- corner angle weight
+            XMVECTOR a = XMVector3Normalize(XMVectorSubtract(p[(k + 1) % 3], p[k]));
+            XMVECTOR b = XMVector3Normalize(XMVectorSubtract(p[(k + 2) % 3], p[k]));
+            float cos_angle = XMVectorGetX(XMVector3Dot(a, b));
+            float weight = acosf(fmaxf(-1.0f, fminf(cos_angle, 1.0f)));
+
+            // -- project onto the tangent plane of the vertex before accumulating (as MikkTSpace does)
+            XMVECTOR n = XMVector3Normalize(load_attribute(mesh, idx[k], mesh.normal_offset));
+            XMVECTOR vt = project_to_plane(tri_t, n);
+            XMVECTOR vb = project_to_plane(tri_b, n);
+            float lt = XMVectorGetX(XMVector3Length(vt));
+            float lb = XMVectorGetX(XMVector3Length(vb));
+            if (!(weight > 0.0f) || lt < 1e-20f || lb < 1e-20f)
+                continue;
+            vt = XMVectorScale(vt, weight / lt);
+            vb = XMVectorScale(vb, weight / lb);
+
+            float * dst = accum + (size_t)idx[k] * ACCUM_FLOATS;
+            XMFLOAT3 ft, fb;
+            XMStoreFloat3(&ft, vt);
+            XMStoreFloat3(&fb, vb);
+            dst[0] += ft.x; dst[1] += ft.y; dst[2] += ft.z;
+            dst[3] += fb.x; dst[4] += fb.y; dst[5] += fb.z;
+        }
+    }
+}
+static void
+reduce_vertices (
+    TangentMeshDesc const & mesh, UINT first_vtx, UINT last_vtx,
+    float const * accum, UINT n_buffers, XMFLOAT4 out_tangents []
+) {
+    size_t buffer_floats = (size_t)mesh.nvtx * ACCUM_FLOATS;
+    for (UINT v = first_vtx; v < last_vtx; ++v) {
+        XMVECTOR t = XMVectorZero();
+        XMVECTOR b = XMVectorZero();
+        for (UINT i = 0; i < n_buffers; ++i) {
+            float const * src = accum + i * buffer_floats + (size_t)v * ACCUM_FLOATS;
+            t = XMVectorAdd(t, XMVectorSet(src[0], src[1], src[2], 0.0f));
+            b = XMVectorAdd(b, XMVectorSet(src[3], src[4], src[5], 0.0f));
+        }
+
+        // -- Gram-Schmidt against the normal, fall back to any orthogonal vector if nothing was accumulated
+        XMVECTOR n = XMVector3Normalize(load_attribute(mesh, v, mesh.normal_offset));
+        t = project_to_plane(t, n);
+        if (XMVectorGetX(XMVector3LengthSq(t)) < 1e-20f) {
+            XMVECTOR axis = fabsf(XMVectorGetX(n)) < 0.9f ? XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+            t = project_to_plane(axis, n);
+        }
+        t = XMVector3Normalize(t);
+        float w = XMVectorGetX(XMVector3Dot(XMVector3Cross(n, t), b)) < 0.0f ? -1.0f : 1.0f;
+
+        XMStoreFloat4(&out_tangents[v], XMVectorSetW(t, w));
+    }
+}
+UINT
+Tangents_ThreadCount (UINT ntri, UINT max_threads) {
+    if (0 == max_threads)
+        max_threads = std::thread::hardware_concurrency();
+    if (0 == max_threads)
+        max_threads = 1;
+    if (max_threads > TANGENTS_MAX_THREADS)
+        max_threads = TANGENTS_MAX_THREADS;
+    UINT n = ntri / TANGENTS_MIN_TRIS_PER_THREAD;
+    return n < 1 ? 1 : (n > max_threads ? max_threads : n);
+}
+size_t
+Tangents_CalculateRequiredSize (UINT nvtx, UINT n_threads) {
+    return sizeof(float) * ACCUM_FLOATS * (size_t)nvtx * n_threads;
+}
+void
+Tangents_Generate (BYTE * memory, TangentMeshDesc const & mesh, UINT n_threads, XMFLOAT4 out_tangents []) {
+    _ASSERT_EXPR(n_threads >= 1 && n_threads <= TANGENTS_MAX_THREADS, "Invalid tangent generator thread count");
+
+    float * accum = reinterpret_cast<float *>(memory);
+    memset(accum, 0, Tangents_CalculateRequiredSize(mesh.nvtx, n_threads));
+    size_t buffer_floats = (size_t)mesh.nvtx * ACCUM_FLOATS;
+    UINT ntri = mesh.nidx / 3;
+
+    // -- pass 1: triangles, thread i owns buffer i
+    // -- pass 2: vertices, thread i owns a vertex range and reads every buffer
+    std::thread threads[TANGENTS_MAX_THREADS];
+    for (UINT i = 1; i < n_threads; ++i) {
+        threads[i] = std::thread(
+            accumulate_triangles, std::cref(mesh),
+            (UINT)((uint64_t)ntri * i / n_threads), (UINT)((uint64_t)ntri * (i + 1) / n_threads),
+            accum + i * buffer_floats
+        );
+    }
+    accumulate_triangles(mesh, 0, (UINT)((uint64_t)ntri / n_threads), accum);
+    for (UINT i = 1; i < n_threads; ++i)
+        threads[i].join();
+
+    for (UINT i = 1; i < n_threads; ++i) {
+        threads[i] = std::thread(
+            reduce_vertices, std::cref(mesh),
+            (UINT)((uint64_t)mesh.nvtx * i / n_threads), (UINT)((uint64_t)mesh.nvtx * (i + 1) / n_threads),
+            accum, n_threads, out_tangents
+        );
+    }
+    reduce_vertices(mesh, 0, (UINT)((uint64_t)mesh.nvtx / n_threads), accum, n_threads, out_tangents);
+    for (UINT i = 1; i < n_threads; ++i)
+        threads[i].join();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "headers/common.h"
+
+// NOTE(omid): Tangent frame generation for indexed triangle meshes, following MikkTSpace conventions:
+// per-triangle tangent/bitangent from the texcoord derivatives are projected onto the tangent plane of each
+// corner normal, weighted by the corner angle and accumulated per vertex; the result is normalized
+// and w stores the bitangent sign (bitangent = w * cross(normal, tangent)).
+// Unlike the reference implementation, vertices are not split where the frames disagree (e.g., mirrored uvs),
+// run a weld with split attributes beforehand if that matters.
+//
+// Triangles are processed in parallel: every thread accumulates into its own per-vertex buffer
+// (no atomics or locks), then the buffers are reduced and finalized in parallel over vertex ranges.
+
+#define TANGENTS_MAX_THREADS            16
+#define TANGENTS_MIN_TRIS_PER_THREAD    8192
+
+// Strided view of the vertex attributes (offsets in bytes from the beginning of a vertex)
+struct TangentMeshDesc {
+    void const *        vertices;
+    UINT                nvtx;
+    UINT                stride;
+    UINT                position_offset;
+    UINT                normal_offset;
+    UINT                texc_offset;
+
+    uint32_t const *    indices;    // triangle list
+    UINT                nidx;
+};
+
+// Number of threads the generator uses for a mesh of ntri triangles (0 means hardware concurrency)
+UINT
+Tangents_ThreadCount (UINT ntri, UINT max_threads);
+
+size_t
+Tangents_CalculateRequiredSize (UINT nvtx, UINT n_threads);
+
+/*
+    Writes one tangent per vertex into out_tangents (xyz unit tangent, w = +1/-1 handedness).
+    memory is scratch space of Tangents_CalculateRequiredSize(nvtx, n_threads) bytes,
+    n_threads is usually Tangents_ThreadCount(nidx / 3, 0).
+*/
+void
+Tangents_Generate (BYTE * memory, TangentMeshDesc const & mesh, UINT n_threads, DirectX::XMFLOAT4 out_tangents []);
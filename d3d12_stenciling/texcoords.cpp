@@ -0,0 +1,209 @@
+#include "texcoords.h"
+
+#include <thread>
+
+using namespace DirectX;
+
+// vertices gathered per SoA block (multiple of 4)
+#define BLOCK_SIZE  64
+
+// -- polynomial approximations (4 lanes)
+
+// atan on [-1, 1], odd polynomial of degree 11 (max error ~2e-6 rad)
+static inline XMVECTOR
+atan_unit_est (FXMVECTOR x) {
+    XMVECTOR x2 = XMVectorMultiply(x, x);
+    XMVECTOR p = XMVectorReplicate(-0.01172120f);
+    p = XMVectorMultiplyAdd(p, x2, XMVectorReplicate(0.05265332f));
+    p = XMVectorMultiplyAdd(p, x2, XMVectorReplicate(-0.11643287f));
+    p = XMVectorMultiplyAdd(p, x2, XMVectorReplicate(0.19354346f));
+    p = XMVectorMultiplyAdd(p, x2, XMVectorReplicate(-0.33262347f));
+    p = XMVectorMultiplyAdd(p, x2, XMVectorReplicate(0.99997726f));
+    return XMVectorMultiply(p, x);
+}
+// atan2 in [-pi, pi] by octant reduction, 0 for (0, 0)
+static inline XMVECTOR
+atan2_est (FXMVECTOR y, FXMVECTOR x) {
+    XMVECTOR zero = XMVectorZero();
+    XMVECTOR ax = XMVectorAbs(x);
+    XMVECTOR ay = XMVectorAbs(y);
+    XMVECTOR hi = XMVectorMax(ax, ay);
+    XMVECTOR lo = XMVectorMin(ax, ay);
+    XMVECTOR ratio = XMVectorDivide(lo, XMVectorSelect(hi, XMVectorSplatOne(), XMVectorEqual(hi, zero)));
+    XMVECTOR ret = atan_unit_est(ratio);
+    ret = XMVectorSelect(ret, XMVectorSubtract(XMVectorReplicate(XM_PIDIV2), ret), XMVectorGreater(ay, ax));
+    ret = XMVectorSelect(ret, XMVectorSubtract(XMVectorReplicate(XM_PI), ret), XMVectorLess(x, zero));
+    return XMVectorSelect(ret, XMVectorNegate(ret), XMVectorLess(y, zero));
+}
+// acos on [-1, 1], Abramowitz & Stegun 4.4.46 (max error 2e-8 rad before float rounding)
+static inline XMVECTOR
+acos_est (FXMVECTOR x) {
+    XMVECTOR one = XMVectorSplatOne();
+    XMVECTOR ax = XMVectorMin(XMVectorAbs(x), one);
+    XMVECTOR p = XMVectorReplicate(-0.0012624911f);
+    p = XMVectorMultiplyAdd(p, ax, XMVectorReplicate(0.0066700901f));
+    p = XMVectorMultiplyAdd(p, ax, XMVectorReplicate(-0.0170881256f));
+    p = XMVectorMultiplyAdd(p, ax, XMVectorReplicate(0.0308918810f));
+    p = XMVectorMultiplyAdd(p, ax, XMVectorReplicate(-0.0501743046f));
+    p = XMVectorMultiplyAdd(p, ax, XMVectorReplicate(0.0889789874f));
+    p = XMVectorMultiplyAdd(p, ax, XMVectorReplicate(-0.2145988016f));
+    p = XMVectorMultiplyAdd(p, ax, XMVectorReplicate(1.5707963050f));
+    XMVECTOR ret = XMVectorMultiply(p, XMVectorSqrt(XMVectorSubtract(one, ax)));
+    return XMVectorSelect(ret, XMVectorSubtract(XMVectorReplicate(XM_PI), ret), XMVectorLess(x, XMVectorZero()));
+}
+// longitude around +y mapped to [0, 1]
+static inline XMVECTOR
+longitude_u (FXMVECTOR x, FXMVECTOR z) {
+    XMVECTOR theta = atan2_est(z, x);
+    theta = XMVectorSelect(theta, XMVectorAdd(theta, XMVectorReplicate(XM_2PI)), XMVectorLess(theta, XMVectorZero()));
+    return XMVectorScale(theta, XM_1DIV2PI);
+}
+static inline XMVECTOR
+sign_of (FXMVECTOR x) {
+    return XMVectorSelect(XMVectorSplatOne(), XMVectorReplicate(-1.0f), XMVectorLess(x, XMVectorZero()));
+}
+
+// -- SoA block: attributes relative to the projection center, 4 lanes at a time
+struct TexcoordBlock {
+    alignas(16) float x[BLOCK_SIZE];
+    alignas(16) float y[BLOCK_SIZE];
+    alignas(16) float z[BLOCK_SIZE];
+    alignas(16) float nx[BLOCK_SIZE];
+    alignas(16) float ny[BLOCK_SIZE];
+    alignas(16) float nz[BLOCK_SIZE];
+    alignas(16) float u[BLOCK_SIZE];
+    alignas(16) float v[BLOCK_SIZE];
+};
+static inline XMVECTOR
+load_lanes (float const * src) {
+    return XMLoadFloat4A(reinterpret_cast<XMFLOAT4A const *>(src));
+}
+static inline void
+store_lanes (float * dst, FXMVECTOR v) {
+    XMStoreFloat4A(reinterpret_cast<XMFLOAT4A *>(dst), v);
+}
+static void
+project_block (TexcoordBlock * block, UINT n4, TexcoordProjection const & projection) {
+    XMVECTOR zero = XMVectorZero();
+    float s = projection.scale;
+    for (UINT i = 0; i < n4; i += 4) {
+        XMVECTOR x = load_lanes(block->x + i);
+        XMVECTOR y = load_lanes(block->y + i);
+        XMVECTOR z = load_lanes(block->z + i);
+        XMVECTOR u, v;
+        switch (projection.type) {
+        case TEXCOORD_PROJECTION_SPHERICAL: {
+            XMVECTOR len = XMVectorSqrt(XMVectorMultiplyAdd(x, x, XMVectorMultiplyAdd(y, y, XMVectorMultiply(z, z))));
+            XMVECTOR cos_phi = XMVectorSelect(XMVectorDivide(y, len), zero, XMVectorEqual(len, zero));
+            u = longitude_u(x, z);
+            v = XMVectorScale(acos_est(cos_phi), XM_1DIVPI);
+        } break;
+        case TEXCOORD_PROJECTION_CYLINDRICAL: {
+            u = longitude_u(x, z);
+            v = XMVectorScale(y, -s);
+        } break;
+        case TEXCOORD_PROJECTION_PLANAR: {
+            if (0 == projection.axis) {
+                u = z;
+                v = XMVectorNegate(y);
+            } else if (1 == projection.axis) {
+                u = x;
+                v = XMVectorNegate(z);
+            } else {
+                u = XMVectorNegate(x);
+                v = XMVectorNegate(y);
+            }
+            u = XMVectorScale(u, s);
+            v = XMVectorScale(v, s);
+        } break;
+        default: {  // box
+            XMVECTOR nx = load_lanes(block->nx + i);
+            XMVECTOR ny = load_lanes(block->ny + i);
+            XMVECTOR nz = load_lanes(block->nz + i);
+            XMVECTOR ax = XMVectorAbs(nx);
+            XMVECTOR ay = XMVectorAbs(ny);
+            XMVECTOR az = XMVectorAbs(nz);
+            XMVECTOR is_x = XMVectorAndInt(XMVectorGreaterOrEqual(ax, ay), XMVectorGreaterOrEqual(ax, az));
+            XMVECTOR is_y = XMVectorGreaterOrEqual(ay, az);
+
+            // -- z face, then y and x override
+            u = XMVectorNegate(XMVectorMultiply(sign_of(nz), x));
+            v = XMVectorNegate(y);
+            u = XMVectorSelect(u, x, is_y);
+            v = XMVectorSelect(v, XMVectorNegate(XMVectorMultiply(sign_of(ny), z)), is_y);
+            u = XMVectorSelect(u, XMVectorMultiply(sign_of(nx), z), is_x);
+            v = XMVectorSelect(v, XMVectorNegate(y), is_x);
+            u = XMVectorScale(u, s);
+            v = XMVectorScale(v, s);
+        } break;
+        }
+        store_lanes(block->u + i, u);
+        store_lanes(block->v + i, v);
+    }
+}
+static void
+generate_range (TexcoordMeshDesc const & mesh, TexcoordProjection const & projection, UINT first_vtx, UINT last_vtx) {
+    TexcoordBlock block;
+    bool use_normals = TEXCOORD_PROJECTION_BOX == projection.type;
+    for (UINT base = first_vtx; base < last_vtx; base += BLOCK_SIZE) {
+        UINT n = last_vtx - base < BLOCK_SIZE ? last_vtx - base : BLOCK_SIZE;
+        UINT n4 = (n + 3) & ~3u;
+        BYTE * vtx = reinterpret_cast<BYTE *>(mesh.vertices) + (size_t)base * mesh.stride;
+
+        // -- gather (padding lanes are zeroed, their results are dropped)
+        for (UINT i = 0; i < n; ++i, vtx += mesh.stride) {
+            float const * p = reinterpret_cast<float const *>(vtx + mesh.position_offset);
+            block.x[i] = p[0] - projection.center.x;
+            block.y[i] = p[1] - projection.center.y;
+            block.z[i] = p[2] - projection.center.z;
+            if (use_normals) {
+                float const * nrm = reinterpret_cast<float const *>(vtx + mesh.normal_offset);
+                block.nx[i] = nrm[0];
+                block.ny[i] = nrm[1];
+                block.nz[i] = nrm[2];
+            }
+        }
+        for (UINT i = n; i < n4; ++i) {
+            block.x[i] = block.y[i] = block.z[i] = 0.0f;
+            block.nx[i] = block.ny[i] = block.nz[i] = 0.0f;
+        }
+
+        project_block(&block, n4, projection);
+
+        // -- scatter
+        vtx = reinterpret_cast<BYTE *>(mesh.vertices) + (size_t)base * mesh.stride;
+        for (UINT i = 0; i < n; ++i, vtx += mesh.stride) {
+            float * texc = reinterpret_cast<float *>(vtx + mesh.texc_offset);
+            texc[0] = block.u[i];
+            texc[1] = block.v[i];
+        }
+    }
+}
+UINT
+Texcoords_ThreadCount (UINT nvtx, UINT max_threads) {
+    if (0 == max_threads)
+        max_threads = std::thread::hardware_concurrency();
+    if (0 == max_threads)
+        max_threads = 1;
+    if (max_threads > TEXCOORDS_MAX_THREADS)
+        max_threads = TEXCOORDS_MAX_THREADS;
+    UINT n = nvtx / TEXCOORDS_MIN_VERTS_PER_THREAD;
+    return n < 1 ? 1 : (n > max_threads ? max_threads : n);
+}
+void
+Texcoords_Generate (TexcoordMeshDesc const & mesh, TexcoordProjection const & projection, UINT n_threads) {
+    _ASSERT_EXPR(n_threads >= 1 && n_threads <= TEXCOORDS_MAX_THREADS, "Invalid texcoord generator thread count");
+    _ASSERT_EXPR(TEXCOORD_PROJECTION_PLANAR != projection.type || projection.axis < 3, "Invalid planar projection axis");
+
+    // -- contiguous vertex ranges, thread 0 is the caller
+    std::thread threads[TEXCOORDS_MAX_THREADS];
+    for (UINT i = 1; i < n_threads; ++i) {
+        threads[i] = std::thread(
+            generate_range, std::cref(mesh), std::cref(projection),
+            (UINT)((uint64_t)mesh.nvtx * i / n_threads), (UINT)((uint64_t)mesh.nvtx * (i + 1) / n_threads)
+        );
+    }
+    generate_range(mesh, projection, 0, (UINT)((uint64_t)mesh.nvtx / n_threads));
+    for (UINT i = 1; i < n_threads; ++i)
+        threads[i].join();
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "headers/common.h"
+
+// NOTE(omid): Texture coordinate generation for meshes that come without them (e.g., the book's text models).
+// Vertices are processed in blocks: positions (and normals) are gathered into SoA arrays, the projection
+// runs 4 vertices per XMVECTOR, then the results are scattered back. atan2 and acos are polynomial
+// approximations (max error TEXCOORDS_MAX_ANGLE_ERROR radians, i.e. ~1e-6 in uv for spherical/cylindrical),
+// far below what a texel can resolve. Blocks are spread over threads in contiguous ranges.
+//
+// Projections (positions are taken relative to center, then multiplied by scale):
+//  - spherical:    u = longitude around +y in [0, 1], v = polar angle from +y in [0, 1]
+//  - cylindrical:  u as spherical, v = -y (grows downwards like spherical's v)
+//  - planar:       the two axes other than axis, seen from its positive side (v down)
+//  - box:          planar along the dominant axis of each vertex's normal, seen from the side the normal faces
+
+#define TEXCOORDS_MAX_THREADS           16
+#define TEXCOORDS_MIN_VERTS_PER_THREAD  16384
+#define TEXCOORDS_MAX_ANGLE_ERROR       1e-5f
+
+enum TEXCOORD_PROJECTION {
+    TEXCOORD_PROJECTION_SPHERICAL = 0,
+    TEXCOORD_PROJECTION_CYLINDRICAL = 1,
+    TEXCOORD_PROJECTION_PLANAR = 2,
+    TEXCOORD_PROJECTION_BOX = 3
+};
+
+struct TexcoordProjection {
+    TEXCOORD_PROJECTION     type;
+    DirectX::XMFLOAT3       center;
+    float                   scale;      // cylindrical v, planar and box (1 means one uv unit per world unit)
+    UINT                    axis;       // planar: 0 = x, 1 = y, 2 = z
+};
+
+// Strided view of the vertex attributes (offsets in bytes from the beginning of a vertex)
+struct TexcoordMeshDesc {
+    void *      vertices;
+    UINT        nvtx;
+    UINT        stride;
+    UINT        position_offset;
+    UINT        normal_offset;      // box projection only
+    UINT        texc_offset;
+};
+
+// Number of threads the generator uses for nvtx vertices (0 means hardware concurrency)
+UINT
+Texcoords_ThreadCount (UINT nvtx, UINT max_threads);
+
+/*
+    Overwrites the texcoords of every vertex, other attributes are left untouched.
+    n_threads is usually Texcoords_ThreadCount(nvtx, 0).
+*/
+void
+Texcoords_Generate (TexcoordMeshDesc const & mesh, TexcoordProjection const & projection, UINT n_threads);
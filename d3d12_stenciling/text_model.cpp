@@ -0,0 +1,291 @@
+#include "text_model.h"
+
+#include <emmintrin.h>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <thread>
+
+// -- one chunk of each section per thread
+struct ParseChunk {
+    char const *    vertices_begin;
+    char const *    vertices_end;
+    UINT            first_vertex;
+
+    char const *    triangles_begin;
+    char const *    triangles_end;
+    UINT            first_triangle;
+
+    bool            ok;
+};
+
+static inline char const *
+skip_blanks (char const * p, char const * end) {
+    while (p < end && (' ' == *p || '\t' == *p || '\r' == *p))
+        ++p;
+    return p;
+}
+// Beginning of the line after the one p is in (end if there is none)
+static char const *
+next_line (char const * p, char const * end) {
+    char const * nl = reinterpret_cast<char const *>(memchr(p, '\n', end - p));
+    return nl ? nl + 1 : end;
+}
+static UINT
+count_newlines (char const * p, char const * end) {
+    UINT n = 0;
+    __m128i const newline = _mm_set1_epi8('\n');
+    for (; p + 16 <= end; p += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+        n += std::popcount((unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)));
+    }
+    for (; p < end; ++p)
+        n += '\n' == *p;
+    return n;
+}
+// "Name: value" line
+static bool
+read_count (char const ** p, char const * end, UINT * out) {
+    char const * line_end = next_line(*p, end);
+    char const * colon = reinterpret_cast<char const *>(memchr(*p, ':', line_end - *p));
+    if (nullptr == colon)
+        return false;
+    std::from_chars_result res = std::from_chars(skip_blanks(colon + 1, line_end), line_end, *out);
+    *p = line_end;
+    return std::errc() == res.ec;
+}
+// Lines between the next "{" line and the matching "}" line
+static bool
+find_section (char const ** p, char const * end, char const ** out_begin, char const ** out_end) {
+    char const * open = reinterpret_cast<char const *>(memchr(*p, '{', end - *p));
+    if (nullptr == open)
+        return false;
+    char const * begin = next_line(open, end);
+    char const * close = reinterpret_cast<char const *>(memchr(begin, '}', end - begin));
+    if (nullptr == close)
+        return false;
+
+    // -- the section stops at the last newline (blanks before the brace are not a record)
+    char const * last = close;
+    while (last > begin && '\n' != last[-1])
+        --last;
+    *out_begin = begin;
+    *out_end = last;
+    *p = close + 1;
+    return true;
+}
+// Chunk boundaries at line starts, bounds [n + 1]
+static void
+split_section (char const * begin, char const * end, UINT n, char const * bounds []) {
+    bounds[0] = begin;
+    for (UINT i = 1; i < n; ++i) {
+        char const * p = begin + (size_t)(end - begin) * i / n;
+        p = p > begin ? next_line(p - 1, end) : begin;
+        bounds[i] = p > bounds[i - 1] ? p : bounds[i - 1];
+    }
+    bounds[n] = end;
+}
+template <typename T>
+static inline bool
+read_field (char const ** p, char const * end, T * value) {
+    std::from_chars_result res = std::from_chars(skip_blanks(*p, end), end, *value);
+    *p = res.ptr;
+    return std::errc() == res.ec;
+}
+// Only blanks may follow the last field of a record
+static inline bool
+end_record (char const ** p, char const * end) {
+    char const * q = skip_blanks(*p, end);
+    if (q < end && '\n' != *q)
+        return false;
+    *p = q < end ? q + 1 : q;
+    return true;
+}
+static void
+parse_chunk (TextModelOutput const * out, UINT nvtx, ParseChunk * chunk) {
+    chunk->ok = false;
+
+    // -- vertices
+    BYTE * dst = reinterpret_cast<BYTE *>(out->vertices) + (size_t)chunk->first_vertex * out->stride;
+    char const * p = chunk->vertices_begin;
+    char const * end = chunk->vertices_end;
+    while (p < end) {
+        float v[6];
+        for (int k = 0; k < 6; ++k)
+            if (!read_field(&p, end, &v[k]))
+                return;
+        if (!end_record(&p, end))
+            return;
+        memcpy(dst + out->position_offset, &v[0], 3 * sizeof(float));
+        memcpy(dst + out->normal_offset, &v[3], 3 * sizeof(float));
+        dst += out->stride;
+    }
+
+    // -- triangles
+    uint32_t * idx = out->indices + (size_t)chunk->first_triangle * 3;
+    p = chunk->triangles_begin;
+    end = chunk->triangles_end;
+    while (p < end) {
+        for (int k = 0; k < 3; ++k)
+            if (!read_field(&p, end, &idx[k]) || idx[k] >= nvtx)
+                return;
+        if (!end_record(&p, end))
+            return;
+        idx += 3;
+    }
+    chunk->ok = true;
+}
+static bool
+read_header (char const * text, size_t size, TextModel * out) {
+    char const * p = text;
+    char const * end = p + size;
+    out->size = size;
+    return
+        read_count(&p, end, &out->nvtx) &&
+        read_count(&p, end, &out->ntri) &&
+        find_section(&p, end, &out->vertices_begin, &out->vertices_end) &&
+        find_section(&p, end, &out->triangles_begin, &out->triangles_end);
+}
+bool
+TextModel_Open (char const * path, TextModel * out) {
+    *out = {};
+    if (!MappedFile_Open(path, &out->file))
+        return false;
+    bool ret = read_header(reinterpret_cast<char const *>(out->file.data), out->file.size, out);
+    if (!ret)
+        TextModel_Close(out);
+    return ret;
+}
+bool
+TextModel_OpenMemory (char const * text, size_t size, TextModel * out) {
+    *out = {};
+    bool ret = read_header(text, size, out);
+    if (!ret)
+        *out = {};
+    return ret;
+}
+void
+TextModel_Close (TextModel * model) {
+    MappedFile_Close(&model->file);
+    *model = {};
+}
+UINT
+TextModel_ThreadCount (size_t nbytes, UINT max_threads) {
+    if (0 == max_threads)
+        max_threads = std::thread::hardware_concurrency();
+    if (0 == max_threads)
+        max_threads = 1;
+    if (max_threads > TEXT_MODEL_MAX_THREADS)
+        max_threads = TEXT_MODEL_MAX_THREADS;
+    size_t n = nbytes / TEXT_MODEL_MIN_BYTES_PER_THREAD;
+    return n < 1 ? 1 : (n > max_threads ? max_threads : (UINT)n);
+}
+bool
+TextModel_Parse (TextModel const * model, UINT n_threads, TextModelOutput const & out) {
+    _ASSERT_EXPR(n_threads >= 1 && n_threads <= TEXT_MODEL_MAX_THREADS, "Invalid text model thread count");
+
+    char const * vtx_bounds[TEXT_MODEL_MAX_THREADS + 1];
+    char const * tri_bounds[TEXT_MODEL_MAX_THREADS + 1];
+    split_section(model->vertices_begin, model->vertices_end, n_threads, vtx_bounds);
+    split_section(model->triangles_begin, model->triangles_end, n_threads, tri_bounds);
+
+    // -- one record per line: the prefix sum of line counts gives where each chunk writes,
+    // -- and the totals are checked before anything is written
+    ParseChunk chunks[TEXT_MODEL_MAX_THREADS];
+    UINT nvtx = 0;
+    UINT ntri = 0;
+    for (UINT i = 0; i < n_threads; ++i) {
+        chunks[i].vertices_begin = vtx_bounds[i];
+        chunks[i].vertices_end = vtx_bounds[i + 1];
+        chunks[i].first_vertex = nvtx;
+        chunks[i].triangles_begin = tri_bounds[i];
+        chunks[i].triangles_end = tri_bounds[i + 1];
+        chunks[i].first_triangle = ntri;
+        nvtx += count_newlines(vtx_bounds[i], vtx_bounds[i + 1]);
+        ntri += count_newlines(tri_bounds[i], tri_bounds[i + 1]);
+    }
+    if (nvtx != model->nvtx || ntri != model->ntri)
+        return false;
+
+    std::thread threads[TEXT_MODEL_MAX_THREADS];
+    for (UINT i = 1; i < n_threads; ++i)
+        threads[i] = std::thread(parse_chunk, &out, model->nvtx, &chunks[i]);
+    parse_chunk(&out, model->nvtx, &chunks[0]);
+    for (UINT i = 1; i < n_threads; ++i)
+        threads[i].join();
+
+    bool ret = true;
+    for (UINT i = 0; i < n_threads; ++i)
+        ret = ret && chunks[i].ok;
+    return ret;
+}
+// -- reference: the line reader create_skull_geometry used (one fgets + sscanf_s per line, 100-byte lines)
+static bool
+load_legacy (char const * path, TextModelOutput const & out, UINT max_vtx, UINT max_tri) {
+    FILE * f = nullptr;
+    if (0 != fopen_s(&f, path, "r") || nullptr == f)
+        return false;
+    char linebuf[100];
+    unsigned vcount = 0;
+    unsigned tcount = 0;
+    bool ret =
+        fgets(linebuf, sizeof(linebuf), f) && 1 == sscanf_s(linebuf, "%*s %u", &vcount) &&
+        fgets(linebuf, sizeof(linebuf), f) && 1 == sscanf_s(linebuf, "%*s %u", &tcount) &&
+        vcount <= max_vtx && tcount <= max_tri;
+    fgets(linebuf, sizeof(linebuf), f);
+    fgets(linebuf, sizeof(linebuf), f);
+    for (unsigned i = 0; ret && i < vcount; ++i) {
+        float * pos = reinterpret_cast<float *>(reinterpret_cast<BYTE *>(out.vertices) + (size_t)i * out.stride + out.position_offset);
+        float * nrm = reinterpret_cast<float *>(reinterpret_cast<BYTE *>(out.vertices) + (size_t)i * out.stride + out.normal_offset);
+        ret = fgets(linebuf, sizeof(linebuf), f) &&
+            6 == sscanf_s(linebuf, "%f %f %f %f %f %f", &pos[0], &pos[1], &pos[2], &nrm[0], &nrm[1], &nrm[2]);
+    }
+    fgets(linebuf, sizeof(linebuf), f);
+    fgets(linebuf, sizeof(linebuf), f);
+    fgets(linebuf, sizeof(linebuf), f);
+    for (unsigned i = 0; ret && i < tcount; ++i) {
+        uint32_t * idx = out.indices + (size_t)i * 3;
+        ret = fgets(linebuf, sizeof(linebuf), f) && 3 == sscanf_s(linebuf, "%u %u %u", &idx[0], &idx[1], &idx[2]);
+    }
+    fclose(f);
+    return ret;
+}
+bool
+TextModel_BenchmarkLoad (char const * path, int n_iterations, double * out_legacy_ms, double * out_mapped_ms) {
+    TextModel model = {};
+    if (n_iterations < 1 || !TextModel_Open(path, &model))
+        return false;
+    UINT nvtx = model.nvtx;
+    UINT ntri = model.ntri;
+    TextModel_Close(&model);
+
+    // same layout as the demo vertex (position, normal, texc)
+    UINT stride = 8 * sizeof(float);
+    TextModelOutput out = {};
+    out.vertices = ::malloc((size_t)nvtx * stride);
+    out.stride = stride;
+    out.position_offset = 0;
+    out.normal_offset = 3 * sizeof(float);
+    out.indices = (uint32_t *)::malloc(sizeof(uint32_t) * 3 * (size_t)ntri);
+
+    bool ret = true;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; ret && i < n_iterations; ++i)
+        ret = load_legacy(path, out, nvtx, ntri);
+    auto mid = std::chrono::high_resolution_clock::now();
+    for (int i = 0; ret && i < n_iterations; ++i) {
+        ret = TextModel_Open(path, &model);
+        if (ret) {
+            ret = TextModel_Parse(&model, TextModel_ThreadCount(model.size, 0), out);
+            TextModel_Close(&model);
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    *out_legacy_ms = std::chrono::duration<double, std::milli>(mid - start).count() / n_iterations;
+    *out_mapped_ms = std::chrono::duration<double, std::milli>(end - mid).count() / n_iterations;
+
+    ::free(out.indices);
+    ::free(out.vertices);
+    return ret;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "mapped_file.h"
+
+// NOTE(omid): Loader for the text model format of the book samples (skull.txt, car.txt):
+//
+//   VertexCount: N
+//   TriangleCount: M
+//   VertexList (pos, normal)
+//   {
+//       px py pz nx ny nz          (N lines)
+//   }
+//   TriangleList
+//   {
+//       i0 i1 i2                   (M lines)
+//   }
+//
+// The file is memory-mapped and both sections are split into chunks at line boundaries.
+// Newlines are counted 16 bytes at a time (SSE2 compare + movemask + popcount), a prefix sum over
+// the chunk counts gives the first record of every chunk, then the chunks are parsed in parallel
+// with std::from_chars straight into the caller's arrays (no per-line copies, no line length limit).
+
+#define TEXT_MODEL_MAX_THREADS          16
+#define TEXT_MODEL_MIN_BYTES_PER_THREAD (256 * 1024)
+
+struct TextModel {
+    MappedFile      file;           // not mapped when opened from memory
+    size_t          size;           // bytes of text
+
+    UINT            nvtx;
+    UINT            ntri;
+
+    // sections (whole lines, the braces excluded)
+    char const *    vertices_begin;
+    char const *    vertices_end;
+    char const *    triangles_begin;
+    char const *    triangles_end;
+};
+
+// Where parsed records go (offsets in bytes from the beginning of a vertex)
+struct TextModelOutput {
+    void *      vertices;       // nvtx * stride bytes
+    UINT        stride;
+    UINT        position_offset;
+    UINT        normal_offset;
+
+    uint32_t *  indices;        // ntri * 3
+};
+
+/*
+    Maps the file and locates the sections, returns false if it can't be read or the header is malformed.
+    On success the model has to be closed with TextModel_Close (the sections point into the mapping).
+*/
+bool
+TextModel_Open (char const * path, TextModel * out);
+
+/*
+    Same as TextModel_Open for text already in memory (e.g., extracted from an archive).
+    The sections point into text, it has to outlive the model.
+*/
+bool
+TextModel_OpenMemory (char const * text, size_t size, TextModel * out);
+
+void
+TextModel_Close (TextModel * model);
+
+// Number of threads the parser uses for a file of nbytes (0 means hardware concurrency)
+UINT
+TextModel_ThreadCount (size_t nbytes, UINT max_threads);
+
+/*
+    Fills positions, normals and indices. Other vertex attributes are left untouched.
+    Returns false if a section doesn't hold exactly the announced number of records,
+    a record is malformed or an index is out of range.
+*/
+bool
+TextModel_Parse (TextModel const * model, UINT n_threads, TextModelOutput const & out);
+
+/*
+    Loads the model n_iterations times with the fgets/sscanf_s reader the demo used before
+    and with the mapped parser, out_*_ms receive the average time per load in milliseconds.
+    Both runs write into the same buffers, so after the first iteration the file is in the OS cache.
+*/
+bool
+TextModel_BenchmarkLoad (char const * path, int n_iterations, double * out_legacy_ms, double * out_mapped_ms);
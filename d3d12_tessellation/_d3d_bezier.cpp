@@ -10,6 +10,10 @@
 #include "headers/game_timer.h"
 #include "headers/dds_loader.h"
 
+#include "texture_batch.h"
+#include "texture_registry.h"
+#include "upload_ring.h"
+
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_win32.h>
 #include <imgui/imgui_impl_dx12.h>
@@ -28,6 +32,7 @@
 
 #define NUM_BACKBUFFERS         2
 #define NUM_QUEUING_FRAMES      3
+#define UPLOAD_RING_SIZE        (1024 * 1024)   // startup textures, the batch executes early if they don't fit
 
 enum RENDER_LAYER : int {
     LAYER_BASIC_TESS = 0,
@@ -175,78 +180,21 @@ struct D3DRenderContext {
     ID3D12Resource *                depth_stencil_buffer;
 
     Material                        materials[_COUNT_MATERIAL];
-    Texture                         textures[_COUNT_TEX];
+    Texture                         textures[_COUNT_TEX];   // resources are owned by the registry
     IDxcBlob *                      shaders[_COUNT_SHADERS];
-};
-static void
-load_texture (
-    ID3D12Device * device,
-    ID3D12GraphicsCommandList * cmd_list,
-    wchar_t const * tex_path,
-    Texture * out_texture
-) {
-
-    uint8_t * ddsData;
-    D3D12_SUBRESOURCE_DATA * subresources;
-    UINT n_subresources = 0;
-
-    LoadDDSTextureFromFile(device, tex_path, &out_texture->resource, &ddsData, &subresources, &n_subresources);
-
-    UINT64 upload_buffer_size = get_required_intermediate_size(out_texture->resource, 0,
-                                                               n_subresources);
-
-   // Create the GPU upload buffer.
-    D3D12_HEAP_PROPERTIES heap_props = {};
-    heap_props.Type = D3D12_HEAP_TYPE_UPLOAD;
-    heap_props.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-    heap_props.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-    heap_props.CreationNodeMask = 1;
-    heap_props.VisibleNodeMask = 1;
-
-    D3D12_RESOURCE_DESC desc = {};
-    desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-    desc.Alignment = 0;
-    desc.Width = upload_buffer_size;
-    desc.Height = 1;
-    desc.DepthOrArraySize = 1;
-    desc.MipLevels = 1;
-    desc.Format = DXGI_FORMAT_UNKNOWN;
-    // TODO(omid): do we need to set 4x MSAA here? 
-    desc.SampleDesc.Count = 1;
-    desc.SampleDesc.Quality = 0;
-    desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-    desc.Flags = D3D12_RESOURCE_FLAG_NONE;
-
-    device->CreateCommittedResource(
-        &heap_props,
-        D3D12_HEAP_FLAG_NONE,
-        &desc,
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        nullptr,
-        IID_PPV_ARGS(&out_texture->upload_heap)
-    );
 
-    // Use Heap-allocating UpdateSubresources implementation for variable number of subresources (which is the case for textures).
-    update_subresources_heap(
-        cmd_list, out_texture->resource, out_texture->upload_heap,
-        0, 0, n_subresources, subresources
-    );
-
-    resource_usage_transition(
-        cmd_list, out_texture->resource,
-        D3D12_RESOURCE_STATE_COPY_DEST,
-        D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
-    );
-
-    ::free(subresources);
-    ::free(ddsData);
-}
+    // Textures shared by content, owns the texture SRVs (the first _COUNT_TEX descriptors of srv_heap)
+    TextureRegistry                 texture_registry;
+    int                             texture_entries[_COUNT_TEX];
+    UploadRing                      upload_ring;    // startup uploads only, destroyed once they're done
+};
+// texture_srvs: SRV index of each TEX_INDEX (textures with the same contents share one)
 static void
-create_materials (Material out_materials []) {
+create_materials (UINT const texture_srvs [], Material out_materials []) {
 
     strcpy_s(out_materials[MAT_WHITE].name, "whitemat");
     out_materials[MAT_WHITE].mat_cbuffer_index = 0;
-    out_materials[MAT_WHITE].diffuse_srvheap_index = 0;
+    out_materials[MAT_WHITE].diffuse_srvheap_index = texture_srvs[TEX_WHITE1X1];
     out_materials[MAT_WHITE].diffuse_albedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
     out_materials[MAT_WHITE].fresnel_r0 = XMFLOAT3(0.05f, 0.05f, 0.05f);
     out_materials[MAT_WHITE].roughness = 0.2f;
@@ -463,7 +411,7 @@ draw_render_items (
 static void
 create_descriptor_heaps (D3DRenderContext * render_ctx) {
 
-    // Create Shader Resource View descriptor heap
+    // Create Shader Resource View descriptor heap (the texture SRVs are created by the texture registry)
     D3D12_DESCRIPTOR_HEAP_DESC srv_heap_desc = {};
     srv_heap_desc.NumDescriptors = _COUNT_TEX +
         1;      /* imgui descriptor     */
@@ -471,23 +419,6 @@ create_descriptor_heaps (D3DRenderContext * render_ctx) {
     srv_heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
     render_ctx->device->CreateDescriptorHeap(&srv_heap_desc, IID_PPV_ARGS(&render_ctx->srv_heap));
 
-    // Fill out the heap with actual descriptors
-    D3D12_CPU_DESCRIPTOR_HANDLE descriptor_cpu_handle = render_ctx->srv_heap->GetCPUDescriptorHandleForHeapStart();
-    D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
-
-    // crate texture
-    ID3D12Resource * white1x1_tex = render_ctx->textures[TEX_WHITE1X1].resource;
-    memset(&srv_desc, 0, sizeof(srv_desc)); // reset desc
-    srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    srv_desc.Format = white1x1_tex->GetDesc().Format;
-    srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-    srv_desc.Texture2D.MostDetailedMip = 0;
-    srv_desc.Texture2D.MipLevels = white1x1_tex->GetDesc().MipLevels;
-    srv_desc.Texture2D.ResourceMinLODClamp = 0.0f;
-    //descriptor_cpu_handle.ptr += render_ctx->cbv_srv_uav_descriptor_size;   // next descriptor
-    render_ctx->device->CreateShaderResourceView(white1x1_tex, &srv_desc, descriptor_cpu_handle);
-
-
     // Create Render Target View Descriptor Heap
     D3D12_DESCRIPTOR_HEAP_DESC rtv_heap_desc = {};
     rtv_heap_desc.NumDescriptors = NUM_BACKBUFFERS + 1 /* offscreen render-target */;
@@ -1501,17 +1432,39 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
 
 // ========================================================================================================
 #pragma region Load Textures
-    // crate
-    strcpy_s(render_ctx->textures[TEX_WHITE1X1].name, "white1x1");
-    wcscpy_s(render_ctx->textures[TEX_WHITE1X1].filename, L"../Textures/white1x1.dds");
-    load_texture(
-        render_ctx->device, render_ctx->direct_cmd_list,
-        render_ctx->textures[TEX_WHITE1X1].filename,
-        &render_ctx->textures[TEX_WHITE1X1]
-    );
-#pragma endregion
-
+    struct {
+        TEX_INDEX           index;
+        char const *        name;
+        wchar_t const *     filename;
+    } const texture_table [] = {
+        {TEX_WHITE1X1, "white1x1", L"../Textures/white1x1.dds"},
+    };
+    static_assert(_countof(texture_table) == _COUNT_TEX, "Missing texture table entries");
+    wchar_t const * texture_paths[_COUNT_TEX];
+    int texture_entries[_COUNT_TEX];
+    for (UINT i = 0; i < _countof(texture_table); ++i) {
+        strcpy_s(render_ctx->textures[texture_table[i].index].name, texture_table[i].name);
+        wcscpy_s(render_ctx->textures[texture_table[i].index].filename, texture_table[i].filename);
+        texture_paths[i] = texture_table[i].filename;
+    }
+    // -- all textures are read in parallel and uploaded through the ring, identical images are loaded once
+    if (!UploadRing_Init(&render_ctx->upload_ring, render_ctx->device, UPLOAD_RING_SIZE)) {
+        ::printf("[ERROR] UploadRing_Init() failed at line %d. \n", __LINE__);
+        ::abort();
+    }
     create_descriptor_heaps(render_ctx);
+    TextureRegistry_Init(&render_ctx->texture_registry, render_ctx->device, render_ctx->srv_heap, 0, _COUNT_TEX);
+    if (!TextureBatch_Load(
+        render_ctx->device, render_ctx->direct_cmd_list, render_ctx->cmd_queue, render_ctx->direct_cmd_list_alloc, &render_ctx->texture_registry,
+        texture_paths, _COUNT_TEX, 0, DDS_LOADER_DEFAULT, texture_entries, &render_ctx->upload_ring
+    ))
+        printf("some textures could not be loaded\n");
+    for (UINT i = 0; i < _countof(texture_table); ++i) {
+        int entry = texture_entries[i];
+        render_ctx->texture_entries[texture_table[i].index] = entry;
+        render_ctx->textures[texture_table[i].index].resource = entry >= 0 ? render_ctx->texture_registry.entries[entry].resource : nullptr;
+    }
+#pragma endregion
 
 #pragma region Dsv_Creation
 // Create the depth/stencil buffer and view.
@@ -1631,7 +1584,11 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
 #pragma region Shapes_And_Renderitem_Creation
     create_quad_patch_geometry_4cp(render_ctx);     // basic tessellation
     create_quad_patch_geometry_16cp(render_ctx);    // cubic bezier surface
-    create_materials(render_ctx->materials);
+    // -- a texture that failed to load leaves its materials on the first SRV
+    UINT texture_srvs[_COUNT_TEX];
+    for (UINT i = 0; i < _COUNT_TEX; ++i)
+        texture_srvs[i] = render_ctx->texture_entries[i] >= 0 ? TextureRegistry_GetSrvIndex(&render_ctx->texture_registry, render_ctx->texture_entries[i]) : 0;
+    create_materials(texture_srvs, render_ctx->materials);
     create_render_items(render_ctx);
 
 #pragma endregion Shapes_And_Renderitem_Creation
@@ -1643,6 +1600,7 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     CHECK_AND_FAIL(render_ctx->direct_cmd_list->Close());
     ID3D12CommandList * cmd_lists [] = {render_ctx->direct_cmd_list};
     render_ctx->cmd_queue->ExecuteCommandLists(ARRAY_COUNT(cmd_lists), cmd_lists);
+    UploadRing_Submit(&render_ctx->upload_ring, render_ctx->cmd_queue);
 
     //----------------
     // Create fence
@@ -1664,6 +1622,9 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
     // we just want to wait for setup to complete before continuing.
     flush_command_queue(render_ctx);
 
+    // -- nothing else goes through the ring
+    UploadRing_Destroy(&render_ctx->upload_ring);
+
 #pragma endregion
 
 #pragma region Imgui Setup
@@ -1818,10 +1779,8 @@ WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ INT) {
 
     render_ctx->depth_stencil_buffer->Release();
 
-    for (unsigned i = 0; i < _COUNT_TEX; i++) {
-        render_ctx->textures[i].upload_heap->Release();
-        render_ctx->textures[i].resource->Release();
-    }
+    for (unsigned i = 0; i < _COUNT_TEX; i++)
+        TextureRegistry_Release(&render_ctx->texture_registry, render_ctx->texture_entries[i]);
 
     //render_ctx->swapchain3->Release();
     render_ctx->swapchain->Release();
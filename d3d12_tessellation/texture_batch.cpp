@@ -0,0 +1,330 @@
+#include "texture_batch.h"
+#include "texture_registry.h"
+#include "upload_ring.h"
+#include "headers/dds_loader.h"
+
+#include <thread>
+#include <atomic>
+
+// Per-texture state carried from one phase to the next (fixed capacity, nothing is allocated per texture)
+struct BatchTexture {
+    DDS_FILE_DATA                           file;
+    uint64_t                                hash;       // content hash, see TextureRegistry_HashDDS
+    int                                     alias;      // earlier texture of the batch with the same contents, -1 if none
+    bool                                    upload;     // a new image: this texture creates and fills the resource
+    ID3D12Resource *                        resource;
+    bool                                    is_cube_map;
+    DDS_CONVERSION                          conversion; // the subresources are in the file's layout if it isn't NONE
+
+    D3D12_SUBRESOURCE_DATA                  subresources[DDS_MAX_SUBRESOURCES];
+    UINT                                    n_subresources;
+
+    // footprints relative to the texture's own allocation of the upload ring
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT      layouts[DDS_MAX_SUBRESOURCES];
+    UINT64                                  row_sizes[DDS_MAX_SUBRESOURCES];
+    UINT                                    n_rows[DDS_MAX_SUBRESOURCES];
+    UINT64                                  upload_size;
+    UINT64                                  upload_offset;  // of the allocation in the ring's buffer
+
+    bool                                    ok;
+};
+// Rows [first_row, first_row + n_rows) of a subresource, numbered through its depth slices
+struct BatchCopy {
+    UINT    texture;
+    UINT    subresource;
+    UINT    first_row;
+    UINT    n_rows;
+};
+struct BatchContext {
+    ID3D12Device *              device;
+    wchar_t const * const *     paths;
+    unsigned int                load_flags;
+    BatchTexture *              batch;
+    UINT                        n_textures;
+
+    BatchCopy *                 copies;
+    UINT                        n_copies;
+    BYTE *                      upload_data;    // the ring's mapped buffer
+
+    std::atomic<UINT>           next;   // next unclaimed texture (parse and create phases) or copy (fill phase)
+};
+static void
+parse_one (wchar_t const * path, unsigned int load_flags, BatchTexture * batch) {
+    DDS_HEADER const * header = nullptr;
+    uint8_t const * bit_data = nullptr;
+    size_t bit_size = 0;
+    batch->ok =
+        SUCCEEDED(LoadTextureDataFromFile(path, &batch->file, &header, &bit_data, &bit_size)) &&
+        TextureRegistry_HashDDS(batch->file.data, batch->file.size, load_flags, &batch->hash);
+}
+static void
+create_one (ID3D12Device * device, wchar_t const * path, unsigned int load_flags, BatchTexture * batch) {
+    DDS_HEADER const * header = nullptr;
+    uint8_t const * bit_data = nullptr;
+    size_t bit_size = 0;
+    ID3D12Resource ** texture = &batch->resource;
+    batch->ok =
+        SUCCEEDED(LoadTextureDataFromMemory(batch->file.data, batch->file.size, &header, &bit_data, &bit_size)) &&
+        SUCCEEDED(CreateTextureFromDDS(
+            device, header, bit_data, bit_size, 0, D3D12_RESOURCE_FLAG_NONE, load_flags,
+            texture, batch->subresources, &batch->n_subresources, &batch->is_cube_map, &batch->conversion
+        ));
+    if (!batch->ok) {
+        batch->upload = false;
+        return;
+    }
+    SetDebugTextureInfo(path, texture);
+
+    // -- footprints on the CPU, only multi-plane formats are laid out by the device
+    UINT n = batch->n_subresources;
+    D3D12_RESOURCE_DESC desc = (*texture)->GetDesc();
+    if (HRESULT_E_NOT_SUPPORTED == ComputeCopyableFootprints(desc, 0, n, 0, batch->layouts, batch->n_rows, batch->row_sizes, &batch->upload_size))
+        device->GetCopyableFootprints(&desc, 0, n, 0, batch->layouts, batch->n_rows, batch->row_sizes, &batch->upload_size);
+}
+static void
+copy_one (BYTE * upload_data, BatchTexture const * batch, BatchCopy const & copy) {
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT const & layout = batch->layouts[copy.subresource];
+    D3D12_SUBRESOURCE_DATA const & src = batch->subresources[copy.subresource];
+    UINT64 row_size = batch->row_sizes[copy.subresource];
+    UINT n_rows = batch->n_rows[copy.subresource];
+    UINT64 dst_row_pitch = layout.Footprint.RowPitch;
+
+    // -- slices are n_rows rows apart in the footprint, so a row number is also its offset in rows
+    BYTE * dst = upload_data + batch->upload_offset + layout.Offset;
+    for (UINT row = copy.first_row, end = copy.first_row + copy.n_rows; row < end;) {
+        UINT z = row / n_rows;
+        UINT y = row % n_rows;
+        UINT n = (end - row < n_rows - y) ? end - row : n_rows - y;
+        BYTE * dst_rows = dst + dst_row_pitch * row;
+        BYTE const * src_rows = reinterpret_cast<BYTE const *>(src.pData) + src.SlicePitch * z + src.RowPitch * y;
+        if (DDS_CONVERSION_NONE != batch->conversion) {
+            for (UINT i = 0; i < n; ++i)
+                ConvertRow(batch->conversion, dst_rows + dst_row_pitch * i, src_rows + src.RowPitch * i, layout.Footprint.Width);
+        } else if ((UINT64)src.RowPitch == dst_row_pitch && row_size == dst_row_pitch) {
+            // -- tightly packed on both sides (e.g., wide mips): one copy for the run of rows
+            memcpy(dst_rows, src_rows, (size_t)(dst_row_pitch * n));
+        } else {
+            for (UINT i = 0; i < n; ++i)
+                memcpy(dst_rows + dst_row_pitch * i, src_rows + src.RowPitch * i, (size_t)row_size);
+        }
+        row += n;
+    }
+}
+// Copy jobs of a subresource: about TEXTURE_BATCH_COPY_BYTES of the upload buffer each, whole rows
+static UINT
+rows_per_copy (BatchTexture const * batch, UINT subresource) {
+    UINT64 n = TEXTURE_BATCH_COPY_BYTES / batch->layouts[subresource].Footprint.RowPitch;
+    return n > 0 ? (UINT)n : 1;
+}
+static void
+parse_worker (BatchContext * ctx) {
+    for (UINT i; (i = ctx->next.fetch_add(1)) < ctx->n_textures;)
+        parse_one(ctx->paths[i], ctx->load_flags, &ctx->batch[i]);
+}
+static void
+create_worker (BatchContext * ctx) {
+    for (UINT i; (i = ctx->next.fetch_add(1)) < ctx->n_textures;)
+        if (ctx->batch[i].upload)
+            create_one(ctx->device, ctx->paths[i], ctx->load_flags, &ctx->batch[i]);
+}
+static void
+copy_worker (BatchContext * ctx) {
+    for (UINT i; (i = ctx->next.fetch_add(1)) < ctx->n_copies;)
+        copy_one(ctx->upload_data, &ctx->batch[ctx->copies[i].texture], ctx->copies[i]);
+}
+// Runs worker on n_threads threads (thread 0 is the caller) until the shared counter runs out
+static void
+run_workers (void (*worker)(BatchContext *), BatchContext * ctx, UINT n_threads) {
+    ctx->next.store(0);
+    std::thread threads[TEXTURE_BATCH_MAX_THREADS];
+    for (UINT i = 1; i < n_threads; ++i)
+        threads[i] = std::thread(worker, ctx);
+    worker(ctx);
+    for (UINT i = 1; i < n_threads; ++i)
+        threads[i].join();
+}
+static UINT
+clamp_threads (UINT n_threads, UINT n_jobs) {
+    if (n_threads > n_jobs)
+        n_threads = n_jobs;
+    return n_threads < 1 ? 1 : n_threads;
+}
+// Fills the footprints of the new images in [begin, end) and records their copies, then their barriers at once
+static void
+record_uploads (BatchContext * ctx, UINT begin, UINT end, UINT n_threads, ID3D12GraphicsCommandList * cmd_list, ID3D12Resource * upload_buffer) {
+    ctx->n_copies = 0;
+    for (UINT i = begin; i < end; ++i) {
+        for (UINT j = 0; ctx->batch[i].upload && j < ctx->batch[i].n_subresources; ++j) {
+            UINT rows = ctx->batch[i].n_rows[j] * ctx->batch[i].layouts[j].Footprint.Depth;
+            UINT per_copy = rows_per_copy(&ctx->batch[i], j);
+            for (UINT first = 0; first < rows; first += per_copy)
+                ctx->copies[ctx->n_copies++] = {i, j, first, (rows - first < per_copy) ? rows - first : per_copy};
+        }
+    }
+    if (0 == ctx->n_copies)
+        return;
+
+    // -- 5. fill the footprints
+    run_workers(copy_worker, ctx, clamp_threads(n_threads, ctx->n_copies));
+
+    // -- 6. record the copies, then transition everything at once
+    D3D12_RESOURCE_BARRIER * barriers = (D3D12_RESOURCE_BARRIER *)::calloc(end - begin, sizeof(D3D12_RESOURCE_BARRIER));
+    UINT n_barriers = 0;
+    for (UINT i = begin; i < end; ++i) {
+        BatchTexture const * batch = &ctx->batch[i];
+        if (!batch->upload)
+            continue;
+        for (UINT j = 0; j < batch->n_subresources; ++j) {
+            D3D12_TEXTURE_COPY_LOCATION loc_dst = {};
+            loc_dst.pResource = batch->resource;
+            loc_dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+            loc_dst.SubresourceIndex = j;
+
+            D3D12_TEXTURE_COPY_LOCATION loc_src = {};
+            loc_src.pResource = upload_buffer;
+            loc_src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+            loc_src.PlacedFootprint = batch->layouts[j];
+            loc_src.PlacedFootprint.Offset += batch->upload_offset;
+
+            cmd_list->CopyTextureRegion(&loc_dst, 0, 0, 0, &loc_src, nullptr);
+        }
+        D3D12_RESOURCE_BARRIER * barrier = &barriers[n_barriers++];
+        barrier->Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier->Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+        barrier->Transition.pResource = batch->resource;
+        barrier->Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+        barrier->Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+        barrier->Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    }
+    cmd_list->ResourceBarrier(n_barriers, barriers);
+    ::free(barriers);
+}
+// Executes what cmd_list recorded so far and submits the ring, so its allocations retire once the GPU is done with them
+static bool
+execute_uploads (ID3D12GraphicsCommandList * cmd_list, ID3D12CommandQueue * cmd_queue, ID3D12CommandAllocator * cmd_allocator, UploadRing * upload_ring) {
+    if (FAILED(cmd_list->Close()))
+        return false;
+    ID3D12CommandList * cmd_lists [] = {cmd_list};
+    cmd_queue->ExecuteCommandLists(_countof(cmd_lists), cmd_lists);
+    UploadRing_Submit(upload_ring, cmd_queue);
+    return SUCCEEDED(cmd_list->Reset(cmd_allocator, nullptr));
+}
+bool
+TextureBatch_Load (
+    ID3D12Device * device,
+    ID3D12GraphicsCommandList * cmd_list,
+    ID3D12CommandQueue * cmd_queue,
+    ID3D12CommandAllocator * cmd_allocator,
+    TextureRegistry * registry,
+    wchar_t const * const paths [], UINT n_textures,
+    UINT n_threads,
+    unsigned int load_flags,
+    int out_entries [],
+    UploadRing * upload_ring
+) {
+    if (0 == n_threads)
+        n_threads = std::thread::hardware_concurrency();
+    if (n_threads > TEXTURE_BATCH_MAX_THREADS)
+        n_threads = TEXTURE_BATCH_MAX_THREADS;
+
+    BatchContext ctx;
+    ctx.device = device;
+    ctx.paths = paths;
+    ctx.load_flags = load_flags;
+    ctx.batch = (BatchTexture *)::calloc(n_textures, sizeof(BatchTexture));
+    ctx.n_textures = n_textures;
+    ctx.copies = nullptr;
+    ctx.n_copies = 0;
+    ctx.upload_data = nullptr;
+    for (UINT i = 0; i < n_textures; ++i)
+        out_entries[i] = -1;
+
+    // -- 1. map the files and hash their contents
+    run_workers(parse_worker, &ctx, clamp_threads(n_threads, n_textures));
+
+    // -- 2. images the registry already has, or that an earlier texture of the batch has, aren't loaded again
+    bool ret = true;
+    UINT n_uploads = 0;
+    for (UINT i = 0; i < n_textures; ++i) {
+        BatchTexture * batch = &ctx.batch[i];
+        batch->alias = -1;
+        if (!batch->ok) {
+            ret = false;
+            continue;
+        }
+        out_entries[i] = TextureRegistry_Acquire(registry, batch->hash);
+        if (out_entries[i] >= 0)
+            continue;
+        for (UINT j = 0; j < i && batch->alias < 0; ++j)
+            if (ctx.batch[j].upload && ctx.batch[j].hash == batch->hash)
+                batch->alias = (int)j;
+        batch->upload = batch->alias < 0;
+        n_uploads += batch->upload ? 1 : 0;
+    }
+
+    // -- 3. create the resources of the new images and query their footprints
+    if (n_uploads > 0)
+        run_workers(create_worker, &ctx, clamp_threads(n_threads, n_textures));
+
+    // -- 4. every new image takes its own allocation of the upload ring; when the next one doesn't fit
+    // the images allocated so far are filled, recorded and executed to make room
+    UINT max_copies = 0;
+    for (UINT i = 0; i < n_textures; ++i) {
+        BatchTexture * batch = &ctx.batch[i];
+        if (!batch->ok)
+            ret = false;
+        for (UINT j = 0; batch->upload && j < batch->n_subresources; ++j) {
+            UINT rows = batch->n_rows[j] * batch->layouts[j].Footprint.Depth;
+            UINT per_copy = rows_per_copy(batch, j);
+            max_copies += (rows + per_copy - 1) / per_copy;
+        }
+    }
+    ctx.copies = (BatchCopy *)::malloc(sizeof(BatchCopy) * (max_copies > 0 ? max_copies : 1));
+    ctx.upload_data = upload_ring->cpu_base;
+    UINT first_pending = 0;
+    for (UINT i = 0; i < n_textures; ++i) {
+        BatchTexture * batch = &ctx.batch[i];
+        if (!batch->upload)
+            continue;
+        UploadRingAllocation upload = {};
+        bool allocated = UploadRing_Alloc(upload_ring, batch->upload_size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, &upload);
+        if (!allocated) {
+            record_uploads(&ctx, first_pending, i, n_threads, cmd_list, upload_ring->buffer);
+            first_pending = i;
+            allocated =
+                execute_uploads(cmd_list, cmd_queue, cmd_allocator, upload_ring) &&
+                UploadRing_Alloc(upload_ring, batch->upload_size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, &upload);
+        }
+        if (!allocated) {
+            // -- larger than the ring
+            batch->resource->Release();
+            batch->resource = nullptr;
+            batch->upload = false;
+            ret = false;
+            continue;
+        }
+        batch->upload_offset = upload.offset;
+    }
+    record_uploads(&ctx, first_pending, n_textures, n_threads, cmd_list, upload_ring->buffer);
+
+    // -- 7. the new images go to the registry, duplicates in the batch take a reference on them
+    for (UINT i = 0; i < n_textures; ++i) {
+        BatchTexture * batch = &ctx.batch[i];
+        if (batch->upload) {
+            out_entries[i] = TextureRegistry_Add(registry, batch->hash, batch->resource, batch->is_cube_map);
+            if (out_entries[i] < 0) {
+                batch->resource->Release();
+                ret = false;
+            }
+        } else if (batch->alias >= 0) {
+            out_entries[i] = out_entries[batch->alias] >= 0 ? TextureRegistry_Acquire(registry, batch->hash) : -1;
+            ret = ret && out_entries[i] >= 0;
+        }
+    }
+
+    for (UINT i = 0; i < n_textures; ++i)
+        ReleaseTextureData(&ctx.batch[i].file);
+    ::free(ctx.copies);
+    ::free(ctx.batch);
+    return ret;
+}